@@ -129,6 +129,7 @@ int show_help;
 int nofilter;
 int nosource;				/**< undocumented command */
 int debug;
+int statistics = STATISTICS_STYLE_NONE;
 int literal;				/**< 1: literal search	*/
 int print0;				/**< --print0 option	*/
 int format;
@@ -240,6 +241,7 @@ struct option const long_options[] = {
 	{"result", required_argument, NULL, OPT_RESULT},
 	{"nosource", no_argument, &nosource, 1},
 	{"single-update", required_argument, NULL, OPT_SINGLE_UPDATE},
+	{"statistics", no_argument, &statistics, STATISTICS_STYLE_TABLE},
 	{ 0 }
 };
 
@@ -374,6 +376,8 @@ finish:
 				continue;
 			if (!STRCMP(dbpath, libdbpath))
 				continue;
+			if (!gtags_may_exist(libdbpath, GTAGS, tag, flags))
+				continue;
 			gtop = gtags_open(libdbpath, root, GTAGS, GTAGS_READ, 0);
 			if ((gtp = gtags_first(gtop, tag, flags)) != NULL)
 				db = GTAGS;
@@ -971,6 +975,10 @@ main(int argc, char **argv)
 			conv_flags |= CONVERT_PATH;
 		set_convert_flags(conv_flags);
 	}
+	/*
+	 * Start statistics.
+	 */
+	init_statistics();
 	/*
 	 * exec lid(idutils).
 	 */
@@ -1005,6 +1013,7 @@ main(int argc, char **argv)
 	else {
 		tagsearch(av, cwd, root, dbpath, db);
 	}
+	print_statistics(statistics);
 	return 0;
 }
 /**
@@ -1952,6 +1961,12 @@ tagsearch(const char *pattern, const char *cwd, const char *root, const char *db
 	if (db == GTAGS && getenv("GTAGSLIBPATH") && (count == 0 || Tflag) && !Sflag) {
 		STRBUF *sb = strbuf_open(0);
 		char *libdir, *nextp = NULL;
+		int flags = 0;
+
+		if (literal)
+			flags |= GTOP_NOREGEX;
+		if (iflag)
+			flags |= GTOP_IGNORECASE;
 
 		strbuf_puts(sb, getenv("GTAGSLIBPATH"));
 		back2slash(sb);
@@ -1967,6 +1982,11 @@ tagsearch(const char *pattern, const char *cwd, const char *root, const char *db
 				continue;
 			if (!test("f", makepath(libdbpath, dbname(db), NULL)))
 				continue;
+			/*
+			 * skip the tree which certainly doesn't have the name.
+			 */
+			if (!gtags_may_exist(libdbpath, db, pattern, flags))
+				continue;
 			/*
 			 * search again
 			 */
@@ -50,10 +50,14 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_DIRENT_H
+#include <dirent.h>
+#endif
 #include "getopt.h"
 
 #include "global.h"
 #include "parser.h"
+#include "parsecache.h"
 #include "const.h"
 
 /*
@@ -97,6 +101,8 @@ const char *dump_target;
 char *single_update;
 int statistics = STATISTICS_STYLE_NONE;
 int explain;
+int in_place_update;				/**< update tag files in place */
+int dictionary;					/**< compress line images with a dictionary */
 #ifdef USE_SQLITE3
 int use_sqlite3;
 #endif
@@ -178,10 +184,14 @@ struct option const long_options[] = {
 #define OPT_ACCEPT_DOTFILES	131
 #define OPT_SKIP_UNREADABLE	132
 #define OPT_GTAGSSKIP_SYMLINK	133
+#define OPT_PAGESIZE		134
+#define OPT_FORMAT		135
 	/* flag value */
 	{"accept-dotfiles", no_argument, NULL, OPT_ACCEPT_DOTFILES},
 	{"debug", no_argument, &debug, 1},
+	{"dictionary", no_argument, &dictionary, 1},
 	{"explain", no_argument, &explain, 1},
+	{"in-place", no_argument, &in_place_update, 1},
 #ifdef USE_SQLITE3
 	{"sqlite3", no_argument, &use_sqlite3, 1},
 #endif
@@ -192,9 +202,11 @@ struct option const long_options[] = {
 
 	/* accept value */
 	{"config", optional_argument, NULL, OPT_CONFIG},
+	{"format", required_argument, NULL, OPT_FORMAT},
 	{"gtagsconf", required_argument, NULL, OPT_GTAGSCONF},
 	{"gtagslabel", required_argument, NULL, OPT_GTAGSLABEL},
 	{"skip-symlink", optional_argument, NULL, OPT_GTAGSSKIP_SYMLINK},
+	{"pagesize", required_argument, NULL, OPT_PAGESIZE},
 	{"path", required_argument, NULL, OPT_PATH},
 	{"single-update", required_argument, NULL, OPT_SINGLE_UPDATE},
 	{ 0 }
@@ -202,6 +214,202 @@ struct option const long_options[] = {
 
 static const char *langmap = DEFAULTLANGMAP;	/**< langmap */
 static const char *gtags_parser;		/**< gtags_parser */
+static const char *parse_cache;			/**< parse_cache */
+static int parse_cache_size = PARSECACHESIZE; /**< parse_cache_size */
+static int pagesize[GTAGLIM];			/**< page size of each tag file */
+static int format = -1;				/**< -1: as is, 0: B-tree, DBOP_SSTABLE, DBOP_FOLDDUP */
+/**
+ * check_pagesize: check the page size of a tag file.
+ *
+ *	@param[in]	db	GPATH, GTAGS, GRTAGS
+ *	@param[in]	size	page size
+ */
+static void
+check_pagesize(int db, int size)
+{
+	if (size < DBOP_MINPAGESIZE || size > DBOP_MAXPAGESIZE || (size & (size - 1)))
+		die("page size of %s must be a power of 2 from %d to %d.",
+			dbname(db), DBOP_MINPAGESIZE, DBOP_MAXPAGESIZE);
+	pagesize[db] = size;
+}
+/**
+ * set_pagesize: set page size from the argument of the --pagesize option.
+ *
+ *	@param[in]	arg	'size' for all tag files or 'name:size' for a tag file,
+ *			e.g. '32768', 'GRTAGS:32768'
+ */
+static void
+set_pagesize(const char *arg)
+{
+	const char *p = strchr(arg, ':');
+	int db;
+
+	if (p == NULL) {
+		for (db = GPATH; db <= GRTAGS; db++)
+			check_pagesize(db, atoi(arg));
+		return;
+	}
+	for (db = GPATH; db <= GRTAGS; db++)
+		if (strlen(dbname(db)) == p - arg && !strncmp(dbname(db), arg, p - arg))
+			break;
+	if (db > GRTAGS)
+		die("--pagesize: %s: unknown tag file.", arg);
+	check_pagesize(db, atoi(p + 1));
+}
+/**
+ * convert_tags: convert the tag files into the format.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	flags	DBOP_SSTABLE: sorted table, 0: B-tree,
+ *			DBOP_FOLDDUP: B-tree with folded duplicate keys
+ */
+static void
+convert_tags(const char *dbpath, int flags)
+{
+	int db;
+
+	for (db = GPATH; db <= GRTAGS; db++)
+		dbop_convert(makepath(dbpath, dbname(db), NULL),
+			db == GPATH ? flags : flags | DBOP_DUP, pagesize[db]);
+}
+/*
+ * An incremental update is made on copies of the tag files in a staging
+ * directory, and they are published by renaming, so that global never
+ * reads a half-updated tag file. Copying costs as much as the tag files
+ * however small the change is; the --in-place option updates them in
+ * place instead. Rename cannot replace an existing file on Windows, where
+ * the tag files are always updated in place.
+ */
+#if defined(HAVE_MKDTEMP) && !(defined(_WIN32) && !defined(__CYGWIN__))
+#define STAGING_UPDATE
+#define STAGINGDIR	".gtags-update.XXXXXX"
+static char staging[MAXPATHLEN];	/**< staging directory, "": none */
+static pid_t staging_owner;		/**< process which made it */
+/**
+ * remove_staging: remove the staging directory with the files in it.
+ *
+ * This is also called by die() and on signals, so that a failed update
+ * doesn't leave the directory. Child processes leave it to the parent.
+ */
+static void
+remove_staging(void)
+{
+	DIR *dirp;
+	struct dirent *dp;
+
+	if (staging[0] == '\0' || getpid() != staging_owner)
+		return;
+	if ((dirp = opendir(staging)) != NULL) {
+		while ((dp = readdir(dirp)) != NULL) {
+			if (!strcmp(dp->d_name, ".") || !strcmp(dp->d_name, ".."))
+				continue;
+			(void)unlink(makepath(staging, dp->d_name, NULL));
+		}
+		(void)closedir(dirp);
+	}
+	if (rmdir(staging) < 0)
+		warning("cannot remove directory '%s'.", staging);
+	staging[0] = '\0';
+}
+static void
+suddenly(int signo)
+{
+	signo = 0;	/* to satisfy compiler */
+
+	remove_staging();
+	exit(1);
+}
+/**
+ * stage_tags: copy the tag files into a new staging directory.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@return		staging directory
+ */
+static const char *
+stage_tags(const char *dbpath)
+{
+	char src[MAXPATHLEN], dst[MAXPATHLEN];
+	struct stat st;
+	int db;
+
+	strlimcpy(staging, makepath(dbpath, STAGINGDIR, NULL), sizeof(staging));
+	if (mkdtemp(staging) == NULL) {
+		staging[0] = '\0';
+		die("cannot make directory '%s'.", makepath(dbpath, STAGINGDIR, NULL));
+	}
+	staging_owner = getpid();
+	sethandler(remove_staging);
+	signal(SIGINT, suddenly);
+	signal(SIGTERM, suddenly);
+#ifdef SIGHUP
+	signal(SIGHUP, suddenly);
+#endif
+	for (db = GPATH; db <= GRTAGS; db++) {
+		strlimcpy(src, makepath(dbpath, dbname(db), NULL), sizeof(src));
+		strlimcpy(dst, makepath(staging, dbname(db), NULL), sizeof(dst));
+		if (stat(src, &st) < 0)
+			die("cannot stat '%s'.", src);
+		copyfile(src, dst);
+		if (chmod(dst, st.st_mode & 0777) < 0)
+			die("cannot change mode of '%s'.", dst);
+		if (db != GPATH)
+			bloom_copy(src, dst);
+	}
+	return staging;
+}
+#endif
+/**
+ * publish_tags: put a new generation into the updated tag files, and
+ * move them from the staging directory into dbpath.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	work	staging directory, or dbpath if updated in place
+ */
+static void
+publish_tags(const char *dbpath, const char *work)
+{
+	char src[MAXPATHLEN];
+	DBOP *dbop;
+	int db, generation = 0;
+
+	/*
+	 * The bloom filter is rewritten for the new state of the tag file
+	 * when it is closed.
+	 */
+	for (db = GPATH; db <= GRTAGS; db++) {
+		strlimcpy(src, makepath(work, dbname(db), NULL), sizeof(src));
+		if ((dbop = dbop_open(src, 2, 0644, db == GPATH ? 0 : DBOP_BLOOM)) == NULL)
+			die("cannot open '%s'.", src);
+		if (db == GPATH)
+			generation = dbop_getgeneration(dbop) + 1;
+		dbop_putgeneration(dbop, generation);
+		/*
+		 * Update modification time of tag files
+		 * because they may have no definitions.
+		 */
+		if (db != GPATH)
+			utime(src, NULL);
+		dbop_close(dbop);
+	}
+	if (!strcmp(work, dbpath))
+		return;
+	/*
+	 * GPATH goes first, since global opens it after the other tag files.
+	 * The old bloom filter left for a while doesn't match the new tag
+	 * file, and is not used.
+	 */
+	for (db = GPATH; db <= GRTAGS; db++) {
+		strlimcpy(src, makepath(work, dbname(db), NULL), sizeof(src));
+		if (rename(src, makepath(dbpath, dbname(db), NULL)) < 0)
+			die("cannot rename '%s'.", src);
+		strlimcpy(src, makepath(work, dbname(db), BLOOM_SUFFIX), sizeof(src));
+		if (test("f", src) && rename(src, makepath(dbpath, dbname(db), BLOOM_SUFFIX)) < 0)
+			die("cannot rename '%s'.", src);
+	}
+#ifdef STAGING_UPDATE
+	remove_staging();
+#endif
+}
 /**
  * load configuration variables.
  */
@@ -209,6 +417,7 @@ static void
 configuration()
 {
 	STRBUF *sb = strbuf_open(0);
+	int db, n;
 
 	if (getconfb("extractmethod"))
 		extractmethod = 1;
@@ -218,6 +427,24 @@ configuration()
 	strbuf_reset(sb);
 	if (getconfs("gtags_parser", sb))
 		gtags_parser = check_strdup(strbuf_value(sb));
+	strbuf_reset(sb);
+	if (getconfs("parse_cache", sb))
+		parse_cache = check_strdup(strbuf_value(sb));
+	if (getconfn("parse_cache_size", &parse_cache_size) && parse_cache_size <= 0)
+		die("parse_cache_size must be a positive number.");
+	if (getconfn("find_readers", &n))
+		set_find_readers(n);
+	if (getconfb("in_place_update"))
+		in_place_update = 1;
+	/*
+	 * GPATH_pagesize, GTAGS_pagesize, GRTAGS_pagesize
+	 */
+	for (db = GPATH; db <= GRTAGS; db++) {
+		strbuf_reset(sb);
+		strbuf_sprintf(sb, "%s_pagesize", dbname(db));
+		if (getconfn(strbuf_value(sb), &n))
+			check_pagesize(db, n);
+	}
 	strbuf_close(sb);
 }
 int
@@ -313,6 +540,19 @@ main(int argc, char **argv)
 		case OPT_SKIP_UNREADABLE:
 			skip_unreadable = 1;
 			break;
+		case OPT_PAGESIZE:
+			set_pagesize(optarg);
+			break;
+		case OPT_FORMAT:
+			if (!strcmp(optarg, "btree"))
+				format = 0;
+			else if (!strcmp(optarg, "sstable"))
+				format = DBOP_SSTABLE;
+			else if (!strcmp(optarg, "folded"))
+				format = DBOP_FOLDDUP;
+			else
+				die("--format: %s: unknown format.", optarg);
+			break;
 		case OPT_GTAGSSKIP_SYMLINK:
 			skip_symlink = SKIP_SYMLINK_FOR_ALL;
 			if (optarg) {
@@ -378,6 +618,11 @@ main(int argc, char **argv)
 		version(NULL, vflag);
 	if (show_help)
 		help();
+#ifdef USE_SQLITE3
+	if (use_sqlite3 && format > 0)
+		die("--format=%s cannot be used with --sqlite3.",
+			format == DBOP_SSTABLE ? "sstable" : "folded");
+#endif
 
 	argc -= optind;
         argv += optind;
@@ -552,6 +797,11 @@ main(int argc, char **argv)
 	if (vflag && gtags_parser)
 		fprintf(stderr, " Using plug-in parser.\n");
 	parser_init(langmap, gtags_parser);
+	if (parse_cache) {
+		if (vflag)
+			fprintf(stderr, " Using parse cache '%s'.\n", parse_cache);
+		parsecache_open(parse_cache, parse_cache_size);
+	}
 	/*
 	 * Start statistics.
 	 */
@@ -560,11 +810,23 @@ main(int argc, char **argv)
 	 * incremental update.
 	 */
 	if (iflag) {
+		GTOP *gtop;
+
+		/*
+		 * Sorted tables are read only. They are converted into
+		 * B-trees for updating, and back again unless --format=btree
+		 * is specified.
+		 */
+		if (is_sstable(makepath(dbpath, dbname(GTAGS), NULL))) {
+			if (format < 0)
+				format = DBOP_SSTABLE;
+			convert_tags(dbpath, format == DBOP_FOLDDUP ? DBOP_FOLDDUP : 0);
+		}
 		/*
 		 * Version check. If existing tag files are old enough
 		 * gtagsopen() abort with error message.
 		 */
-		GTOP *gtop = gtags_open(dbpath, cwd, GTAGS, GTAGS_MODIFY, 0);
+		gtop = gtags_open(dbpath, cwd, GTAGS, GTAGS_MODIFY, 0);
 		gtags_close(gtop);
 		/*
 		 * GPATH is needed for incremental updating.
@@ -573,7 +835,10 @@ main(int argc, char **argv)
 		 */
 		if (!test("f", makepath(dbpath, dbname(GPATH), NULL)))
 			die("Old version tag file found. Please remake it.");
-		(void)incremental(dbpath, cwd);
+		if (incremental(dbpath, cwd))
+			dbop_unshare(makepath(dbpath, dbname(GTAGS), NULL));
+		if (format == DBOP_SSTABLE)
+			convert_tags(dbpath, DBOP_SSTABLE);
 		print_statistics(statistics);
 		exit(0);
 	}
@@ -581,6 +846,17 @@ main(int argc, char **argv)
 	 * create GTAGS and GRTAGS
 	 */
 	createtags(dbpath, cwd);
+	if (format == DBOP_SSTABLE) {
+		tim = statistics_time_start("Time of converting tag files");
+		if (vflag)
+			fprintf(stderr, "[%s] Converting tag files into sorted tables.\n", now());
+		convert_tags(dbpath, DBOP_SSTABLE);
+		statistics_time_end(tim);
+	}
+	/*
+	 * The pages of the old tag files in the shared cache are useless.
+	 */
+	dbop_unshare(makepath(dbpath, dbname(GTAGS), NULL));
 	/*
 	 * create idutils index.
 	 */
@@ -661,6 +937,7 @@ incremental(const char *dbpath, const char *root)
 	IDSET *deleteset, *findset;
 	int updated = 0;
 	const char *path;
+	const char *work = dbpath;
 	unsigned int id, limit;
 
 	tim = statistics_time_start("Time of inspecting %s and %s.", dbname(GTAGS), dbname(GRTAGS));
@@ -801,11 +1078,20 @@ incremental(const char *dbpath, const char *root)
 	if ((!idset_empty(deleteset) || strbuf_getlen(addlist) > 0) ||
 	    (strbuf_getlen(deletelist) + strbuf_getlen(addlist_other) > 0))
 	{
-		int db;
 		updated = 1;
+#ifdef STAGING_UPDATE
+		if (!in_place_update) {
+			tim = statistics_time_start("Time of copying tag files");
+			gpath_close();
+			work = stage_tags(dbpath);
+			if (gpath_open(work, 2) < 0)
+				die("GPATH not found.");
+			statistics_time_end(tim);
+		}
+#endif
 		tim = statistics_time_start("Time of updating %s and %s.", dbname(GTAGS), dbname(GRTAGS));
 		if (!idset_empty(deleteset) || strbuf_getlen(addlist) > 0)
-			updatetags(dbpath, root, deleteset, addlist);
+			updatetags(work, root, deleteset, addlist);
 		if (strbuf_getlen(deletelist) + strbuf_getlen(addlist_other) > 0) {
 			const char *start, *end, *p;
 
@@ -829,15 +1115,12 @@ incremental(const char *dbpath, const char *root)
 			}
 			/* gpath_close(); */
 		}
-		/*
-		 * Update modification time of tag files
-		 * because they may have no definitions.
-		 */
-		for (db = GTAGS; db < GTAGLIM; db++)
-			utime(makepath(dbpath, dbname(db), NULL), NULL);
 		statistics_time_end(tim);
 	}
 exit:
+	gpath_close();
+	if (updated)
+		publish_tags(dbpath, work);
 	if (vflag) {
 		if (updated)
 			fprintf(stderr, " Global databases have been modified.\n");
@@ -848,63 +1131,68 @@ exit:
 	strbuf_close(addlist);
 	strbuf_close(deletelist);
 	strbuf_close(addlist_other);
-	gpath_close();
 	idset_close(deleteset);
 	idset_close(findset);
 
 	return updated;
 }
 /**
- * static void put_syms(int type, const char *tag, int lno, const char *path, const char *line_image, void *arg)
+ * put_syms: put the tags of a file into tag files.
  *
- * callback functions for built-in parser
+ *	@param[in]	batch	tags extracted by parse_file_batch()
+ *	@param[in]	path	path name
+ *	@param[in]	data	tag files and file id
  */
 struct put_func_data {
 	GTOP *gtop[GTAGLIM];
 	const char *fid;
 };
 static void
-put_syms(int type, const char *tag, int lno, const char *path, const char *line_image, void *arg)
+put_syms(const struct parser_batch *batch, const char *path, const struct put_func_data *data)
 {
-	const struct put_func_data *data = arg;
-	GTOP *gtop;
-	const char *p;
+	int i;
 
-	/*
-	 * sanity checks
-	 * These checks are required, because there is no telling what kind of string
-	 * comes as 'a symbol' from external plug-in parsers.
-	 */
-	for (p = tag; *p; p++) {
-		if (isspace(*p)) {
+	for (i = 0; i < batch->count; i++) {
+		const char *tag = PARSER_BATCH_TAG(batch, i);
+		int len = batch->taglen[i];
+		int lno = batch->lineno[i];
+		GTOP *gtop;
+
+		/*
+		 * sanity checks
+		 * These checks are required, because there is no telling what kind of string
+		 * comes as 'a symbol' from external plug-in parsers.
+		 */
+		if (len == 0) {
+			if (wflag)
+				warning("symbol name is null. (Ignored) [+%d %s]", lno, path);
+			continue;
+		}
+		if (strcspn(tag, " \t\n\v\f\r") != len) {
 			if (wflag)
 				warning("symbol name includs a space character. (Ignored) [+%d %s]", lno, path);
-			return;
+			continue;
 		}
+		if (len >= IDENTLEN) {
+			if (wflag)
+				warning("symbol name is too long. (Ignored) [+%d %s]", lno, path);
+			continue;
+		}
+		switch (batch->type[i]) {
+		case PARSER_DEF:
+			gtop = data->gtop[GTAGS];
+			break;
+		case PARSER_REF_SYM:
+			gtop = data->gtop[GRTAGS];
+			if (gtop == NULL)
+				continue;
+			break;
+		default:
+			continue;
+		}
+		gtags_put_image(gtop, tag, lno, data->fid,
+				PARSER_BATCH_IMAGE(batch, i), PARSER_BATCH_IMAGELEN(batch, i));
 	}
-	if (p == tag) {
-		if (wflag)
-			warning("symbol name is null. (Ignored) [+%d %s]", lno, path);
-		return;
-	}
-	if (p - tag >= IDENTLEN) {
-		if (wflag)
-			warning("symbol name is too long. (Ignored) [+%d %s]", lno, path);
-		return;
-	}
-	switch (type) {
-	case PARSER_DEF:
-		gtop = data->gtop[GTAGS];
-		break;
-	case PARSER_REF_SYM:
-		gtop = data->gtop[GRTAGS];
-		if (gtop == NULL)
-			return;
-		break;
-	default:
-		return;
-	}
-	gtags_put_using(gtop, tag, lno, data->fid, line_image);
 }
 /**
  * updatetags: update tag file.
@@ -918,6 +1206,7 @@ void
 updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addlist)
 {
 	struct put_func_data data;
+	struct parser_batch *batch;
 	int seqno, flags;
 	const char *path, *start, *end;
 
@@ -981,6 +1270,9 @@ updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addli
 	 */
 	start = strbuf_value(addlist);
 	end = start + strbuf_getlen(addlist);
+	batch = parser_batch_open();
+	for (path = start; path < end; path += strlen(path) + 1)
+		parser_ahead(path, flags);
 	seqno = 0;
 	for (path = start; path < end; path += strlen(path) + 1) {
 		gpath_put(path, GPATH_SOURCE);
@@ -989,11 +1281,13 @@ updatetags(const char *dbpath, const char *root, IDSET *deleteset, STRBUF *addli
 			die("GPATH is corrupted.('%s' not found)", path);
 		if (vflag)
 			fprintf(stderr, " [%d/%d] extracting tags of %s\n", ++seqno, total, path + 2);
-		parse_file(path, flags, put_syms, &data);
+		parse_file_batch(path, flags, batch);
+		put_syms(batch, path, &data);
 		gtags_flush(data.gtop[GTAGS], data.fid);
 		if (data.gtop[GRTAGS] != NULL)
 			gtags_flush(data.gtop[GRTAGS], data.fid);
 	}
+	parser_batch_close(batch);
 	parser_exit();
 	gtags_close(data.gtop[GTAGS]);
 	if (data.gtop[GRTAGS] != NULL)
@@ -1011,17 +1305,25 @@ createtags(const char *dbpath, const char *root)
 	STATISTICS_TIME *tim;
 	STRBUF *sb = strbuf_open(0);
 	struct put_func_data data;
-	int openflags, flags, seqno;
-	const char *path;
+	struct parser_batch *batch;
+	STRBUF *pathlist = NULL;
+	int openflags, flags, seqno, db;
+	const char *path, *next = NULL, *end = NULL;
 
 	tim = statistics_time_start("Time of creating %s and %s.", dbname(GTAGS), dbname(GRTAGS));
 	if (vflag)
 		fprintf(stderr, "[%s] Creating '%s' and '%s'.\n", now(), dbname(GTAGS), dbname(GRTAGS));
 	openflags = cflag ? GTAGS_COMPACT : 0;
+	if (dictionary)
+		openflags |= GTAGS_COMPDICT;
+	if (format == DBOP_FOLDDUP)
+		openflags |= GTAGS_FOLDDUP;
 #ifdef USE_SQLITE3
 	if (use_sqlite3)
 		openflags |= GTAGS_SQLITE3;
 #endif
+	for (db = GPATH; db <= GRTAGS; db++)
+		set_gtags_pagesize(db, pagesize[db]);
 	data.gtop[GTAGS] = gtags_open(dbpath, root, GTAGS, GTAGS_CREATE, openflags);
 	data.gtop[GTAGS]->flags = 0;
 	if (extractmethod)
@@ -1046,8 +1348,32 @@ createtags(const char *dbpath, const char *root)
 		find_open_filelist(file_list, root, explain);
 	else
 		find_open(NULL, explain);
+	batch = parser_batch_open();
+	/*
+	 * Plug-in parsers are told the files in advance (see parser_ahead()),
+	 * so that the file list is read at first.
+	 */
+	if (gtags_parser != NULL) {
+		pathlist = strbuf_open(0);
+		while ((path = find_read()) != NULL) {
+			strbuf_puts0(pathlist, path);
+			if (*path != ' ')
+				parser_ahead(path, flags);
+		}
+		next = strbuf_value(pathlist);
+		end = next + strbuf_getlen(pathlist);
+	}
 	seqno = 0;
-	while ((path = find_read()) != NULL) {
+	for (;;) {
+		if (pathlist == NULL)
+			path = find_read();
+		else if (next < end) {
+			path = next;
+			next += strlen(next) + 1;
+		} else
+			path = NULL;
+		if (path == NULL)
+			break;
 		if (*path == ' ') {
 			path++;
 			if (!test("b", path))
@@ -1061,11 +1387,15 @@ createtags(const char *dbpath, const char *root)
 		seqno++;
 		if (vflag)
 			fprintf(stderr, " [%d] extracting tags of %s\n", seqno, path + 2);
-		parse_file(path, flags, put_syms, &data);
+		parse_file_batch(path, flags, batch);
+		put_syms(batch, path, &data);
 		gtags_flush(data.gtop[GTAGS], data.fid);
 		gtags_flush(data.gtop[GRTAGS], data.fid);
 	}
 	total = seqno;
+	if (pathlist != NULL)
+		strbuf_close(pathlist);
+	parser_batch_close(batch);
 	parser_exit();
 	find_close();
 	statistics_time_end(tim);
@@ -37,14 +37,11 @@
 #include "htags.h"
 #include "path2url.h"
 
+/*
+ * Input streams of the anchors. They are shared by all the files,
+ * and each anchor_load() reads the records of its file in order.
+ */
 static XARGS *anchor_input[GTAGLIM];
-static struct anchor *table;
-static VARRAY *vb;
-
-static struct anchor *start;
-static struct anchor *curp;
-static struct anchor *end;
-static struct anchor *CURRENT;
 
 /** compare routine for qsort(3) */
 static int
@@ -52,13 +49,6 @@ cmp(const void *s1, const void *s2)
 {
 	return ((struct anchor *)s1)->lineno - ((struct anchor *)s2)->lineno;
 }
-/*
- * Pointers (as lineno).
- */
-static int FIRST;
-static int LAST;
-static struct anchor *CURRENTDEF;
-
 /**
  * anchor_prepare: setup input stream.
  *
@@ -98,13 +88,39 @@ anchor_prepare(FILE *anchor_stream)
 		}
 	}
 }
+/**
+ * anchor_open: open an anchor table
+ *
+ *	@return		anchor table
+ */
+ANCHOR *
+anchor_open(void)
+{
+	ANCHOR *anc = check_calloc(sizeof(ANCHOR), 1);
+
+	anc->vb = varray_open(sizeof(struct anchor), 1000);
+	return anc;
+}
+/**
+ * anchor_close: close an anchor table
+ *
+ *	@param[in]	anc	anchor table
+ */
+void
+anchor_close(ANCHOR *anc)
+{
+	anchor_unload(anc);
+	varray_close(anc->vb);
+	free(anc);
+}
 /**
  * anchor_load: load anchor table
  *
+ *	@param[in]	anc	anchor table
  *	@param[in]	path	path name
  */
 void
-anchor_load(const char *path)
+anchor_load(ANCHOR *anc, const char *path)
 {
 	int db, current_fid;
 
@@ -115,13 +131,9 @@ anchor_load(const char *path)
 			die("anchor_load: internal error. file '%s' not found in GPATH.", path);
 		current_fid = atoi(p);
 	}
-	FIRST = LAST = 0;
-	end = CURRENT = NULL;
-
-	if (vb == NULL)
-		vb = varray_open(sizeof(struct anchor), 1000);
-	else
-		varray_reset(vb);
+	anc->first = anc->last = 0;
+	anc->end = anc->current = anc->currentdef = NULL;
+	varray_reset(anc->vb);
 
 	for (db = GTAGS; db < GTAGLIM; db++) {
 		XARGS *xp;
@@ -181,7 +193,7 @@ anchor_load(const char *path)
 			else
 				type = 'Y';
 			/* allocate an entry */
-			a = varray_append(vb);
+			a = varray_append(anc->vb);
 			a->lineno = atoi(ptable.part[PART_LNO].start);
 			a->type = type;
 			a->done = 0;
@@ -193,14 +205,15 @@ anchor_load(const char *path)
 			anchor_input[db] = NULL;
 		}
 	}
-	if (vb->length == 0) {
-		table = NULL;
+	if (anc->vb->length == 0) {
+		anc->table = NULL;
 	} else {
-		int i, used = vb->length;
+		struct anchor *table;
+		int i, used = anc->vb->length;
 		/*
 		 * Sort by lineno.
 		 */
-		table = varray_assign(vb, 0, 0);
+		table = anc->table = varray_assign(anc->vb, 0, 0);
 		qsort(table, used, sizeof(struct anchor), cmp); 
 		/*
 		 * Setup some lineno.
@@ -209,70 +222,77 @@ anchor_load(const char *path)
 			if (table[i].type == 'D')
 				break;
 		if (i < used)
-			FIRST = table[i].lineno;
+			anc->first = table[i].lineno;
 		for (i = used - 1; i >= 0; i--)
 			if (table[i].type == 'D')
 				break;
 		if (i >= 0)
-			LAST = table[i].lineno;
+			anc->last = table[i].lineno;
 	}
 	/*
 	 * Setup loop range.
 	 */
-	start = table;
-	curp = NULL;
-	end = &table[vb->length];
-	/* anchor_dump(stderr, 0);*/
+	anc->start = anc->table;
+	anc->curp = NULL;
+	anc->end = anc->table ? &anc->table[anc->vb->length] : NULL;
+	/* anchor_dump(anc, stderr, 0);*/
 }
 /**
  * anchor_unload: unload anchor table
+ *
+ *	@param[in]	anc	anchor table
  */
 void
-anchor_unload(void)
+anchor_unload(ANCHOR *anc)
 {
 	struct anchor *a;
 
-	for (a = start; a && a < end; a++) {
+	for (a = anc->start; a && a < anc->end; a++) {
 		if (a->reserve) {
 			free(a->reserve);
 			a->reserve = NULL;
 		}
 	}
-	/* We don't free varray */
-	/* varray_close(vb); */
-	FIRST = LAST = 0;
-	start = curp = end = NULL;
+	/* We don't free varray; it is reused by the next anchor_load(). */
+	anc->first = anc->last = 0;
+	anc->table = anc->start = anc->curp = anc->end = NULL;
+	anc->current = anc->currentdef = NULL;
 }
 /**
  * anchor_first: return the first anchor
+ *
+ *	@param[in]	anc	anchor table
  */
 struct anchor *
-anchor_first(void)
+anchor_first(ANCHOR *anc)
 {
-	if (!start || start == end)
+	if (!anc->start || anc->start == anc->end)
 		return NULL;
-	CURRENT = start;
-	if (CURRENT->type == 'D')
-		CURRENTDEF = CURRENT;
-	return CURRENT;
+	anc->current = anc->start;
+	if (anc->current->type == 'D')
+		anc->currentdef = anc->current;
+	return anc->current;
 }
 /**
  * anchor_next: return the next anchor
+ *
+ *	@param[in]	anc	anchor table
  */
 struct anchor *
-anchor_next(void)
+anchor_next(ANCHOR *anc)
 {
-	if (!start)
+	if (!anc->start)
 		return NULL;
-	if (++CURRENT >= end)
+	if (++anc->current >= anc->end)
 		return NULL;
-	if (CURRENT->type == 'D')
-		CURRENTDEF = CURRENT;
-	return CURRENT;
+	if (anc->current->type == 'D')
+		anc->currentdef = anc->current;
+	return anc->current;
 }
 /**
  * anchor_get: return the specified anchor
  *
+ *	@param[in]	anc	anchor table
  *	@param[in]	name	name of anchor
  *	@param[in]	length	lenght of the name
  *	@param[in]	type	==0: not specified,
@@ -280,11 +300,12 @@ anchor_next(void)
  *	@param[in]	lineno	line number
  */
 struct anchor *
-anchor_get(const char *name, int length, int type, int lineno)
+anchor_get(ANCHOR *anc, const char *name, int length, int type, int lineno)
 {
-	struct anchor *p = curp ? curp : start;
+	struct anchor *p = anc->curp ? anc->curp : anc->start;
+	struct anchor *end = anc->end;
 
-	if (table == NULL)
+	if (anc->table == NULL)
 		return NULL;
 	if (p->lineno > lineno)
 		return NULL;
@@ -295,7 +316,7 @@ anchor_get(const char *name, int length, int type, int lineno)
 		;
 	if (p >= end || p->lineno != lineno)
 		return NULL;
-	curp = p;
+	anc->curp = p;
 	for (; p < end && p->lineno == lineno; p++)
 		if (!p->done && p->length == length && !strcmp(gettag(p), name))
 			if (!type || p->type == type)
@@ -305,17 +326,19 @@ anchor_get(const char *name, int length, int type, int lineno)
 /**
  * define_line: check whether or not this is a define line.
  *
+ *	@param[in]	anc	anchor table
  *	@param[in]	lineno	line number
  *	@return		1: definition, 0: not definition
- *	Globals used (output):
- *		curp	pointer to the current cluster
+ *	Output:
+ *		anc->curp	pointer to the current cluster
  */
 int
-define_line(int lineno)
+define_line(ANCHOR *anc, int lineno)
 {
-	struct anchor *p = curp ? curp : start;
+	struct anchor *p = anc->curp ? anc->curp : anc->start;
+	struct anchor *end = anc->end;
 
-	if (table == NULL)
+	if (anc->table == NULL)
 		return 0;
 	if (p->lineno > lineno)
 		return 0;
@@ -326,7 +349,7 @@ define_line(int lineno)
 		;
 	if (p >= end || p->lineno != lineno)
 		return 0;
-	curp = p;
+	anc->curp = p;
 	for (; p < end && p->lineno == lineno; p++)
 		if (p->type == 'D')
 			return 1;
@@ -336,12 +359,16 @@ define_line(int lineno)
  * anchor_getlinks: return anchor link array
  *		(previous, next, first, last, top, bottom)
  *
+ *	@param[in]	anc	anchor table
  *	@param[in]	lineno	line number
+ *	@return		link array, valid until the next call with anc
  */
 int *
-anchor_getlinks(int lineno)
+anchor_getlinks(ANCHOR *anc, int lineno)
 {
-	static int ref[A_SIZE];
+	int *ref = anc->ref;
+	struct anchor *start = anc->start, *end = anc->end;
+	int first = anc->first, last = anc->last;
 	int i;
 
 	for (i = 0; i < A_SIZE; i++)
@@ -349,13 +376,13 @@ anchor_getlinks(int lineno)
 	if (lineno >= 1 && start) {
 		struct anchor *c, *p;
 
-		if (CURRENTDEF == NULL) {
+		if (anc->currentdef == NULL) {
 			for (c = start; c < end; c++)
 				if (c->lineno == lineno && c->type == 'D')
 					break;
-			CURRENTDEF = c;
+			anc->currentdef = c;
 		} else {
-			for (c = CURRENTDEF; c >= start; c--)
+			for (c = anc->currentdef; c >= start; c--)
 				if (c->lineno == lineno && c->type == 'D')
 					break;
 		}
@@ -370,15 +397,15 @@ anchor_getlinks(int lineno)
 				break;
 			}
 	}
-	if (FIRST > 0 && lineno != FIRST)
-		ref[A_FIRST] = FIRST;
-	if (LAST > 0 && lineno != LAST)
-		ref[A_LAST] = LAST;
+	if (first > 0 && lineno != first)
+		ref[A_FIRST] = first;
+	if (last > 0 && lineno != last)
+		ref[A_LAST] = last;
 	if (lineno != 0)
 		ref[A_TOP] = -1;
 	if (lineno != -1)
 		ref[A_BOTTOM] = -2;
-	if (FIRST > 0 && FIRST == LAST) {
+	if (first > 0 && first == last) {
 		if (lineno == 0)
 			ref[A_LAST] = 0;
 		if (lineno == -1)
@@ -387,13 +414,13 @@ anchor_getlinks(int lineno)
 	return ref;
 }
 void
-anchor_dump(FILE *op, int lineno)
+anchor_dump(ANCHOR *anc, FILE *op, int lineno)
 {
 	struct anchor *a;
 
 	if (op == NULL)
 		op = stderr;
-	for (a = start; a < end ; a++)
+	for (a = anc->start; a < anc->end ; a++)
 		if (lineno == 0 || a->lineno == lineno)
 			fprintf(op, "%d %s(%c)\n",
 				a->lineno, gettag(a), a->type);
@@ -20,6 +20,7 @@
 #define _ANCHOR_H_
 
 #include "checkalloc.h"
+#include "varray.h"
 /*
  * Anchor table.
  *
@@ -63,14 +64,35 @@ struct anchor {
 #define A_HELP		7
 #define A_LIMIT		8
 
+/*
+ * Anchor table of the file being converted.
+ *
+ * Each conversion context (SRCCONV) has its own ANCHOR, so that
+ * the anchors of a file are not shared with other conversions.
+ */
+typedef struct {
+	VARRAY *vb;			/**< storage of the table */
+	struct anchor *table;		/**< sorted by lineno */
+	struct anchor *start;		/**< loop range */
+	struct anchor *end;
+	struct anchor *curp;		/**< current cluster */
+	struct anchor *current;		/**< for anchor_first() and anchor_next() */
+	struct anchor *currentdef;	/**< current definition */
+	int first;			/**< lineno of the first definition */
+	int last;			/**< lineno of the last definition */
+	int ref[A_SIZE];		/**< result of anchor_getlinks() */
+} ANCHOR;
+
 void anchor_prepare(FILE *);
-void anchor_load(const char *);
-void anchor_unload(void);
-struct anchor *anchor_first(void);
-struct anchor *anchor_next(void);
-struct anchor *anchor_get(const char *, int, int, int);
-int define_line(int);
-int *anchor_getlinks(int);
-void anchor_dump(FILE *, int);
+ANCHOR *anchor_open(void);
+void anchor_close(ANCHOR *);
+void anchor_load(ANCHOR *, const char *);
+void anchor_unload(ANCHOR *);
+struct anchor *anchor_first(ANCHOR *);
+struct anchor *anchor_next(ANCHOR *);
+struct anchor *anchor_get(ANCHOR *, const char *, int, int, int);
+int define_line(ANCHOR *, int);
+int *anchor_getlinks(ANCHOR *, int);
+void anchor_dump(ANCHOR *, FILE *, int);
 
 #endif /* _ANCHOR_H_ */
@@ -349,6 +349,19 @@ gen_page_begin(const char *title, int place)
 {
 	return gen_page_generic_begin(title, place, 0, NULL);
 }
+/**
+ * Generate beginning of normal page with a header item
+ *
+ *	@param[in]	title	title of this page
+ *	@param[in]	place	SUBDIR: this page is in sub directory,
+ *			TOPDIR: this page is in the top directory
+ *	@param[in]	header_item	an item which should be inserted into the header
+ */
+const char *
+gen_page_begin_with_item(const char *title, int place, const char *header_item)
+{
+	return gen_page_generic_begin(title, place, 0, header_item);
+}
 /**
  * beginning of normal page for index page
  *
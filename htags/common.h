@@ -131,6 +131,7 @@ const char *upperdir(const char *);
 const char *gen_insert_header(int);
 const char *gen_insert_footer(int);
 const char *gen_page_begin(const char *, int);
+const char *gen_page_begin_with_item(const char *, int, const char *);
 const char *gen_page_index_begin(const char *, const char *);
 const char *gen_page_frameset_begin(const char *);
 const char *gen_page_end(void);
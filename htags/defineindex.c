@@ -35,7 +35,223 @@
 #include "htags.h"
 #include "path2url.h"
 #include "common.h"
+#include "manifest.h"
 
+/*
+ * Stuff for the split index (--split-index option).
+ *
+ * The definition index (defines.html, or each page of the alphabetical
+ * index with the -a option) is continued to 'defines/<name>-<n>.html'
+ * every split_index items. See manifest.c for the details.
+ */
+static const char *indexlink;
+static const char *index_string = "Index Page";
+static int shard;			/**< shard number of the current page */
+static int shard_items;			/**< number of items in the current page */
+static char shard_first[IDENTLEN];	/**< first tag in the current page */
+static char shard_last[IDENTLEN];	/**< last tag in the current page */
+
+static void begin_defines_page(FILE *, const char *);
+static void end_defines_page(FILE *, const char *, int);
+static void begin_alpha_page(FILE *, const char *);
+static void end_alpha_page(FILE *, const char *, int);
+static void put_shard(const char *, const char *);
+static const char *shard_url(const char *, int, int);
+
+/**
+ * begin_defines_page: print the head of the definition index
+ *
+ *	@param[in]	op	output
+ *	@param[in]	name	file name without suffix (e.g. "defines")
+ *
+ * The second and later shard is placed in the 'defines' directory.
+ */
+static void
+begin_defines_page(FILE *op, const char *name)
+{
+	const char *dir = (shard > 1) ? ".." : NULL;
+	const char *link = (shard > 1) ? "../mains" : indexlink;
+
+	if (!split_index)
+		fputs_nl(gen_page_begin(title_define_index, TOPDIR), op);
+	else if (shard > 1)
+		fputs_nl(gen_page_begin_with_item(title_define_index, SUBDIR, gen_shard_script("../defines.json")), op);
+	else
+		fputs_nl(gen_page_begin_with_item(title_define_index, TOPDIR, aflag ? NULL : gen_shard_script("defines.json")), op);
+	fputs_nl(body_begin, op);
+	fputs(header_begin, op);
+	if (Fflag)
+		fputs(gen_href_begin(dir, name, normal_suffix, NULL), op);
+	fputs(title_define_index, op);
+	if (Fflag)
+		fputs(gen_href_end(), op);
+	fputs_nl(header_end, op);
+	if (!aflag && !Fflag) {
+		fputs(gen_href_begin_with_title(NULL, link, normal_suffix, NULL, index_string), op);
+		if (Iflag)
+			fputs(gen_image(shard > 1 ? PARENT : CURRENT, back_icon, ".."), op);
+		else
+			fputs("[..]", op);
+		fputs_nl(gen_href_end(), op);
+	}
+	if (!aflag) {
+		if (split_index)
+			fputs_nl(shard_list_begin, op);
+		if (!no_order_list)
+			fputs_nl(list_begin, op);
+	}
+}
+/**
+ * end_defines_page: print the tail of the definition index
+ *
+ *	@param[in]	op	output
+ *	@param[in]	name	file name without suffix (e.g. "defines")
+ *	@param[in]	next	1: the next shard follows
+ */
+static void
+end_defines_page(FILE *op, const char *name, int next)
+{
+	if (!no_order_list && !aflag)
+		fputs_nl(list_end, op);
+	if (split_index && !aflag) {
+		char prev[MAXPATHLEN];
+
+		fputs_nl(shard_list_end, op);
+		if (shard > 1 || next) {
+			strlimcpy(prev, shard_url(name, shard - 1, shard), sizeof(prev));
+			fputs_nl(gen_shard_navi(shard > 1 ? prev : NULL,
+				next ? shard_url(name, shard + 1, shard) : NULL), op);
+		}
+	}
+	if (!aflag && !Fflag) {
+		fputs(gen_href_begin_with_title(NULL, shard > 1 ? "../mains" : "mains", normal_suffix, NULL, index_string), op);
+		if (Iflag)
+			fputs(gen_image(shard > 1 ? PARENT : CURRENT, back_icon, ".."), op);
+		else
+			fputs("[..]", op);
+		fputs_nl(gen_href_end(), op);
+	}
+	fputs_nl(body_end, op);
+	fputs_nl(gen_page_end(), op);
+}
+/**
+ * begin_alpha_page: print the head of a page of the alphabetical index
+ *
+ *	@param[in]	op	output
+ *	@param[in]	alpha	index char
+ */
+static void
+begin_alpha_page(FILE *op, const char *alpha)
+{
+	char buf[1024];
+
+	snprintf(buf, sizeof(buf), "[%s]", alpha);
+	if (split_index)
+		fputs_nl(gen_page_begin_with_item(buf, SUBDIR, gen_shard_script("../defines.json")), op);
+	else
+		fputs_nl(gen_page_begin(buf, SUBDIR), op);
+	fputs_nl(body_begin, op);
+	fprintf(op, "%s[%s]%s\n", header_begin, alpha, header_end);
+	fputs(gen_href_begin_with_title(NULL, indexlink, normal_suffix, NULL, index_string), op);
+	if (Iflag)
+		fputs(gen_image(PARENT, back_icon, ".."), op);
+	else
+		fputs("[..]", op);
+	fputs_nl(gen_href_end(), op);
+	if (split_index)
+		fputs_nl(shard_list_begin, op);
+	if (!no_order_list)
+		fputs_nl(list_begin, op);
+	else
+		fprintf(op, "%s%s\n", br, br);
+}
+/**
+ * end_alpha_page: print the tail of a page of the alphabetical index
+ *
+ *	@param[in]	op	output
+ *	@param[in]	name	file name without suffix (e.g. "A")
+ *	@param[in]	next	1: the next shard follows
+ */
+static void
+end_alpha_page(FILE *op, const char *name, int next)
+{
+	if (!no_order_list)
+		fputs_nl(list_end, op);
+	else
+		fputs_nl(br, op);
+	if (split_index) {
+		char prev[MAXPATHLEN];
+
+		fputs_nl(shard_list_end, op);
+		if (shard > 1 || next) {
+			strlimcpy(prev, shard_url(name, shard - 1, shard), sizeof(prev));
+			fputs_nl(gen_shard_navi(shard > 1 ? prev : NULL,
+				next ? shard_url(name, shard + 1, shard) : NULL), op);
+		}
+	}
+	fputs(gen_href_begin_with_title(NULL, indexlink, normal_suffix, NULL, index_string), op);
+	if (Iflag)
+		fputs(gen_image(PARENT, back_icon, ".."), op);
+	else
+		fputs("[..]", op);
+	fputs_nl(gen_href_end(), op);
+	fputs_nl(body_end, op);
+	fputs_nl(gen_page_end(), op);
+}
+/**
+ * put_shard: record the current page in the manifest
+ *
+ *	@param[in]	group	group of the page
+ *	@param[in]	name	name of the first page of the group
+ */
+static void
+put_shard(const char *group, const char *name)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	if (aflag || shard > 1)
+		strbuf_sprintf(sb, "defines/%s.%s", shard_name(name, shard), HTML);
+	else
+		strbuf_sprintf(sb, "%s.%s", name, normal_suffix);
+	manifest_put(strbuf_value(sb), group, shard_first, shard_last, shard_items);
+}
+/**
+ * shard_url: url of a shard from another shard
+ *
+ *	@param[in]	name	name of the first page of the group
+ *	@param[in]	n	shard number
+ *	@param[in]	from	shard number of the page which refers the url
+ */
+static const char *
+shard_url(const char *name, int n, int from)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	if (aflag || (n > 1 && from > 1))
+		strbuf_sprintf(sb, "%s.%s", shard_name(name, n), HTML);
+	else if (n > 1)
+		strbuf_sprintf(sb, "defines/%s.%s", shard_name(name, n), HTML);
+	else
+		strbuf_sprintf(sb, "../%s.%s", name, normal_suffix);
+	return strbuf_value(sb);
+}
+/**
+ * shard_path: path of a shard in the distribution directory
+ *
+ *	@param[in]	name	name of the first page of the group
+ *	@param[in]	n	shard number
+ */
+static const char *
+shard_path(const char *name, int n)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	strbuf_sprintf(sb, "defines/%s.%s", shard_name(name, n), HTML);
+	return makepath(distpath, strbuf_value(sb), NULL);
+}
 /*
  * makedefineindex: make definition index (including alphabetic index)
  *
@@ -57,9 +273,7 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 	STRBUF *url = strbuf_open(0);
 	/* Index link */
 	const char *target = (Fflag) ? "mains" : "_top";
-	const char *indexlink;
-	const char *index_string = "Index Page";
-	char command[1024], buf[1024], alpha[32], alpha_f[32], *_;
+	char command[1024], alpha[32], alpha_f[32], name[32], *_;
 
 	if (!aflag && !Fflag)
 		indexlink = "mains";
@@ -67,6 +281,14 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 		indexlink = "../defines";
 	else
 		indexlink = "../mains";
+	/* the base name of the definition index (e.g. "defines") */
+	strlimcpy(name, file, sizeof(name));
+	if ((_ = locatestring(name, ".", MATCH_LAST)) != NULL)
+		*_ = '\0';
+	shard = 1;
+	shard_items = 0;
+	if (split_index)
+		manifest_open("defines.json");
 
 	if (map_file) {
 		fileop_MAP = open_output_file(makepath(distpath, "MAP", NULL), 0);
@@ -74,27 +296,7 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 	}
 	fileop_DEFINES = open_output_file(makepath(distpath, file, NULL), 0);
 	DEFINES = get_descripter(fileop_DEFINES);
-	fputs_nl(gen_page_begin(title_define_index, TOPDIR), DEFINES);
-	fputs_nl(body_begin, DEFINES);
-	fputs(header_begin, DEFINES);
-	if (Fflag)
-		fputs(gen_href_begin(NULL, "defines", normal_suffix, NULL), DEFINES);
-	fputs(title_define_index, DEFINES);
-	if (Fflag)
-		fputs(gen_href_end(), DEFINES);
-	fputs_nl(header_end, DEFINES);
-	if (!aflag && !Fflag) {
-		fputs(gen_href_begin_with_title(NULL, indexlink, normal_suffix, NULL, index_string), DEFINES);
-		if (Iflag)
-			fputs(gen_image(CURRENT, back_icon, ".."), DEFINES);
-		else
-			fputs("[..]", DEFINES);
-		fputs_nl(gen_href_end(), DEFINES);
-	}
-	if (!aflag) {
-		if (!no_order_list)
-			fputs_nl(list_begin, DEFINES);
-	}
+	begin_defines_page(DEFINES, name);
 	/*
 	 * map DEFINES to STDOUT.
 	 */
@@ -121,20 +323,11 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 				strbuf_sprintf(defines, "[%s]", alpha);
 				strbuf_puts_nl(defines, gen_href_end());
 				alpha_count = 0;
-				if (!no_order_list)
-					fputs_nl(list_end, ALPHA);
-				else
-					fputs_nl(br, ALPHA);
-				fputs(gen_href_begin_with_title(NULL, indexlink, normal_suffix, NULL, index_string), ALPHA);
-				if (Iflag)
-					fputs(gen_image(PARENT, back_icon, ".."), ALPHA);
-				else
-					fputs("[..]", ALPHA);
-				fputs_nl(gen_href_end(), ALPHA);
-				fputs_nl(body_end, ALPHA);
-				fputs_nl(gen_page_end(), ALPHA);
+				end_alpha_page(ALPHA, alpha_f, 0);
 				close_file(fileop_ALPHA);
 				html_count++;
+				if (split_index)
+					put_shard(alpha, alpha_f);
 			}
 			/*
 			 * setup index char (for example, 'a' of '[a]').
@@ -170,26 +363,45 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 				alpha[1] = '\0';
 				snprintf(alpha_f, sizeof(alpha_f), "%03d", c);
 			}
-			snprintf(buf, sizeof(buf), "%s/defines/%s.%s", distpath, alpha_f, HTML);
-			fileop_ALPHA = open_output_file(buf, 0);
+			fileop_ALPHA = open_output_file(shard_path(alpha_f, 1), 0);
 			ALPHA = get_descripter(fileop_ALPHA);
-			snprintf(buf, sizeof(buf), "[%s]", alpha);
-			fputs_nl(gen_page_begin(buf, SUBDIR), ALPHA);
-			fputs_nl(body_begin, ALPHA);
-			fprintf(ALPHA, "%s[%s]%s\n", header_begin, alpha, header_end);
-			fputs(gen_href_begin_with_title(NULL, indexlink, normal_suffix, NULL, index_string), ALPHA);
-			if (Iflag)
-				fputs(gen_image(PARENT, back_icon, ".."), ALPHA);
-			else
-				fputs("[..]", ALPHA);
-			fputs_nl(gen_href_end(), ALPHA);
-			if (!no_order_list)
-				fputs_nl(list_begin, ALPHA);
-			else
-				fprintf(ALPHA, "%s%s\n", br, br);
+			shard = 1;
+			shard_items = 0;
+			begin_alpha_page(ALPHA, alpha);
 			STDOUT = ALPHA;
+		} else if (split_index && shard_items >= split_index) {
+			/*
+			 * Continue to the next shard.
+			 */
+			if (aflag) {
+				end_alpha_page(ALPHA, alpha_f, 1);
+				close_file(fileop_ALPHA);
+				html_count++;
+				put_shard(alpha, alpha_f);
+				shard++;
+				fileop_ALPHA = open_output_file(shard_path(alpha_f, shard), 0);
+				ALPHA = get_descripter(fileop_ALPHA);
+				begin_alpha_page(ALPHA, alpha);
+				STDOUT = ALPHA;
+			} else {
+				end_defines_page(DEFINES, name, 1);
+				close_file(fileop_DEFINES);
+				html_count++;
+				put_shard("", name);
+				shard++;
+				fileop_DEFINES = open_output_file(shard_path(name, shard), 0);
+				DEFINES = get_descripter(fileop_DEFINES);
+				begin_defines_page(DEFINES, name);
+				STDOUT = DEFINES;
+			}
+			shard_items = 0;
 		}
 		alpha_count++;
+		if (split_index) {
+			if (shard_items++ == 0)
+				strlimcpy(shard_first, tag, sizeof(shard_first));
+			strlimcpy(shard_last, tag, sizeof(shard_last));
+		}
 		/*
 		 * generating url for function definition.
 	 	 */
@@ -208,12 +420,12 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 			snprintf(url_for_map, sizeof(url_for_map), "%s/%s.%s",
 				DEFS, fid, HTML);
 			if (dynamic) {
-				if (*action != '/' && aflag)
+				if (*action != '/' && (aflag || shard > 1))
 					strbuf_puts(url, "../");
 				strbuf_puts(url, action);
 				strbuf_sprintf(url, "?pattern=%s%stype=definitions", tag, quote_amp);
 			} else {
-				if (aflag)
+				if (aflag || shard > 1)
 					strbuf_puts(url, "../");
 				strbuf_sprintf(url, "%s/%s.%s", DEFS, fid, HTML);
 			}
@@ -226,7 +438,7 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 			path += 2;		/* remove './' */
 			snprintf(url_for_map, sizeof(url_for_map), "%s/%s.%s#L%s",
 				SRCS, fid, HTML, lno);
-			if (aflag)
+			if (aflag || shard > 1)
 				strbuf_puts(url, "../");
 			strbuf_sprintf(url, "%s/%s.%s#L%s", SRCS, fid, HTML, lno);
 			snprintf(guide, sizeof(guide), "Defined at %s in %s.", lno, path);
@@ -254,37 +466,22 @@ makedefineindex(const char *file, int total, STRBUF *defines)
 		strbuf_puts(defines, gen_href_begin_with_title("defines", alpha_f, HTML, NULL, tmp));
 		strbuf_sprintf(defines, "[%s]", alpha);
 		strbuf_puts_nl(defines, gen_href_end());
-		if (!no_order_list)
-			fputs_nl(list_end, ALPHA);
-		else
-			fputs_nl(br, ALPHA);
-		fputs(gen_href_begin_with_title(NULL, indexlink, normal_suffix, NULL, index_string), ALPHA);
-		if (Iflag)
-			fputs(gen_image(PARENT, back_icon, ".."), ALPHA);
-		else
-			fputs("[..]", ALPHA);
-		fputs_nl(gen_href_end(), ALPHA);
-		fputs_nl(body_end, ALPHA);
-		fputs_nl(gen_page_end(), ALPHA);
+		end_alpha_page(ALPHA, alpha_f, 0);
 		close_file(fileop_ALPHA);
 		html_count++;
+		if (split_index)
+			put_shard(alpha, alpha_f);
 
 		fputs(strbuf_value(defines), DEFINES);
 	}
-	if (!no_order_list && !aflag)
-		fputs_nl(list_end, DEFINES);
-	if (!aflag && !Fflag) {
-		fputs(gen_href_begin_with_title(NULL, "mains", normal_suffix, NULL, index_string), DEFINES);
-		if (Iflag)
-			fputs(gen_image(CURRENT, back_icon, ".."), DEFINES);
-		else
-			fputs("[..]", DEFINES);
-		fputs_nl(gen_href_end(), DEFINES);
-	}
-	fputs_nl(body_end, DEFINES);
-	fputs_nl(gen_page_end(), DEFINES);
+	end_defines_page(DEFINES, name, 0);
 	close_file(fileop_DEFINES);
 	html_count++;
+	if (split_index) {
+		if (!aflag && shard_items > 0)
+			put_shard("", name);
+		manifest_close();
+	}
 	if (map_file)
 		close_file(fileop_MAP);
 	strbuf_close(sb);
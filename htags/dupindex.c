@@ -21,7 +21,6 @@
 #include <config.h>
 #endif
 #include <stdio.h>
-#include <errno.h>
 #ifdef HAVE_STRING_H
 #include <string.h>
 #else
@@ -29,8 +28,12 @@
 #endif
 #include "cache.h"
 #include "common.h"
+#include "convert.h"
+#include "encodepath.h"
+#include "format.h"
 #include "global.h"
 #include "htags.h"
+#include "output.h"
 
 /*
  * Data for each tag file.
@@ -39,8 +42,148 @@
  */
 static const char *dirs[]    = {NULL, DEFS,         REFS,        SYMS};
 static const char *kinds[]   = {NULL, "definition", "reference", "symbol"};
-static const char *options[] = {NULL, "",           "r",         "s"};
 
+/*
+ * The tag file is read directly through the GTOP interface in the
+ * order of the key, instead of reading the output of global(1) through
+ * a pipe. Since the records of a tag are adjacent to each other, only
+ * the records of the current tag are kept in memory. A list page is
+ * built in memory and written at once when the tag changes.
+ */
+static CONVERT *cv;
+static int db;				/**< current tag file */
+static int writing;			/**< the list page is being built */
+static int count;			/**< number of tags */
+static int entry_count;			/**< number of records of the tag */
+static char prev[IDENTLEN];		/**< current tag */
+static char first_line[MAXBUFLEN];	/**< first record of the tag */
+static char srcdir[MAXPATHLEN];
+static STRBUF *record;			/**< record in ctags-xid format */
+static STRBUF *page;			/**< list page */
+static STRBUF *tmp;
+
+static void put_record(const char *, const char *, int, const char *, const char *);
+static void put_tag(int);
+
+/**
+ * put_tag: complete the current tag.
+ *
+ *	@param[in]	id	id of the list page
+ *
+ * The cache record is made for the tag, and the list page is written
+ * if it has two or more records.
+ */
+static void
+put_tag(int id)
+{
+	if (writing) {
+		if (!dynamic) {
+			strbuf_puts_nl(page, gen_list_end());
+			strbuf_puts_nl(page, body_end);
+			strbuf_puts_nl(page, gen_page_end());
+			strbuf_reset(tmp);
+			strbuf_sprintf(tmp, "%s/%s/%d.%s", distpath, dirs[db], id, HTML);
+			write_output_file(strbuf_value(tmp), strbuf_value(page), strbuf_getlen(page));
+			html_count++;
+		}
+		writing = 0;
+		/*
+		 * cache record: " <fid>\0<entry number>\0"
+		 */
+		strbuf_reset(tmp);
+		strbuf_putc(tmp, ' ');
+		strbuf_putn(tmp, id);
+		strbuf_putc(tmp, '\0');
+		strbuf_putn(tmp, entry_count);
+		cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+	}
+	/* single entry */
+	if (first_line[0]) {
+		char fid[MAXFIDLEN];
+		const char *ctags_x = parse_xid(first_line, fid, NULL);
+		const char *lno = nextelement(ctags_x);
+
+		strbuf_reset(tmp);
+		strbuf_puts_withterm(tmp, lno, ' ');
+		strbuf_putc(tmp, '\0');
+		strbuf_puts(tmp, fid);
+		cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
+		first_line[0] = 0;
+	}
+}
+/**
+ * put_record: receive a record from the convert filter.
+ *
+ *	@param[in]	tag	tag name
+ *	@param[in]	path	path name
+ *	@param[in]	lineno	line number
+ *	@param[in]	rest	line image
+ *	@param[in]	fid	file id
+ *
+ * The record is formatted in the same way as 'global --result=ctags-xid'.
+ */
+static void
+put_record(const char *tag, const char *path, int lineno, const char *rest, const char *fid)
+{
+	const char *ctags_xid, *ctags_x;
+	int n;
+
+	if (fid == NULL) {
+		fid = gpath_path2fid(path, NULL);
+		if (fid == NULL)
+			die("put_record: unknown file. '%s'", path);
+	}
+	path = convert_pathname(cv, path);
+	strbuf_reset(record);
+	strbuf_puts(record, fid);
+	strbuf_putc(record, ' ');
+	strbuf_puts(record, tag);
+	for (n = strlen(tag); n < 16; n++)
+		strbuf_putc(record, ' ');
+	strbuf_sprintf(record, " %4d ", lineno);
+	strbuf_puts(record, path);
+	for (n = strlen(path); n < 16; n++)
+		strbuf_putc(record, ' ');
+	strbuf_putc(record, ' ');
+	strbuf_puts(record, rest);
+	ctags_xid = strbuf_value(record);
+	ctags_x = nextelement(ctags_xid);
+
+	if (strcmp(prev, tag)) {
+		count++;
+		if (vflag)
+			fprintf(stderr, " [%d] adding %s %s\n", count, kinds[db], tag);
+		put_tag(count - 1);
+		/*
+		 * Chop the tail of the line. It is not important.
+		 * strlimcpy(first_line, ctags_x, sizeof(first_line));
+		 */
+		strncpy(first_line, ctags_xid, sizeof(first_line));
+		first_line[sizeof(first_line) - 1] = '\0';
+		strlimcpy(prev, tag, sizeof(prev));
+		entry_count = 0;
+	} else {
+		/* duplicate entry */
+		if (first_line[0]) {
+			char first_fid[MAXFIDLEN];
+			const char *first_ctags_x = parse_xid(first_line, first_fid, NULL);
+
+			if (!dynamic) {
+				strbuf_reset(page);
+				strbuf_puts_nl(page, gen_page_begin(tag, SUBDIR));
+				strbuf_puts_nl(page, body_begin);
+				strbuf_puts_nl(page, gen_list_begin());
+				strbuf_puts_nl(page, gen_list_body(srcdir, first_ctags_x, first_fid));
+			}
+			writing = 1;
+			entry_count++;
+			first_line[0] = 0;
+		}
+		if (!dynamic)
+			strbuf_puts_nl(page, gen_list_body(srcdir, ctags_x, fid));
+		entry_count++;
+	}
+}
 /**
  * Make duplicate object index.
  *
@@ -51,164 +194,45 @@ static const char *options[] = {NULL, "",           "r",         "s"};
 int
 makedupindex(void)
 {
-	STRBUF *sb = strbuf_open(0);
-	STRBUF *tmp = strbuf_open(0);
-	STRBUF *command = strbuf_open(0);
 	int definition_count = 0;
-	char srcdir[MAXPATHLEN];
-	int db;
-	FILEOP *fileop = NULL;
-	FILE *op = NULL;
-	FILE *ip = NULL;
 
+	record = strbuf_open(0);
+	page = strbuf_open(0);
+	tmp = strbuf_open(0);
 	snprintf(srcdir, sizeof(srcdir), "../%s", SRCS);
+	set_encode_chars((unsigned char *)" \t");
 	for (db = GTAGS; db < GTAGLIM; db++) {
-		const char *kind = kinds[db];
-		const char *option = options[db];
-		int writing = 0;
-		int count = 0;
-		int entry_count = 0;
-		const char *ctags_xid, *ctags_x;
-		char tag[IDENTLEN], prev[IDENTLEN], first_line[MAXBUFLEN];
+		GTOP *gtop;
+		GTP *gtp;
+		int flags = 0;
 
 		if (gtags_exist[db] == 0)
 			continue;
+		writing = 0;
+		count = 0;
+		entry_count = 0;
 		prev[0] = 0;
 		first_line[0] = 0;
-		/*
-		 * construct command line.
-		 */
-		strbuf_reset(command);
-#if defined(_WIN32) && !defined(__CYGWIN__)
-		strbuf_putc(command, '"');
-#endif
-		strbuf_sprintf(command, "%s -x%s --result=ctags-xid --encode-path=\" \t\" --nofilter=path", quote_shell(global_path), option);
 		/*
 		 * Optimization when the --dynamic option is specified.
 		 */
-		if (dynamic) {
-			strbuf_puts(command, " --nosource");
-			if (db != GSYMS)
-				strbuf_puts(command, " --nofilter=sort");
-		}
-		strbuf_puts(command, " \".*\"");
-#if defined(_WIN32) && !defined(__CYGWIN__)
-		strbuf_putc(command, '"');
-#endif
-		if ((ip = popen(strbuf_value(command), "r")) == NULL)
-			die("cannot execute '%s'.", strbuf_value(command));
-		while ((ctags_xid = strbuf_fgets(sb, ip, STRBUF_NOCRLF)) != NULL) {
-			char fid[MAXFIDLEN];
-
-			ctags_x = parse_xid(ctags_xid, fid, NULL);
-			/* tag name */
-			(void)strcpy_withterm(tag, ctags_x, sizeof(tag), ' ');
-			if (strcmp(prev, tag)) {
-				count++;
-				if (vflag)
-					fprintf(stderr, " [%d] adding %s %s\n", count, kind, tag);
-				if (writing) {
-					if (!dynamic) {
-						fputs_nl(gen_list_end(), op);
-						fputs_nl(body_end, op);
-						fputs_nl(gen_page_end(), op);
-						close_file(fileop);
-						html_count++;
-					}
-					writing = 0;
-					/*
-					 * cache record: " <fid>\0<entry number>\0"
-					 */
-					strbuf_reset(tmp);
-					strbuf_putc(tmp, ' ');
-					strbuf_putn(tmp, count - 1);
-					strbuf_putc(tmp, '\0');
-					strbuf_putn(tmp, entry_count);
-					cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
-				}				
-				/* single entry */
-				if (first_line[0]) {
-					char fid[MAXFIDLEN];
-					const char *ctags_x = parse_xid(first_line, fid, NULL);
-					const char *lno = nextelement(ctags_x);
-
-					strbuf_reset(tmp);
-					strbuf_puts_withterm(tmp, lno, ' ');
-					strbuf_putc(tmp, '\0');
-					strbuf_puts(tmp, fid);
-					cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
-				}
-				/*
-				 * Chop the tail of the line. It is not important.
-				 * strlimcpy(first_line, ctags_x, sizeof(first_line));
-				 */
-				strncpy(first_line, ctags_xid, sizeof(first_line));
-				first_line[sizeof(first_line) - 1] = '\0';
-				strlimcpy(prev, tag, sizeof(prev));
-				entry_count = 0;
-			} else {
-				/* duplicate entry */
-				if (first_line[0]) {
-					char fid[MAXFIDLEN];
-					const char *ctags_x = parse_xid(first_line, fid, NULL);
-
-					if (!dynamic) {
-						char path[MAXPATHLEN];
-
-						snprintf(path, sizeof(path), "%s/%s/%d.%s", distpath, dirs[db], count, HTML);
-						fileop = open_output_file(path, 0);
-						op = get_descripter(fileop);
-						fputs_nl(gen_page_begin(tag, SUBDIR), op);
-						fputs_nl(body_begin, op);
-						fputs_nl(gen_list_begin(), op);
-						fputs_nl(gen_list_body(srcdir, ctags_x, fid), op);
-					}
-					writing = 1;
-					entry_count++;
-					first_line[0] = 0;
-				}
-				if (!dynamic) {
-					fputs_nl(gen_list_body(srcdir, ctags_x, fid), op);
-				}
-				entry_count++;
-			}
-		}
+		if (dynamic && db != GSYMS)
+			flags |= GTOP_NOSORT;
+		start_output(FORMAT_CTAGS_XID, dynamic);
+		gtop = gtags_open(dbpath, cwdpath, db, GTAGS_READ, 0);
+		cv = convert_open(PATH_THROUGH, FORMAT_CTAGS_XID, cwdpath, cwdpath, dbpath, NULL, db);
+		cv->hook = put_record;
+		for (gtp = gtags_first(gtop, NULL, flags); gtp; gtp = gtags_next(gtop))
+			output_with_formatting(cv, gtp, cwdpath, gtop->format);
+		convert_close(cv);
+		gtags_close(gtop);
+		end_output();
 		if (db == GTAGS)
 			definition_count = count;
-		if (pclose(ip) != 0)
-			die("terminated abnormally '%s' (errno = %d).", strbuf_value(command), errno);
-		if (writing) {
-			if (!dynamic) {
-				fputs_nl(gen_list_end(), op);
-				fputs_nl(body_end, op);
-				fputs_nl(gen_page_end(), op);
-				close_file(fileop);
-				html_count++;
-			}
-			/*
-			 * cache record: " <fid>\0<entry number>\0"
-			 */
-			strbuf_reset(tmp);
-			strbuf_putc(tmp, ' ');
-			strbuf_putn(tmp, count);
-			strbuf_putc(tmp, '\0');
-			strbuf_putn(tmp, entry_count);
-			cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
-		}
-		if (first_line[0]) {
-			char fid[MAXFIDLEN];
-			const char *ctags_x = parse_xid(first_line, fid, NULL);
-			const char *lno = nextelement(ctags_x);
-
-			strbuf_reset(tmp);
-			strbuf_puts_withterm(tmp, lno, ' ');
-			strbuf_putc(tmp, '\0');
-			strbuf_puts(tmp, fid);
-			cache_put(db, prev, strbuf_value(tmp), strbuf_getlen(tmp) + 1);
-		}
+		put_tag(count);
 	}
-	strbuf_close(sb);
+	strbuf_close(record);
+	strbuf_close(page);
 	strbuf_close(tmp);
-	strbuf_close(command);
 	return definition_count;
 }
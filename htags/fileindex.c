@@ -38,6 +38,7 @@
 #include "htags.h"
 #include "path2url.h"
 #include "common.h"
+#include "manifest.h"
 
 /*----------------------------------------------------------------------*/
 /* Find list procedures							*/
@@ -308,7 +309,7 @@ giveup:
 /*----------------------------------------------------------------------*/
 static int print_directory(int, char *);
 static void print_directory_header(FILE *, int, const char *);
-static void print_directory_footer(FILE *, int, const char *);
+static void print_directory_footer(FILE *, int, const char *, int, int);
 static const char *print_file_name(int, const char *);
 static const char *print_directory_name(int, const char *, int);
 
@@ -341,6 +342,42 @@ int src_count;
 			 fputs(s, op);				\
 } while (0)
 
+/**
+ * When the --split-index option is specified, the page of a directory
+ * is continued to 'files/<fid>-<n>.html' every split_index items.
+ * See manifest.c for the details.
+ */
+static const char *
+shard_file(const char *fid, int n)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	strbuf_sprintf(sb, "%s.%s", shard_name(fid, n), HTML);
+	return strbuf_value(sb);
+}
+/**
+ * shard_path: path of a shard in the distribution directory
+ */
+static const char *
+shard_path(const char *fid, int n)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	strbuf_sprintf(sb, "files/%s", shard_file(fid, n));
+	return makepath(distpath, strbuf_value(sb), NULL);
+}
+static void
+put_shard(const char *dir, const char *fid, int n, const char *first, const char *last, int items)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	strbuf_sprintf(sb, "files/%s", shard_file(fid, n));
+	manifest_put(strbuf_value(sb), removedotslash(dir), first, last, items);
+}
+
 static int
 print_directory(int level, char *basedir)
 {
@@ -349,12 +386,12 @@ print_directory(int level, char *basedir)
 	FILE *op = NULL;
 	int flist_items = 0;
 	int count = 0;
+	int shard = 1;
+	int shard_items = 0;
+	char shard_first[MAXPATHLEN], shard_last[MAXPATHLEN];
 
 	if (level > 0) {
-		char name[MAXPATHLEN];
-
-		snprintf(name, sizeof(name), "%s/files/%s.%s", distpath, path2fid(basedir), HTML);
-		fileop = open_output_file(name, 0);
+		fileop = open_output_file(shard_path(path2fid(basedir), 1), 0);
 		op = get_descripter(fileop);
 		print_directory_header(op, level, basedir);
 		if (tree_view) {
@@ -384,6 +421,24 @@ print_directory(int level, char *basedir)
 		else {
 			char *slash = strchr(local, '/');
 
+			/*
+			 * Continue to the next shard.
+			 */
+			if (level > 0 && split_index && shard_items >= split_index
+			    && (!table_flist || flist_items % flist_fields == 0)) {
+				char fid[MAXFIDLEN];
+
+				strlimcpy(fid, path2fid(basedir), sizeof(fid));
+				print_directory_footer(op, level, basedir, shard, 1);
+				close_file(fileop);
+				html_count++;
+				put_shard(basedir, fid, shard, shard_first, shard_last, shard_items);
+				shard++;
+				shard_items = 0;
+				fileop = open_output_file(shard_path(fid, shard), 0);
+				op = get_descripter(fileop);
+				print_directory_header(op, level, basedir);
+			}
 			if (table_flist && flist_items++ % flist_fields == 0)
 				PUT(fline_begin);
 			/*
@@ -413,6 +468,11 @@ print_directory(int level, char *basedir)
 				ungetpath();	/* read again by lower level print_directory(). */
 				subcount = print_directory(level + 1, basedir);
 				PUT(print_directory_name(level, basedir, subcount));
+				if (level > 0 && split_index) {
+					if (shard_items++ == 0)
+						strlimcpy(shard_first, appendslash(lastpart(basedir)), sizeof(shard_first));
+					strlimcpy(shard_last, appendslash(lastpart(basedir)), sizeof(shard_last));
+				}
 				count += subcount;
 				/*
 				 * Shrink the basedir.
@@ -442,6 +502,11 @@ print_directory(int level, char *basedir)
 						file_end);
 				}
 				PUT(file_name);
+				if (level > 0 && split_index) {
+					if (shard_items++ == 0)
+						strlimcpy(shard_first, lastpart(path), sizeof(shard_first));
+					strlimcpy(shard_last, lastpart(path), sizeof(shard_last));
+				}
 				if (filemap_file)
 					fprintf(FILEMAP, "%s\t%s/%s.%s\n", removedotslash(path), SRCS, path2fid(path), HTML);
 				count++;
@@ -453,8 +518,10 @@ print_directory(int level, char *basedir)
 	if (flist_items % flist_fields != 0)
 		PUT(fline_end);
 	if (level > 0) {
-		print_directory_footer(op, level, basedir);
+		print_directory_footer(op, level, basedir, shard, 0);
 		close_file(fileop);
+		if (split_index)
+			put_shard(basedir, path2fid(basedir), shard, shard_first, shard_last, shard_items);
 		if (tree_view) {
 			strbuf_puts_nl(files, "</ul>");
 			strbuf_puts_nl(files, dir_end);
@@ -481,7 +548,10 @@ print_directory_header(FILE *op, int level, const char *dir)
 	strbuf_clear(sb);
 	strbuf_puts(sb, removedotslash(dir));
 	strbuf_putc(sb, '/');
-	fputs_nl(gen_page_begin(strbuf_value(sb), SUBDIR), op);
+	if (split_index)
+		fputs_nl(gen_page_begin_with_item(strbuf_value(sb), SUBDIR, gen_shard_script("../files.json")), op);
+	else
+		fputs_nl(gen_page_begin(strbuf_value(sb), SUBDIR), op);
 	fputs_nl(body_begin, op);
 
 	strbuf_clear(sb);
@@ -530,6 +600,8 @@ print_directory_header(FILE *op, int level, const char *dir)
 	else
 		fputs("[..]", op);
 	fputs_nl(gen_href_end(), op);
+	if (split_index)
+		fputs_nl(shard_list_begin, op);
 	if (table_flist)
 		fputs_nl(flist_begin, op);
 	else if (!no_order_list)
@@ -545,9 +617,11 @@ print_directory_header(FILE *op, int level, const char *dir)
  *	@param[in]	op	file index
  *	@param[in]	level	1,2...
  *	@param[in]	dir	directory name
+ *	@param[in]	shard	shard number of this page
+ *	@param[in]	next	1: the next shard follows
  */
 static void
-print_directory_footer(FILE *op, int level, const char *dir)
+print_directory_footer(FILE *op, int level, const char *dir, int shard, int next)
 {
 	const char *parent, *suffix;
 	char parentdir[MAXPATHLEN];
@@ -569,6 +643,16 @@ print_directory_footer(FILE *op, int level, const char *dir)
 		fputs_nl(list_end, op);
 	else
 		fputs_nl(br, op);
+	if (split_index) {
+		char prev[MAXPATHLEN];
+
+		fputs_nl(shard_list_end, op);
+		if (shard > 1 || next) {
+			strlimcpy(prev, shard_file(path2fid(dir), shard - 1), sizeof(prev));
+			fputs_nl(gen_shard_navi(shard > 1 ? prev : NULL,
+				next ? shard_file(path2fid(dir), shard + 1) : NULL), op);
+		}
+	}
 	fputs(gen_href_begin_with_title(NULL, parent, suffix, NULL, "Parent Directory"), op);
 	if (Iflag)
 		fputs(gen_image(PARENT, back_icon, ".."), op);
@@ -687,6 +771,7 @@ int
 makefileindex(const char *file, STRBUF *a_files)
 {
 	STATIC_STRBUF(sb);
+	FILEOP *fileop_files;
 	FILE *filesop;
 	int flags = REG_EXTENDED;
 	/*
@@ -730,8 +815,8 @@ makefileindex(const char *file, STRBUF *a_files)
 	/*
 	 * Write to files.html.
 	 */
-	if ((filesop = fopen(makepath(distpath, file, NULL), "w")) == NULL)
-		die("cannot open file '%s'.", file);
+	fileop_files = open_output_file(makepath(distpath, file, NULL), 0);
+	filesop = get_descripter(fileop_files);
 	fputs_nl(gen_page_index_begin(title_file_index, jscode), filesop);
 	fputs_nl(body_begin, filesop);
 	fputs(header_begin, filesop);
@@ -763,7 +848,11 @@ makefileindex(const char *file, STRBUF *a_files)
 	files = a_files;
 	strcpy(basedir, ".");
 
+	if (split_index)
+		manifest_open("files.json");
 	(void)print_directory(0, basedir);
+	if (split_index)
+		manifest_close();
 	if (tree_view)
 		strbuf_puts(files, tree_end);
 
@@ -781,7 +870,7 @@ makefileindex(const char *file, STRBUF *a_files)
 		fputs_nl(list_end, filesop);
 	fputs_nl(body_end, filesop);
 	fputs_nl(gen_page_end(), filesop);
-	fclose(filesop);
+	close_file(fileop_files);
 	html_count++;
 	return src_count;
 }
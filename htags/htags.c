@@ -39,6 +39,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#include <sys/wait.h>
+#endif
 #include <errno.h>
 
 #include "getopt.h"
@@ -50,13 +53,13 @@
 #include "htags.h"
 #include "incop.h"
 #include "path2url.h"
+#include "src2html.h"
 #include "const.h"
 
 /*
  * htags - generate hypertext (XHTML or HTML) pages from a set of source files.
  */
 
-void src2html(const char *, const char *, int);
 int makedupindex(void);
 int makedefineindex(const char *, int, STRBUF *);
 int makefileindex(const char *, STRBUF *);
@@ -129,6 +132,10 @@ int fixed_guide;			/**< --fixed-guide		*/
 const char *tree_view_type;		/**< --type-view=[type]		*/
 char *auto_completion_limit = "0";	/**< --auto-completion=limit	*/
 int statistics = STATISTICS_STYLE_NONE;	/**< --statistics option		*/
+int gzip_pages;				/**< --gzip option		*/
+int pack_pages;				/**< --pack option		*/
+int split_index;			/**< --split-index option		*/
+int jobs;				/**< --jobs option			*/
 
 int no_order_list;			/**< 1: doesn't use order list	*/
 int other_files;			/**< 1: list other files		*/
@@ -146,6 +153,7 @@ const char *insert_header;		/* --insert-header=<file>	*/
 const char *insert_footer;		/* --insert-footer=<file>	*/
 const char *html_header;		/* --html-header=<file>		*/
 const char *jscode;			/**< javascript code		*/
+const char *shard_jscode;		/**< javascript code for shards	*/
 /*
  * Constant values.
  */
@@ -286,8 +294,10 @@ struct option const long_options[] = {
         {"disable-idutils", no_argument, &enable_idutils, 0},
         {"full-path", no_argument, &full_path, 1},
         {"fixed-guide",  no_argument, &fixed_guide, 1},
+        {"gzip", no_argument, &gzip_pages, 1},
         {"map-file", no_argument, &map_file, 1},
         {"no-order-list", no_argument, &no_order_list, 1},
+        {"pack", no_argument, &pack_pages, 1},
         {"show-position", no_argument, &show_position, 1},
         {"statistics", no_argument, &statistics, STATISTICS_STYLE_TABLE},
         {"suggest", no_argument, &suggest, 1},
@@ -310,6 +320,8 @@ struct option const long_options[] = {
 #define OPT_HTML_HEADER		138
 #define OPT_CALL_TREE		139
 #define OPT_CALLEE_TREE		140
+#define OPT_SPLIT_INDEX		141
+#define OPT_JOBS		142
         {"auto-completion", optional_argument, NULL, OPT_AUTO_COMPLETION},
         {"call-tree", required_argument, NULL, OPT_CALL_TREE},
         {"callee-tree", required_argument, NULL, OPT_CALLEE_TREE},
@@ -323,6 +335,8 @@ struct option const long_options[] = {
         {"insert-footer", required_argument, NULL, OPT_INSERT_FOOTER},
         {"insert-header", required_argument, NULL, OPT_INSERT_HEADER},
         {"item-order", required_argument, NULL, OPT_ITEM_ORDER},
+        {"jobs", required_argument, NULL, OPT_JOBS},
+        {"split-index", required_argument, NULL, OPT_SPLIT_INDEX},
 	{"tabs", required_argument, NULL, OPT_TABS},
         {"tree-view",  optional_argument, NULL, OPT_TREE_VIEW},
         { 0 }
@@ -397,6 +411,7 @@ static void
 make_directory_in_distpath(const char *name)
 {
 	char path[MAXPATHLEN];
+	FILEOP *fileop;
 	FILE *op;
 
 	strlimcpy(path, makepath(distpath, name, NULL), sizeof(path));
@@ -406,13 +421,12 @@ make_directory_in_distpath(const char *name)
 	/*
 	 * Not to publish the directory list.
 	 */
-	op = fopen(makepath(path, "index.html", NULL), "w");
-	if (op == NULL)
-		die("cannot make file '%s'.", makepath(path, "index.html", NULL));
+	fileop = open_output_file(makepath(path, "index.html", NULL), 0);
+	op = get_descripter(fileop);
 	fputs(html_begin, op);
 	fputs(html_end, op);
 	fputc('\n', op);
-	fclose(op);
+	close_file(fileop);
 }
 /**
  * Load file.
@@ -450,11 +464,11 @@ makeprogram(const char *cgidir, const char *file, int perm)
 static void
 makerebuild(const char *file)
 {
+	FILEOP *fileop;
 	FILE *op;
 
-	op = fopen(makepath(distpath, file, NULL), "w");
-	if (!op)
-		die("cannot make rebuild script.");
+	fileop = open_output_file(makepath(distpath, file, NULL), 0);
+	op = get_descripter(fileop);
 	fputs_nl("#!/bin/sh", op);
 	fputs_nl("#", op);
 	fputs_nl("# rebuild.sh: rebuild hypertext with the previous context.", op);
@@ -463,7 +477,7 @@ makerebuild(const char *file)
 	fputs_nl("#\t% sh rebuild.sh", op);
 	fputs_nl("#", op);
 	fprintf(op, "cd %s && GTAGSCONF='%s' htags%s\n", cwdpath, save_config, save_argv);
-        fclose(op);
+        close_file(fileop);
 }
 /**
  * makehelp: make help file
@@ -475,11 +489,11 @@ makehelp(const char *file)
 	const char **icons = anchor_icons;
 	const char **msg   = anchor_msg;
 	int n, last = 7;
+	FILEOP *fileop;
 	FILE *op;
 
-	op = fopen(makepath(distpath, file, NULL), "w");
-	if (!op)
-		die("cannot make help file.");
+	fileop = open_output_file(makepath(distpath, file, NULL), 0);
+	op = get_descripter(fileop);
 	fputs_nl(gen_page_begin("HELP", TOPDIR), op);
 	fputs_nl(body_begin, op);
 	fputs(header_begin, op);
@@ -528,7 +542,7 @@ makehelp(const char *file)
 	fputs_nl(define_list_end, op);
 	fputs_nl(body_end, op);
 	fputs_nl(gen_page_end(), op);
-	fclose(op);
+	close_file(fileop);
 	html_count++;
 }
 /*
@@ -602,11 +616,11 @@ makesearchpart(const char *target)
 static void
 makeindex(const char *file, const char *title, const char *index)
 {
+	FILEOP *fileop;
 	FILE *op;
 
-	op = fopen(makepath(distpath, file, NULL), "w");
-	if (!op)
-		die("cannot make file '%s'.", file);
+	fileop = open_output_file(makepath(distpath, file, NULL), 0);
+	op = get_descripter(fileop);
 	if (Fflag) {
 		fputs_nl(gen_page_frameset_begin(title), op);
 		fputs_nl(gen_frameset_begin("cols='200,*'"), op);
@@ -642,7 +656,7 @@ makeindex(const char *file, const char *title, const char *index)
 		fputs_nl(body_end, op);
 		fputs_nl(gen_page_end(), op);
 	}
-	fclose(op);
+	close_file(fileop);
 	html_count++;
 }
 /**
@@ -654,11 +668,11 @@ makeindex(const char *file, const char *title, const char *index)
 static void
 makemainindex(const char *file, const char *index)
 {
+	FILEOP *fileop;
 	FILE *op;
 
-	op = fopen(makepath(distpath, file, NULL), "w");
-	if (!op)
-		die("cannot make file '%s'.", file);
+	fileop = open_output_file(makepath(distpath, file, NULL), 0);
+	op = get_descripter(fileop);
 	fputs_nl(gen_page_index_begin(title, jscode), op);
 	fputs_nl(body_begin, op);
 	if (insert_header)
@@ -668,7 +682,7 @@ makemainindex(const char *file, const char *index)
 		fputs(gen_insert_footer(TOPDIR), op);
 	fputs_nl(body_end, op);
 	fputs_nl(gen_page_end(), op);
-	fclose(op);
+	close_file(fileop);
 	html_count++;
 }
 /**
@@ -679,17 +693,17 @@ makemainindex(const char *file, const char *index)
 static void
 makesearchindex(const char *file)
 {
+	FILEOP *fileop;
 	FILE *op;
 
-	op = fopen(makepath(distpath, file, NULL), "w");
-	if (!op)
-		die("cannot create file '%s'.", file);
+	fileop = open_output_file(makepath(distpath, file, NULL), 0);
+	op = get_descripter(fileop);
 	fputs_nl(gen_page_index_begin("SEARCH", jscode), op);
 	fputs_nl(body_begin, op);
 	fputs(makesearchpart("mains"), op);
 	fputs_nl(body_end, op);
 	fputs_nl(gen_page_end(), op);
-	fclose(op);
+	close_file(fileop);
 	html_count++;
 }
 /**
@@ -707,14 +721,20 @@ makehtaccess(const char *file, int perm)
 		die("cannot chmod .htaccess skeleton.");
 }
 /**
- * makehtml: make html files
+ * convert_files: convert source files into HTML files.
  *
  *	@param[in]	total	number of files.
+ *	@param[in]	jobs	number of workers
+ *	@param[in]	job	worker number (0 - jobs-1)
+ *
+ * The worker converts the files whose ordinal number is congruent to job
+ * modulo jobs.
  */
 static void
-makehtml(int total)
+convert_files(int total, int jobs, int job)
 {
 	GFIND *gp;
+	SRCCONV *conv;
 	FILE *anchor_stream;
 	const char *path;
 	int count = 0;
@@ -736,6 +756,10 @@ makehtml(int total)
 #endif
 	gp = gfind_open(dbpath, NULL, other_files ? GPATH_BOTH : GPATH_SOURCE, 0);
 	while ((path = gfind_read(gp)) != NULL) {
+		if (gp->type == GPATH_OTHER && !other_files)
+			continue;
+		if (count++ % jobs != job)
+			continue;
 		if (gp->type == GPATH_OTHER)
 			fputc(' ', anchor_stream);
 		fputs(path, anchor_stream);
@@ -749,28 +773,80 @@ makehtml(int total)
 	/*
 	 * For each path in GPATH, convert the path into HTML file.
 	 */
+	count = 0;
+	conv = src2html_open();
 	gp = gfind_open(dbpath, NULL, other_files ? GPATH_BOTH : GPATH_SOURCE, 0);
 	while ((path = gfind_read(gp)) != NULL) {
 		char html[MAXPATHLEN];
 
 		if (gp->type == GPATH_OTHER && !other_files)
 			continue;
+		if (count++ % jobs != job)
+			continue;
 		/*
 		 * load tags belonging to the path.
 		 * The path must be start "./".
 		 */
-		anchor_load(path);
+		anchor_load(conv->anchor, path);
 		/*
 		 * inform the current path name to lex() function.
 		 */
 		save_current_path(path);
-		count++;
 		path += 2;		/* remove './' at the head */
 		message(" [%d/%d] converting %s", count, total, path);
 		snprintf(html, sizeof(html), "%s/%s/%s.%s", distpath, SRCS, path2fid(path), HTML);
-		src2html(path, html, gp->type == GPATH_OTHER);
+		src2html(conv, path, html, gp->type == GPATH_OTHER);
 	}
 	gfind_close(gp);
+	src2html_close(conv);
+}
+/**
+ * makehtml: make html files
+ *
+ *	@param[in]	total	number of files.
+ *
+ * If --jobs option is specified, the files are converted by the worker
+ * processes. The scanners and the anchor table keep their state in the
+ * context of src2html(), but the HTML helpers and the tag cache are still
+ * global, so each worker should be a process.
+ */
+static void
+makehtml(int total)
+{
+#if !defined(_WIN32) || defined(__CYGWIN__)
+	if (jobs > 1) {
+		pid_t *pids = check_calloc(sizeof(pid_t), jobs);
+		int i, status, failed = 0;
+
+		/* the buffered output must not be inherited by the workers */
+		fflush(NULL);
+		for (i = 0; i < jobs; i++) {
+			pids[i] = fork();
+			if (pids[i] < 0)
+				die("cannot fork.");
+			if (pids[i] == 0) {
+				fork_output_policy(i);
+				convert_files(total, jobs, i);
+				close_output_policy();
+				fflush(NULL);
+				_exit(0);
+			}
+		}
+		for (i = 0; i < jobs; i++) {
+			while (waitpid(pids[i], &status, 0) < 0)
+				if (errno != EINTR)
+					die("waitpid failed.");
+			if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+				failed++;
+		}
+		free(pids);
+		if (failed)
+			die("%d worker(s) terminated abnormally.", failed);
+		join_output_policy(jobs);
+		return;
+	}
+#endif
+	convert_files(total, 1, 0);
 }
 /**
  * makecommonpart: make a common part for "mains.html" and "index.html"
@@ -1160,6 +1236,18 @@ main(int argc, char **argv)
 		case OPT_ITEM_ORDER:
 			item_order = optarg;
 			break;
+		case OPT_JOBS:
+			if (atoi(optarg) > 0)
+				jobs = atoi(optarg);
+			else
+				die("--jobs option requires numeric value.");
+			break;
+		case OPT_SPLIT_INDEX:
+			if (atoi(optarg) > 0)
+				split_index = atoi(optarg);
+			else
+				die("--split-index option requires numeric value.");
+			break;
 		case OPT_TABS:
 			if (atoi(optarg) > 0)
 				tabs = atoi(optarg);
@@ -1443,7 +1531,9 @@ main(int argc, char **argv)
 	 *       HTML/search.html        ... search index (4)
 	 *       HTML/defines.html       ... definitions index (5)
 	 *       HTML/defines/           ... definitions index (5)
+	 *       HTML/defines.json       ... manifest of --split-index (5)
 	 *       HTML/files/             ... file index (6)
+	 *       HTML/files.json         ... manifest of --split-index (6)
 	 *       HTML/index.html         ... index file (7)
 	 *       HTML/mains.html         ... main index (8)
 	 *       HTML/null.html          ... main null html (8)
@@ -1451,6 +1541,7 @@ main(int argc, char **argv)
 	 *       HTML/I/                 ... include file index (9)
 	 *       HTML/rebuild.sh         ... rebuild script (10)
 	 *       HTML/style.css          ... style sheet (11)
+	 *       HTML/htags.pack         ... pages packed by --pack (0)-(9)
 	 *------------------------------------------------------------------
 	 */
 	/* for clean up */
@@ -1483,6 +1574,12 @@ main(int argc, char **argv)
 			loadfile(makepath(datadir, "gtags/jscode_treeview", NULL), sb);
 		jscode = strbuf_value(sb);
 	}
+	if (split_index) {
+		STATIC_STRBUF(sb);
+		strbuf_clear(sb);
+		loadfile(makepath(datadir, "gtags/jscode_shard", NULL), sb);
+		shard_jscode = strbuf_value(sb);
+	}
 	/*
 	 * (0) make directories
 	 */
@@ -1490,6 +1587,12 @@ main(int argc, char **argv)
 	if (!test("d", distpath))
 		if (mkdir(distpath, 0777) < 0)
 			die("cannot make directory '%s'.", distpath);
+	/*
+	 * From now on, pages are compressed and/or packed if required.
+	 */
+	if (gzip_pages || pack_pages)
+		set_output_policy((gzip_pages ? FILEOP_GZIP : 0) | (pack_pages ? FILEOP_PACK : 0),
+			distpath, HTML);
 	make_directory_in_distpath("files");
 	make_directory_in_distpath("defines");
 	make_directory_in_distpath(SRCS);
@@ -1632,6 +1735,8 @@ main(int argc, char **argv)
 	tim = statistics_time_start("Time of making hypertext");
 	makehtml(file_total);
 	statistics_time_end(tim);
+	if (gzip_pages || pack_pages)
+		close_output_policy();
 	/*
 	 * (10) rebuild script. (rebuild.sh)
 	 *
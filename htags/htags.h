@@ -95,6 +95,10 @@ extern int fixed_guide;
 extern int dynamic;
 extern int symbol;
 extern int statistics;
+extern int gzip_pages;
+extern int pack_pages;
+extern int split_index;
+extern int jobs;
 
 extern int no_order_list;
 extern int other_files;
@@ -112,6 +116,7 @@ extern const char *insert_header;
 extern const char *insert_footer;
 extern const char *html_header;
 extern const char *jscode;
+extern const char *shard_jscode;
 
 extern const char *title_define_index;
 extern const char *title_file_index;
@@ -21,27 +21,32 @@
 
 #include "incop.h"
 #include "tab.h"
+#include "src2html.h"
 
 /*
  * Definition of LEXTEXT, LEXLENG, LEXIN and LEXRESTART.
  *
  * These symbols are substitutions of yytext, yyleng, yyin and yyrestart.
  * You should write lex code using them.
- * The usage of this file is, for instance, in "c.l":
+ *
+ * The scanners are reentrant (%option reentrant). All the state of the
+ * conversion of a file is kept in the SRCCONV context, which is the extra
+ * data of the scanner (yyextra). The usage of this file is, for instance,
+ * in "c.l":
  *
  * [code]
- *	#define lex_symbol_generation_rule(x) c_ ## x
  *	#include "lexcommon.h"
+ *	...
+ *	%option reentrant prefix="c_"
+ *	%option extra-type="SRCCONV *"
+ *
+ * These symbols are available where the scanner (yyscanner and yyg)
+ * is available, that is, in the actions and the initializing procedures.
  */
-#ifndef lex_symbol_generation_rule
-ERROR: lex_symbol_generation_rule(x) macro not defined.
-lexcommon.h requires the lex_symbol_generation_rule(x) macro for each language
-to generate language specific symbols.
-#endif
-#define LEXTEXT lex_symbol_generation_rule(text)
-#define LEXLENG lex_symbol_generation_rule(leng)
-#define LEXIN lex_symbol_generation_rule(in)
-#define LEXRESTART lex_symbol_generation_rule(restart)
+#define LEXTEXT yytext
+#define LEXLENG yyleng
+#define LEXIN yyin
+#define LEXRESTART(f) yyrestart(f, yyscanner)
 
 /*
  * The default action for line control.
@@ -49,48 +54,50 @@ to generate language specific symbols.
  * You must define C_COMMENT, CPP_COMMENT, SHELL_COMMENT, LITERAL, STRING
  * and PREPROCESSOR_LINE as %start values, even if they are not used.
  * It assumed that CPP_COMMENT and SHELL_COMMENT is one line comment.
+ *
+ * If you want newline to terminate string, set
+ * yyextra->newline_terminate_string to 1.
  */
-static int lexcommon_lineno;
-static int begin_line;
-
-/*
- * If you want newline to terminate string, set this variable to 1.
- */
-static int newline_terminate_string = 0;
-
-/*
- * Variables for converting tabs to spaces.
- */
-static int dest_column;
-static int left_spaces;
-
 #define YY_INPUT(buf, result, max_size) do {				\
 	result = read_file_detabing(buf, max_size, LEXIN,		\
-			&dest_column, &left_spaces);			\
+			&yyextra->dest_column, &yyextra->left_spaces);	\
 } while (0)
 
-#define LINENO lexcommon_lineno
+#define LINENO (yyextra->lineno)
 
+/*
+ * The initializing procedure of each language begins with this.
+ * It makes a scanner (yyscanner, yyg) which reads from ip and
+ * works on the context conv.
+ */
 #define DEFAULT_BEGIN_OF_FILE_ACTION {					\
+	if (yylex_init_extra(conv, &yyscanner) != 0)			\
+		die("cannot initialize the scanner.");			\
+	yyg = (struct yyguts_t *)yyscanner;				\
         LEXIN = ip;							\
         LEXRESTART(LEXIN);						\
         LINENO = 1;							\
-        begin_line = 1;							\
-	dest_column = 0;						\
-	left_spaces = 0;						\
+        yyextra->begin_line = 1;					\
+	yyextra->newline_terminate_string = 0;				\
+	yyextra->dest_column = 0;					\
+	yyextra->left_spaces = 0;					\
+	yyextra->last_directive = 0;					\
+	yyextra->brace_level = 0;					\
+	yyextra->pre_here_document = 0;					\
+	yyextra->end_of_here_document[0] = '\0';			\
 }
 
 #define DEFAULT_YY_USER_ACTION {					\
-	if (begin_line) {						\
-		put_begin_of_line(LINENO);				\
+	if (yyextra->begin_line) {					\
+		put_begin_of_line(yyextra, LINENO);			\
 		switch (YY_START) {					\
 		case C_COMMENT:						\
 		case CPP_COMMENT:					\
 		case SHELL_COMMENT:					\
-			echos(comment_begin);				\
+			echos(yyextra, comment_begin);			\
 			break;						\
 		}							\
-		begin_line = 0;						\
+		yyextra->begin_line = 0;				\
 	}								\
 }
 
@@ -98,60 +105,60 @@ static int left_spaces;
 	switch (YY_START) {						\
 	case CPP_COMMENT:						\
 	case SHELL_COMMENT:						\
-		yy_pop_state();						\
+		yy_pop_state(yyscanner);				\
 		/* FALLTHROUGH */					\
 	case C_COMMENT:							\
-		echos(comment_end);					\
+		echos(yyextra, comment_end);				\
 		break;							\
 	case STRING:							\
 	case LITERAL:							\
-		if (newline_terminate_string)				\
-			yy_pop_state();					\
+		if (yyextra->newline_terminate_string)			\
+			yy_pop_state(yyscanner);			\
 		break;							\
 	}								\
 	if (YY_START == PREPROCESSOR_LINE)				\
-		yy_pop_state();						\
-	put_end_of_line(LINENO);					\
+		yy_pop_state(yyscanner);				\
+	put_end_of_line(yyextra, LINENO);				\
 	/* for the next line */						\
 	LINENO++;							\
-	begin_line = 1;							\
+	yyextra->begin_line = 1;					\
 }
 
 #define DEFAULT_BACKSLASH_NEWLINE_ACTION {				\
-	echoc('\\');							\
+	echoc(yyextra, '\\');						\
 	switch (YY_START) {						\
 	case CPP_COMMENT:						\
 	case C_COMMENT:							\
 	case SHELL_COMMENT:						\
-		echos(comment_end);					\
+		echos(yyextra, comment_end);				\
 		break;							\
 	}								\
-	put_end_of_line(LINENO);					\
+	put_end_of_line(yyextra, LINENO);				\
 	/* for the next line */						\
 	LINENO++;							\
-	begin_line = 1;							\
+	yyextra->begin_line = 1;					\
 }
 
 /*
  * Output routine.
  */
-extern void echoc(int);
-extern void echos(const char *);
-extern const char *generate_guide(int);
-extern void put_anchor(char *, int, int);
-extern void put_anchor_force(char *, int, int);
-extern void put_include_anchor(struct data *, const char *);
-extern void put_include_anchor_direct(const char *, const char *);
-extern void put_reserved_word(const char *);
-extern void put_macro(const char *);
-extern void unknown_preprocessing_directive(const char *, int);
-extern void unexpected_eof(int);
-extern void unknown_yacc_directive(const char *, int);
-extern void missing_left(const char *, int);
-extern void put_char(int);
-extern void put_string(const char *);
-extern void put_brace(const char *);
-extern void put_begin_of_line(int);
-extern void put_end_of_line(int);
+extern void echoc(SRCCONV *, int);
+extern void echos(SRCCONV *, const char *);
+extern const char *generate_guide(SRCCONV *, int);
+extern void put_anchor(SRCCONV *, char *, int, int);
+extern void put_anchor_force(SRCCONV *, char *, int, int);
+extern void put_include_anchor(SRCCONV *, struct data *, const char *);
+extern void put_include_anchor_direct(SRCCONV *, const char *, const char *);
+extern void put_reserved_word(SRCCONV *, const char *);
+extern void put_macro(SRCCONV *, const char *);
+extern void unknown_preprocessing_directive(SRCCONV *, const char *, int);
+extern void unexpected_eof(SRCCONV *, int);
+extern void unknown_yacc_directive(SRCCONV *, const char *, int);
+extern void missing_left(SRCCONV *, const char *, int);
+extern void put_char(SRCCONV *, int);
+extern void put_string(SRCCONV *, const char *);
+extern void put_brace(SRCCONV *, const char *);
+extern void put_begin_of_line(SRCCONV *, int);
+extern void put_end_of_line(SRCCONV *, int);
 
 #endif /* ! _LEXCOMMON_H */
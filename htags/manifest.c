@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#include "global.h"
+#include "htags.h"
+#include "common.h"
+#include "manifest.h"
+
+/*
+ * Manifest of a split index.
+ *
+ * When the --split-index=<number> option is specified, the definition
+ * index and the file index are split into pages (shards) which have
+ * at most <number> items. A shard is written as '<name>.html' (first)
+ * or '<name>-<n>.html' (second and later). The manifest describes the
+ * shards in JSON so that javascript code can fetch them on demand.
+ *
+ * {
+ * "total": 12345,
+ * "pagesize": 1000,
+ * "pages": [
+ *  {"url": "defines/A.html", "group": "A", "first": "ABC", "last": "AZ", "count": 1000},
+ *  {"url": "defines/A-2.html", "group": "A", "first": "AZZ", "last": "Azz", "count": 20},
+ *  ...
+ * ]
+ * }
+ *
+ * Url is relative to the top of the HTML directory. The shards of a
+ * group appear in order, though the shards of other groups may come
+ * between them. First and last are the labels of the first and the last
+ * item of the shard.
+ */
+const char *shard_list_begin = "<div id='shard-list'>";
+const char *shard_list_end = "</div>";
+const char *shard_navi_begin = "<div id='shard-navi'>";
+const char *shard_navi_end = "</div>";
+
+static STRBUF *manifest;
+static char manifest_path[MAXPATHLEN];
+static int manifest_pages;
+static int manifest_total;		/**< number of items in the pages */
+
+/**
+ * put_json_string: put a string as a JSON string literal.
+ *
+ *	@param[out]	sb	string buffer
+ *	@param[in]	s	string
+ */
+static void
+put_json_string(STRBUF *sb, const char *s)
+{
+	strbuf_putc(sb, '"');
+	for (; *s; s++) {
+		unsigned char c = *s;
+
+		if (c == '"' || c == '\\') {
+			strbuf_putc(sb, '\\');
+			strbuf_putc(sb, c);
+		} else if (c < 0x20) {
+			char buf[8];
+
+			snprintf(buf, sizeof(buf), "\\u%04x", c);
+			strbuf_puts(sb, buf);
+		} else
+			strbuf_putc(sb, c);
+	}
+	strbuf_putc(sb, '"');
+}
+/**
+ * manifest_open: start a manifest
+ *
+ *	@param[in]	name	file name in the HTML directory (e.g. "defines.json")
+ */
+void
+manifest_open(const char *name)
+{
+	if (manifest)
+		die("manifest_open: internal error.");
+	manifest = strbuf_open(0);
+	strlimcpy(manifest_path, makepath(distpath, name, NULL), sizeof(manifest_path));
+	manifest_pages = 0;
+	manifest_total = 0;
+}
+/**
+ * manifest_put: add a shard to the manifest
+ *
+ *	@param[in]	url	url of the shard (relative to the HTML directory)
+ *	@param[in]	group	group of the shard
+ *	@param[in]	first	label of the first item
+ *	@param[in]	last	label of the last item
+ *	@param[in]	count	number of items
+ */
+void
+manifest_put(const char *url, const char *group, const char *first, const char *last, int count)
+{
+	if (manifest_pages++ > 0)
+		strbuf_puts_nl(manifest, ",");
+	strbuf_puts(manifest, " {\"url\": ");
+	put_json_string(manifest, url);
+	strbuf_puts(manifest, ", \"group\": ");
+	put_json_string(manifest, group);
+	strbuf_puts(manifest, ", \"first\": ");
+	put_json_string(manifest, first);
+	strbuf_puts(manifest, ", \"last\": ");
+	put_json_string(manifest, last);
+	strbuf_sprintf(manifest, ", \"count\": %d}", count);
+	manifest_total += count;
+}
+/**
+ * manifest_close: write the manifest
+ *
+ * The total is the sum of the counts of the pages, so that a client
+ * can page by it.
+ */
+void
+manifest_close(void)
+{
+	STRBUF *sb = strbuf_open(0);
+
+	strbuf_puts_nl(sb, "{");
+	strbuf_sprintf(sb, "\"total\": %d,\n", manifest_total);
+	strbuf_sprintf(sb, "\"pagesize\": %d,\n", split_index);
+	strbuf_puts_nl(sb, "\"pages\": [");
+	strbuf_puts(sb, strbuf_value(manifest));
+	if (manifest_pages > 0)
+		strbuf_putc(sb, '\n');
+	strbuf_puts_nl(sb, "]");
+	strbuf_puts_nl(sb, "}");
+	write_output_file(manifest_path, strbuf_value(sb), strbuf_getlen(sb));
+	strbuf_close(sb);
+	strbuf_close(manifest);
+	manifest = NULL;
+}
+/**
+ * shard_name: name of a shard
+ *
+ *	@param[in]	name	name of the first shard
+ *	@param[in]	n	shard number (1, 2, ...)
+ *	@return		name of the shard
+ */
+const char *
+shard_name(const char *name, int n)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	strbuf_puts(sb, name);
+	if (n > 1)
+		strbuf_sprintf(sb, "-%d", n);
+	return strbuf_value(sb);
+}
+/**
+ * gen_shard_navi: links to the previous and the next shard
+ *
+ *	@param[in]	prev	url of the previous shard or NULL
+ *	@param[in]	next	url of the next shard or NULL
+ *	@return		navigation bar
+ */
+const char *
+gen_shard_navi(const char *prev, const char *next)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	strbuf_puts(sb, shard_navi_begin);
+	if (prev) {
+		strbuf_puts(sb, gen_href_begin_with_title(NULL, prev, NULL, NULL, "Previous page"));
+		strbuf_puts(sb, "[&lt;]");
+		strbuf_puts(sb, gen_href_end());
+	}
+	if (next) {
+		/* the loader hides this link when it appends the following shards */
+		strbuf_puts(sb, "<span id='shard-next'>");
+		if (prev)
+			strbuf_putc(sb, ' ');
+		strbuf_puts(sb, gen_href_begin_with_title(NULL, next, NULL, NULL, "Next page"));
+		strbuf_puts(sb, "[&gt;]");
+		strbuf_puts(sb, gen_href_end());
+		strbuf_puts(sb, "</span>");
+	}
+	strbuf_puts(sb, shard_navi_end);
+	return strbuf_value(sb);
+}
+/**
+ * gen_shard_script: header item for a shard
+ *
+ *	@param[in]	url	url of the manifest (relative to the shard)
+ *	@return		javascript code
+ */
+const char *
+gen_shard_script(const char *url)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	strbuf_sprintf(sb, "<script type='text/javascript'>var shard_manifest = '%s';</script>\n", url);
+	strbuf_puts(sb, shard_jscode);
+	return strbuf_value(sb);
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _MANIFEST_H_
+#define _MANIFEST_H_
+
+extern const char *shard_list_begin;
+extern const char *shard_list_end;
+extern const char *shard_navi_begin;
+extern const char *shard_navi_end;
+
+void manifest_open(const char *);
+void manifest_put(const char *, const char *, const char *, const char *, int);
+void manifest_close(void);
+const char *shard_name(const char *, int);
+const char *gen_shard_navi(const char *, const char *);
+const char *gen_shard_script(const char *);
+
+#endif /* ! _MANIFEST_H_ */
@@ -35,56 +35,71 @@
 #include "incop.h"
 #include "path2url.h"
 #include "htags.h"
+#include "src2html.h"
 
 /*----------------------------------------------------------------------*/
 /* Parser switch							*/
 /*----------------------------------------------------------------------*/
 /**
  * This is the linkage section of each parsers.
- * If you want to support new language, you must define two procedures:
+ * If you want to support new language, you must define three procedures:
  *	1. Initializing procedure (init_proc).
- *		Called once first with an input file descripter.
+ *		Called once first with an input file descripter and
+ *		the context of the conversion.
+ *		It should return a new scanner.
  *	2. Executing procedure (exec_proc).
- *		Called repeatedly until returning EOF.
+ *		Called repeatedly with the scanner until returning EOF.
  *		It should read from above descripter and write HTML
  *		using output procedures in this module.
+ *	3. Terminating procedure (term_proc).
+ *		Called once last to free the scanner.
  */
 struct lang_entry {
 	const char *lang_name;
-	void (*init_proc)(FILE *);		/**< initializing procedure */
-	int (*exec_proc)(void);			/**< executing procedure */
+	void *(*init_proc)(FILE *, SRCCONV *);	/**< initializing procedure */
+	int (*exec_proc)(void *);		/**< executing procedure */
+	int (*term_proc)(void *);		/**< terminating procedure */
 };
 
 /*
  * initializing procedures
  */
-void c_parser_init(FILE *);
-void yacc_parser_init(FILE *);
-void cpp_parser_init(FILE *);
-void java_parser_init(FILE *);
-void php_parser_init(FILE *);
-void asm_parser_init(FILE *);
+void *c_parser_init(FILE *, SRCCONV *);
+void *yacc_parser_init(FILE *, SRCCONV *);
+void *cpp_parser_init(FILE *, SRCCONV *);
+void *java_parser_init(FILE *, SRCCONV *);
+void *php_parser_init(FILE *, SRCCONV *);
+void *asm_parser_init(FILE *, SRCCONV *);
 
 /*
  * executing procedures
  */
-int c_lex(void);
-int cpp_lex(void);
-int java_lex(void);
-int php_lex(void);
-int asm_lex(void);
+int c_lex(void *);
+int cpp_lex(void *);
+int java_lex(void *);
+int php_lex(void *);
+int asm_lex(void *);
+
+/*
+ * terminating procedures
+ */
+int c_lex_destroy(void *);
+int cpp_lex_destroy(void *);
+int java_lex_destroy(void *);
+int php_lex_destroy(void *);
+int asm_lex_destroy(void *);
 
 /**
  * The first entry is default language.
  */
 struct lang_entry lang_switch[] = {
-	/* lang_name	init_proc 		exec_proc */
-	{"c",		c_parser_init,		c_lex},		/* DEFAULT */
-	{"yacc",	yacc_parser_init,	c_lex},
-	{"cpp",		cpp_parser_init,	cpp_lex},
-	{"java",	java_parser_init,	java_lex},
-	{"php",		php_parser_init,	php_lex},
-	{"asm",		asm_parser_init,	asm_lex}
+	/* lang_name	init_proc 		exec_proc	term_proc */
+	{"c",		c_parser_init,		c_lex,		c_lex_destroy},	/* DEFAULT */
+	{"yacc",	yacc_parser_init,	c_lex,		c_lex_destroy},
+	{"cpp",		cpp_parser_init,	cpp_lex,	cpp_lex_destroy},
+	{"java",	java_parser_init,	java_lex,	java_lex_destroy},
+	{"php",		php_parser_init,	php_lex,	php_lex_destroy},
+	{"asm",		asm_parser_init,	asm_lex,	asm_lex_destroy}
 };
 #define DEFAULT_ENTRY &lang_switch[0]
 
@@ -119,17 +134,20 @@ get_lang_entry(const char *lang)
 /* Input/Output								*/
 /*----------------------------------------------------------------------*/
 /*
- * Input/Output descriptor.
+ * Output buffers.
+ *
+ * The whole page is built in conv->page and written at once at the end of
+ * src2html(). The HTML image of the current line is built in conv->out,
+ * and moved to conv->page by put_end_of_line().
+ * The page buffer is reused for every file converted with the context,
+ * so that it is expanded only while it grows to the largest page.
  */
-static FILEOP *fileop_out;
-static FILEOP *fileop_in;
-static FILE *out;
-static FILE *in;
+#define PAGE_BUFSIZE	(256 * 1024)
 
-STATIC_STRBUF(outbuf);
-static const char *curpfile;
-static int warned;
-static int last_lineno;
+/*
+ * Quoting table for HTML: quote_table[c] is not NULL if c should be quoted.
+ */
+static const char *quote_table[256];
 
 /*
  * Put a character to HTML as is.
@@ -141,9 +159,9 @@ static int last_lineno;
  * See put_char()
  */
 void
-echoc(int c)
+echoc(SRCCONV *conv, int c)
 {
-        strbuf_putc(outbuf, c);
+        strbuf_putc(conv->out, c);
 }
 /*
  * Put a string to HTML as is.
@@ -155,9 +173,9 @@ echoc(int c)
  * See put_string()
  */
 void
-echos(const char *s)
+echos(SRCCONV *conv, const char *s)
 {
-        strbuf_puts(outbuf, s);
+        strbuf_puts(conv->out, s);
 }
 /*----------------------------------------------------------------------*/
 /* HTML output								*/
@@ -170,13 +188,7 @@ echos(const char *s)
 static const char *
 HTML_quoting(int c)
 {
-	if (c == '<')
-		return quote_little;
-	else if (c == '>')
-		return quote_great;
-	else if (c == '&')
-		return quote_amp;
-	return NULL;
+	return quote_table[(unsigned char)c];
 }
 /*
  * fill_anchor: fill anchor into file name
@@ -333,11 +345,12 @@ fixed_guide_link_format(int ref[A_LIMIT], const char *anchors)
 /**
  * generate_guide: generate guide string for definition line.
  *
+ *	@param[in]	conv	context
  *	@param[in]	lineno	line number
  *	@return		guide string
  */
 const char *
-generate_guide(int lineno)
+generate_guide(SRCCONV *conv, int lineno)
 {
 	STATIC_STRBUF(sb);
 	int i = 0;
@@ -351,10 +364,10 @@ generate_guide(int lineno)
 		for (; i > 0; i--)
 			strbuf_putc(sb, ' ');
 	strbuf_sprintf(sb, "%s/* ", comment_begin);
-	strbuf_puts(sb, link_format(anchor_getlinks(lineno)));
+	strbuf_puts(sb, link_format(anchor_getlinks(conv->anchor, lineno)));
 	if (show_position) {
 		strbuf_sprintf(sb, "%s%s value='+%d %s' %s",
-			quote_space, position_begin, lineno, curpfile, position_end);
+			quote_space, position_begin, lineno, conv->curpfile, position_end);
 	}
 	strbuf_sprintf(sb, " */%s", comment_end);
 
@@ -413,6 +426,7 @@ tooltip(int type, int lno, const char *opt)
 /**
  * put_anchor: output HTML anchor.
  *
+ *	@param[in]	conv	context
  *	@param[in]	name	tag
  *	@param[in]	type	tag type. 'R': GTAGS,
  *			'Y': GSYMS,
@@ -420,7 +434,7 @@ tooltip(int type, int lno, const char *opt)
  *	@param[in]	lineno	current line no
  */
 void
-put_anchor(char *name, int type, int lineno)
+put_anchor(SRCCONV *conv, char *name, int type, int lineno)
 {
 	const char *line;
 	int db;
@@ -435,11 +449,11 @@ put_anchor(char *name, int type, int lineno)
 	if (line == NULL) {
 		if ((type == 'R' || type == 'Y') && wflag) {
 			warning("%s %d %s(%c) found but not defined.",
-				curpfile, lineno, name, type);
+				conv->curpfile, lineno, name, type);
 			if (colorize_warned_line)
-				warned = 1;
+				conv->warned = 1;
 		}
-		strbuf_puts(outbuf, name);
+		strbuf_puts(conv->out, name);
 	} else {
 		/*
 		 * About the format of 'line', please see the head comment of cache.c.
@@ -477,9 +491,9 @@ put_anchor(char *name, int type, int lineno)
 				file = fid;
 				suffix = HTML;
 			}
-			strbuf_puts(outbuf, gen_href_begin_with_title(dir, file, suffix, NULL, tooltip(type, -1, count)));
-			strbuf_puts(outbuf, name);
-			strbuf_puts(outbuf, gen_href_end());
+			strbuf_puts(conv->out, gen_href_begin_with_title(dir, file, suffix, NULL, tooltip(type, -1, count)));
+			strbuf_puts(conv->out, name);
+			strbuf_puts(conv->out, gen_href_end());
 		} else {
 			const char *lno = line;
 			const char *fid = nextstring(line);
@@ -491,18 +505,19 @@ put_anchor(char *name, int type, int lineno)
 			 * Being used only once means that it is a self link.
 			 */
 			if (db == GSYMS) {
-				strbuf_puts(outbuf, name);
+				strbuf_puts(conv->out, name);
 				return;
 			}
-			strbuf_puts(outbuf, gen_href_begin_with_title(upperdir(SRCS), fid, HTML, lno, tooltip(type, atoi(lno), path)));
-			strbuf_puts(outbuf, name);
-			strbuf_puts(outbuf, gen_href_end());
+			strbuf_puts(conv->out, gen_href_begin_with_title(upperdir(SRCS), fid, HTML, lno, tooltip(type, atoi(lno), path)));
+			strbuf_puts(conv->out, name);
+			strbuf_puts(conv->out, gen_href_end());
 		}
 	}
 }
 /**
  * put_anchor_force: output HTML anchor without warning.
  *
+ *	@param[in]	conv	context
  *	@param[in]	name	tag
  *	@param[in]	length
  *	@param[in]	lineno	current line no
@@ -510,7 +525,7 @@ put_anchor(char *name, int type, int lineno)
  * The tag type is fixed at 'R' (GTAGS)
  */
 void
-put_anchor_force(char *name, int length, int lineno)
+put_anchor_force(SRCCONV *conv, char *name, int length, int lineno)
 {
 	STATIC_STRBUF(sb);
 	int saveflag = wflag;
@@ -518,101 +533,103 @@ put_anchor_force(char *name, int length, int lineno)
 	strbuf_clear(sb);
 	strbuf_nputs(sb, name, length);
 	wflag = 0;
-	put_anchor(strbuf_value(sb), 'R', lineno);
+	put_anchor(conv, strbuf_value(sb), 'R', lineno);
 	wflag = saveflag;
 }
 /**
  * put_include_anchor: output HTML anchor.
  *
+ *	@param[in]	conv	context
  *	@param[in]	inc	inc structure
  *	@param[in]	path	path name for display
  */
 void
-put_include_anchor(struct data *inc, const char *path)
+put_include_anchor(SRCCONV *conv, struct data *inc, const char *path)
 {
 	if (inc->count == 1)
-		strbuf_puts(outbuf, gen_href_begin(NULL, path2fid(strbuf_value(inc->contents)), HTML, NULL));
+		strbuf_puts(conv->out, gen_href_begin(NULL, path2fid(strbuf_value(inc->contents)), HTML, NULL));
 	else {
 		char id[32];
 		snprintf(id, sizeof(id), "%d", inc->id);
-		strbuf_puts(outbuf, gen_href_begin(upperdir(INCS), id, HTML, NULL));
+		strbuf_puts(conv->out, gen_href_begin(upperdir(INCS), id, HTML, NULL));
 	}
-	strbuf_puts(outbuf, path);
-	strbuf_puts(outbuf, gen_href_end());
+	strbuf_puts(conv->out, path);
+	strbuf_puts(conv->out, gen_href_end());
 }
 /**
  * put_include_anchor_direct: output HTML anchor.
  *
+ *	@param[in]	conv	context
  *	@param[in]	file	normalized path
  *	@param[in]	path	path name for display
  */
 void
-put_include_anchor_direct(const char *file, const char *path)
+put_include_anchor_direct(SRCCONV *conv, const char *file, const char *path)
 {
-	strbuf_puts(outbuf, gen_href_begin(NULL, path2fid(file), HTML, NULL));
-	strbuf_puts(outbuf, path);
-	strbuf_puts(outbuf, gen_href_end());
+	strbuf_puts(conv->out, gen_href_begin(NULL, path2fid(file), HTML, NULL));
+	strbuf_puts(conv->out, path);
+	strbuf_puts(conv->out, gen_href_end());
 }
 /**
  * Put a reserved word (if, while, ...)
  */
 void
-put_reserved_word(const char *word)
+put_reserved_word(SRCCONV *conv, const char *word)
 {
-	strbuf_puts(outbuf, reserved_begin);
-	strbuf_puts(outbuf, word);
-	strbuf_puts(outbuf, reserved_end);
+	strbuf_puts(conv->out, reserved_begin);
+	strbuf_puts(conv->out, word);
+	strbuf_puts(conv->out, reserved_end);
 }
 /*
  * Put a macro (#define, #undef, ...) 
  */
 void
-put_macro(const char *word)
+put_macro(SRCCONV *conv, const char *word)
 {
-	strbuf_puts(outbuf, sharp_begin);
-	strbuf_puts(outbuf, word);
-	strbuf_puts(outbuf, sharp_end);
+	strbuf_puts(conv->out, sharp_begin);
+	strbuf_puts(conv->out, word);
+	strbuf_puts(conv->out, sharp_end);
 }
 /**
  * Print warning message when unknown preprocessing directive is found.
  */
 void
-unknown_preprocessing_directive(const char *word, int lineno)
+unknown_preprocessing_directive(SRCCONV *conv, const char *word, int lineno)
 {
 	word = strtrim(word, TRIM_ALL, NULL);
-	warning("unknown preprocessing directive '%s'. [+%d %s]", word, lineno, curpfile);
+	warning("unknown preprocessing directive '%s'. [+%d %s]", word, lineno, conv->curpfile);
 	if (colorize_warned_line)
-		warned = 1;
+		conv->warned = 1;
 }
 /**
  * Print warning message when unexpected eof.
  */
 void
-unexpected_eof(int lineno)
+unexpected_eof(SRCCONV *conv, int lineno)
 {
-	warning("unexpected eof. [+%d %s]", lineno, curpfile);
+	warning("unexpected eof. [+%d %s]", lineno, conv->curpfile);
 	if (colorize_warned_line)
-		warned = 1;
+		conv->warned = 1;
 }
 /**
  * Print warning message when unknown yacc directive is found.
  */
 void
-unknown_yacc_directive(const char *word, int lineno)
+unknown_yacc_directive(SRCCONV *conv, const char *word, int lineno)
 {
-	warning("unknown yacc directive '%s'. [+%d %s]", word, lineno, curpfile);
+	warning("unknown yacc directive '%s'. [+%d %s]", word, lineno, conv->curpfile);
 	if (colorize_warned_line)
-		warned = 1;
+		conv->warned = 1;
 }
 /**
  * Print warning message when unmatched brace is found.
  */
 void
-missing_left(const char *word, int lineno)
+missing_left(SRCCONV *conv, const char *word, int lineno)
 {
-	warning("missing left '%s'. [+%d %s]", word, lineno, curpfile);
+	warning("missing left '%s'. [+%d %s]", word, lineno, conv->curpfile);
 	if (colorize_warned_line)
-		warned = 1;
+		conv->warned = 1;
 }
 /*
  * Put a character with HTML quoting.
@@ -622,14 +639,14 @@ missing_left(const char *word, int lineno)
  *		characters for HTML.
  */
 void
-put_char(int c)
+put_char(SRCCONV *conv, int c)
 {
-	const char *quoted = HTML_quoting(c);
+	const char *quoted = quote_table[(unsigned char)c];
 
 	if (quoted)
-		strbuf_puts(outbuf, quoted);
+		strbuf_puts(conv->out, quoted);
 	else
-		strbuf_putc(outbuf, c);
+		strbuf_putc(conv->out, c);
 }
 /*
  * Put a string with HTML quoting.
@@ -639,85 +656,100 @@ put_char(int c)
  *		'>' and '&' for HTML.
  */
 void
-put_string(const char *s)
+put_string(SRCCONV *conv, const char *s)
 {
-	for (; *s; s++)
-		put_char(*s);
+	const char *p;
+
+	for (;;) {
+		/*
+		 * Put a run of characters which need not be quoted at once.
+		 */
+		for (p = s; *p && !quote_table[(unsigned char)*p]; p++)
+			;
+		strbuf_nputs(conv->out, s, p - s);
+		if (*p == '\0')
+			break;
+		strbuf_puts(conv->out, quote_table[(unsigned char)*p]);
+		s = p + 1;
+	}
 }
 /**
  * Put brace ('{', '}')
  */
 void
-put_brace(const char *text)
+put_brace(SRCCONV *conv, const char *text)
 {
-	strbuf_puts(outbuf, brace_begin);
-	strbuf_puts(outbuf, text);
-	strbuf_puts(outbuf, brace_end);
+	strbuf_puts(conv->out, brace_begin);
+	strbuf_puts(conv->out, text);
+	strbuf_puts(conv->out, brace_end);
 }
 
 /*
  * common procedure for line control.
  */
 static char lineno_format[32];
-static const char *guide = NULL;
 
 /**
  * Begin of line processing.
+ *
+ *	@param[in]	conv	context
+ *	@param[in]	lineno	current line number
  */
 void
-put_begin_of_line(int lineno)
+put_begin_of_line(SRCCONV *conv, int lineno)
 {
         if (definition_header != NO_HEADER) {
-                if (define_line(lineno))
-                        guide = generate_guide(lineno);
+                if (define_line(conv->anchor, lineno))
+                        conv->guide = generate_guide(conv, lineno);
                 else
-                        guide = NULL;
+                        conv->guide = NULL;
         }
-        if (guide && definition_header == BEFORE_HEADER) {
-		fputs_nl(guide, out);
-                guide = NULL;
+        if (conv->guide && definition_header == BEFORE_HEADER) {
+		strbuf_puts_nl(conv->page, conv->guide);
+                conv->guide = NULL;
         }
 }
 /**
  * End of line processing.
  *
+ *	@param[in]	conv	context
  *	@param[in]	lineno	current line number
- *	Globals used (input):
- *		outbuf, HTML line image
  *
- * The outbuf (string buffer) has HTML image of the line.
+ * The conv->out (string buffer) has HTML image of the line.
  * This function flush and clear it.
  */
 void
-put_end_of_line(int lineno)
+put_end_of_line(SRCCONV *conv, int lineno)
 {
-	fputs(gen_name_number(lineno), out);
+	STRBUF *page = conv->page;
+
+	strbuf_puts(page, gen_name_number(lineno));
         if (nflag)
-                fprintf(out, lineno_format, lineno);
-	if (warned)
-		fputs(warned_line_begin, out);
+                strbuf_sprintf(page, lineno_format, lineno);
+	if (conv->warned)
+		strbuf_puts(page, warned_line_begin);
 
 	/* flush output buffer */
-	fputs(strbuf_value(outbuf), out);
-	strbuf_reset(outbuf);
+	strbuf_nputs(page, strbuf_value(conv->out), strbuf_getlen(conv->out));
+	strbuf_reset(conv->out);
 
-	if (warned)
-		fputs(warned_line_end, out);
-	if (guide == NULL)
-		fputc('\n', out);
+	if (conv->warned)
+		strbuf_puts(page, warned_line_end);
+	if (conv->guide == NULL)
+		strbuf_putc(page, '\n');
 	else {
 		if (definition_header == RIGHT_HEADER)
-			fputs(guide, out);
-		fputc('\n', out);
+			strbuf_puts(page, conv->guide);
+		strbuf_putc(page, '\n');
 		if (definition_header == AFTER_HEADER) {
-			fputs_nl(guide, out);
+			strbuf_puts_nl(page, conv->guide);
 		}
-		guide = NULL;
+		conv->guide = NULL;
 	}
-	warned = 0;
+	conv->warned = 0;
 
 	/* save for the other job in this module */
-	last_lineno = lineno;
+	conv->last_lineno = lineno;
 }
 /**
  * Encode URL.
@@ -784,48 +816,70 @@ get_cvs_module(const char *file, const char **basename)
 	return NULL;
 }
 /**
+ * src2html_open: open a context of the conversion
  *
- * src2html: convert source code into HTML
+ *	@return		context
  *
- *       @param[in]      src   source file     - Read from
- *       @param[in]      html  HTML file       - Write to
- *       @param[in]      notsource 1: isn't source, 0: source.
+ * A context can convert any number of files one after another.
+ * Give each process its own context (see src2html.h).
  */
-void
-src2html(const char *src, const char *html, int notsource)
+SRCCONV *
+src2html_open(void)
 {
-	char indexlink[128];
+	SRCCONV *conv = check_calloc(sizeof(SRCCONV), 1);
 
 	/*
 	 * setup lineno format.
 	 */
 	snprintf(lineno_format, sizeof(lineno_format), "%%%dd ", ncol);
+	quote_table['<'] = quote_little;
+	quote_table['>'] = quote_great;
+	quote_table['&'] = quote_amp;
 
-	fileop_in  = open_input_file(src);
-	in = get_descripter(fileop_in);
-        curpfile = src;
-        warned = 0;
+	conv->anchor = anchor_open();
+	conv->page = strbuf_open(PAGE_BUFSIZE);
+	conv->out = strbuf_open(0);
+	return conv;
+}
+/**
+ *
+ * src2html: convert source code into HTML
+ *
+ *       @param[in]      conv  context
+ *       @param[in]      src   source file     - Read from
+ *       @param[in]      html  HTML file       - Write to
+ *       @param[in]      notsource 1: isn't source, 0: source.
+ */
+void
+src2html(SRCCONV *conv, const char *src, const char *html, int notsource)
+{
+	STRBUF *page = conv->page;
+	char indexlink[128];
 
-	fileop_out = open_output_file(html, 0);
-	out = get_descripter(fileop_out);
-	strbuf_clear(outbuf);
+	conv->fileop_in = open_input_file(src);
+	conv->in = get_descripter(conv->fileop_in);
+        conv->curpfile = src;
+        conv->warned = 0;
+	conv->guide = NULL;
+	strbuf_reset(page);
+	strbuf_clear(conv->out);
 
 	snprintf(indexlink, sizeof(indexlink), "../mains.%s", normal_suffix);
-	fputs_nl(gen_page_begin(src, SUBDIR), out);
-	fputs_nl(body_begin, out);
+	strbuf_puts_nl(page, gen_page_begin(src, SUBDIR));
+	strbuf_puts_nl(page, body_begin);
 	/*
          * print fixed guide
          */
 	if (fixed_guide)
-		fputs(fixed_guide_link_format(anchor_getlinks(0), fill_anchor(NULL, src)), out);
+		strbuf_puts(page, fixed_guide_link_format(anchor_getlinks(conv->anchor, 0), fill_anchor(NULL, src)));
 	/*
          * print the header
          */
 	if (insert_header)
-		fputs(gen_insert_header(SUBDIR), out);
-	fputs(gen_name_string("TOP"), out);
-	fputs(header_begin, out);
-	fputs(fill_anchor(indexlink, src), out);
+		strbuf_puts(page, gen_insert_header(SUBDIR));
+	strbuf_puts(page, gen_name_string("TOP"));
+	strbuf_puts(page, header_begin);
+	strbuf_puts(page, fill_anchor(indexlink, src));
 	if (cvsweb_url) {
 		STATIC_STRBUF(sb);
 		const char *module, *basename;
@@ -846,24 +900,24 @@ src2html(const char *src, const char *html, int notsource)
 			strbuf_puts(sb, "cvsroot=");
 			strbuf_puts(sb, cvsweb_cvsroot);
 		}
-		fputs(quote_space, out);
-		fputs(gen_href_begin_simple(strbuf_value(sb)), out);
-		fputs(cvslink_begin, out);
-		fputs("[CVS]", out);
-		fputs(cvslink_end, out);
-		fputs_nl(gen_href_end(), out);
+		strbuf_puts(page, quote_space);
+		strbuf_puts(page, gen_href_begin_simple(strbuf_value(sb)));
+		strbuf_puts(page, cvslink_begin);
+		strbuf_puts(page, "[CVS]");
+		strbuf_puts(page, cvslink_end);
+		strbuf_puts_nl(page, gen_href_end());
 		/* doesn't close string buffer */
 	}
-	fputs_nl(header_end, out);
-	fputs(comment_begin, out);
-	fputs("/* ", out);
+	strbuf_puts_nl(page, header_end);
+	strbuf_puts(page, comment_begin);
+	strbuf_puts(page, "/* ");
 
-	fputs(link_format(anchor_getlinks(0)), out);
+	strbuf_puts(page, link_format(anchor_getlinks(conv->anchor, 0)));
 	if (show_position)
-		fprintf(out, "%s%s value='+1 %s' %s", quote_space, position_begin, src, position_end);
-	fputs(" */", out);
-	fputs_nl(comment_end, out);
-	fputs_nl(hr, out);
+		strbuf_sprintf(page, "%s%s value='+1 %s' %s", quote_space, position_begin, src, position_end);
+	strbuf_puts(page, " */");
+	strbuf_puts_nl(page, comment_end);
+	strbuf_puts_nl(page, hr);
         /*
          * It is not source file.
          */
@@ -871,13 +925,13 @@ src2html(const char *src, const char *html, int notsource)
 		STRBUF *sb = strbuf_open(0);
 		const char *_;
 
-		fputs_nl(verbatim_begin, out);
-		last_lineno = 0;
-		while ((_ = strbuf_fgets(sb, in, STRBUF_NOCRLF)) != NULL) {
-			fputs(gen_name_number(++last_lineno), out);
-			detab_replacing(out, _, HTML_quoting);
+		strbuf_puts_nl(page, verbatim_begin);
+		conv->last_lineno = 0;
+		while ((_ = strbuf_fgets(sb, conv->in, STRBUF_NOCRLF)) != NULL) {
+			strbuf_puts(page, gen_name_number(++conv->last_lineno));
+			detab_replacing(page, _, HTML_quoting);
 		}
-		fputs_nl(verbatim_end, out);
+		strbuf_puts_nl(page, verbatim_end);
 		strbuf_close(sb);
         }
 	/*
@@ -902,7 +956,7 @@ src2html(const char *src, const char *html, int notsource)
 			char s_id[32];
 			const char *dir, *file, *suffix, *key, *title;
 
-			fputs(header_begin, out);
+			strbuf_puts(page, header_begin);
 			if (incref->ref_count > 1) {
 				char s_count[32];
 
@@ -930,17 +984,17 @@ src2html(const char *src, const char *html, int notsource)
 				key = lno;
 				title = tooltip('I', atoi(lno), filename);
 			}
-			fputs(gen_href_begin_with_title(dir, file, suffix, key, title), out);
-			fputs(title_included_from, out);
-			fputs(gen_href_end(), out);
-			fputs_nl(header_end, out);
-			fputs_nl(hr, out);
+			strbuf_puts(page, gen_href_begin_with_title(dir, file, suffix, key, title));
+			strbuf_puts(page, title_included_from);
+			strbuf_puts(page, gen_href_end());
+			strbuf_puts_nl(page, header_end);
+			strbuf_puts_nl(page, hr);
 		}
 		/*
 		 * DEFINITIONS index.
 		 */
 		strbuf_clear(define_index);
-		for (ancref = anchor_first(); ancref; ancref = anchor_next()) {
+		for (ancref = anchor_first(conv->anchor); ancref; ancref = anchor_next(conv->anchor)) {
 			if (ancref->type == 'D') {
 				char tmp[32];
 				snprintf(tmp, sizeof(tmp), "%d", ancref->lineno);
@@ -952,23 +1006,24 @@ src2html(const char *src, const char *html, int notsource)
 			}
 		}
 		if (strbuf_getlen(define_index) > 0) {
-			fputs(header_begin, out);
-			fputs(title_define_index, out);
-			fputs_nl(header_end, out);
-			fputs_nl("This source file includes following definitions.", out);
-			fputs_nl(list_begin, out);
-			fputs(strbuf_value(define_index), out);
-			fputs_nl(list_end, out);
-			fputs_nl(hr, out);
+			strbuf_puts(page, header_begin);
+			strbuf_puts(page, title_define_index);
+			strbuf_puts_nl(page, header_end);
+			strbuf_puts_nl(page, "This source file includes following definitions.");
+			strbuf_puts_nl(page, list_begin);
+			strbuf_puts(page, strbuf_value(define_index));
+			strbuf_puts_nl(page, list_end);
+			strbuf_puts_nl(page, hr);
 		}
 		/*
 		 * print source code
 		 */
-		fputs_nl(verbatim_begin, out);
+		strbuf_puts_nl(page, verbatim_begin);
 		{
 			const char *suffix = locatestring(src, ".", MATCH_LAST);
 			const char *lang = NULL;
 			struct lang_entry *ent;
+			void *scanner;
 
 			/*
 			 * Decide language.
@@ -983,33 +1038,50 @@ src2html(const char *src, const char *html, int notsource)
 			/*
 			 * Initialize parser.
 			 */
-			ent->init_proc(in);
+			scanner = ent->init_proc(conv->in, conv);
 			/*
 			 * Execute parser.
 			 * Exec_proc() is called repeatedly until returning EOF.
 			 */
-			while (ent->exec_proc())
+			while (ent->exec_proc(scanner))
 				;
+			ent->term_proc(scanner);
 		}
-		fputs_nl(verbatim_end, out);
+		strbuf_puts_nl(page, verbatim_end);
 	}
-	fputs_nl(hr, out);
-	fputs_nl(gen_name_string("BOTTOM"), out);
-	fputs(comment_begin, out);
-	fputs("/* ", out);
-	fputs(link_format(anchor_getlinks(-1)), out);
+	strbuf_puts_nl(page, hr);
+	strbuf_puts_nl(page, gen_name_string("BOTTOM"));
+	strbuf_puts(page, comment_begin);
+	strbuf_puts(page, "/* ");
+	strbuf_puts(page, link_format(anchor_getlinks(conv->anchor, -1)));
 	if (show_position)
-		fprintf(out, "%s%s value='+%d %s' %s", quote_space, position_begin, last_lineno, src, position_end);
-	fputs(" */", out);
-	fputs_nl(comment_end, out);
+		strbuf_sprintf(page, "%s%s value='+%d %s' %s", quote_space, position_begin, conv->last_lineno, src, position_end);
+	strbuf_puts(page, " */");
+	strbuf_puts_nl(page, comment_end);
 	if (insert_footer) {
-		fputs(br, out);
-		fputs(gen_insert_footer(SUBDIR), out);
+		strbuf_puts(page, br);
+		strbuf_puts(page, gen_insert_footer(SUBDIR));
 	}
-	fputs_nl(body_end, out);
-	fputs_nl(gen_page_end(), out);
+	strbuf_puts_nl(page, body_end);
+	strbuf_puts_nl(page, gen_page_end());
 	if (!notsource)
-		anchor_unload();
-	close_file(fileop_out);
-	close_file(fileop_in);
+		anchor_unload(conv->anchor);
+	write_output_file(html, strbuf_value(page), strbuf_getlen(page));
+	close_file(conv->fileop_in);
+	conv->fileop_in = NULL;
+	conv->in = NULL;
+	conv->curpfile = NULL;
+}
+/**
+ * src2html_close: close a context of the conversion
+ *
+ *	@param[in]	conv	context
+ */
+void
+src2html_close(SRCCONV *conv)
+{
+	anchor_close(conv->anchor);
+	strbuf_close(conv->page);
+	strbuf_close(conv->out);
+	free(conv);
 }
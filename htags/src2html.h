@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SRC2HTML_H_
+#define _SRC2HTML_H_
+
+#include <stdio.h>
+
+#include "anchor.h"
+#include "fileop.h"
+#include "gparam.h"
+#include "strbuf.h"
+
+/*
+ * Context of the conversion of source files into HTML.
+ *
+ * It has the state of the conversion of a file: the input, the anchor
+ * table, the page being built and the state of the scanner. The scanners
+ * (c.l, cpp.l, ...) are reentrant and keep this context as their extra
+ * data (yyextra). The buffers are reused for every file converted with
+ * the context.
+ *
+ * The context is not meant for threads. A conversion also reads the tag
+ * cache and GPATH through libdb, and builds HTML fragments in static
+ * buffers (gen_*() in common.c), all of which belong to the process.
+ * htags converts files in parallel with worker processes instead (--jobs),
+ * and each worker opens its own context.
+ */
+typedef struct {
+	/* input */
+	FILEOP *fileop_in;
+	FILE *in;			/**< source file */
+	const char *curpfile;		/**< path of the source file */
+	ANCHOR *anchor;			/**< anchors of the source file */
+	/* output */
+	STRBUF *page;			/**< HTML image of the whole page */
+	STRBUF *out;			/**< HTML image of the current line */
+	const char *guide;		/**< guide for the current line */
+	int warned;			/**< the current line has a warning */
+	int last_lineno;		/**< last line number put */
+	/* scanner (see lexcommon.h) */
+	int lineno;
+	int begin_line;
+	int newline_terminate_string;
+	int dest_column;		/**< for converting tabs to spaces */
+	int left_spaces;		/**< for converting tabs to spaces */
+	/* language specific state of the scanner */
+	int last_directive;		/**< C, C++ and assembly */
+	int brace_level;		/**< yacc */
+	int pre_here_document;		/**< PHP */
+	char end_of_here_document[IDENTLEN];	/**< PHP */
+} SRCCONV;
+
+SRCCONV *src2html_open(void);
+void src2html(SRCCONV *, const char *, const char *, int);
+void src2html_close(SRCCONV *);
+
+#endif /* ! _SRC2HTML_H_ */
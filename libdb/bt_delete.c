@@ -41,6 +41,7 @@ static char sccsid[] = "@(#)bt_delete.c	8.13 (Berkeley) 7/28/94";
 
 #include <errno.h>
 #include <stdio.h>
+#include <stdlib.h>
 #ifdef HAVE_STRING_H
 #include <string.h>
 #else
@@ -52,6 +53,7 @@ static char sccsid[] = "@(#)bt_delete.c	8.13 (Berkeley) 7/28/94";
 
 static int __bt_bdelete(BTREE *, const DBT *);
 static int __bt_curdel(BTREE *, const DBT *, PAGE *, u_int);
+static void __bt_dpack(PAGE *, u_int);
 static int __bt_pdelete(BTREE *, PAGE *);
 static int __bt_relink(BTREE *, PAGE *);
 static int __bt_stkacq(BTREE *, PAGE **, CURSOR *);
@@ -471,11 +473,11 @@ __bt_dleaf(t, key, h, index)
 	PAGE *h;
 	u_int index;
 {
-	BLEAF *bl;
-	indx_t cnt, *ip, offset;
+	BLEAF *bl, *nbl;
+	DBT k, d, *kp = &k, *data = &d;
+	indx_t nxtindex;
 	u_int32_t nbytes;
-	void *to;
-	char *from;
+	char *buf, *dest;
 
 	/* If this record is referenced by the cursor, delete the cursor. */
 	if (F_ISSET(&t->bt_cursor, CURS_INIT) &&
@@ -484,18 +486,81 @@ __bt_dleaf(t, key, h, index)
 	    __bt_curdel(t, key, h, index))
 		return (RET_ERROR);
 
+	/*
+	 * If the next record holds its key in this one, it takes over the
+	 * key: both are removed and replaced by a record with the key and
+	 * the data of the next one.  The room of the two is always enough.
+	 */
+	bl = GETBLEAF(h, index);
+	buf = NULL;
+	nbytes = 0;
+	if (!(bl->flags & P_DUPKEY) && index + 1 < NEXTINDEX(h) &&
+	    (nbl = GETBLEAF(h, index + 1))->flags & P_DUPKEY) {
+		nbytes = NBLEAFDBT(bl->ksize, nbl->dsize);
+		if ((buf = malloc(nbytes)) == NULL)
+			return (RET_ERROR);
+		k.data = bl->bytes;
+		k.size = bl->ksize;
+		d.data = nbl->bytes;
+		d.size = nbl->dsize;
+		dest = buf;
+		WR_BLEAF(dest, kp, data, nbl->flags & ~P_DUPKEY);
+	}
+
 	/* If the entry uses overflow pages, make them available for reuse. */
-	to = bl = GETBLEAF(h, index);
-	if (bl->flags & P_BIGKEY && __ovfl_delete(t, bl->bytes) == RET_ERROR)
-		return (RET_ERROR);
-	if (bl->flags & P_BIGDATA &&
-	    __ovfl_delete(t, bl->bytes + bl->ksize) == RET_ERROR)
+	if ((bl->flags & P_BIGKEY && __ovfl_delete(t, bl->bytes) == RET_ERROR) ||
+	    (bl->flags & P_BIGDATA &&
+	    __ovfl_delete(t, bl->bytes + bl->ksize) == RET_ERROR)) {
+		if (buf)
+			free(buf);
 		return (RET_ERROR);
+	}
+	BT_KCLR(t);
+
+	if (buf) {
+		__bt_dpack(h, index + 1);
+		__bt_dpack(h, index);
+		if (index < (nxtindex = NEXTINDEX(h)))
+			memmove(h->linp + index + 1, h->linp + index,
+			    (nxtindex - index) * sizeof(indx_t));
+		h->lower += sizeof(indx_t);
+		h->linp[index] = h->upper -= nbytes;
+		memmove((char *)h + h->upper, buf, nbytes);
+		free(buf);
+	} else
+		__bt_dpack(h, index);
+
+	/* If the cursor is on this page, adjust it as necessary. */
+	if (F_ISSET(&t->bt_cursor, CURS_INIT) &&
+	    !F_ISSET(&t->bt_cursor, CURS_ACQUIRE) &&
+	    t->bt_cursor.pg.pgno == h->pgno && t->bt_cursor.pg.index > index)
+		--t->bt_cursor.pg.index;
+
+	return (RET_SUCCESS);
+}
+
+/**
+ * __bt_dpack --
+ *	Remove a record from a leaf page and pack the remaining ones.
+ *
+ *	@param h	page
+ *	@param index	index on page to remove
+ */
+static void
+__bt_dpack(h, index)
+	PAGE *h;
+	u_int index;
+{
+	BLEAF *bl;
+	indx_t cnt, *ip, offset;
+	u_int32_t nbytes;
+	char *from;
 
 	/* Pack the remaining key/data items at the end of the page. */
+	bl = GETBLEAF(h, index);
 	nbytes = NBLEAF(bl);
 	from = (char *)h + h->upper;
-	memmove(from + nbytes, from, (char *)to - from);
+	memmove(from + nbytes, from, (char *)bl - from);
 	h->upper += nbytes;
 
 	/* Adjust the indices' offsets, shift the indices down. */
@@ -506,14 +571,6 @@ __bt_dleaf(t, key, h, index)
 	for (cnt = NEXTINDEX(h) - index; --cnt; ++ip)
 		ip[0] = ip[1] < offset ? ip[1] + nbytes : ip[1];
 	h->lower -= sizeof(indx_t);
-
-	/* If the cursor is on this page, adjust it as necessary. */
-	if (F_ISSET(&t->bt_cursor, CURS_INIT) &&
-	    !F_ISSET(&t->bt_cursor, CURS_ACQUIRE) &&
-	    t->bt_cursor.pg.pgno == h->pgno && t->bt_cursor.pg.index > index)
-		--t->bt_cursor.pg.index;
-
-	return (RET_SUCCESS);
 }
 
 /**
@@ -126,8 +126,8 @@ __bt_open(fname, flags, mode, openinfo, dflags)
 	if (openinfo) {
 		b = *openinfo;
 
-		/* Flags: R_DUP. */
-		if (b.flags & ~(R_DUP))
+		/* Flags: R_DUP, R_FOLDDUP. */
+		if (b.flags & ~(R_DUP | R_FOLDDUP))
 			goto einval;
 
 		/*
@@ -164,6 +164,7 @@ __bt_open(fname, flags, mode, openinfo, dflags)
 		b.minkeypage = DEFMINKEYPAGE;
 		b.prefix = __bt_defpfx;
 		b.psize = 0;
+		b.shmsize = 0;
 	}
 
 	/* Check for the ubiquitous PDP-11. */
@@ -287,6 +288,8 @@ __bt_open(fname, flags, mode, openinfo, dflags)
 		/* Set flag if duplicates permitted. */
 		if (!(b.flags & R_DUP))
 			F_SET(t, B_NODUPS);
+		else if (b.flags & R_FOLDDUP && b.compare == __bt_defcmp)
+			F_SET(t, B_FOLDDUP);
 
 		t->bt_free = P_INVALID;
 		t->bt_nrecs = 0;
@@ -328,6 +331,13 @@ __bt_open(fname, flags, mode, openinfo, dflags)
 	if (!F_ISSET(t, B_INMEM))
 		mpool_filter(t->bt_mp, __bt_pgin, __bt_pgout, t);
 
+	/*
+	 * Attach a read only tree to the shared cache.  The cache only
+	 * saves reads, so the tree works without it.
+	 */
+	if (dflags & DB_SHMEM && b.shmsize && F_ISSET(t, B_RDONLY))
+		(void)mpool_shmem(t->bt_mp, fname, b.shmsize);
+
 	/* Create a root page if new tree. */
 	if (nroot(t) == RET_ERROR)
 		goto err;
@@ -470,3 +480,93 @@ __bt_fd(dbp)
 	}
 	return (t->bt_fd);
 }
+
+/**
+ * __bt_pagesize --
+ *	Get the page size of the tree, which is recorded in the meta page.
+ *
+ *	@param dbp	pointer to access method
+ *	@return page size
+ */
+u_int
+__bt_pagesize(dbp)
+	const DB *dbp;
+{
+	return (((BTREE *)dbp->internal)->bt_psize);
+}
+
+/**
+ * __bt_shmunlink --
+ *	Remove the shared memory segments of the directory of the file,
+ *	one for each page size which is a power of two.
+ *
+ *	@param fname	path of a file in the directory
+ *	@return RET_SUCCESS, RET_ERROR.
+ */
+int
+__bt_shmunlink(fname)
+	const char *fname;
+{
+	u_int psize;
+
+	for (psize = MINPSIZE; psize <= MAX_PAGE_OFFSET + 1; psize <<= 1)
+		if (mpool_shmunlink(fname, psize) == RET_ERROR)
+			return (RET_ERROR);
+	return (RET_SUCCESS);
+}
+
+/**
+ * __bt_getstat --
+ *	Get the cache and I/O statistics of the tree.
+ *
+ *	@param dbp	pointer to access method
+ *	@param sp	statistics are stored here
+ *	@return RET_SUCCESS, RET_ERROR.
+ */
+int
+__bt_getstat(dbp, sp)
+	const DB *dbp;
+	DBSTAT *sp;
+{
+	BTREE *t;
+	MPOOL *mp;
+	PAGE *h;
+	pgno_t i;
+
+	t = dbp->internal;
+	mp = t->bt_mp;
+
+	/* Toss any page pinned across calls. */
+	if (t->bt_pinned != NULL) {
+		mpool_put(t->bt_mp, t->bt_pinned, 0);
+		t->bt_pinned = NULL;
+	}
+
+	/* Take the counters before counting the levels disturbs them. */
+	sp->pageget = mp->pageget;
+	sp->cachehit = mp->cachehit;
+	sp->cachemiss = mp->cachemiss;
+	sp->pagenew = mp->pagenew;
+	sp->pageread = mp->pageread;
+	sp->pagereadahead = mp->pagereadahead;
+	sp->pageshared = mp->pageshared;
+	sp->pagewrite = mp->pagewrite;
+	sp->npages = mp->npages;
+	sp->psize = t->bt_psize;
+	sp->maxcache = mp->maxcache;
+
+	/* Count the levels of the tree. */
+	for (i = P_ROOT, sp->levels = 1;; ++sp->levels) {
+		if ((h = mpool_get(mp, i, 0)) == NULL)
+			return (RET_ERROR);
+		if (h->flags & (P_BLEAF|P_RLEAF)) {
+			mpool_put(mp, h, 0);
+			break;
+		}
+		i = F_ISSET(t, R_RECNO) ?
+		    GETRINTERNAL(h, 0)->pgno :
+		    GETBINTERNAL(h, 0)->pgno;
+		mpool_put(mp, h, 0);
+	}
+	return (RET_SUCCESS);
+}
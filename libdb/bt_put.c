@@ -158,6 +158,17 @@ storekey:		if (__ovfl_put(t, key, &pg) == RET_ERROR)
 		if ((h = mpool_get(t->bt_mp, t->bt_cursor.pg.pgno, 0)) == NULL)
 			return (RET_ERROR);
 		index = t->bt_cursor.pg.index;
+		/*
+		 * The next record may hold its key in this one.  It must not
+		 * be changed.
+		 */
+		if (F_ISSET(t, B_FOLDDUP) && index + 1 < NEXTINDEX(h) &&
+		    GETBLEAF(h, index + 1)->flags & P_DUPKEY &&
+		    !__bt_dupkey(t, h, index, key)) {
+			mpool_put(t->bt_mp, h, 0);
+			errno = EINVAL;
+			return (RET_ERROR);
+		}
 		goto delete;
 	}
 
@@ -198,13 +209,29 @@ delete:		if (__bt_dleaf(t, key, h, index) == RET_ERROR) {
 		break;
 	}
 
+	/*
+	 * If the key is the same as the key of the previous record, store
+	 * it only once.  Small records only: bt_psplit() may have to expand
+	 * a folded record again, which must never make a page overflow.
+	 */
+	nbytes = NBLEAFDBT(key->size, data->size);
+	if (F_ISSET(t, B_FOLDDUP) && index > 0 && !(dflags & P_BIGKEY) &&
+	    nbytes + sizeof(indx_t) <= (t->bt_psize - BTDATAOFF) / 4 &&
+	    h->upper - h->lower >= NBLEAFDBT(0, data->size) + sizeof(indx_t) &&
+	    __bt_dupkey(t, h, index - 1, key)) {
+		tkey.data = kb;
+		tkey.size = 0;
+		key = &tkey;
+		dflags |= P_DUPKEY;
+		nbytes = NBLEAFDBT(0, data->size);
+	}
+
 	/*
 	 * If not enough room, or the user has put a ceiling on the number of
 	 * keys permitted in the page, split the page.  The split code will
 	 * insert the key and data and unpin the current page.  If inserting
 	 * into the offset array, shift the pointers up.
 	 */
-	nbytes = NBLEAFDBT(key->size, data->size);
 	if (h->upper - h->lower < nbytes + sizeof(indx_t)) {
 		if ((status = __bt_split(t, h, key,
 		    data, dflags, nbytes, index)) != RET_SUCCESS)
@@ -220,6 +247,7 @@ delete:		if (__bt_dleaf(t, key, h, index) == RET_ERROR) {
 	h->linp[index] = h->upper -= nbytes;
 	dest = (char *)h + h->upper;
 	WR_BLEAF(dest, key, data, dflags);
+	BT_KCLR(t);
 
 	/* If the cursor is on this page, adjust it as necessary. */
 	if (F_ISSET(&t->bt_cursor, CURS_INIT) &&
@@ -284,7 +284,7 @@ __bt_seqadv(t, ep, flags)
 			mpool_put(t->bt_mp, h, 0);
 			if (pg == P_INVALID)
 				return (RET_SPECIAL);
-			if ((h = mpool_get(t->bt_mp, pg, 0)) == NULL)
+			if ((h = mpool_get(t->bt_mp, pg, MPOOL_SEQUENTIAL)) == NULL)
 				return (RET_ERROR);
 			index = 0;
 		}
@@ -416,7 +416,7 @@ __bt_first(t, key, erval, exactp)
 		mpool_put(t->bt_mp, h, 0);
 		if (pg == P_INVALID)
 			return (RET_SPECIAL);
-		if ((h = mpool_get(t->bt_mp, pg, 0)) == NULL)
+		if ((h = mpool_get(t->bt_mp, pg, MPOOL_SEQUENTIAL)) == NULL)
 			return (RET_ERROR);
 		ep->index = 0;
 		ep->page = h;
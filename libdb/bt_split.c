@@ -110,6 +110,7 @@ __bt_split(t, sp, key, data, flags, ilen, argskip)
 	    bt_page(t, sp, &l, &r, &skip, ilen);
 	if (h == NULL)
 		return (RET_ERROR);
+	BT_KCLR(t);
 
 	/*
 	 * Insert the new key/data pair into the leaf page.  (Key inserts
@@ -189,7 +190,8 @@ __bt_split(t, sp, key, data, flags, ilen, argskip)
 			nbytes = NBINTERNAL(bl->ksize);
 			if (t->bt_pfx && !(bl->flags & P_BIGKEY) &&
 			    (h->prevpg != P_INVALID || skip > 1)) {
-				tbl = GETBLEAF(lchild, NEXTINDEX(lchild) - 1);
+				tbl = __bt_leafkey(t,
+				    lchild, NEXTINDEX(lchild) - 1);
 				a.size = tbl->ksize;
 				a.data = tbl->bytes;
 				b.size = bl->ksize;
@@ -612,14 +614,16 @@ bt_psplit(t, h, l, r, pskip, ilen)
 	size_t ilen;
 {
 	BINTERNAL *bi;
-	BLEAF *bl;
+	BLEAF *bl, *kl;
 	CURSOR *c;
+	DBT k, d, *kp = &k, *data = &d;
 	RLEAF *rl;
 	PAGE *rval;
 	void *src = NULL;
 	indx_t full, half, nxt, off, skip, top, used;
-	u_int32_t nbytes;
+	u_int32_t nbytes, total;
 	int bigkeycnt, isbigkey;
+	char *dest;
 
 	/*
 	 * Split the data to the left and right pages.  Leave the skip index
@@ -691,6 +695,35 @@ bt_psplit(t, h, l, r, pskip, ilen)
 		}
 	}
 
+	/*
+	 * The first record on the right page must hold its key.  If it is
+	 * folded, it is expanded when copied below.  Should the right page
+	 * not have room for the expanded record, move folded records to the
+	 * left page.  As records are folded only if they are small (see
+	 * __bt_put()), one of the pages always has room.
+	 */
+	if ((h->flags & P_TYPE) == P_BLEAF && F_ISSET(t, B_FOLDDUP)) {
+		total = (t->bt_psize - h->upper) + (h->lower - BTDATAOFF) +
+		    ilen + sizeof(indx_t);
+		while (nxt < top - 1 && skip != off + 1) {
+			bl = GETBLEAF(h, nxt);
+			if (!(bl->flags & P_DUPKEY))
+				break;
+			kl = __bt_leafkey(t, h, nxt);
+			nbytes = NBLEAF(bl);
+			if (total - used - nbytes +
+			    NBLEAFDBT(kl->ksize, bl->dsize) <= full)
+				break;
+			if (used + nbytes + sizeof(indx_t) >= full)
+				break;
+			++off;
+			++nxt;
+			l->linp[off] = l->upper -= nbytes;
+			memmove((char *)l + l->upper, bl, nbytes);
+			used += nbytes + sizeof(indx_t);
+		}
+	}
+
 	/*
 	 * Off is the last offset that's valid for the left page.
 	 * Nxt is the first offset to be placed on the right page.
@@ -742,6 +775,19 @@ bt_psplit(t, h, l, r, pskip, ilen)
 		case P_BLEAF:
 			src = bl = GETBLEAF(h, nxt);
 			nbytes = NBLEAF(bl);
+			if (off == 0 && bl->flags & P_DUPKEY) {
+				kl = __bt_leafkey(t, h, nxt);
+				k.data = kl->bytes;
+				k.size = kl->ksize;
+				d.data = bl->bytes;
+				d.size = bl->dsize;
+				++nxt;
+				r->linp[off] = r->upper -=
+				    NBLEAFDBT(k.size, d.size);
+				dest = (char *)r + r->upper;
+				WR_BLEAF(dest, kp, data, bl->flags & ~P_DUPKEY);
+				continue;
+			}
 			break;
 		case P_RINTERNAL:
 			src = GETRINTERNAL(h, nxt);
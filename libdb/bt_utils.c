@@ -72,10 +72,11 @@ __bt_ret(t, e, key, rkey, data, rdata, copy)
 	DBT *key, *rkey, *data, *rdata;
 	int copy;
 {
-	BLEAF *bl;
+	BLEAF *bl, *kl;
 	void *p;
 
 	bl = GETBLEAF(e->page, e->index);
+	kl = __bt_leafkey(t, e->page, e->index);
 
 	/*
 	 * We must copy big keys/data to make them contigous.  Otherwise,
@@ -85,26 +86,26 @@ __bt_ret(t, e, key, rkey, data, rdata, copy)
 	if (key == NULL)
 		goto dataonly;
 
-	if (bl->flags & P_BIGKEY) {
-		if (__ovfl_get(t, bl->bytes,
+	if (kl->flags & P_BIGKEY) {
+		if (__ovfl_get(t, kl->bytes,
 		    &key->size, &rkey->data, &rkey->size))
 			return (RET_ERROR);
 		key->data = rkey->data;
 	} else if (copy || F_ISSET(t, B_DB_LOCK)) {
-		if (bl->ksize > rkey->size) {
+		if (kl->ksize > rkey->size) {
 			p = (void *)(rkey->data == NULL ?
-			    malloc(bl->ksize) : realloc(rkey->data, bl->ksize));
+			    malloc(kl->ksize) : realloc(rkey->data, kl->ksize));
 			if (p == NULL)
 				return (RET_ERROR);
 			rkey->data = p;
-			rkey->size = bl->ksize;
+			rkey->size = kl->ksize;
 		}
-		memmove(rkey->data, bl->bytes, bl->ksize);
-		key->size = bl->ksize;
+		memmove(rkey->data, kl->bytes, kl->ksize);
+		key->size = kl->ksize;
 		key->data = rkey->data;
 	} else {
-		key->size = bl->ksize;
-		key->data = bl->bytes;
+		key->size = kl->ksize;
+		key->data = kl->bytes;
 	}
 
 dataonly:
@@ -138,6 +139,73 @@ dataonly:
 	return (RET_SUCCESS);
 }
 
+/**
+ * __BT_LEAFKEY -- Get the record holding the key of a leaf record.
+ *
+ *	@param t	tree
+ *	@param h	leaf page
+ *	@param index	index of the record
+ *
+ * @return
+ *	The BLEAF of the record itself, or of the nearest previous record
+ *	without P_DUPKEY if the key is folded.
+ *
+ * The last run resolved is remembered in the tree, so sequential access
+ * and binary searches don't walk back the same run over and over.  Any
+ * change of a leaf page must forget it with BT_KCLR().
+ */
+BLEAF *
+__bt_leafkey(t, h, index)
+	BTREE *t;
+	PAGE *h;
+	u_int index;
+{
+	BLEAF *bl;
+	u_int i;
+
+	for (i = index; (bl = GETBLEAF(h, i))->flags & P_DUPKEY; --i) {
+		if (h->pgno == t->bt_kpgno &&
+		    i > t->bt_khead && i <= t->bt_kindex) {
+			i = t->bt_khead;
+			bl = GETBLEAF(h, i);
+			break;
+		}
+	}
+	if (i != index && (h->pgno != t->bt_kpgno ||
+	    i != t->bt_khead || index > t->bt_kindex)) {
+		t->bt_kpgno = h->pgno;
+		t->bt_khead = i;
+		t->bt_kindex = index;
+	}
+	return (bl);
+}
+
+/**
+ * __BT_DUPKEY -- Check whether a key may be folded into a leaf record.
+ *
+ *	@param t	tree
+ *	@param h	leaf page
+ *	@param index	index of the record
+ *	@param key	key
+ *
+ * @return
+ *	1 if the record has exactly the same key which is not on overflow
+ *	pages, else 0.
+ */
+int
+__bt_dupkey(t, h, index, key)
+	BTREE *t;
+	PAGE *h;
+	u_int index;
+	const DBT *key;
+{
+	BLEAF *bl;
+
+	bl = __bt_leafkey(t, h, index);
+	return (!(bl->flags & P_BIGKEY) && bl->ksize == key->size &&
+	    memcmp(bl->bytes, key->data, key->size) == 0);
+}
+
 /*
  * __BT_CMP -- Compare a key to a given record.
  *
@@ -175,7 +243,7 @@ __bt_cmp(t, k1, e)
 
 	bigkey = NULL;
 	if (h->flags & P_BLEAF) {
-		bl = GETBLEAF(h, e->index);
+		bl = __bt_leafkey(t, h, e->index);
 		if (bl->flags & P_BIGKEY)
 			bigkey = bl->bytes;
 		else {
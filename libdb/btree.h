@@ -182,11 +182,21 @@ typedef struct _rinternal {
 	*(pgno_t *)p = pgno;						\
 }
 
-/** For the btree leaf pages, the item is a key and data pair. */
+/**
+ * For the btree leaf pages, the item is a key and data pair.
+ *
+ * In a tree with B_FOLDDUP, a record whose key is the same as the key of the
+ * previous record on the page may be stored without the key.  Such a record
+ * has P_DUPKEY and a ksize of 0, and its key is held by the nearest previous
+ * record without P_DUPKEY (see __bt_leafkey()).  The first record on a page
+ * and records with P_BIGKEY never have P_DUPKEY.
+ */
 typedef struct _bleaf {
 	u_int32_t	ksize;		/**< size of key */
 	u_int32_t	dsize;		/**< size of data */
-	u_char	flags;			/**< P_BIGDATA, P_BIGKEY */
+		/** key is held by the previous record */
+#define	P_DUPKEY	0x04
+	u_char	flags;			/**< P_BIGDATA, P_BIGKEY, P_DUPKEY */
 	char	bytes[1];		/**< data */
 } BLEAF;
 
@@ -316,7 +326,7 @@ typedef struct _btmeta {
 	u_int32_t	free;		/**< page number of first free page */
 	u_int32_t	nrecs;		/**< R: number of records */
 
-#define	SAVEMETA	(B_NODUPS | R_RECNO)
+#define	SAVEMETA	(B_NODUPS | R_RECNO | B_FOLDDUP)
 	u_int32_t	flags;		/**< bt_flags & SAVEMETA */
 } BTMETA;
 
@@ -354,6 +364,11 @@ typedef struct _btree {
 	enum { NOT, BACK, FORWARD } bt_order;
 	EPGNO	  bt_last;		/**< last insert */
 
+#define	BT_KCLR(t)	((t)->bt_kpgno = P_INVALID)
+	pgno_t	  bt_kpgno;		/**< page of the last folded run */
+	indx_t	  bt_khead;		/**< index of the record holding the key */
+	indx_t	  bt_kindex;		/**< last index known to be in the run */
+
 					/** B: key comparison function */
 	int	(*bt_cmp)(const DBT *, const DBT *);
 					/** B: prefix comparison function */
@@ -375,7 +390,7 @@ typedef struct _btree {
 
 /*
  * NB:
- * B_NODUPS and R_RECNO are stored on disk, and may not be changed.
+ * B_NODUPS, R_RECNO and B_FOLDDUP are stored on disk, and may not be changed.
  */
 		/** in-memory tree */
 #define	B_INMEM		0x00001
@@ -417,6 +432,10 @@ typedef struct _btree {
 #define	B_DB_SHMEM	0x08000
 		/** DB_TXN specified. */
 #define	B_DB_TXN	0x10000
+
+/** duplicate keys are folded in leaf pages.
+    [Note] B_FOLDDUP is stored on disk, and may not be changed. */
+#define	B_FOLDDUP	0x20000
 	u_int32_t flags;
 } BTREE;
 
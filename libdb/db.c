@@ -73,11 +73,72 @@ dbopen(fname, flags, mode, type, openinfo)
 			return (__rec_open(fname, (flags & USE_OPEN_FLAGS) | O_BINARY,
 			    mode, openinfo, flags & DB_FLAGS));
 			*/
+		case DB_SSTABLE:
+			;
 		}
 	errno = EINVAL;
 	return (NULL);
 }
 
+/**
+ * dbstat -- Get the cache and I/O statistics of a database.
+ *
+ *	@param dbp	pointer to the DB structure.
+ *	@param sp	statistics are stored here.
+ *	@return RET_SUCCESS, RET_ERROR.
+ */
+int
+dbstat(dbp, sp)
+	const DB *dbp;
+	DBSTAT *sp;
+{
+	switch (dbp->type) {
+	case DB_BTREE:
+		return (__bt_getstat(dbp, sp));
+	default:
+		break;
+	}
+	errno = EINVAL;
+	return (RET_ERROR);
+}
+
+/**
+ * dbpagesize -- Get the page size of a database.
+ *
+ * Unlike dbstat(), it reads no page.
+ *
+ *	@param dbp	pointer to the DB structure.
+ *	@return page size, 0 if the access method has no pages.
+ */
+u_int
+dbpagesize(dbp)
+	const DB *dbp;
+{
+	switch (dbp->type) {
+	case DB_BTREE:
+		return (__bt_pagesize(dbp));
+	default:
+		break;
+	}
+	return (0);
+}
+
+/**
+ * dbshmunlink -- Remove the shared memory segments of a directory.
+ *
+ * They are made by the databases opened with DB_SHMEM in the directory,
+ * and are left when the databases are closed.
+ *
+ *	@param fname	path of a file in the directory.
+ *	@return RET_SUCCESS, RET_ERROR.
+ */
+int
+dbshmunlink(fname)
+	const char *fname;
+{
+	return (__bt_shmunlink(fname));
+}
+
 static int
 __dberr(void)
 {
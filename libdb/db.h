@@ -91,7 +91,8 @@ typedef struct {
 		/** sync (RECNO) */
 #define	R_RECNOSYNC	11
 
-typedef enum { DB_BTREE, DB_HASH, DB_RECNO } DBTYPE;
+/** DB_SSTABLE is a read only table of GLOBAL (libutil/sstable.c). */
+typedef enum { DB_BTREE, DB_HASH, DB_RECNO, DB_SSTABLE } DBTYPE;
 
 /**
  * !!!
@@ -102,9 +103,11 @@ typedef enum { DB_BTREE, DB_HASH, DB_RECNO } DBTYPE;
  * a problem.  Wish I'd left another flags word in the dbopen call.
  *
  * !!!
- * None of this stuff is implemented yet.  The only reason that it's here
- * is so that the access methods can skip copying the key/data pair when
- * the DB_LOCK flag isn't set.
+ * Only DB_SHMEM is implemented: a B-tree opened read only with a shmsize
+ * in its BTREEINFO shares the pages it reads with other processes through
+ * a shared memory segment (see mpool.h).  The other flags are here only
+ * so that the access methods can skip copying the key/data pair when the
+ * DB_LOCK flag isn't set.
  */
 #if UINT_MAX > 65535
 				/** Do locking. */
@@ -141,6 +144,8 @@ typedef struct __db {
 #define	BTREEVERSION	3
 		/** duplicate keys */
 #define	R_DUP		0x01
+		/** store a duplicate key once per run in a leaf page */
+#define	R_FOLDDUP	0x02
 
 /** Structure used to pass parameters to the btree routines. */
 typedef struct {
@@ -154,8 +159,25 @@ typedef struct {
 	size_t	(*prefix)	/**< prefix function */
 	   (const DBT *, const DBT *);
 	int	lorder;		/**< byte order */
+	u_long	shmsize;	/**< bytes of the shared cache (DB_SHMEM) */
 } BTREEINFO;
 
+/** Structure returned by dbstat(). */
+typedef struct {
+	u_long	pageget;	/**< pages requested to the cache */
+	u_long	cachehit;	/**< pages found in the cache */
+	u_long	cachemiss;	/**< pages not found in the cache */
+	u_long	pagenew;	/**< pages allocated */
+	u_long	pageread;	/**< pages read on demand */
+	u_long	pagereadahead;	/**< pages read ahead */
+	u_long	pageshared;	/**< pages copied from the shared cache */
+	u_long	pagewrite;	/**< pages written */
+	u_long	npages;		/**< pages in the file */
+	u_int	psize;		/**< page size */
+	u_int	maxcache;	/**< max pages cached */
+	int	levels;		/**< levels of the tree */
+} DBSTAT;
+
 #define	HASHMAGIC	0x061561
 #define	HASHVERSION	2
 
@@ -237,9 +259,15 @@ typedef struct {
 }
 
 DB	*dbopen(const char *, int, int, DBTYPE, const void *);
+int	 dbstat(const DB *, DBSTAT *);
+u_int	 dbpagesize(const DB *);
+int	 dbshmunlink(const char *);
 
 DB	*__bt_open(const char *, int, int, const BTREEINFO *, int);
 DB	*__hash_open(const char *, int, int, const HASHINFO *, int);
 DB	*__rec_open(const char *, int, int, const RECNOINFO *, int);
+int	 __bt_getstat(const DB *, DBSTAT *);
+u_int	 __bt_pagesize(const DB *);
+int	 __bt_shmunlink(const char *);
 void	 __dbpanic(DB *dbp);
 #endif /* !_DB_H_ */
@@ -36,9 +36,11 @@ int	 __bt_defcmp(const DBT *, const DBT *);
 size_t	 __bt_defpfx(const DBT *, const DBT *);
 int	 __bt_delete(const DB *, const DBT *, u_int);
 int	 __bt_dleaf(BTREE *, const DBT *, PAGE *, u_int);
+int	 __bt_dupkey(BTREE *, PAGE *, u_int, const DBT *);
 int	 __bt_fd(const DB *);
 int	 __bt_free(BTREE *, PAGE *);
 int	 __bt_get(const DB *, const DBT *, DBT *, u_int);
+BLEAF	*__bt_leafkey(BTREE *, PAGE *, u_int);
 PAGE	*__bt_new(BTREE *, pgno_t *);
 void	 __bt_pgin(void *, pgno_t, void *);
 void	 __bt_pgout(void *, pgno_t, void *);
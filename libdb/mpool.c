@@ -53,6 +53,12 @@ static char sccsid[] = "@(#)mpool.c	8.5 (Berkeley) 7/26/94";
 #if (defined(_WIN32) && !defined(__CYGWIN__))
 #define fsync _commit
 #endif
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
+#ifndef PATH_MAX
+#define PATH_MAX	1024
+#endif
 
 #include "queue.h"
 #include "db.h"
@@ -60,8 +66,46 @@ static char sccsid[] = "@(#)mpool.c	8.5 (Berkeley) 7/26/94";
 #define	__MPOOLINTERFACE_PRIVATE
 #include "mpool.h"
 
+#ifdef MPOOL_SHMEM
+#include <sys/mman.h>
+#include <fcntl.h>
+
+/*
+ * The shared memory segment begins with a header, which is followed by
+ * the slots.  Each slot is a SHMSLOT followed by a page of psize bytes.
+ * The segment is created zero filled, i.e. with all the slots empty.
+ */
+#define	SHMMAGIC	0x0b1d5a7e
+#define	SHMVERSION	1
+#define	SHMMINSLOTS	16
+typedef struct {
+	volatile u_int32_t magic;	/* set last by the creator */
+	u_int32_t version;
+	u_int32_t psize;		/* page size of a slot */
+	u_int32_t nslots;		/* number of slots */
+} SHMHDR;
+typedef struct {
+	volatile u_int32_t seq;		/* odd while being updated */
+	volatile u_int32_t pgno;	/* page number */
+	volatile u_int32_t gen;		/* generation of the file */
+	u_int32_t pad;
+} SHMSLOT;
+#define	SHMSLOTSIZE(psize)	(sizeof(SHMSLOT) + (psize))
+
+static u_int32_t shm_hash(u_int32_t, const void *, size_t);
+static int  shm_name(char *, size_t, const char *, u_int);
+static SHMSLOT *mpool_shmslot(MPOOL *, pgno_t);
+static int  mpool_shmget(MPOOL *, BKT *, pgno_t);
+static void mpool_shmput(MPOOL *, BKT *, pgno_t);
+#endif
+
 static BKT *mpool_bkt(MPOOL *);
+static BKT *mpool_find(MPOOL *, pgno_t);
 static BKT *mpool_look(MPOOL *, pgno_t);
+static void mpool_link(MPOOL *, BKT *);
+static void mpool_touch(MPOOL *, BKT *);
+static int  mpool_read(MPOOL *, BKT *, pgno_t);
+static int  mpool_readahead(MPOOL *, BKT *, pgno_t);
 static int  mpool_write(MPOOL *, BKT *);
 
 /**
@@ -100,9 +144,12 @@ mpool_open(key, fd, pagesize, maxcache)
 	if ((mp = (MPOOL *)calloc(1, sizeof(MPOOL))) == NULL)
 		return (NULL);
 	CIRCLEQ_INIT(&mp->lqh);
+	CIRCLEQ_INIT(&mp->oqh);
 	for (entry = 0; entry < HASHSIZE; ++entry)
 		CIRCLEQ_INIT(&mp->hqh[entry]);
 	mp->maxcache = maxcache;
+	/* Don't let reading ahead push out much of a small cache. */
+	mp->ramax = maxcache / 8 < READAHEAD ? maxcache / 8 : READAHEAD;
 	mp->npages = sb.st_size / pagesize;
 	mp->pagesize = pagesize;
 	mp->fd = fd;
@@ -142,29 +189,23 @@ mpool_new(mp, pgnoaddr)
 	MPOOL *mp;
 	pgno_t *pgnoaddr;
 {
-	struct _hqh *head;
 	BKT *bp;
 
 	if (mp->npages == MAX_PAGE_NUMBER) {
 		(void)fprintf(stderr, "mpool_new: page allocation overflow.\n");
 		abort();
 	}
-#ifdef STATISTICS
 	++mp->pagenew;
-#endif
 	/*
 	 * Get a BKT from the cache.  Assign a new page number, attach
-	 * it to the head of the hash chain, the tail of the lru chain,
+	 * it to the head of the hash chain, the tail of the old chain,
 	 * and return.
 	 */
 	if ((bp = mpool_bkt(mp)) == NULL)
 		return (NULL);
 	*pgnoaddr = bp->pgno = mp->npages++;
 	bp->flags = MPOOL_PINNED;
-
-	head = &mp->hqh[HASHKEY(bp->pgno)];
-	CIRCLEQ_INSERT_HEAD(head, bp, hq);
-	CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+	mpool_link(mp, bp);
 	return (bp->page);
 }
 
@@ -180,12 +221,11 @@ void *
 mpool_get(mp, pgno, flags)
 	MPOOL *mp;
 	pgno_t pgno;
-	u_int flags;				/* XXX not used? */
+	u_int flags;
 {
 	struct _hqh *head;
 	BKT *bp;
-	off_t off;
-	int nr;
+	int sequential;
 
 	/* Check for attempt to retrieve a non-existent page. */
 	if (pgno >= mp->npages) {
@@ -193,9 +233,11 @@ mpool_get(mp, pgno, flags)
 		return (NULL);
 	}
 
-#ifdef STATISTICS
 	++mp->pageget;
-#endif
+	sequential = (flags & MPOOL_SEQUENTIAL) &&
+	    pgno > mp->seqlast && pgno - mp->seqlast <= READAHEAD;
+	if (flags & MPOOL_SEQUENTIAL)
+		mp->seqlast = pgno;
 
 	/* Check for a page that is cached. */
 	if ((bp = mpool_look(mp, pgno)) != NULL) {
@@ -213,8 +255,7 @@ mpool_get(mp, pgno, flags)
 		head = &mp->hqh[HASHKEY(bp->pgno)];
 		CIRCLEQ_REMOVE(head, bp, hq);
 		CIRCLEQ_INSERT_HEAD(head, bp, hq);
-		CIRCLEQ_REMOVE(&mp->lqh, bp, q);
-		CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+		mpool_touch(mp, bp);
 
 		/* Return a pinned page. */
 		bp->flags |= MPOOL_PINNED;
@@ -225,44 +266,23 @@ mpool_get(mp, pgno, flags)
 	if ((bp = mpool_bkt(mp)) == NULL)
 		return (NULL);
 
-	/* Read in the contents. */
-#ifdef STATISTICS
-	++mp->pageread;
-#endif
-
 	/*
-	 * If both of `off_t' and `long' are 32 bits, the right operand
-	 * of the multiplication is converted to `unsigned long',
-	 * and the multiplication is done with unsigned 32 bits.
-	 * It is equivalent to the case without cast.
-	 *
-	 * If `off_t' is 64 bits and `long' is 32 bits, the left operand
-	 * of the multiplication is converted to `off_t',
-	 * and the multiplication is done with signed 64 bits.
-	 * Adding cast avoids integer overflow.
-	 *
-	 * If both of `off_t' and `long' are 64 bits, the right operand
-	 * of the multiplication is converted to `unsigned long',
-	 * and the multiplication is done with unsigned 64 bits.
-	 * It is equivalent to the case without cast.
+	 * Read in the contents, and the following pages in a scan.  With
+	 * a shared memory segment, a page is copied from it if it is there,
+	 * and a page read on demand is published to it.
 	 */
-	off = mp->pagesize * (off_t)pgno;
-
-#if defined(HAVE_PREAD) && !defined(__CYGWIN__)
-	if ((nr = pread(mp->fd, bp->page, mp->pagesize, off)) != mp->pagesize) {
-		if (nr >= 0)
-			errno = EFTYPE;
-		return (NULL);
-	}
-#else
-	if (lseek(mp->fd, off, SEEK_SET) != off)
-		return (NULL);
-	if ((nr = read(mp->fd, bp->page, mp->pagesize)) != mp->pagesize) {
-		if (nr >= 0)
-			errno = EFTYPE;
-		return (NULL);
-	}
+#ifdef MPOOL_SHMEM
+	if (mp->shm != NULL && mpool_shmget(mp, bp, pgno) == RET_SUCCESS)
+		;
+	else if (!sequential && mp->shm != NULL) {
+		if (mpool_read(mp, bp, pgno) == RET_ERROR)
+			return (NULL);
+		mpool_shmput(mp, bp, pgno);
+	} else
 #endif
+	if ((sequential ? mpool_readahead(mp, bp, pgno) :
+	    mpool_read(mp, bp, pgno)) == RET_ERROR)
+		return (NULL);
 
 	/* Set the page number, pin the page. */
 	bp->pgno = pgno;
@@ -270,11 +290,9 @@ mpool_get(mp, pgno, flags)
 
 	/*
 	 * Add the page to the head of the hash chain and the tail
-	 * of the lru chain.
+	 * of the old chain.
 	 */
-	head = &mp->hqh[HASHKEY(bp->pgno)];
-	CIRCLEQ_INSERT_HEAD(head, bp, hq);
-	CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+	mpool_link(mp, bp);
 
 	/* Run through the user's filter. */
 	if (mp->pgin != NULL)
@@ -299,9 +317,7 @@ mpool_put(mp, page, flags)
 {
 	BKT *bp;
 
-#ifdef STATISTICS
 	++mp->pageput;
-#endif
 	bp = (BKT *)((char *)page - sizeof(BKT));
 #ifdef DEBUG
 	if (!(bp->flags & MPOOL_PINNED)) {
@@ -332,12 +348,283 @@ mpool_close(mp)
 		CIRCLEQ_REMOVE(&mp->lqh, mp->lqh.cqh_first, q);
 		free(bp);
 	}
+	while ((bp = mp->oqh.cqh_first) != (void *)&mp->oqh) {
+		CIRCLEQ_REMOVE(&mp->oqh, mp->oqh.cqh_first, q);
+		free(bp);
+	}
 
+#ifdef MPOOL_SHMEM
+	if (mp->shm != NULL)
+		(void)munmap(mp->shm, mp->shmsize);
+#endif
 	/* Free the MPOOL cookie. */
+	if (mp->rabuf != NULL)
+		free(mp->rabuf);
 	free(mp);
 	return (RET_SUCCESS);
 }
 
+/**
+ * mpool_shmem
+ *	Attach a read only pool to the shared memory segment of the
+ *	directory of the file and its page size, creating it of size
+ *	bytes if it does not exist.  The segment is private to the user,
+ *	and holds the pages of all the files of the page size in the
+ *	directory, which are told apart by the generation computed from
+ *	the status of each file.  A rewritten file has a new generation,
+ *	so its old pages are never found.  The segment is left when the
+ *	pool is closed, so that the next process starts warm; it is
+ *	removed by mpool_shmunlink().
+ *
+ *	@param mp
+ *	@param fname	path of the file
+ *	@param size	size of the segment
+ *	@return RET_SUCCESS, RET_ERROR.
+ */
+int
+mpool_shmem(mp, fname, size)
+	MPOOL *mp;
+	const char *fname;
+	size_t size;
+{
+#ifdef MPOOL_SHMEM
+	struct stat sb;
+	SHMHDR *hp;
+	char name[64];
+	u_int32_t gen;
+	int fd, created;
+
+	if (fstat(mp->fd, &sb) < 0 ||
+	    shm_name(name, sizeof(name), fname, mp->pagesize) == RET_ERROR)
+		return (RET_ERROR);
+	gen = shm_hash(2166136261U, &sb.st_dev, sizeof(sb.st_dev));
+	gen = shm_hash(gen, &sb.st_ino, sizeof(sb.st_ino));
+	gen = shm_hash(gen, &sb.st_size, sizeof(sb.st_size));
+	gen = shm_hash(gen, &sb.st_mtime, sizeof(sb.st_mtime));
+	gen = shm_hash(gen, &sb.st_ctime, sizeof(sb.st_ctime));
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	gen = shm_hash(gen, &sb.st_mtim.tv_nsec, sizeof(sb.st_mtim.tv_nsec));
+#endif
+	/* Zero is the generation of the empty slots. */
+	mp->shmgen = gen ? gen : 1;
+
+	created = 0;
+	if ((fd = shm_open(name, O_RDWR|O_CREAT|O_EXCL, 0600)) >= 0) {
+		created = 1;
+		if (size < sizeof(SHMHDR) + SHMSLOTSIZE(mp->pagesize) * SHMMINSLOTS ||
+		    ftruncate(fd, size) < 0) {
+			(void)close(fd);
+			(void)shm_unlink(name);
+			return (RET_ERROR);
+		}
+	} else if (errno != EEXIST || (fd = shm_open(name, O_RDWR, 0)) < 0)
+		return (RET_ERROR);
+	else if (fstat(fd, &sb) < 0 || (size_t)sb.st_size < sizeof(SHMHDR)) {
+		(void)close(fd);
+		return (RET_ERROR);
+	} else
+		size = sb.st_size;
+	hp = (SHMHDR *)mmap(NULL, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+	(void)close(fd);
+	if (hp == (SHMHDR *)MAP_FAILED) {
+		if (created)
+			(void)shm_unlink(name);
+		return (RET_ERROR);
+	}
+	if (created) {
+		hp->version = SHMVERSION;
+		hp->psize = mp->pagesize;
+		hp->nslots = (size - sizeof(SHMHDR)) / SHMSLOTSIZE(mp->pagesize);
+		__sync_synchronize();
+		hp->magic = SHMMAGIC;
+	} else {
+		/* A segment being created is not used this time. */
+		if (hp->magic == SHMMAGIC)
+			__sync_synchronize();
+		if (hp->magic != SHMMAGIC || hp->version != SHMVERSION ||
+		    hp->psize != mp->pagesize || hp->nslots == 0 ||
+		    sizeof(SHMHDR) + hp->nslots * SHMSLOTSIZE(hp->psize) > size) {
+			(void)munmap((void *)hp, size);
+			return (RET_ERROR);
+		}
+	}
+	mp->shm = (char *)hp;
+	mp->shmsize = size;
+	return (RET_SUCCESS);
+#else
+	errno = ENOSYS;
+	return (RET_ERROR);
+#endif
+}
+
+/**
+ * mpool_shmunlink
+ *	Remove the shared memory segment of the directory of the file
+ *	and a page size.  The processes attached to it keep using it
+ *	until they close their pools.
+ *
+ *	@param fname	path of a file in the directory
+ *	@param psize	page size
+ *	@return RET_SUCCESS, RET_ERROR.
+ */
+int
+mpool_shmunlink(fname, psize)
+	const char *fname;
+	u_int psize;
+{
+#ifdef MPOOL_SHMEM
+	char name[64];
+
+	if (shm_name(name, sizeof(name), fname, psize) == RET_ERROR)
+		return (RET_ERROR);
+	if (shm_unlink(name) < 0 && errno != ENOENT)
+		return (RET_ERROR);
+	return (RET_SUCCESS);
+#else
+	errno = ENOSYS;
+	return (RET_ERROR);
+#endif
+}
+
+#ifdef MPOOL_SHMEM
+/**
+ * shm_name
+ *	Make the name of the shared memory segment of the directory of
+ *	the file and a page size.  The pages of a size are kept apart
+ *	from the others, so that a file need not fit the slots made for
+ *	another.
+ *
+ *	@param name	the name is stored here
+ *	@param size	size of name
+ *	@param fname	path of the file
+ *	@param psize	page size
+ *	@return RET_SUCCESS, RET_ERROR.
+ */
+static int
+shm_name(name, size, fname, psize)
+	char *name;
+	size_t size;
+	const char *fname;
+	u_int psize;
+{
+	char path[PATH_MAX], *p;
+
+	if (realpath(fname, path) == NULL)
+		return (RET_ERROR);
+	if ((p = strrchr(path, '/')) != NULL)
+		*p = '\0';
+	(void)snprintf(name, size, "/global.%lu.%08lx.%u",
+	    (u_long)getuid(), (u_long)shm_hash(2166136261U, path, strlen(path)),
+	    psize);
+	return (RET_SUCCESS);
+}
+
+/**
+ * shm_hash
+ *	FNV-1a hash.
+ *
+ *	@param h	initial value
+ *	@param p
+ *	@param len
+ */
+static u_int32_t
+shm_hash(h, p, len)
+	u_int32_t h;
+	const void *p;
+	size_t len;
+{
+	const unsigned char *s = p;
+
+	while (len-- > 0) {
+		h ^= *s++;
+		h *= 16777619U;
+	}
+	return (h);
+}
+
+/**
+ * mpool_shmslot
+ *	Get the slot of a page in the shared memory segment.
+ *
+ *	@param mp
+ *	@param pgno
+ */
+static SHMSLOT *
+mpool_shmslot(mp, pgno)
+	MPOOL *mp;
+	pgno_t pgno;
+{
+	SHMHDR *hp = (SHMHDR *)mp->shm;
+	u_int32_t h;
+
+	h = shm_hash(mp->shmgen, &pgno, sizeof(pgno));
+	return ((SHMSLOT *)(mp->shm + sizeof(SHMHDR) +
+	    (size_t)(h % hp->nslots) * SHMSLOTSIZE(hp->psize)));
+}
+
+/**
+ * mpool_shmget
+ *	Copy a page from the shared memory segment.  The copy is
+ *	valid only if no writer touched the slot meanwhile.
+ *
+ *	@param mp
+ *	@param bp
+ *	@param pgno
+ *	@return RET_SUCCESS, RET_ERROR: not found.
+ */
+static int
+mpool_shmget(mp, bp, pgno)
+	MPOOL *mp;
+	BKT *bp;
+	pgno_t pgno;
+{
+	SHMSLOT *sp = mpool_shmslot(mp, pgno);
+	u_int32_t seq;
+
+	seq = sp->seq;
+	if (seq & 1)
+		return (RET_ERROR);
+	__sync_synchronize();
+	if (sp->pgno != pgno || sp->gen != mp->shmgen)
+		return (RET_ERROR);
+	memcpy(bp->page, (char *)(sp + 1), mp->pagesize);
+	__sync_synchronize();
+	if (sp->seq != seq)
+		return (RET_ERROR);
+	++mp->pageshared;
+	return (RET_SUCCESS);
+}
+
+/**
+ * mpool_shmput
+ *	Publish a page read from the file to the shared memory segment,
+ *	replacing the page in its slot.  If another writer holds the
+ *	slot, the page is not published.
+ *
+ *	@param mp
+ *	@param bp
+ *	@param pgno
+ */
+static void
+mpool_shmput(mp, bp, pgno)
+	MPOOL *mp;
+	BKT *bp;
+	pgno_t pgno;
+{
+	SHMSLOT *sp = mpool_shmslot(mp, pgno);
+	u_int32_t seq;
+
+	seq = sp->seq;
+	if (seq & 1 || !__sync_bool_compare_and_swap(&sp->seq, seq, seq + 1))
+		return;
+	sp->pgno = pgno;
+	sp->gen = mp->shmgen;
+	memcpy((char *)(sp + 1), bp->page, mp->pagesize);
+	__sync_synchronize();
+	sp->seq = seq + 2;
+}
+#endif
+
 /**
  * mpool_sync
  *	Sync the pool to disk.
@@ -350,7 +637,12 @@ mpool_sync(mp)
 {
 	BKT *bp;
 
-	/* Walk the lru chain, flushing any dirty pages to disk. */
+	/* Walk the lru chains, flushing any dirty pages to disk. */
+	for (bp = mp->oqh.cqh_first;
+	    bp != (void *)&mp->oqh; bp = bp->q.cqe_next)
+		if (bp->flags & MPOOL_DIRTY &&
+		    mpool_write(mp, bp) == RET_ERROR)
+			return (RET_ERROR);
 	for (bp = mp->lqh.cqh_first;
 	    bp != (void *)&mp->lqh; bp = bp->q.cqe_next)
 		if (bp->flags & MPOOL_DIRTY &&
@@ -379,40 +671,46 @@ mpool_bkt(mp)
 		goto new;
 
 	/*
-	 * If the cache is max'd out, walk the lru list for a buffer we
-	 * can flush.  If we find one, write it (if necessary) and take it
-	 * off any lists.  If we don't find anything we grow the cache anyway.
-	 * The cache never shrinks.
+	 * If the cache is max'd out, walk the lru lists, the old one first,
+	 * for a buffer we can flush.  If we find one, write it (if necessary)
+	 * and take it off any lists.  If we don't find anything we grow the
+	 * cache anyway.  The cache never shrinks.
 	 */
+	for (bp = mp->oqh.cqh_first;
+	    bp != (void *)&mp->oqh; bp = bp->q.cqe_next)
+		if (!(bp->flags & MPOOL_PINNED))
+			goto found;
 	for (bp = mp->lqh.cqh_first;
 	    bp != (void *)&mp->lqh; bp = bp->q.cqe_next)
-		if (!(bp->flags & MPOOL_PINNED)) {
-			/* Flush if dirty. */
-			if (bp->flags & MPOOL_DIRTY &&
-			    mpool_write(mp, bp) == RET_ERROR)
-				return (NULL);
-#ifdef STATISTICS
-			++mp->pageflush;
-#endif
-			/* Remove from the hash and lru queues. */
-			head = &mp->hqh[HASHKEY(bp->pgno)];
-			CIRCLEQ_REMOVE(head, bp, hq);
-			CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+		if (!(bp->flags & MPOOL_PINNED))
+			goto found;
+	goto new;
+
+found:	/* Flush if dirty. */
+	if (bp->flags & MPOOL_DIRTY &&
+	    mpool_write(mp, bp) == RET_ERROR)
+		return (NULL);
+	++mp->pageflush;
+	/* Remove from the hash and lru queues. */
+	head = &mp->hqh[HASHKEY(bp->pgno)];
+	CIRCLEQ_REMOVE(head, bp, hq);
+	if (bp->flags & MPOOL_OLD) {
+		CIRCLEQ_REMOVE(&mp->oqh, bp, q);
+		--mp->nold;
+	} else
+		CIRCLEQ_REMOVE(&mp->lqh, bp, q);
 #ifdef DEBUG
-			{ void *spage;
-				spage = bp->page;
-				memset(bp, 0xff, sizeof(BKT) + mp->pagesize);
-				bp->page = spage;
-			}
+	{ void *spage;
+		spage = bp->page;
+		memset(bp, 0xff, sizeof(BKT) + mp->pagesize);
+		bp->page = spage;
+	}
 #endif
-			return (bp);
-		}
+	return (bp);
 
 new:	if ((bp = (BKT *)malloc(sizeof(BKT) + mp->pagesize)) == NULL)
 		return (NULL);
-#ifdef STATISTICS
 	++mp->pagealloc;
-#endif
 #if defined(DEBUG) || defined(PURIFY)
 	memset(bp, 0xff, sizeof(BKT) + mp->pagesize);
 #endif
@@ -421,6 +719,184 @@ new:	if ((bp = (BKT *)malloc(sizeof(BKT) + mp->pagesize)) == NULL)
 	return (bp);
 }
 
+/**
+ * mpool_read
+ *	Read a page from disk.
+ *
+ *	@param mp
+ *	@param bp
+ *	@param pgno
+ */
+static int
+mpool_read(mp, bp, pgno)
+	MPOOL *mp;
+	BKT *bp;
+	pgno_t pgno;
+{
+	off_t off;
+	int nr;
+
+	++mp->pageread;
+
+	/*
+	 * If both of `off_t' and `long' are 32 bits, the right operand
+	 * of the multiplication is converted to `unsigned long',
+	 * and the multiplication is done with unsigned 32 bits.
+	 * It is equivalent to the case without cast.
+	 *
+	 * If `off_t' is 64 bits and `long' is 32 bits, the left operand
+	 * of the multiplication is converted to `off_t',
+	 * and the multiplication is done with signed 64 bits.
+	 * Adding cast avoids integer overflow.
+	 *
+	 * If both of `off_t' and `long' are 64 bits, the right operand
+	 * of the multiplication is converted to `unsigned long',
+	 * and the multiplication is done with unsigned 64 bits.
+	 * It is equivalent to the case without cast.
+	 */
+	off = mp->pagesize * (off_t)pgno;
+
+#if defined(HAVE_PREAD) && !defined(__CYGWIN__)
+	if ((nr = pread(mp->fd, bp->page, mp->pagesize, off)) != mp->pagesize) {
+		if (nr >= 0)
+			errno = EFTYPE;
+		return (RET_ERROR);
+	}
+#else
+	if (lseek(mp->fd, off, SEEK_SET) != off)
+		return (RET_ERROR);
+	if ((nr = read(mp->fd, bp->page, mp->pagesize)) != mp->pagesize) {
+		if (nr >= 0)
+			errno = EFTYPE;
+		return (RET_ERROR);
+	}
+#endif
+	return (RET_SUCCESS);
+}
+
+/**
+ * mpool_readahead
+ *	Read a page and the following pages which are not cached
+ *	by a single read.  The following pages enter the old chain
+ *	unpinned, so they are the first to go if they are not used.
+ *
+ *	@param mp
+ *	@param bp
+ *	@param pgno
+ */
+static int
+mpool_readahead(mp, bp, pgno)
+	MPOOL *mp;
+	BKT *bp;
+	pgno_t pgno;
+{
+	BKT *rp;
+	off_t off;
+	pgno_t n, i;
+	int nr;
+
+	for (n = 1; n < mp->ramax && pgno + n < mp->npages; ++n)
+		if (mpool_find(mp, pgno + n) != NULL)
+			break;
+	if (n == 1)
+		return (mpool_read(mp, bp, pgno));
+	if (mp->rabuf == NULL &&
+	    (mp->rabuf = malloc(mp->ramax * mp->pagesize)) == NULL)
+		return (mpool_read(mp, bp, pgno));
+	++mp->pageread;
+
+	/* See the comment in mpool_read for cast addition. */
+	off = mp->pagesize * (off_t)pgno;
+
+#if defined(HAVE_PREAD) && !defined(__CYGWIN__)
+	nr = pread(mp->fd, mp->rabuf, n * mp->pagesize, off);
+#else
+	if (lseek(mp->fd, off, SEEK_SET) != off)
+		return (RET_ERROR);
+	nr = read(mp->fd, mp->rabuf, n * mp->pagesize);
+#endif
+	if (nr < (int)mp->pagesize) {
+		if (nr >= 0)
+			errno = EFTYPE;
+		return (RET_ERROR);
+	}
+	memcpy(bp->page, mp->rabuf, mp->pagesize);
+
+	/* Cache the following pages which were read in full. */
+	n = nr / mp->pagesize;
+	for (i = 1; i < n; ++i) {
+		if ((rp = mpool_bkt(mp)) == NULL)
+			break;
+		memcpy(rp->page, mp->rabuf + i * mp->pagesize, mp->pagesize);
+		rp->pgno = pgno + i;
+		rp->flags = 0;
+		mpool_link(mp, rp);
+		if (mp->pgin != NULL)
+			(mp->pgin)(mp->pgcookie, rp->pgno, rp->page);
+		++mp->pagereadahead;
+	}
+	return (RET_SUCCESS);
+}
+
+/**
+ * mpool_link
+ *	Add a page to the head of the hash chain and the tail of
+ *	the old chain.
+ *
+ *	@param mp
+ *	@param bp
+ */
+static void
+mpool_link(mp, bp)
+	MPOOL *mp;
+	BKT *bp;
+{
+	struct _hqh *head;
+
+	head = &mp->hqh[HASHKEY(bp->pgno)];
+	CIRCLEQ_INSERT_HEAD(head, bp, hq);
+	CIRCLEQ_INSERT_TAIL(&mp->oqh, bp, q);
+	bp->flags |= MPOOL_OLD;
+	bp->stamp = mp->clock++;
+	++mp->nold;
+}
+
+/**
+ * mpool_touch
+ *	Move a referenced page to the tail of its lru chain.  A page
+ *	in the old chain becomes young if it was loaded a while ago.
+ *
+ *	@param mp
+ *	@param bp
+ */
+static void
+mpool_touch(mp, bp)
+	MPOOL *mp;
+	BKT *bp;
+{
+	if (!(bp->flags & MPOOL_OLD)) {
+		CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+		CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+		return;
+	}
+	if (mp->clock - bp->stamp <= mp->nold / 4)
+		return;
+	CIRCLEQ_REMOVE(&mp->oqh, bp, q);
+	CIRCLEQ_INSERT_TAIL(&mp->lqh, bp, q);
+	bp->flags &= ~MPOOL_OLD;
+	--mp->nold;
+
+	/* Return the least recently used young page to the old chain. */
+	if (mp->curcache - mp->nold > YOUNGRATIO(mp->maxcache)) {
+		bp = mp->lqh.cqh_first;
+		CIRCLEQ_REMOVE(&mp->lqh, bp, q);
+		CIRCLEQ_INSERT_TAIL(&mp->oqh, bp, q);
+		bp->flags |= MPOOL_OLD;
+		bp->stamp = mp->clock;
+		++mp->nold;
+	}
+}
+
 /**
  * mpool_write
  *	Write a page to disk.
@@ -435,15 +911,13 @@ mpool_write(mp, bp)
 {
 	off_t off;
 
-#ifdef STATISTICS
 	++mp->pagewrite;
-#endif
 
 	/* Run through the user's filter. */
 	if (mp->pgout)
 		(mp->pgout)(mp->pgcookie, bp->pgno, bp->page);
 
-	/* See the comment in mpool_get for cast addition. */
+	/* See the comment in mpool_read for cast addition. */
 	off = mp->pagesize * (off_t)bp->pgno;
 
 #if defined(HAVE_PWRITE) && !defined(__CYGWIN__)
@@ -461,14 +935,14 @@ mpool_write(mp, bp)
 }
 
 /**
- * mpool_look
- *	Lookup a page in the cache.
+ * mpool_find
+ *	Find a page in the cache.
  *
  *	@param mp
  *	@param pgno
  */
 static BKT *
-mpool_look(mp, pgno)
+mpool_find(mp, pgno)
 	MPOOL *mp;
 	pgno_t pgno;
 {
@@ -477,18 +951,33 @@ mpool_look(mp, pgno)
 
 	head = &mp->hqh[HASHKEY(pgno)];
 	for (bp = head->cqh_first; bp != (void *)head; bp = bp->hq.cqe_next)
-		if (bp->pgno == pgno) {
-#ifdef STATISTICS
-			++mp->cachehit;
-#endif
+		if (bp->pgno == pgno)
 			return (bp);
-		}
-#ifdef STATISTICS
-	++mp->cachemiss;
-#endif
 	return (NULL);
 }
 
+/**
+ * mpool_look
+ *	Lookup a page in the cache.
+ *
+ *	@param mp
+ *	@param pgno
+ */
+static BKT *
+mpool_look(mp, pgno)
+	MPOOL *mp;
+	pgno_t pgno;
+{
+	BKT *bp;
+
+	bp = mpool_find(mp, pgno);
+	if (bp != NULL)
+		++mp->cachehit;
+	else
+		++mp->cachemiss;
+	return (bp);
+}
+
 #ifdef STATISTICS
 /**
  * mpool_stat
@@ -517,14 +1006,24 @@ mpool_stat(mp)
 		    "%.0f%% cache hit rate (%lu hits, %lu misses)\n", 
 		    ((double)mp->cachehit / (mp->cachehit + mp->cachemiss))
 		    * 100, mp->cachehit, mp->cachemiss);
-	(void)fprintf(stderr, "%lu page reads, %lu page writes\n",
-	    mp->pageread, mp->pagewrite);
+	(void)fprintf(stderr, "%lu page reads, %lu pages read ahead, %lu page writes\n",
+	    mp->pageread, mp->pagereadahead, mp->pagewrite);
+	if (mp->shm != NULL)
+		(void)fprintf(stderr, "%lu pages from the shared cache\n",
+		    mp->pageshared);
+	(void)fprintf(stderr, "%lu old pages, %lu young pages\n",
+	    (long unsigned int)mp->nold, (long unsigned int)(mp->curcache - mp->nold));
 
 	sep = "";
 	cnt = 0;
-	for (bp = mp->lqh.cqh_first;
-	    bp != (void *)&mp->lqh; bp = bp->q.cqe_next) {
+	for (bp = mp->oqh.cqh_first != (void *)&mp->oqh ?
+	    mp->oqh.cqh_first : mp->lqh.cqh_first;
+	    bp != (void *)&mp->lqh;
+	    bp = bp->q.cqe_next == (void *)&mp->oqh ?
+	    mp->lqh.cqh_first : bp->q.cqe_next) {
 		(void)fprintf(stderr, "%s%d", sep, bp->pgno);
+		if (bp->flags & MPOOL_OLD)
+			(void)fprintf(stderr, "o");
 		if (bp->flags & MPOOL_DIRTY)
 			(void)fprintf(stderr, "d");
 		if (bp->flags & MPOOL_PINNED)
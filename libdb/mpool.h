@@ -37,9 +37,45 @@
  * are threaded on a hash chain (hashed by page number) and an lru chain.
  * Inactive pages are threaded on a free chain.  Each reference to a memory
  * pool is handed an opaque MPOOL cookie which stores all of this information.
+ *
+ * The lru chain is split in two, so that a scan does not flush the cache.
+ * A page read from the file enters the old chain, which is replaced first.
+ * It moves to the young chain only when it is referenced again after a
+ * while, i.e. after a quarter of the old chain has been read in since it
+ * was loaded.  The repeated references of a scan to a leaf page come close
+ * together and leave it in the old chain, while interior pages which are
+ * referenced by every search become young.  The young chain is limited to
+ * YOUNGRATIO of the cache; its least recently used page returns to the old
+ * chain.
+ *
+ * When mpool_get() is called with MPOOL_SEQUENTIAL for a page a little
+ * after the last one so called, and the page is not cached, the following
+ * pages are read together with it by a single read.  A B-tree written in
+ * key order keeps its leaf pages mostly in file order.
+ *
+ * A read only pool may also be attached to a shared memory segment by
+ * mpool_shmem(), so that processes reading the same files one after
+ * another start warm.  The segment is an array of slots, each of which
+ * holds the raw contents of a page tagged with its page number and the
+ * generation of its file.  A page is looked up in a single slot chosen by
+ * hashing the two.  Readers take no lock: a slot has a sequence number,
+ * which is odd while a writer is updating it, and a copy is valid only if
+ * the number was even and unchanged around it.  Pages read in a scan are
+ * not published, so a scan does not flush the segment.  There is a segment
+ * for each directory and page size; it is left after the last process
+ * detaches, and is removed by mpool_shmunlink().
  */
 #define	HASHSIZE	128
 #define	HASHKEY(pgno)	((pgno - 1) % HASHSIZE)
+#define	YOUNGRATIO(n)	((n) * 5 / 8)	/**< max pages in the young chain */
+#define	READAHEAD	16		/**< max pages read at once */
+
+#if defined(HAVE_SHM_OPEN) && defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_SYNC_BUILTINS)
+#define	MPOOL_SHMEM
+#endif
+
+			/** mpool_get: the page follows the last one in a scan */
+#define	MPOOL_SEQUENTIAL	0x01
 
 /** The BKT structures are the elements of the queues. */
 typedef struct _bkt {
@@ -52,20 +88,28 @@ typedef struct _bkt {
 #define	MPOOL_DIRTY	0x01
 			/** page is pinned into memory */
 #define	MPOOL_PINNED	0x02
+			/** page is in the old chain */
+#define	MPOOL_OLD	0x04
 	u_int8_t flags;			/**< flags */
+	u_long	 stamp;			/**< MPOOL.clock when loaded */
 } BKT;
 
 typedef struct MPOOL {
 
 #ifndef IS__DOXYGEN_
-	CIRCLEQ_HEAD(_lqh, _bkt) lqh;	/**< lru queue head */
+	CIRCLEQ_HEAD(_lqh, _bkt) lqh;	/**< lru queue head (young) */
+	CIRCLEQ_HEAD(_oqh, _bkt) oqh;	/**< lru queue head (old) */
 					/** hash queue array */
 	CIRCLEQ_HEAD(_hqh, _bkt) hqh[HASHSIZE];
 #else
 	struct _lqh {
 		struct _bkt *cqh_first;
 		struct _bkt *cqh_last;
-	} lqh;							/**< lru queue head */
+	} lqh;							/**< lru queue head (young) */
+	struct _oqh {
+		struct _bkt *cqh_first;
+		struct _bkt *cqh_last;
+	} oqh;							/**< lru queue head (old) */
 	struct _hqh {
 		struct _bkt *cqh_first;
 		struct _bkt *cqh_last;
@@ -73,6 +117,11 @@ typedef struct MPOOL {
 #endif
 	pgno_t	curcache;		/**< current number of cached pages */
 	pgno_t	maxcache;		/**< max number of cached pages */
+	pgno_t	nold;			/**< number of pages in the old chain */
+	u_long	clock;			/**< number of pages loaded */
+	pgno_t	seqlast;		/**< last page got with MPOOL_SEQUENTIAL */
+	pgno_t	ramax;			/**< max pages read at once */
+	char	*rabuf;			/**< buffer for reading ahead */
 	pgno_t	npages;			/**< number of pages in the file */
 	u_long	pagesize;		/**< file page size */
 	int	fd;			/**< file descriptor */
@@ -81,7 +130,10 @@ typedef struct MPOOL {
 					/** page out conversion routine */
 	void    (*pgout)(void *, pgno_t, void *);
 	void	*pgcookie;		/**< cookie for page in/out routines */
-#ifdef STATISTICS
+	char	*shm;			/**< shared memory segment */
+	size_t	 shmsize;		/**< size of the segment */
+	u_int32_t shmgen;		/**< generation of the file */
+	/* statistics */
 	u_long	cachehit;
 	u_long	cachemiss;
 	u_long	pagealloc;
@@ -90,8 +142,9 @@ typedef struct MPOOL {
 	u_long	pagenew;
 	u_long	pageput;
 	u_long	pageread;
+	u_long	pagereadahead;
+	u_long	pageshared;
 	u_long	pagewrite;
-#endif
 } MPOOL;
 
 MPOOL	*mpool_open(void *, int, pgno_t, pgno_t);
@@ -102,6 +155,8 @@ void	*mpool_get(MPOOL *, pgno_t, u_int);
 int	 mpool_put(MPOOL *, void *, u_int);
 int	 mpool_sync(MPOOL *);
 int	 mpool_close(MPOOL *);
+int	 mpool_shmem(MPOOL *, const char *, size_t);
+int	 mpool_shmunlink(const char *, u_int);
 #ifdef STATISTICS
 void	 mpool_stat(MPOOL *);
 #endif
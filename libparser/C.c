@@ -35,12 +35,6 @@
 #include "token.h"
 #include "c_res.h"
 
-static void C_family(const struct parser_param *, int);
-static void process_attribute(const struct parser_param *);
-static int function_definition(const struct parser_param *, char *);
-static void condition_macro(const struct parser_param *, int);
-static int enumerator_list(const struct parser_param *);
-
 #define IS_TYPE_QUALIFIER(c)	((c) == C_CONST || (c) == C_RESTRICT || (c) == C_VOLATILE)
 
 #define DECLARATIONS    0
@@ -53,17 +47,31 @@ static int enumerator_list(const struct parser_param *);
 
 #define MAXPIFSTACK	100
 
+#undef DBG_LEVEL
+#define DBG_LEVEL	(ps->level)
+
 /*
- * #ifdef stack.
+ * The state of a parse. Each C_family() call has its own.
  */
-static struct {
-	short start;		/* level when '#if' block started */
-	short end;		/* level when '#if' block end */
-	short if0only;		/* '#if 0' or notdef only */
-} stack[MAXPIFSTACK], *cur;
-static int piflevel;		/* condition macro level */
-static int level;		/* brace level */
-static int externclevel;	/* 'extern "C"' block level */
+struct parse_state {
+	/*
+	 * #ifdef stack.
+	 */
+	struct {
+		short start;		/* level when '#if' block started */
+		short end;		/* level when '#if' block end */
+		short if0only;		/* '#if 0' or notdef only */
+	} stack[MAXPIFSTACK], *cur;
+	int piflevel;			/* condition macro level */
+	int level;			/* brace level */
+	int externclevel;		/* 'extern "C"' block level */
+};
+
+static void C_family(const struct parser_param *, int);
+static void process_attribute(const struct parser_param *, TOKEN *, struct parse_state *);
+static int function_definition(const struct parser_param *, TOKEN *, struct parse_state *, char [MAXTOKEN]);
+static void condition_macro(const struct parser_param *, TOKEN *, struct parse_state *, int);
+static int enumerator_list(const struct parser_param *, TOKEN *, struct parse_state *);
 
 /**
  * yacc: read yacc file and pickup tag entries.
@@ -89,6 +97,8 @@ static void
 C_family(const struct parser_param *param, int type)
 {
 	int c, cc;
+	TOKEN *tp;
+	struct parse_state state, *ps = &state;
 	int savelevel;
 	int startmacro, startsharp;
 	const char *interested = "{}=;";
@@ -106,32 +116,32 @@ C_family(const struct parser_param *param, int type)
 	int yaccstatus = (type == TYPE_YACC) ? DECLARATIONS : PROGRAMS;
 	int inC = (type == TYPE_YACC) ? 0 : 1;	/* 1 while C source */
 
-	level = piflevel = externclevel = 0;
+	memset(ps, 0, sizeof(*ps));
 	savelevel = -1;
 	startmacro = startsharp = 0;
 
-	if (!opentoken(param->file))
+	if ((tp = OPENTOKEN(param)) == NULL)
 		die("'%s' cannot open.", param->file);
-	cmode = 1;			/* allow token like '#xxx' */
-	crflag = 1;			/* require '\n' as a token */
+	tp->cmode = 1;			/* allow token like '#xxx' */
+	tp->crflag = 1;			/* require '\n' as a token */
 	if (type == TYPE_YACC)
-		ymode = 1;		/* allow token like '%xxx' */
+		tp->ymode = 1;		/* allow token like '%xxx' */
 
-	while ((cc = nexttoken(interested, c_reserved_word)) != EOF) {
+	while ((cc = nexttoken(tp, interested, c_reserved_word)) != EOF) {
 		switch (cc) {
 		case SYMBOL:		/* symbol	*/
-			if (inC && peekc(0) == '('/* ) */) {
-				if (param->isnotfunction(token)) {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
-				} else if (level > 0 || startmacro) {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
-				} else if (level == 0 && !startmacro && !startsharp) {
+			if (inC && peekc(tp, 0) == '('/* ) */) {
+				if (param->isnotfunction(tp->token)) {
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
+				} else if (ps->level > 0 || startmacro) {
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
+				} else if (ps->level == 0 && !startmacro && !startsharp) {
 					char arg1[MAXTOKEN], savetok[MAXTOKEN], *saveline;
-					int savelineno = lineno;
+					int savelineno = tp->lineno;
 
-					strlimcpy(savetok, token, sizeof(savetok));
+					strlimcpy(savetok, tp->token, sizeof(savetok));
 					strbuf_reset(sb);
-					strbuf_puts(sb, sp);
+					strbuf_puts(sb, tp->sp);
 					saveline = strbuf_value(sb);
 					arg1[0] = '\0';
 					/*
@@ -148,7 +158,7 @@ C_family(const struct parser_param *param, int type)
 					 *
 					 * We should assume the first argument as a function name instead of 'SCM_DEFINE'.
 					 */
-					if (function_definition(param, arg1)) {
+					if (function_definition(param, tp, ps, arg1)) {
 						if (!strcmp(savetok, "SCM_DEFINE") && *arg1)
 							strlimcpy(savetok, arg1, sizeof(savetok));
 						PUT(PARSER_DEF, savetok, savelineno, saveline);
@@ -157,83 +167,83 @@ C_family(const struct parser_param *param, int type)
 					}
 				}
 			} else {
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			}
 			break;
 		case '{':  /* } */
-			DBG_PRINT(level, "{"); /* } */
-			if (yaccstatus == RULES && level == 0)
+			DBG_PRINT(ps->level, "{"); /* } */
+			if (yaccstatus == RULES && ps->level == 0)
 				inC = 1;
-			++level;
-			if ((param->flags & PARSER_BEGIN_BLOCK) && atfirst) {
-				if ((param->flags & PARSER_WARNING) && level != 1)
-					warning("forced level 1 block start by '{' at column 0 [+%d %s].", lineno, curfile); /* } */
-				level = 1;
+			++ps->level;
+			if ((param->flags & PARSER_BEGIN_BLOCK) && atfirst(tp)) {
+				if ((param->flags & PARSER_WARNING) && ps->level != 1)
+					warning("forced level 1 block start by '{' at column 0 [+%d %s].", tp->lineno, tp->curfile); /* } */
+				ps->level = 1;
 			}
 			break;
 			/* { */
 		case '}':
-			if (--level < 0) {
-				if (externclevel > 0)
-					externclevel--;
+			if (--ps->level < 0) {
+				if (ps->externclevel > 0)
+					ps->externclevel--;
 				else if (param->flags & PARSER_WARNING)
-					warning("missing left '{' [+%d %s].", lineno, curfile); /* } */
-				level = 0;
+					warning("missing left '{' [+%d %s].", tp->lineno, tp->curfile); /* } */
+				ps->level = 0;
 			}
-			if ((param->flags & PARSER_END_BLOCK) && atfirst) {
-				if ((param->flags & PARSER_WARNING) && level != 0) /* { */
-					warning("forced level 0 block end by '}' at column 0 [+%d %s].", lineno, curfile);
-				level = 0;
+			if ((param->flags & PARSER_END_BLOCK) && atfirst(tp)) {
+				if ((param->flags & PARSER_WARNING) && ps->level != 0) /* { */
+					warning("forced level 0 block end by '}' at column 0 [+%d %s].", tp->lineno, tp->curfile);
+				ps->level = 0;
 			}
-			if (yaccstatus == RULES && level == 0)
+			if (yaccstatus == RULES && ps->level == 0)
 				inC = 0;
 			/* { */
-			DBG_PRINT(level, "}");
+			DBG_PRINT(ps->level, "}");
 			break;
 		case '\n':
-			if (startmacro && level != savelevel) {
+			if (startmacro && ps->level != savelevel) {
 				if (param->flags & PARSER_WARNING)
-					warning("different level before and after #define macro. reseted. [+%d %s].", lineno, curfile);
-				level = savelevel;
+					warning("different level before and after #define macro. reseted. [+%d %s].", tp->lineno, tp->curfile);
+				ps->level = savelevel;
 			}
 			startmacro = startsharp = 0;
 			break;
 		case YACC_SEP:		/* %% */
-			if (level != 0) {
+			if (ps->level != 0) {
 				if (param->flags & PARSER_WARNING)
-					warning("forced level 0 block end by '%%' [+%d %s].", lineno, curfile);
-				level = 0;
+					warning("forced level 0 block end by '%%' [+%d %s].", tp->lineno, tp->curfile);
+				ps->level = 0;
 			}
 			if (yaccstatus == DECLARATIONS) {
-				PUT(PARSER_DEF, "yyparse", lineno, sp);
+				PUT(PARSER_DEF, "yyparse", tp->lineno, tp->sp);
 				yaccstatus = RULES;
 			} else if (yaccstatus == RULES)
 				yaccstatus = PROGRAMS;
 			inC = (yaccstatus == PROGRAMS) ? 1 : 0;
 			break;
 		case YACC_BEGIN:	/* %{ */
-			if (level != 0) {
+			if (ps->level != 0) {
 				if (param->flags & PARSER_WARNING)
-					warning("forced level 0 block end by '%%{' [+%d %s].", lineno, curfile);
-				level = 0;
+					warning("forced level 0 block end by '%%{' [+%d %s].", tp->lineno, tp->curfile);
+				ps->level = 0;
 			}
 			if (inC == 1 && (param->flags & PARSER_WARNING))
-				warning("'%%{' appeared in C mode. [+%d %s].", lineno, curfile);
+				warning("'%%{' appeared in C mode. [+%d %s].", tp->lineno, tp->curfile);
 			inC = 1;
 			break;
 		case YACC_END:		/* %} */
-			if (level != 0) {
+			if (ps->level != 0) {
 				if (param->flags & PARSER_WARNING)
-					warning("forced level 0 block end by '%%}' [+%d %s].", lineno, curfile);
-				level = 0;
+					warning("forced level 0 block end by '%%}' [+%d %s].", tp->lineno, tp->curfile);
+				ps->level = 0;
 			}
 			if (inC == 0 && (param->flags & PARSER_WARNING))
-				warning("'%%}' appeared in Yacc mode. [+%d %s].", lineno, curfile);
+				warning("'%%}' appeared in Yacc mode. [+%d %s].", tp->lineno, tp->curfile);
 			inC = 0;
 			break;
 		case YACC_UNION:	/* %union {...} */
 			if (yaccstatus == DECLARATIONS)
-				PUT(PARSER_DEF, "YYSTYPE", lineno, sp);
+				PUT(PARSER_DEF, "YYSTYPE", tp->lineno, tp->sp);
 			break;
 		/*
 		 * #xxx
@@ -241,20 +251,20 @@ C_family(const struct parser_param *param, int type)
 		case SHARP_DEFINE:
 		case SHARP_UNDEF:
 			startmacro = 1;
-			savelevel = level;
-			if ((c = nexttoken(interested, c_reserved_word)) != SYMBOL) {
-				pushbacktoken();
+			savelevel = ps->level;
+			if ((c = nexttoken(tp, interested, c_reserved_word)) != SYMBOL) {
+				pushbacktoken(tp);
 				break;
 			}
-			if (peekc(1) == '('/* ) */) {
-				PUT(PARSER_DEF, token, lineno, sp);
-				while ((c = nexttoken("()", c_reserved_word)) != EOF && c != '\n' && c != /* ( */ ')')
+			if (peekc(tp, 1) == '('/* ) */) {
+				PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
+				while ((c = nexttoken(tp, "()", c_reserved_word)) != EOF && c != '\n' && c != /* ( */ ')')
 					if (c == SYMBOL)
-						PUT(PARSER_REF_SYM, token, lineno, sp);
+						PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 				if (c == '\n')
-					pushbacktoken();
+					pushbacktoken(tp);
 			} else {
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 			}
 			break;
 		case SHARP_IMPORT:
@@ -266,7 +276,7 @@ C_family(const struct parser_param *param, int type)
 		case SHARP_WARNING:
 		case SHARP_IDENT:
 		case SHARP_SCCS:
-			while ((c = nexttoken(interested, c_reserved_word)) != EOF && c != '\n')
+			while ((c = nexttoken(tp, interested, c_reserved_word)) != EOF && c != '\n')
 				;
 			break;
 		case SHARP_IFDEF:
@@ -275,46 +285,46 @@ C_family(const struct parser_param *param, int type)
 		case SHARP_ELIF:
 		case SHARP_ELSE:
 		case SHARP_ENDIF:
-			condition_macro(param, cc);
+			condition_macro(param, tp, ps, cc);
 			break;
 		case SHARP_SHARP:		/* ## */
-			(void)nexttoken(interested, c_reserved_word);
+			(void)nexttoken(tp, interested, c_reserved_word);
 			break;
 		case C_EXTERN: /* for 'extern "C"/"C++"' */
-			if (peekc(0) != '"') /* " */
+			if (peekc(tp, 0) != '"') /* " */
 				continue; /* If does not start with '"', continue. */
-			while ((c = nexttoken(interested, c_reserved_word)) == '\n')
+			while ((c = nexttoken(tp, interested, c_reserved_word)) == '\n')
 				;
 			/*
 			 * 'extern "C"/"C++"' block is a kind of namespace block.
 			 * (It doesn't have any influence on level.)
 			 */
 			if (c == '{') /* } */
-				externclevel++;
+				ps->externclevel++;
 			else
-				pushbacktoken();
+				pushbacktoken(tp);
 			break;
 		case C_STRUCT:
 		case C_ENUM:
 		case C_UNION:
-			while ((c = nexttoken(interested, c_reserved_word)) == C___ATTRIBUTE__)
-				process_attribute(param);
+			while ((c = nexttoken(tp, interested, c_reserved_word)) == C___ATTRIBUTE__)
+				process_attribute(param, tp, ps);
 			while (c == '\n')
-				c = nexttoken(interested, c_reserved_word);
+				c = nexttoken(tp, interested, c_reserved_word);
 			if (c == SYMBOL) {
-				if (peekc(0) == '{') /* } */ {
-					PUT(PARSER_DEF, token, lineno, sp);
+				if (peekc(tp, 0) == '{') /* } */ {
+					PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 				} else {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 				}
-				c = nexttoken(interested, c_reserved_word);
+				c = nexttoken(tp, interested, c_reserved_word);
 			}
 			while (c == '\n')
-				c = nexttoken(interested, c_reserved_word);
+				c = nexttoken(tp, interested, c_reserved_word);
 			if (c == '{' /* } */ && cc == C_ENUM) {
-				enumerator_list(param);
+				enumerator_list(param, tp, ps);
 			} else {
-				pushbacktoken();
+				pushbacktoken(tp);
 			}
 			break;
 		/* control statement check */
@@ -330,8 +340,8 @@ C_family(const struct parser_param *param, int type)
 		case C_RETURN:
 		case C_SWITCH:
 		case C_WHILE:
-			if ((param->flags & PARSER_WARNING) && !startmacro && level == 0)
-				warning("Out of function. %8s [+%d %s]", token, lineno, curfile);
+			if ((param->flags & PARSER_WARNING) && !startmacro && ps->level == 0)
+				warning("Out of function. %8s [+%d %s]", tp->token, tp->lineno, tp->curfile);
 			break;
 		case C_TYPEDEF:
 			{
@@ -341,44 +351,44 @@ C_family(const struct parser_param *param, int type)
 				 */
 				char savetok[MAXTOKEN];
 				int savelineno = 0;
-				int typedef_savelevel = level;
+				int typedef_savelevel = ps->level;
 
 				savetok[0] = 0;
 
 				/* skip type qualifiers */
 				do {
-					c = nexttoken("{}(),;", c_reserved_word);
+					c = nexttoken(tp, "{}(),;", c_reserved_word);
 				} while (IS_TYPE_QUALIFIER(c) || c == '\n');
 
 				if ((param->flags & PARSER_WARNING) && c == EOF) {
-					warning("unexpected eof. [+%d %s]", lineno, curfile);
+					warning("unexpected eof. [+%d %s]", tp->lineno, tp->curfile);
 					break;
 				} else if (c == C_ENUM || c == C_STRUCT || c == C_UNION) {
 					char *interest_enum = "{},;";
 					int c_ = c;
 
-					while ((c = nexttoken(interest_enum, c_reserved_word)) == C___ATTRIBUTE__)
-						process_attribute(param);
+					while ((c = nexttoken(tp, interest_enum, c_reserved_word)) == C___ATTRIBUTE__)
+						process_attribute(param, tp, ps);
 					while (c == '\n')
-						c = nexttoken(interest_enum, c_reserved_word);
+						c = nexttoken(tp, interest_enum, c_reserved_word);
 					/* read tag name if exist */
 					if (c == SYMBOL) {
-						if (peekc(0) == '{') /* } */ {
-							PUT(PARSER_DEF, token, lineno, sp);
+						if (peekc(tp, 0) == '{') /* } */ {
+							PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 						} else {
-							PUT(PARSER_REF_SYM, token, lineno, sp);
+							PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 						}
-						c = nexttoken(interest_enum, c_reserved_word);
+						c = nexttoken(tp, interest_enum, c_reserved_word);
 					}
 					while (c == '\n')
-						c = nexttoken(interest_enum, c_reserved_word);
+						c = nexttoken(tp, interest_enum, c_reserved_word);
 					if (c_ == C_ENUM) {
 						if (c == '{') /* } */
-							c = enumerator_list(param);
+							c = enumerator_list(param, tp, ps);
 						else
-							pushbacktoken();
+							pushbacktoken(tp);
 					} else {
-						for (; c != EOF; c = nexttoken(interest_enum, c_reserved_word)) {
+						for (; c != EOF; c = nexttoken(tp, interest_enum, c_reserved_word)) {
 							switch (c) {
 							case SHARP_IFDEF:
 							case SHARP_IFNDEF:
@@ -386,43 +396,43 @@ C_family(const struct parser_param *param, int type)
 							case SHARP_ELIF:
 							case SHARP_ELSE:
 							case SHARP_ENDIF:
-								condition_macro(param, c);
+								condition_macro(param, tp, ps, c);
 								continue;
 							default:
 								break;
 							}
-							if (c == ';' && level == typedef_savelevel) {
+							if (c == ';' && ps->level == typedef_savelevel) {
 								if (savetok[0]) {
-									PUT(PARSER_DEF, savetok, savelineno, sp);
+									PUT(PARSER_DEF, savetok, savelineno, tp->sp);
 									savetok[0] = 0;
 								}
 								break;
 							} else if (c == '{')
-								level++;
+								ps->level++;
 							else if (c == '}') {
 								savetok[0] = 0;
-								if (--level == typedef_savelevel)
+								if (--ps->level == typedef_savelevel)
 									break;
 							} else if (c == SYMBOL) {
-								if (level > typedef_savelevel)
-									PUT(PARSER_REF_SYM, token, lineno, sp);
+								if (ps->level > typedef_savelevel)
+									PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 								/* save lastest token */
-								strlimcpy(savetok, token, sizeof(savetok));
-								savelineno = lineno;
+								strlimcpy(savetok, tp->token, sizeof(savetok));
+								savelineno = tp->lineno;
 							}
 						}
 						if (c == ';')
 							break;
 					}
 					if ((param->flags & PARSER_WARNING) && c == EOF) {
-						warning("unexpected eof. [+%d %s]", lineno, curfile);
+						warning("unexpected eof. [+%d %s]", tp->lineno, tp->curfile);
 						break;
 					}
 				} else if (c == SYMBOL) {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 				}
 				savetok[0] = 0;
-				while ((c = nexttoken("(),;", c_reserved_word)) != EOF) {
+				while ((c = nexttoken(tp, "(),;", c_reserved_word)) != EOF) {
 					switch (c) {
 					case SHARP_IFDEF:
 					case SHARP_IFNDEF:
@@ -430,46 +440,46 @@ C_family(const struct parser_param *param, int type)
 					case SHARP_ELIF:
 					case SHARP_ELSE:
 					case SHARP_ENDIF:
-						condition_macro(param, c);
+						condition_macro(param, tp, ps, c);
 						continue;
 					default:
 						break;
 					}
 					if (c == '(')
-						level++;
+						ps->level++;
 					else if (c == ')')
-						level--;
+						ps->level--;
 					else if (c == SYMBOL) {
-						if (level > typedef_savelevel) {
-							PUT(PARSER_REF_SYM, token, lineno, sp);
+						if (ps->level > typedef_savelevel) {
+							PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 						} else {
 							/* put latest token if any */
 							if (savetok[0]) {
-								PUT(PARSER_REF_SYM, savetok, savelineno, sp);
+								PUT(PARSER_REF_SYM, savetok, savelineno, tp->sp);
 							}
 							/* save lastest token */
-							strlimcpy(savetok, token, sizeof(savetok));
-							savelineno = lineno;
+							strlimcpy(savetok, tp->token, sizeof(savetok));
+							savelineno = tp->lineno;
 						}
 					} else if (c == ',' || c == ';') {
 						if (savetok[0]) {
-							PUT(PARSER_DEF, savetok, lineno, sp);
+							PUT(PARSER_DEF, savetok, tp->lineno, tp->sp);
 							savetok[0] = 0;
 						}
 					}
-					if (level == typedef_savelevel && c == ';')
+					if (ps->level == typedef_savelevel && c == ';')
 						break;
 				}
 				if (param->flags & PARSER_WARNING) {
 					if (c == EOF)
-						warning("unexpected eof. [+%d %s]", lineno, curfile);
-					else if (level != typedef_savelevel)
-						warning("unmatched () block. (last at level %d.)[+%d %s]", level, lineno, curfile);
+						warning("unexpected eof. [+%d %s]", tp->lineno, tp->curfile);
+					else if (ps->level != typedef_savelevel)
+						warning("unmatched () block. (last at level %d.)[+%d %s]", ps->level, tp->lineno, tp->curfile);
 				}
 			}
 			break;
 		case C___ATTRIBUTE__:
-			process_attribute(param);
+			process_attribute(param, tp, ps);
 			break;
 		default:
 			break;
@@ -477,18 +487,18 @@ C_family(const struct parser_param *param, int type)
 	}
 	strbuf_close(sb);
 	if (param->flags & PARSER_WARNING) {
-		if (level != 0)
-			warning("unmatched {} block. (last at level %d.)[+%d %s]", level, lineno, curfile);
-		if (piflevel != 0)
-			warning("unmatched #if block. (last at level %d.)[+%d %s]", piflevel, lineno, curfile);
+		if (ps->level != 0)
+			warning("unmatched {} block. (last at level %d.)[+%d %s]", ps->level, tp->lineno, tp->curfile);
+		if (ps->piflevel != 0)
+			warning("unmatched #if block. (last at level %d.)[+%d %s]", ps->piflevel, tp->lineno, tp->curfile);
 	}
-	closetoken();
+	closetoken(tp);
 }
 /**
  * process_attribute: skip attributes in '__attribute__((...))'.
  */
 static void
-process_attribute(const struct parser_param *param)
+process_attribute(const struct parser_param *param, TOKEN *tp, struct parse_state *ps)
 {
 	int brace = 0;
 	int c;
@@ -496,13 +506,13 @@ process_attribute(const struct parser_param *param)
 	 * Skip '...' in __attribute__((...))
 	 * but pick up symbols in it.
 	 */
-	while ((c = nexttoken("()", c_reserved_word)) != EOF) {
+	while ((c = nexttoken(tp, "()", c_reserved_word)) != EOF) {
 		if (c == '(')
 			brace++;
 		else if (c == ')')
 			brace--;
 		else if (c == SYMBOL) {
-			PUT(PARSER_REF_SYM, token, lineno, sp);
+			PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 		}
 		if (brace == 0)
 			break;
@@ -512,18 +522,19 @@ process_attribute(const struct parser_param *param)
  * function_definition: return if function definition or not.
  *
  *	@param	param	
+ *	@param[in,out]	ps	parse state
  *	@param[out]	arg1	the first argument
  *	@return	target type
  */
 static int
-function_definition(const struct parser_param *param, char arg1[MAXTOKEN])
+function_definition(const struct parser_param *param, TOKEN *tp, struct parse_state *ps, char arg1[MAXTOKEN])
 {
 	int c;
 	int brace_level, isdefine;
 	int accept_arg1 = 0;
 
 	brace_level = isdefine = 0;
-	while ((c = nexttoken("()", c_reserved_word)) != EOF) {
+	while ((c = nexttoken(tp, "()", c_reserved_word)) != EOF) {
 		switch (c) {
 		case SHARP_IFDEF:
 		case SHARP_IFNDEF:
@@ -531,7 +542,7 @@ function_definition(const struct parser_param *param, char arg1[MAXTOKEN])
 		case SHARP_ELIF:
 		case SHARP_ELSE:
 		case SHARP_ENDIF:
-			condition_macro(param, c);
+			condition_macro(param, tp, ps, c);
 			continue;
 		default:
 			break;
@@ -546,15 +557,15 @@ function_definition(const struct parser_param *param, char arg1[MAXTOKEN])
 		if (c == SYMBOL) {
 			if (accept_arg1 == 0) {
 				accept_arg1 = 1;
-				strlimcpy(arg1, token, MAXTOKEN);
+				strlimcpy(arg1, tp->token, MAXTOKEN);
 			}
-			PUT(PARSER_REF_SYM, token, lineno, sp);
+			PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 		}
 	}
 	if (c == EOF)
 		return 0;
 	brace_level = 0;
-	while ((c = nexttoken(",;[](){}=", c_reserved_word)) != EOF) {
+	while ((c = nexttoken(tp, ",;[](){}=", c_reserved_word)) != EOF) {
 		switch (c) {
 		case SHARP_IFDEF:
 		case SHARP_IFNDEF:
@@ -562,13 +573,13 @@ function_definition(const struct parser_param *param, char arg1[MAXTOKEN])
 		case SHARP_ELIF:
 		case SHARP_ELSE:
 		case SHARP_ENDIF:
-			condition_macro(param, c);
+			condition_macro(param, tp, ps, c);
 			continue;
 		case C___ATTRIBUTE__:
-			process_attribute(param);
+			process_attribute(param, tp, ps);
 			continue;
 		case SHARP_DEFINE:
-			pushbacktoken();
+			pushbacktoken(tp);
 			return 0;
 		default:
 			break;
@@ -578,13 +589,13 @@ function_definition(const struct parser_param *param, char arg1[MAXTOKEN])
 		else if (c == /* ( */')' || c == ']')
 			brace_level--;
 		else if (brace_level == 0
-		    && ((c == SYMBOL && strcmp(token, "__THROW")) || IS_RESERVED_WORD(c)))
+		    && ((c == SYMBOL && strcmp(tp->token, "__THROW")) || IS_RESERVED_WORD(c)))
 			isdefine = 1;
 		else if (c == ';' || c == ',') {
 			if (!isdefine)
 				break;
 		} else if (c == '{' /* } */) {
-			pushbacktoken();
+			pushbacktoken(tp);
 			return 1;
 		} else if (c == /* { */'}')
 			break;
@@ -593,7 +604,7 @@ function_definition(const struct parser_param *param, char arg1[MAXTOKEN])
 
 		/* pick up symbol */
 		if (c == SYMBOL)
-			PUT(PARSER_REF_SYM, token, lineno, sp);
+			PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 	}
 	return 0;
 }
@@ -602,59 +613,60 @@ function_definition(const struct parser_param *param, char arg1[MAXTOKEN])
  * condition_macro: 
  *
  *	@param	param	
+ *	@param[in,out]	ps	parse state
  *	@param[in]	cc	token
  */
 static void
-condition_macro(const struct parser_param *param, int cc)
+condition_macro(const struct parser_param *param, TOKEN *tp, struct parse_state *ps, int cc)
 {
-	cur = &stack[piflevel];
+	ps->cur = &ps->stack[ps->piflevel];
 	if (cc == SHARP_IFDEF || cc == SHARP_IFNDEF || cc == SHARP_IF) {
-		DBG_PRINT(piflevel, "#if");
-		if (++piflevel >= MAXPIFSTACK)
-			die("#if stack over flow. [%s]", curfile);
-		++cur;
-		cur->start = level;
-		cur->end = -1;
-		cur->if0only = 0;
-		if (peekc(0) == '0')
-			cur->if0only = 1;
-		else if ((cc = nexttoken(NULL, c_reserved_word)) == SYMBOL && !strcmp(token, "notdef"))
-			cur->if0only = 1;
+		DBG_PRINT(ps->piflevel, "#if");
+		if (++ps->piflevel >= MAXPIFSTACK)
+			die("#if stack over flow. [%s]", tp->curfile);
+		++ps->cur;
+		ps->cur->start = ps->level;
+		ps->cur->end = -1;
+		ps->cur->if0only = 0;
+		if (peekc(tp, 0) == '0')
+			ps->cur->if0only = 1;
+		else if ((cc = nexttoken(tp, NULL, c_reserved_word)) == SYMBOL && !strcmp(tp->token, "notdef"))
+			ps->cur->if0only = 1;
 		else
-			pushbacktoken();
+			pushbacktoken(tp);
 	} else if (cc == SHARP_ELIF || cc == SHARP_ELSE) {
-		DBG_PRINT(piflevel - 1, "#else");
-		if (cur->end == -1)
-			cur->end = level;
-		else if (cur->end != level && (param->flags & PARSER_WARNING))
-			warning("uneven level. [+%d %s]", lineno, curfile);
-		level = cur->start;
-		cur->if0only = 0;
+		DBG_PRINT(ps->piflevel - 1, "#else");
+		if (ps->cur->end == -1)
+			ps->cur->end = ps->level;
+		else if (ps->cur->end != ps->level && (param->flags & PARSER_WARNING))
+			warning("uneven level. [+%d %s]", tp->lineno, tp->curfile);
+		ps->level = ps->cur->start;
+		ps->cur->if0only = 0;
 	} else if (cc == SHARP_ENDIF) {
 		int minus = 0;
 
-		--piflevel;
-		if (piflevel < 0) {
+		--ps->piflevel;
+		if (ps->piflevel < 0) {
 			minus = 1;
-			piflevel = 0;
+			ps->piflevel = 0;
 		}
-		DBG_PRINT(piflevel, "#endif");
+		DBG_PRINT(ps->piflevel, "#endif");
 		if (minus) {
 			if (param->flags & PARSER_WARNING)
-				warning("unmatched #if block. reseted. [+%d %s]", lineno, curfile);
+				warning("unmatched #if block. reseted. [+%d %s]", tp->lineno, tp->curfile);
 		} else {
-			if (cur->if0only)
-				level = cur->start;
-			else if (cur->end != -1) {
-				if (cur->end != level && (param->flags & PARSER_WARNING))
-					warning("uneven level. [+%d %s]", lineno, curfile);
-				level = cur->end;
+			if (ps->cur->if0only)
+				ps->level = ps->cur->start;
+			else if (ps->cur->end != -1) {
+				if (ps->cur->end != ps->level && (param->flags & PARSER_WARNING))
+					warning("uneven level. [+%d %s]", tp->lineno, tp->curfile);
+				ps->level = ps->cur->end;
 			}
 		}
 	}
-	while ((cc = nexttoken(NULL, c_reserved_word)) != EOF && cc != '\n') {
-		if (cc == SYMBOL && strcmp(token, "defined") != 0)
-			PUT(PARSER_REF_SYM, token, lineno, sp);
+	while ((cc = nexttoken(tp, NULL, c_reserved_word)) != EOF && cc != '\n') {
+		if (cc == SYMBOL && strcmp(tp->token, "defined") != 0)
+			PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 	}
 }
 
@@ -662,13 +674,13 @@ condition_macro(const struct parser_param *param, int cc)
  * enumerator_list: process "symbol (= expression), ... "}
  */
 static int
-enumerator_list(const struct parser_param *param)
+enumerator_list(const struct parser_param *param, TOKEN *tp, struct parse_state *ps)
 {
-	int savelevel = level;
+	int savelevel = ps->level;
 	int in_expression = 0;
 	int c = '{';
 
-	for (; c != EOF; c = nexttoken("{}(),=", c_reserved_word)) {
+	for (; c != EOF; c = nexttoken(tp, "{}(),=", c_reserved_word)) {
 		switch (c) {
 		case SHARP_IFDEF:
 		case SHARP_IFNDEF:
@@ -676,25 +688,25 @@ enumerator_list(const struct parser_param *param)
 		case SHARP_ELIF:
 		case SHARP_ELSE:
 		case SHARP_ENDIF:
-			condition_macro(param, c);
+			condition_macro(param, tp, ps, c);
 			break;
 		case SYMBOL:
 			if (in_expression)
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			else
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 			break;
 		case '{':
 		case '(':
-			level++;
+			ps->level++;
 			break;
 		case '}':
 		case ')':
-			if (--level == savelevel)
+			if (--ps->level == savelevel)
 				return c;
 			break;
 		case ',':
-			if (level == savelevel + 1)
+			if (ps->level == savelevel + 1)
 				in_expression = 0;
 			break;
 		case '=':
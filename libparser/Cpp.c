@@ -35,11 +35,6 @@
 #include "token.h"
 #include "cpp_res.h"
 
-static void process_attribute(const struct parser_param *);
-static int function_definition(const struct parser_param *);
-static void condition_macro(const struct parser_param *, int);
-static int enumerator_list(const struct parser_param *);
-
 		/** max size of complete name of class */
 #define MAXCOMPLETENAME 1024
 		/** max size of class stack */
@@ -48,18 +43,30 @@ static int enumerator_list(const struct parser_param *);
 
 #define MAXPIFSTACK	100
 
-/*
- * #ifdef stack.
+#undef DBG_LEVEL
+#define DBG_LEVEL	(ps->level)
+
+/**
+ * The state of a parse. Each Cpp() call has its own.
  */
+struct parse_state {
+	/*
+	 * #ifdef stack.
+	 */
+	struct {
+		short start;		/**< level when '#if' block started */
+		short end;		/**< level when '#if' block end */
+		short if0only;		/**< '#if 0' or notdef only */
+	} pifstack[MAXPIFSTACK], *cur;
+	int piflevel;			/**< condition macro level */
+	int level;			/**< brace level */
+	int namespacelevel;		/**< namespace block level */
+};
 
-static struct {
-	short start;		/**< level when '#if' block started */
-	short end;		/**< level when '#if' block end */
-	short if0only;		/**< '#if 0' or notdef only */
-} pifstack[MAXPIFSTACK], *cur;
-static int piflevel;		/**< condition macro level */
-static int level;		/**< brace level */
-static int namespacelevel;	/**< namespace block level */
+static void process_attribute(const struct parser_param *, TOKEN *, struct parse_state *);
+static int function_definition(const struct parser_param *, TOKEN *, struct parse_state *);
+static void condition_macro(const struct parser_param *, TOKEN *, struct parse_state *, int);
+static int enumerator_list(const struct parser_param *, TOKEN *, struct parse_state *);
 
 /**
  * Cpp: read C++ file and pickup tag entries.
@@ -68,6 +75,8 @@ void
 Cpp(const struct parser_param *param)
 {
 	int c, cc;
+	TOKEN *tp;
+	struct parse_state state, *ps = &state;
 	int savelevel;
 	int startclass, startthrow, startmacro, startsharp, startequal;
 	char classname[MAXTOKEN];
@@ -86,37 +95,38 @@ Cpp(const struct parser_param *param)
 	stack[0].classname = completename;
 	stack[0].terminate = completename;
 	stack[0].level = 0;
-	level = classlevel = piflevel = namespacelevel = 0;
+	memset(ps, 0, sizeof(*ps));
+	classlevel = 0;
 	savelevel = -1;
 	startclass = startthrow = startmacro = startsharp = startequal = 0;
 
-	if (!opentoken(param->file))
+	if ((tp = OPENTOKEN(param)) == NULL)
 		die("'%s' cannot open.", param->file);
-	cmode = 1;			/* allow token like '#xxx' */
-	crflag = 1;			/* require '\n' as a token */
-	cppmode = 1;			/* treat '::' as a token */
+	tp->cmode = 1;			/* allow token like '#xxx' */
+	tp->crflag = 1;			/* require '\n' as a token */
+	tp->cppmode = 1;			/* treat '::' as a token */
 
-	while ((cc = nexttoken(interested, cpp_reserved_word)) != EOF) {
-		if (cc == '~' && level == stack[classlevel].level)
+	while ((cc = nexttoken(tp, interested, cpp_reserved_word)) != EOF) {
+		if (cc == '~' && ps->level == stack[classlevel].level)
 			continue;
 		switch (cc) {
 		case SYMBOL:		/* symbol	*/
 			if (startclass || startthrow) {
-				PUT(PARSER_REF_SYM, token, lineno, sp);
-			} else if (peekc(0) == '('/* ) */) {
-				if (param->isnotfunction(token)) {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
-				} else if (level > stack[classlevel].level || startequal || startmacro) {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
-				} else if (level == stack[classlevel].level && !startmacro && !startsharp && !startequal) {
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
+			} else if (peekc(tp, 0) == '('/* ) */) {
+				if (param->isnotfunction(tp->token)) {
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
+				} else if (ps->level > stack[classlevel].level || startequal || startmacro) {
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
+				} else if (ps->level == stack[classlevel].level && !startmacro && !startsharp && !startequal) {
 					char savetok[MAXTOKEN], *saveline;
-					int savelineno = lineno;
+					int savelineno = tp->lineno;
 
-					strlimcpy(savetok, token, sizeof(savetok));
+					strlimcpy(savetok, tp->token, sizeof(savetok));
 					strbuf_reset(sb);
-					strbuf_puts(sb, sp);
+					strbuf_puts(sb, tp->sp);
 					saveline = strbuf_value(sb);
-					if (function_definition(param)) {
+					if (function_definition(param, tp, ps)) {
 						/* ignore constructor */
 						if (strcmp(stack[classlevel].classname, savetok))
 							PUT(PARSER_DEF, savetok, savelineno, saveline);
@@ -125,58 +135,58 @@ Cpp(const struct parser_param *param)
 					}
 				}
 			} else {
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			}
 			break;
 		case CPP_USING:
-			crflag = 0;
+			tp->crflag = 0;
 			/*
 			 * using namespace name;
 			 * using ...;
 			 */
-			if ((c = nexttoken(interested, cpp_reserved_word)) == CPP_NAMESPACE) {
-				if ((c = nexttoken(interested, cpp_reserved_word)) == SYMBOL) {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
+			if ((c = nexttoken(tp, interested, cpp_reserved_word)) == CPP_NAMESPACE) {
+				if ((c = nexttoken(tp, interested, cpp_reserved_word)) == SYMBOL) {
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 				} else {
 					if (param->flags & PARSER_WARNING)
-						warning("missing namespace name. [+%d %s].", lineno, curfile);
-					pushbacktoken();
+						warning("missing namespace name. [+%d %s].", tp->lineno, tp->curfile);
+					pushbacktoken(tp);
 				}
 			} else if (c  == SYMBOL) {
 				char savetok[MAXTOKEN], *saveline;
-				int savelineno = lineno;
+				int savelineno = tp->lineno;
 
-				strlimcpy(savetok, token, sizeof(savetok));
+				strlimcpy(savetok, tp->token, sizeof(savetok));
 				strbuf_reset(sb);
-				strbuf_puts(sb, sp);
+				strbuf_puts(sb, tp->sp);
 				saveline = strbuf_value(sb);
-				if ((c = nexttoken(interested, cpp_reserved_word)) == '=') {
+				if ((c = nexttoken(tp, interested, cpp_reserved_word)) == '=') {
 					PUT(PARSER_DEF, savetok, savelineno, saveline);
 				} else {
 					PUT(PARSER_REF_SYM, savetok, savelineno, saveline);
 					while (c == SYMBOL) {
-						PUT(PARSER_REF_SYM, token, lineno, sp);
-						c = nexttoken(interested, cpp_reserved_word);
+						PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
+						c = nexttoken(tp, interested, cpp_reserved_word);
 					}
 				}
 			} else {
-				pushbacktoken();
+				pushbacktoken(tp);
 			}
-			crflag = 1;
+			tp->crflag = 1;
 			break;
 		case CPP_NAMESPACE:
-			crflag = 0;
+			tp->crflag = 0;
 			/*
 			 * namespace name = ...;
 			 * namespace [name] { ... }
 			 * namespace name[::name]* { ... }
 			 */
 		cpp_namespace_loop:
-			if ((c = nexttoken(interested, cpp_reserved_word)) == SYMBOL) {
+			if ((c = nexttoken(tp, interested, cpp_reserved_word)) == SYMBOL) {
 			cpp_namespace_token_loop:
-				PUT(PARSER_DEF, token, lineno, sp);
-				if ((c = nexttoken(interested, cpp_reserved_word)) == '=') {
-					crflag = 1;
+				PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
+				if ((c = nexttoken(tp, interested, cpp_reserved_word)) == '=') {
+					tp->crflag = 1;
 					break;
 				}
 				if (c == CPP_WCOLON)
@@ -188,56 +198,56 @@ Cpp(const struct parser_param *param)
 			 * Namespace block doesn't have any influence on level.
 			 */
 			if (c == '{') /* } */ {
-				namespacelevel++;
+				ps->namespacelevel++;
 			} else {
 				if (param->flags & PARSER_WARNING)
-					warning("missing namespace block. [+%d %s](0x%x).", lineno, curfile, c);
+					warning("missing namespace block. [+%d %s](0x%x).", tp->lineno, tp->curfile, c);
 			}
-			crflag = 1;
+			tp->crflag = 1;
 			break;
 		case CPP_EXTERN: /* for 'extern "C"/"C++"' */
-			if (peekc(0) != '"') /* " */
+			if (peekc(tp, 0) != '"') /* " */
 				continue; /* If does not start with '"', continue. */
-			while ((c = nexttoken(interested, cpp_reserved_word)) == '\n')
+			while ((c = nexttoken(tp, interested, cpp_reserved_word)) == '\n')
 				;
 			/*
 			 * 'extern "C"/"C++"' block is a kind of namespace block.
 			 * (It doesn't have any influence on level.)
 			 */
 			if (c == '{') /* } */
-				namespacelevel++;
+				ps->namespacelevel++;
 			else
-				pushbacktoken();
+				pushbacktoken(tp);
 			break;
 		case CPP_STRUCT:
 		case CPP_CLASS:
-			DBG_PRINT(level, cc == CPP_CLASS ? "class" : "struct");
-			while ((c = nexttoken(NULL, cpp_reserved_word)) == CPP___ATTRIBUTE__ || c == '\n')
+			DBG_PRINT(ps->level, cc == CPP_CLASS ? "class" : "struct");
+			while ((c = nexttoken(tp, NULL, cpp_reserved_word)) == CPP___ATTRIBUTE__ || c == '\n')
 				if (c == CPP___ATTRIBUTE__)
-					process_attribute(param);
+					process_attribute(param, tp, ps);
 			if (c == SYMBOL) {
 				char *saveline;
 				int savelineno;
 				do {
 					if (c == SYMBOL) {
-						savelineno = lineno;
+						savelineno = tp->lineno;
 						strbuf_reset(sb);
-						strbuf_puts(sb, sp);
+						strbuf_puts(sb, tp->sp);
 						saveline = strbuf_value(sb);
-						strlimcpy(classname, token, sizeof(classname));
+						strlimcpy(classname, tp->token, sizeof(classname));
 					}
-					c = nexttoken(NULL, cpp_reserved_word);
+					c = nexttoken(tp, NULL, cpp_reserved_word);
 					if (c == SYMBOL)
 						PUT(PARSER_REF_SYM, classname, savelineno, saveline);
 					else if (c == '<') {
 						int templates = 1;
 						for (;;) {
-							c = nexttoken(NULL, cpp_reserved_word);
+							c = nexttoken(tp, NULL, cpp_reserved_word);
 							if (c == SYMBOL)
-								PUT(PARSER_REF_SYM, token, lineno, sp);
+								PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 							if (c == '<') {
-								if (peekc(1) == '<')
-									throwaway_nextchar();
+								if (peekc(tp, 1) == '<')
+									throwaway_nextchar(tp);
 								else
 									++templates;
 							} else if (c == '>') {
@@ -245,13 +255,13 @@ Cpp(const struct parser_param *param)
 									break;
 							} else if (c == EOF) {
 								if (param->flags & PARSER_WARNING) 
-									warning("failed to parse template [+%d %s].", savelineno, curfile);
+									warning("failed to parse template [+%d %s].", savelineno, tp->curfile);
 								goto finish;
 							}
 						}
-						c = nexttoken(NULL, cpp_reserved_word);
+						c = nexttoken(tp, NULL, cpp_reserved_word);
 					} else if (c == CPP_FINAL) {
-						c = nexttoken(NULL, cpp_reserved_word);
+						c = nexttoken(tp, NULL, cpp_reserved_word);
 					}
 				} while (c == SYMBOL || c == '\n');
 				if (c == ':' || c == '{') /* } */ {
@@ -260,57 +270,57 @@ Cpp(const struct parser_param *param)
 				} else
 					PUT(PARSER_REF_SYM, classname, savelineno, saveline);
 			}
-			pushbacktoken();
+			pushbacktoken(tp);
 			break;
 		case '{':  /* } */
-			DBG_PRINT(level, "{"); /* } */
-			++level;
-			if ((param->flags & PARSER_BEGIN_BLOCK) && atfirst) {
-				if ((param->flags & PARSER_WARNING) && level != 1)
-					warning("forced level 1 block start by '{' at column 0 [+%d %s].", lineno, curfile); /* } */
-				level = 1;
+			DBG_PRINT(ps->level, "{"); /* } */
+			++ps->level;
+			if ((param->flags & PARSER_BEGIN_BLOCK) && atfirst(tp)) {
+				if ((param->flags & PARSER_WARNING) && ps->level != 1)
+					warning("forced level 1 block start by '{' at column 0 [+%d %s].", tp->lineno, tp->curfile); /* } */
+				ps->level = 1;
 			}
 			if (startclass) {
 				char *p = stack[classlevel].terminate;
 				char *q = classname;
 
 				if (++classlevel >= MAXCLASSSTACK)
-					die("class stack over flow.[%s]", curfile);
+					die("class stack over flow.[%s]", tp->curfile);
 				if (classlevel > 1 && p < completename_limit)
 					*p++ = '.';
 				stack[classlevel].classname = p;
 				while (*q && p < completename_limit)
 					*p++ = *q++;
 				stack[classlevel].terminate = p;
-				stack[classlevel].level = level;
+				stack[classlevel].level = ps->level;
 				*p++ = 0;
 			}
 			startclass = startthrow = 0;
 			break;
 			/* { */
 		case '}':
-			if (--level < 0) {
-				if (namespacelevel > 0)
-					namespacelevel--;
+			if (--ps->level < 0) {
+				if (ps->namespacelevel > 0)
+					ps->namespacelevel--;
 				else if (param->flags & PARSER_WARNING)
-					warning("missing left '{' [+%d %s].", lineno, curfile); /* } */
-				level = 0;
+					warning("missing left '{' [+%d %s].", tp->lineno, tp->curfile); /* } */
+				ps->level = 0;
 			}
-			if ((param->flags & PARSER_END_BLOCK) && atfirst) {
-				if ((param->flags & PARSER_WARNING) && level != 0)
+			if ((param->flags & PARSER_END_BLOCK) && atfirst(tp)) {
+				if ((param->flags & PARSER_WARNING) && ps->level != 0)
 					/* { */
-					warning("forced level 0 block end by '}' at column 0 [+%d %s].", lineno, curfile);
-				level = 0;
+					warning("forced level 0 block end by '}' at column 0 [+%d %s].", tp->lineno, tp->curfile);
+				ps->level = 0;
 			}
-			if (level < stack[classlevel].level)
+			if (ps->level < stack[classlevel].level)
 				*(stack[--classlevel].terminate) = 0;
 			/* { */
-			DBG_PRINT(level, "}");
+			DBG_PRINT(ps->level, "}");
 			break;
 		case '=':
 			/* dirty hack. Don't mimic this. */
-			if (peekc(0) == '=') {
-				throwaway_nextchar();
+			if (peekc(tp, 0) == '=') {
+				throwaway_nextchar(tp);
 			} else {
 				startequal = 1;
 			}
@@ -319,10 +329,10 @@ Cpp(const struct parser_param *param)
 			startthrow = startequal = 0;
 			break;
 		case '\n':
-			if (startmacro && level != savelevel) {
+			if (startmacro && ps->level != savelevel) {
 				if (param->flags & PARSER_WARNING)
-					warning("different level before and after #define macro. reseted. [+%d %s].", lineno, curfile);
-				level = savelevel;
+					warning("different level before and after #define macro. reseted. [+%d %s].", tp->lineno, tp->curfile);
+				ps->level = savelevel;
 			}
 			startmacro = startsharp = 0;
 			break;
@@ -332,20 +342,20 @@ Cpp(const struct parser_param *param)
 		case SHARP_DEFINE:
 		case SHARP_UNDEF:
 			startmacro = 1;
-			savelevel = level;
-			if ((c = nexttoken(interested, cpp_reserved_word)) != SYMBOL) {
-				pushbacktoken();
+			savelevel = ps->level;
+			if ((c = nexttoken(tp, interested, cpp_reserved_word)) != SYMBOL) {
+				pushbacktoken(tp);
 				break;
 			}
-			if (peekc(1) == '('/* ) */) {
-				PUT(PARSER_DEF, token, lineno, sp);
-				while ((c = nexttoken("()", cpp_reserved_word)) != EOF && c != '\n' && c != /* ( */ ')')
+			if (peekc(tp, 1) == '('/* ) */) {
+				PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
+				while ((c = nexttoken(tp, "()", cpp_reserved_word)) != EOF && c != '\n' && c != /* ( */ ')')
 					if (c == SYMBOL)
-						PUT(PARSER_REF_SYM, token, lineno, sp);
+						PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 				if (c == '\n')
-					pushbacktoken();
+					pushbacktoken(tp);
 			}  else {
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 			}
 			break;
 		case SHARP_IMPORT:
@@ -357,7 +367,7 @@ Cpp(const struct parser_param *param)
 		case SHARP_WARNING:
 		case SHARP_IDENT:
 		case SHARP_SCCS:
-			while ((c = nexttoken(interested, cpp_reserved_word)) != EOF && c != '\n')
+			while ((c = nexttoken(tp, interested, cpp_reserved_word)) != EOF && c != '\n')
 				;
 			break;
 		case SHARP_IFDEF:
@@ -366,68 +376,68 @@ Cpp(const struct parser_param *param)
 		case SHARP_ELIF:
 		case SHARP_ELSE:
 		case SHARP_ENDIF:
-			condition_macro(param, cc);
+			condition_macro(param, tp, ps, cc);
 			break;
 		case SHARP_SHARP:		/* ## */
-			(void)nexttoken(interested, cpp_reserved_word);
+			(void)nexttoken(tp, interested, cpp_reserved_word);
 			break;
 		case CPP_NEW:
-			if ((c = nexttoken(interested, cpp_reserved_word)) == SYMBOL)
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+			if ((c = nexttoken(tp, interested, cpp_reserved_word)) == SYMBOL)
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			break;
 		case CPP_ENUM:
 		case CPP_UNION:
-			while ((c = nexttoken(interested, cpp_reserved_word)) == CPP___ATTRIBUTE__)
-				process_attribute(param);
+			while ((c = nexttoken(tp, interested, cpp_reserved_word)) == CPP___ATTRIBUTE__)
+				process_attribute(param, tp, ps);
 			while (c == '\n')
-				c = nexttoken(interested, cpp_reserved_word);
+				c = nexttoken(tp, interested, cpp_reserved_word);
 			if (c == SYMBOL) {
-				if (peekc(0) == '{') /* } */ {
-					PUT(PARSER_DEF, token, lineno, sp);
+				if (peekc(tp, 0) == '{') /* } */ {
+					PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 				} else {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 				}
-				c = nexttoken(interested, cpp_reserved_word);
+				c = nexttoken(tp, interested, cpp_reserved_word);
 			}
 			while (c == '\n')
-				c = nexttoken(interested, cpp_reserved_word);
+				c = nexttoken(tp, interested, cpp_reserved_word);
 			if (c == '{' /* } */ && cc == CPP_ENUM) {
-				enumerator_list(param);
+				enumerator_list(param, tp, ps);
 			} else {
-				pushbacktoken();
+				pushbacktoken(tp);
 			}
 			break;
 		case CPP_TEMPLATE:
 			{
 				int level = 0;
 
-				while ((c = nexttoken("<>", cpp_reserved_word)) != EOF) {
+				while ((c = nexttoken(tp, "<>", cpp_reserved_word)) != EOF) {
 					if (c == '<')
 						++level;
 					else if (c == '>') {
 						if (--level == 0)
 							break;
 					} else if (c == SYMBOL) {
-						PUT(PARSER_REF_SYM, token, lineno, sp);
+						PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 					}
 				}
 				if (c == EOF && (param->flags & PARSER_WARNING))
-					warning("template <...> isn't closed. [+%d %s].", lineno, curfile);
+					warning("template <...> isn't closed. [+%d %s].", tp->lineno, tp->curfile);
 			}
 			break;
 		case CPP_OPERATOR:
-			while ((c = nexttoken(";{", /* } */ cpp_reserved_word)) != EOF) {
+			while ((c = nexttoken(tp, ";{", /* } */ cpp_reserved_word)) != EOF) {
 				if (c == '{') /* } */ {
-					pushbacktoken();
+					pushbacktoken(tp);
 					break;
 				} else if (c == ';') {
 					break;
 				} else if (c == SYMBOL) {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 				}
 			}
 			if (c == EOF && (param->flags & PARSER_WARNING))
-				warning("'{' doesn't exist after 'operator'. [+%d %s].", lineno, curfile); /* } */
+				warning("'{' doesn't exist after 'operator'. [+%d %s].", tp->lineno, tp->curfile); /* } */
 			break;
 		/* control statement check */
 		case CPP_THROW:
@@ -447,8 +457,8 @@ Cpp(const struct parser_param *param)
 		case CPP_SWITCH:
 		case CPP_TRY:
 		case CPP_WHILE:
-			if ((param->flags & PARSER_WARNING) && !startmacro && level == 0)
-				warning("Out of function. %8s [+%d %s]", token, lineno, curfile);
+			if ((param->flags & PARSER_WARNING) && !startmacro && ps->level == 0)
+				warning("Out of function. %8s [+%d %s]", tp->token, tp->lineno, tp->curfile);
 			break;
 		case CPP_TYPEDEF:
 			{
@@ -458,45 +468,45 @@ Cpp(const struct parser_param *param)
 				 */
 				char savetok[MAXTOKEN];
 				int savelineno = 0;
-				int typedef_savelevel = level;
+				int typedef_savelevel = ps->level;
 				int templates = 0;
 
 				savetok[0] = 0;
 
 				/* skip CV qualifiers */
 				do {
-					c = nexttoken("{}(),;", cpp_reserved_word);
+					c = nexttoken(tp, "{}(),;", cpp_reserved_word);
 				} while (IS_CV_QUALIFIER(c) || c == '\n');
 
 				if ((param->flags & PARSER_WARNING) && c == EOF) {
-					warning("unexpected eof. [+%d %s]", lineno, curfile);
+					warning("unexpected eof. [+%d %s]", tp->lineno, tp->curfile);
 					break;
 				} else if (c == CPP_ENUM || c == CPP_STRUCT || c == CPP_UNION) {
 					char *interest_enum = "{},;";
 					int c_ = c;
 
-					while ((c = nexttoken(interest_enum, cpp_reserved_word)) == CPP___ATTRIBUTE__)
-						process_attribute(param);
+					while ((c = nexttoken(tp, interest_enum, cpp_reserved_word)) == CPP___ATTRIBUTE__)
+						process_attribute(param, tp, ps);
 					while (c == '\n')
-						c = nexttoken(interest_enum, cpp_reserved_word);
+						c = nexttoken(tp, interest_enum, cpp_reserved_word);
 					/* read tag name if exist */
 					if (c == SYMBOL) {
-						if (peekc(0) == '{') /* } */ {
-							PUT(PARSER_DEF, token, lineno, sp);
+						if (peekc(tp, 0) == '{') /* } */ {
+							PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 						} else {
-							PUT(PARSER_REF_SYM, token, lineno, sp);
+							PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 						}
-						c = nexttoken(interest_enum, cpp_reserved_word);
+						c = nexttoken(tp, interest_enum, cpp_reserved_word);
 					}
 					while (c == '\n')
-						c = nexttoken(interest_enum, cpp_reserved_word);
+						c = nexttoken(tp, interest_enum, cpp_reserved_word);
 					if (c_ == CPP_ENUM) {
 						if (c == '{') /* } */
-							c = enumerator_list(param);
+							c = enumerator_list(param, tp, ps);
 						else
-							pushbacktoken();
+							pushbacktoken(tp);
 					} else {
-						for (; c != EOF; c = nexttoken(interest_enum, cpp_reserved_word)) {
+						for (; c != EOF; c = nexttoken(tp, interest_enum, cpp_reserved_word)) {
 							switch (c) {
 							case SHARP_IFDEF:
 							case SHARP_IFNDEF:
@@ -504,43 +514,43 @@ Cpp(const struct parser_param *param)
 							case SHARP_ELIF:
 							case SHARP_ELSE:
 							case SHARP_ENDIF:
-								condition_macro(param, c);
+								condition_macro(param, tp, ps, c);
 								continue;
 							default:
 								break;
 							}
-							if (c == ';' && level == typedef_savelevel) {
+							if (c == ';' && ps->level == typedef_savelevel) {
 								if (savetok[0]) {
-									PUT(PARSER_DEF, savetok, savelineno, sp);
+									PUT(PARSER_DEF, savetok, savelineno, tp->sp);
 									savetok[0] = 0;
 								}
 								break;
 							} else if (c == '{')
-								level++;
+								ps->level++;
 							else if (c == '}') {
 								savetok[0] = 0;
-								if (--level == typedef_savelevel)
+								if (--ps->level == typedef_savelevel)
 									break;
 							} else if (c == SYMBOL) {
-								if (level > typedef_savelevel)
-									PUT(PARSER_REF_SYM, token, lineno, sp);
+								if (ps->level > typedef_savelevel)
+									PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 								/* save lastest token */
-								strlimcpy(savetok, token, sizeof(savetok));
-								savelineno = lineno;
+								strlimcpy(savetok, tp->token, sizeof(savetok));
+								savelineno = tp->lineno;
 							}
 						}
 						if (c == ';')
 							break;
 					}
 					if ((param->flags & PARSER_WARNING) && c == EOF) {
-						warning("unexpected eof. [+%d %s]", lineno, curfile);
+						warning("unexpected eof. [+%d %s]", tp->lineno, tp->curfile);
 						break;
 					}
 				} else if (c == SYMBOL) {
-					PUT(PARSER_REF_SYM, token, lineno, sp);
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 				}
 				savetok[0] = 0;
-				while ((c = nexttoken("()<>,;", cpp_reserved_word)) != EOF) {
+				while ((c = nexttoken(tp, "()<>,;", cpp_reserved_word)) != EOF) {
 					switch (c) {
 					case SHARP_IFDEF:
 					case SHARP_IFNDEF:
@@ -548,50 +558,50 @@ Cpp(const struct parser_param *param)
 					case SHARP_ELIF:
 					case SHARP_ELSE:
 					case SHARP_ENDIF:
-						condition_macro(param, c);
+						condition_macro(param, tp, ps, c);
 						continue;
 					default:
 						break;
 					}
 					if (c == '(')
-						level++;
+						ps->level++;
 					else if (c == ')')
-						level--;
+						ps->level--;
 					else if (c == '<')
 						templates++;
 					else if (c == '>')
 						templates--;
 					else if (c == SYMBOL) {
-						if (level > typedef_savelevel) {
-							PUT(PARSER_REF_SYM, token, lineno, sp);
+						if (ps->level > typedef_savelevel) {
+							PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 						} else {
 							/* put latest token if any */
 							if (savetok[0]) {
-								PUT(PARSER_REF_SYM, savetok, savelineno, sp);
+								PUT(PARSER_REF_SYM, savetok, savelineno, tp->sp);
 							}
 							/* save lastest token */
-							strlimcpy(savetok, token, sizeof(savetok));
-							savelineno = lineno;
+							strlimcpy(savetok, tp->token, sizeof(savetok));
+							savelineno = tp->lineno;
 						}
 					} else if (c == ',' || c == ';') {
 						if (savetok[0]) {
-							PUT(templates ? PARSER_REF_SYM : PARSER_DEF, savetok, lineno, sp);
+							PUT(templates ? PARSER_REF_SYM : PARSER_DEF, savetok, tp->lineno, tp->sp);
 							savetok[0] = 0;
 						}
 					}
-					if (level == typedef_savelevel && c == ';')
+					if (ps->level == typedef_savelevel && c == ';')
 						break;
 				}
 				if (param->flags & PARSER_WARNING) {
 					if (c == EOF)
-						warning("unexpected eof. [+%d %s]", lineno, curfile);
-					else if (level != typedef_savelevel)
-						warning("unmatched () block. (last at level %d.)[+%d %s]", level, lineno, curfile);
+						warning("unexpected eof. [+%d %s]", tp->lineno, tp->curfile);
+					else if (ps->level != typedef_savelevel)
+						warning("unmatched () block. (last at level %d.)[+%d %s]", ps->level, tp->lineno, tp->curfile);
 				}
 			}
 			break;
 		case CPP___ATTRIBUTE__:
-			process_attribute(param);
+			process_attribute(param, tp, ps);
 			break;
 		default:
 			break;
@@ -600,18 +610,18 @@ Cpp(const struct parser_param *param)
 finish:
 	strbuf_close(sb);
 	if (param->flags & PARSER_WARNING) {
-		if (level != 0)
-			warning("unmatched {} block. (last at level %d.)[+%d %s]", level, lineno, curfile);
-		if (piflevel != 0)
-			warning("unmatched #if block. (last at level %d.)[+%d %s]", piflevel, lineno, curfile);
+		if (ps->level != 0)
+			warning("unmatched {} block. (last at level %d.)[+%d %s]", ps->level, tp->lineno, tp->curfile);
+		if (ps->piflevel != 0)
+			warning("unmatched #if block. (last at level %d.)[+%d %s]", ps->piflevel, tp->lineno, tp->curfile);
 	}
-	closetoken();
+	closetoken(tp);
 }
 /**
  * process_attribute: skip attributes in '__attribute__((...))'.
  */
 static void
-process_attribute(const struct parser_param *param)
+process_attribute(const struct parser_param *param, TOKEN *tp, struct parse_state *ps)
 {
 	int brace = 0;
 	int c;
@@ -619,13 +629,13 @@ process_attribute(const struct parser_param *param)
 	 * Skip '...' in __attribute__((...))
 	 * but pick up symbols in it.
 	 */
-	while ((c = nexttoken("()", cpp_reserved_word)) != EOF) {
+	while ((c = nexttoken(tp, "()", cpp_reserved_word)) != EOF) {
 		if (c == '(')
 			brace++;
 		else if (c == ')')
 			brace--;
 		else if (c == SYMBOL) {
-			PUT(PARSER_REF_SYM, token, lineno, sp);
+			PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 		}
 		if (brace == 0)
 			break;
@@ -637,13 +647,13 @@ process_attribute(const struct parser_param *param)
  *	@return	target type
  */
 static int
-function_definition(const struct parser_param *param)
+function_definition(const struct parser_param *param, TOKEN *tp, struct parse_state *ps)
 {
 	int c;
 	int brace_level;
 
 	brace_level = 0;
-	while ((c = nexttoken("()", cpp_reserved_word)) != EOF) {
+	while ((c = nexttoken(tp, "()", cpp_reserved_word)) != EOF) {
 		switch (c) {
 		case SHARP_IFDEF:
 		case SHARP_IFNDEF:
@@ -651,7 +661,7 @@ function_definition(const struct parser_param *param)
 		case SHARP_ELIF:
 		case SHARP_ELSE:
 		case SHARP_ENDIF:
-			condition_macro(param, c);
+			condition_macro(param, tp, ps, c);
 			continue;
 		default:
 			break;
@@ -664,16 +674,16 @@ function_definition(const struct parser_param *param)
 		}
 		/* pick up symbol */
 		if (c == SYMBOL)
-			PUT(PARSER_REF_SYM, token, lineno, sp);
+			PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 	}
 	if (c == EOF)
 		return 0;
-	if (peekc(0) == ';') {
-		(void)nexttoken(";", NULL);
+	if (peekc(tp, 0) == ';') {
+		(void)nexttoken(tp, ";", NULL);
 		return 0;
 	}
 	brace_level = 0;
-	while ((c = nexttoken(",;[](){}=", cpp_reserved_word)) != EOF) {
+	while ((c = nexttoken(tp, ",;[](){}=", cpp_reserved_word)) != EOF) {
 		switch (c) {
 		case SHARP_IFDEF:
 		case SHARP_IFNDEF:
@@ -681,13 +691,13 @@ function_definition(const struct parser_param *param)
 		case SHARP_ELIF:
 		case SHARP_ELSE:
 		case SHARP_ENDIF:
-			condition_macro(param, c);
+			condition_macro(param, tp, ps, c);
 			continue;
 		case CPP___ATTRIBUTE__:
-			process_attribute(param);
+			process_attribute(param, tp, ps);
 			continue;
 		case SHARP_DEFINE:
-			pushbacktoken();
+			pushbacktoken(tp);
 			return 0;
 		default:
 			break;
@@ -699,16 +709,16 @@ function_definition(const struct parser_param *param)
 		else if (brace_level == 0 && (c == ';' || c == ','))
 			break;
 		else if (c == '{' /* } */) {
-			pushbacktoken();
+			pushbacktoken(tp);
 			return 1;
 		} else if (c == /* { */'}') {
-			pushbacktoken();
+			pushbacktoken(tp);
 			break;
 		} else if (c == '=')
 			break;
 		/* pick up symbol */
 		if (c == SYMBOL)
-			PUT(PARSER_REF_SYM, token, lineno, sp);
+			PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 	}
 	return 0;
 }
@@ -717,59 +727,60 @@ function_definition(const struct parser_param *param)
  * condition_macro: 
  *
  *	@param[in]	param
+ *	@param[in,out]	ps	parse state
  *	@param[in]	cc	token
  */
 static void
-condition_macro(const struct parser_param *param, int cc)
+condition_macro(const struct parser_param *param, TOKEN *tp, struct parse_state *ps, int cc)
 {
-	cur = &pifstack[piflevel];
+	ps->cur = &ps->pifstack[ps->piflevel];
 	if (cc == SHARP_IFDEF || cc == SHARP_IFNDEF || cc == SHARP_IF) {
-		DBG_PRINT(piflevel, "#if");
-		if (++piflevel >= MAXPIFSTACK)
-			die("#if pifstack over flow. [%s]", curfile);
-		++cur;
-		cur->start = level;
-		cur->end = -1;
-		cur->if0only = 0;
-		if (peekc(0) == '0')
-			cur->if0only = 1;
-		else if ((cc = nexttoken(NULL, cpp_reserved_word)) == SYMBOL && !strcmp(token, "notdef"))
-			cur->if0only = 1;
+		DBG_PRINT(ps->piflevel, "#if");
+		if (++ps->piflevel >= MAXPIFSTACK)
+			die("#if pifstack over flow. [%s]", tp->curfile);
+		++ps->cur;
+		ps->cur->start = ps->level;
+		ps->cur->end = -1;
+		ps->cur->if0only = 0;
+		if (peekc(tp, 0) == '0')
+			ps->cur->if0only = 1;
+		else if ((cc = nexttoken(tp, NULL, cpp_reserved_word)) == SYMBOL && !strcmp(tp->token, "notdef"))
+			ps->cur->if0only = 1;
 		else
-			pushbacktoken();
+			pushbacktoken(tp);
 	} else if (cc == SHARP_ELIF || cc == SHARP_ELSE) {
-		DBG_PRINT(piflevel - 1, "#else");
-		if (cur->end == -1)
-			cur->end = level;
-		else if (cur->end != level && (param->flags & PARSER_WARNING))
-			warning("uneven level. [+%d %s]", lineno, curfile);
-		level = cur->start;
-		cur->if0only = 0;
+		DBG_PRINT(ps->piflevel - 1, "#else");
+		if (ps->cur->end == -1)
+			ps->cur->end = ps->level;
+		else if (ps->cur->end != ps->level && (param->flags & PARSER_WARNING))
+			warning("uneven level. [+%d %s]", tp->lineno, tp->curfile);
+		ps->level = ps->cur->start;
+		ps->cur->if0only = 0;
 	} else if (cc == SHARP_ENDIF) {
 		int minus = 0;
 
-		--piflevel;
-		if (piflevel < 0) {
+		--ps->piflevel;
+		if (ps->piflevel < 0) {
 			minus = 1;
-			piflevel = 0;
+			ps->piflevel = 0;
 		}
-		DBG_PRINT(piflevel, "#endif");
+		DBG_PRINT(ps->piflevel, "#endif");
 		if (minus) {
 			if (param->flags & PARSER_WARNING)
-				warning("unmatched #if block. reseted. [+%d %s]", lineno, curfile);
+				warning("unmatched #if block. reseted. [+%d %s]", tp->lineno, tp->curfile);
 		} else {
-			if (cur->if0only)
-				level = cur->start;
-			else if (cur->end != -1) {
-				if (cur->end != level && (param->flags & PARSER_WARNING))
-					warning("uneven level. [+%d %s]", lineno, curfile);
-				level = cur->end;
+			if (ps->cur->if0only)
+				ps->level = ps->cur->start;
+			else if (ps->cur->end != -1) {
+				if (ps->cur->end != ps->level && (param->flags & PARSER_WARNING))
+					warning("uneven level. [+%d %s]", tp->lineno, tp->curfile);
+				ps->level = ps->cur->end;
 			}
 		}
 	}
-	while ((cc = nexttoken(NULL, cpp_reserved_word)) != EOF && cc != '\n') {
-                if (cc == SYMBOL && strcmp(token, "defined") != 0) {
-			PUT(PARSER_REF_SYM, token, lineno, sp);
+	while ((cc = nexttoken(tp, NULL, cpp_reserved_word)) != EOF && cc != '\n') {
+                if (cc == SYMBOL && strcmp(tp->token, "defined") != 0) {
+			PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 		}
 	}
 }
@@ -778,13 +789,13 @@ condition_macro(const struct parser_param *param, int cc)
  * enumerator_list: process "symbol (= expression), ... "}
  */
 static int
-enumerator_list(const struct parser_param *param)
+enumerator_list(const struct parser_param *param, TOKEN *tp, struct parse_state *ps)
 {
-	int savelevel = level;
+	int savelevel = ps->level;
 	int in_expression = 0;
 	int c = '{';
 
-	for (; c != EOF; c = nexttoken("{}(),=", cpp_reserved_word)) {
+	for (; c != EOF; c = nexttoken(tp, "{}(),=", cpp_reserved_word)) {
 		switch (c) {
 		case SHARP_IFDEF:
 		case SHARP_IFNDEF:
@@ -792,25 +803,25 @@ enumerator_list(const struct parser_param *param)
 		case SHARP_ELIF:
 		case SHARP_ELSE:
 		case SHARP_ENDIF:
-			condition_macro(param, c);
+			condition_macro(param, tp, ps, c);
 			break;
 		case SYMBOL:
 			if (in_expression)
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			else
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 			break;
 		case '{':
 		case '(':
-			level++;
+			ps->level++;
 			break;
 		case '}':
 		case ')':
-			if (--level == savelevel)
+			if (--ps->level == savelevel)
 				return c;
 			break;
 		case ',':
-			if (level == savelevel + 1)
+			if (ps->level == savelevel + 1)
 				in_expression = 0;
 			break;
 		case '=':
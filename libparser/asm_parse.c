@@ -55,7 +55,7 @@
 #define YYSKELETON_NAME "yacc.c"
 
 /* Pure parsers.  */
-#define YYPURE 0
+#define YYPURE 2
 
 /* Push parsers.  */
 #define YYPUSH 0
@@ -70,9 +70,6 @@
 #define yyerror         asm_error
 #define yydebug         asm_debug
 #define yynerrs         asm_nerrs
-#define yylval          asm_lval
-#define yychar          asm_char
-#define yylloc          asm_lloc
 
 /* First part of user prologue.  */
 #line 1 "asm_parse.y"
@@ -115,9 +112,15 @@
 #define YYLTYPE		int
 #define YYLLOC_DEFAULT(Current, Rhs, N)	((Current) = (Rhs)[1])
 
+/*
+ * The state of the parse is the extra data of the scanner.
+ */
+#define STATE		asm_get_extra(scanner)
+#define SYMTABLE	(STATE->symtable)
+
 #undef PUT
 #define PUT(type, tag, lno) do {					\
-	const char *line_image = linetable_get(lno, NULL);		\
+	const char *line_image = linetable_get(STATE->lt, lno, NULL);	\
 	char *nl = strchr(line_image, '\n');				\
 	if (nl != NULL)							\
 		*nl = '\0';						\
@@ -126,15 +129,13 @@
 		*nl = '\n';						\
 } while (0)
 
-#define GET_SYM(offset) (assert((offset) < strbuf_getlen(asm_symtable)),\
-			 &strbuf_value(asm_symtable)[offset])
+#define GET_SYM(offset) (assert((offset) < strbuf_getlen(SYMTABLE)),\
+			 &strbuf_value(SYMTABLE)[offset])
 
-STRBUF *asm_symtable;
+static void yyerror(YYLTYPE *, const struct parser_param *, void *, const char *);
 
-static void yyerror(const struct parser_param *, const char *);
 
-
-#line 138 "asm_parse.c"
+#line 139 "asm_parse.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -572,8 +573,8 @@ static const yytype_int8 yytranslate[] =
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    86,    86,    87,    90,    96,   108,   114,   119,   124,
-     129,   134,   139,   144
+       0,    91,    91,    92,    95,   101,   113,   119,   124,   129,
+     134,   139,   144,   149
 };
 #endif
 
@@ -719,7 +720,7 @@ enum { YYENOMEM = -2 };
       }                                                           \
     else                                                          \
       {                                                           \
-        yyerror (param, YY_("syntax error: cannot back up")); \
+        yyerror (&yylloc, param, scanner, YY_("syntax error: cannot back up")); \
         YYERROR;                                                  \
       }                                                           \
   while (0)
@@ -835,7 +836,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Kind, Value, Location, param); \
+                  Kind, Value, Location, param, scanner); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -847,12 +848,13 @@ do {                                                                      \
 
 static void
 yy_symbol_value_print (FILE *yyo,
-                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, const struct parser_param *param)
+                       yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, const struct parser_param *param, void *scanner)
 {
   FILE *yyoutput = yyo;
   YY_USE (yyoutput);
   YY_USE (yylocationp);
   YY_USE (param);
+  YY_USE (scanner);
   if (!yyvaluep)
     return;
   YY_IGNORE_MAYBE_UNINITIALIZED_BEGIN
@@ -867,14 +869,14 @@ yy_symbol_value_print (FILE *yyo,
 
 static void
 yy_symbol_print (FILE *yyo,
-                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, const struct parser_param *param)
+                 yysymbol_kind_t yykind, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, const struct parser_param *param, void *scanner)
 {
   YYFPRINTF (yyo, "%s %s (",
              yykind < YYNTOKENS ? "token" : "nterm", yysymbol_name (yykind));
 
   YYLOCATION_PRINT (yyo, yylocationp);
   YYFPRINTF (yyo, ": ");
-  yy_symbol_value_print (yyo, yykind, yyvaluep, yylocationp, param);
+  yy_symbol_value_print (yyo, yykind, yyvaluep, yylocationp, param, scanner);
   YYFPRINTF (yyo, ")");
 }
 
@@ -908,7 +910,7 @@ do {                                                            \
 
 static void
 yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
-                 int yyrule, const struct parser_param *param)
+                 int yyrule, const struct parser_param *param, void *scanner)
 {
   int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -922,7 +924,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
       yy_symbol_print (stderr,
                        YY_ACCESSING_SYMBOL (+yyssp[yyi + 1 - yynrhs]),
                        &yyvsp[(yyi + 1) - (yynrhs)],
-                       &(yylsp[(yyi + 1) - (yynrhs)]), param);
+                       &(yylsp[(yyi + 1) - (yynrhs)]), param, scanner);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -930,7 +932,7 @@ yy_reduce_print (yy_state_t *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp,
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, param); \
+    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, param, scanner); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -971,11 +973,12 @@ int yydebug;
 
 static void
 yydestruct (const char *yymsg,
-            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, const struct parser_param *param)
+            yysymbol_kind_t yykind, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, const struct parser_param *param, void *scanner)
 {
   YY_USE (yyvaluep);
   YY_USE (yylocationp);
   YY_USE (param);
+  YY_USE (scanner);
   if (!yymsg)
     yymsg = "Deleting";
   YY_SYMBOL_PRINT (yymsg, yykind, yyvaluep, yylocationp);
@@ -986,30 +989,38 @@ yydestruct (const char *yymsg,
 }
 
 
+
+
+
+
+/*----------.
+| yyparse.  |
+`----------*/
+
+int
+yyparse (const struct parser_param *param, void *scanner)
+{
 /* Lookahead token kind.  */
 int yychar;
 
+
 /* The semantic value of the lookahead symbol.  */
-YYSTYPE yylval;
+/* Default value used for initialization, for pacifying older GCCs
+   or non-GCC compilers.  */
+YY_INITIAL_VALUE (static YYSTYPE yyval_default;)
+YYSTYPE yylval YY_INITIAL_VALUE (= yyval_default);
+
 /* Location data for the lookahead symbol.  */
-YYLTYPE yylloc
+static YYLTYPE yyloc_default
 # if defined YYLTYPE_IS_TRIVIAL && YYLTYPE_IS_TRIVIAL
   = { 1, 1, 1, 1 }
 # endif
 ;
-/* Number of syntax errors so far.  */
-int yynerrs;
-
+YYLTYPE yylloc = yyloc_default;
 
+    /* Number of syntax errors so far.  */
+    int yynerrs = 0;
 
-
-/*----------.
-| yyparse.  |
-`----------*/
-
-int
-yyparse (const struct parser_param *param)
-{
     yy_state_fast_t yystate = 0;
     /* Number of tokens to shift before error messages enabled.  */
     int yyerrstatus = 0;
@@ -1177,7 +1188,7 @@ yybackup:
   if (yychar == YYEMPTY)
     {
       YYDPRINTF ((stderr, "Reading a token\n"));
-      yychar = yylex (param);
+      yychar = yylex (&yylval, &yylloc, param, scanner);
     }
 
   if (yychar <= YYEOF)
@@ -1269,17 +1280,17 @@ yyreduce:
   switch (yyn)
     {
   case 4: /* line: ASM_ENTRY '(' ASM_SYMBOL ')' error '\n'  */
-#line 91 "asm_parse.y"
+#line 96 "asm_parse.y"
                 {
 			PUT(PARSER_REF_SYM, GET_SYM(yyvsp[-5]), (yylsp[-5]));
 			PUT(PARSER_DEF, GET_SYM(yyvsp[-3]), (yylsp[-3]));
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1279 "asm_parse.c"
+#line 1290 "asm_parse.c"
     break;
 
   case 5: /* line: ASM_CALL ASM_SYMBOL error '\n'  */
-#line 97 "asm_parse.y"
+#line 102 "asm_parse.y"
                 {
 			const char *sym = GET_SYM(yyvsp[-2]);
 
@@ -1289,83 +1300,83 @@ yyreduce:
 				if (isalpha(c) || c == '_' || c >= 0x80)
 					PUT(PARSER_REF_SYM, &sym[1], (yylsp[-2]));
 			}
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1295 "asm_parse.c"
+#line 1306 "asm_parse.c"
     break;
 
   case 6: /* line: ASM_CALL ASM_EXT '(' ASM_SYMBOL ')' error '\n'  */
-#line 109 "asm_parse.y"
+#line 114 "asm_parse.y"
                 {
 			PUT(PARSER_REF_SYM, GET_SYM(yyvsp[-5]), (yylsp[-5]));
 			PUT(PARSER_REF_SYM, GET_SYM(yyvsp[-3]), (yylsp[-3]));
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1305 "asm_parse.c"
+#line 1316 "asm_parse.c"
     break;
 
   case 7: /* line: "#define" ASM_SYMBOL error '\n'  */
-#line 115 "asm_parse.y"
+#line 120 "asm_parse.y"
                 {
 			PUT(PARSER_DEF, GET_SYM(yyvsp[-2]), (yylsp[-2]));
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1314 "asm_parse.c"
+#line 1325 "asm_parse.c"
     break;
 
   case 8: /* line: "#undef" ASM_SYMBOL error '\n'  */
-#line 120 "asm_parse.y"
+#line 125 "asm_parse.y"
                 {
 			PUT(PARSER_DEF, GET_SYM(yyvsp[-2]), (yylsp[-2]));
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1323 "asm_parse.c"
+#line 1334 "asm_parse.c"
     break;
 
   case 9: /* line: ASM_MACRO ASM_SYMBOL error '\n'  */
-#line 125 "asm_parse.y"
+#line 130 "asm_parse.y"
                 {
 			PUT(PARSER_DEF, GET_SYM(yyvsp[-2]), (yylsp[-2]));
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1332 "asm_parse.c"
+#line 1343 "asm_parse.c"
     break;
 
   case 10: /* line: ASM_LABEL ASM_MACRO error '\n'  */
-#line 130 "asm_parse.y"
+#line 135 "asm_parse.y"
                 {
 			PUT(PARSER_DEF, GET_SYM(yyvsp[-3]), (yylsp[-3]));
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1341 "asm_parse.c"
+#line 1352 "asm_parse.c"
     break;
 
   case 11: /* line: ASM_EQU ASM_SYMBOL ',' error '\n'  */
-#line 135 "asm_parse.y"
+#line 140 "asm_parse.y"
                 {
 			PUT(PARSER_DEF, GET_SYM(yyvsp[-3]), (yylsp[-3]));
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1350 "asm_parse.c"
+#line 1361 "asm_parse.c"
     break;
 
   case 12: /* line: ASM_LABEL ASM_EQU error '\n'  */
-#line 140 "asm_parse.y"
+#line 145 "asm_parse.y"
                 {
 			PUT(PARSER_DEF, GET_SYM(yyvsp[-3]), (yylsp[-3]));
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
-#line 1359 "asm_parse.c"
+#line 1370 "asm_parse.c"
     break;
 
   case 13: /* line: error '\n'  */
-#line 145 "asm_parse.y"
-                { strbuf_reset(asm_symtable); }
-#line 1365 "asm_parse.c"
+#line 150 "asm_parse.y"
+                { strbuf_reset(SYMTABLE); }
+#line 1376 "asm_parse.c"
     break;
 
 
-#line 1369 "asm_parse.c"
+#line 1380 "asm_parse.c"
 
       default: break;
     }
@@ -1413,7 +1424,7 @@ yyerrlab:
   if (!yyerrstatus)
     {
       ++yynerrs;
-      yyerror (param, YY_("syntax error"));
+      yyerror (&yylloc, param, scanner, YY_("syntax error"));
     }
 
   yyerror_range[1] = yylloc;
@@ -1431,7 +1442,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, &yylloc, param);
+                      yytoken, &yylval, &yylloc, param, scanner);
           yychar = YYEMPTY;
         }
     }
@@ -1487,7 +1498,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  YY_ACCESSING_SYMBOL (yystate), yyvsp, yylsp, param);
+                  YY_ACCESSING_SYMBOL (yystate), yyvsp, yylsp, param, scanner);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1528,7 +1539,7 @@ yyabortlab:
 | yyexhaustedlab -- YYNOMEM (memory exhaustion) comes here.  |
 `-----------------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (param, YY_("memory exhausted"));
+  yyerror (&yylloc, param, scanner, YY_("memory exhausted"));
   yyresult = 2;
   goto yyreturnlab;
 
@@ -1543,7 +1554,7 @@ yyreturnlab:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, &yylloc, param);
+                  yytoken, &yylval, &yylloc, param, scanner);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1552,7 +1563,7 @@ yyreturnlab:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, yylsp, param);
+                  YY_ACCESSING_SYMBOL (+*yyssp), yyvsp, yylsp, param, scanner);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1563,26 +1574,31 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 148 "asm_parse.y"
+#line 153 "asm_parse.y"
 
 
 void
 assembly(const struct parser_param *param)
 {
-	if (linetable_open(param->file) == -1)
+	struct asm_state state;
+	void *scanner;
+
+	if ((state.lt = linetable_open(param->file)) == NULL)
 		die("'%s' cannot open.", param->file);
 
-	asm_symtable = strbuf_open(0);
-	asm_initscan();
+	state.symtable = strbuf_open(0);
+	state.last_directive = 0;
+	scanner = asm_initscan(&state);
 
-	asm_parse(param);
+	asm_parse(param, scanner);
 
-	strbuf_close(asm_symtable);
-	linetable_close();
+	asm_termscan(scanner);
+	strbuf_close(state.symtable);
+	linetable_close(state.lt);
 }
 
 static void
-yyerror(const struct parser_param *param, const char *s)
+yyerror(YYLTYPE *llocp, const struct parser_param *param, void *scanner, const char *s)
 {
 
 }
@@ -91,10 +91,9 @@ struct YYLTYPE
 #endif
 
 
-extern YYSTYPE asm_lval;
-extern YYLTYPE asm_lloc;
 
-int asm_parse (const struct parser_param *param);
+
+int asm_parse (const struct parser_param *param, void *scanner);
 
 
 #endif /* !YY_ASM_ASM_PARSE_H_INCLUDED  */
@@ -37,9 +37,15 @@
 #define YYLTYPE		int
 #define YYLLOC_DEFAULT(Current, Rhs, N)	((Current) = (Rhs)[1])
 
+/*
+ * The state of the parse is the extra data of the scanner.
+ */
+#define STATE		asm_get_extra(scanner)
+#define SYMTABLE	(STATE->symtable)
+
 #undef PUT
 #define PUT(type, tag, lno) do {					\
-	const char *line_image = linetable_get(lno, NULL);		\
+	const char *line_image = linetable_get(STATE->lt, lno, NULL);	\
 	char *nl = strchr(line_image, '\n');				\
 	if (nl != NULL)							\
 		*nl = '\0';						\
@@ -48,12 +54,10 @@
 		*nl = '\n';						\
 } while (0)
 
-#define GET_SYM(offset) (assert((offset) < strbuf_getlen(asm_symtable)),\
-			 &strbuf_value(asm_symtable)[offset])
+#define GET_SYM(offset) (assert((offset) < strbuf_getlen(SYMTABLE)),\
+			 &strbuf_value(SYMTABLE)[offset])
 
-STRBUF *asm_symtable;
-
-static void yyerror(const struct parser_param *, const char *);
+static void yyerror(YYLTYPE *, const struct parser_param *, void *, const char *);
 
 %}
 
@@ -78,8 +82,9 @@ static void yyerror(const struct parser_param *, const char *);
  * This code does not work (GNU Bison 3.8.2).
  *	%define api.prefix {asm_}
  */
-%parse-param { const struct parser_param *param }
-%lex-param { const struct parser_param *param }
+%define api.pure full
+%parse-param { const struct parser_param *param } { void *scanner }
+%lex-param { const struct parser_param *param } { void *scanner }
 
 %%
 
@@ -91,7 +96,7 @@ line:	ASM_ENTRY '(' ASM_SYMBOL ')' error '\n'
 		{
 			PUT(PARSER_REF_SYM, GET_SYM($1), @1);
 			PUT(PARSER_DEF, GET_SYM($3), @3);
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| ASM_CALL ASM_SYMBOL error '\n'
 		{
@@ -103,46 +108,46 @@ line:	ASM_ENTRY '(' ASM_SYMBOL ')' error '\n'
 				if (isalpha(c) || c == '_' || c >= 0x80)
 					PUT(PARSER_REF_SYM, &sym[1], @2);
 			}
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| ASM_CALL ASM_EXT '(' ASM_SYMBOL ')' error '\n'
 		{
 			PUT(PARSER_REF_SYM, GET_SYM($2), @2);
 			PUT(PARSER_REF_SYM, GET_SYM($4), @4);
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| "#define" ASM_SYMBOL error '\n'
 		{
 			PUT(PARSER_DEF, GET_SYM($2), @2);
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| "#undef" ASM_SYMBOL error '\n'
 		{
 			PUT(PARSER_DEF, GET_SYM($2), @2);
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| ASM_MACRO ASM_SYMBOL error '\n'
 		{
 			PUT(PARSER_DEF, GET_SYM($2), @2);
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| ASM_LABEL ASM_MACRO error '\n'
 		{
 			PUT(PARSER_DEF, GET_SYM($1), @1);
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| ASM_EQU ASM_SYMBOL ',' error '\n'
 		{
 			PUT(PARSER_DEF, GET_SYM($2), @2);
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| ASM_LABEL ASM_EQU error '\n'
 		{
 			PUT(PARSER_DEF, GET_SYM($1), @1);
-			strbuf_reset(asm_symtable);
+			strbuf_reset(SYMTABLE);
 		}
 	| error '\n'
-		{ strbuf_reset(asm_symtable); }
+		{ strbuf_reset(SYMTABLE); }
 ;
 
 %%
@@ -150,20 +155,25 @@ line:	ASM_ENTRY '(' ASM_SYMBOL ')' error '\n'
 void
 assembly(const struct parser_param *param)
 {
-	if (linetable_open(param->file) == -1)
+	struct asm_state state;
+	void *scanner;
+
+	if ((state.lt = linetable_open(param->file)) == NULL)
 		die("'%s' cannot open.", param->file);
 
-	asm_symtable = strbuf_open(0);
-	asm_initscan();
+	state.symtable = strbuf_open(0);
+	state.last_directive = 0;
+	scanner = asm_initscan(&state);
 
-	asm_parse(param);
+	asm_parse(param, scanner);
 
-	strbuf_close(asm_symtable);
-	linetable_close();
+	asm_termscan(scanner);
+	strbuf_close(state.symtable);
+	linetable_close(state.lt);
 }
 
 static void
-yyerror(const struct parser_param *param, const char *s)
+yyerror(YYLTYPE *llocp, const struct parser_param *param, void *scanner, const char *s)
 {
 
 }
@@ -0,0 +1,472 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * bench-parsers: measure the throughput of the parsers.
+ *
+ * usage: bench-parsers [-kt][-r count][-s kbytes][--langmap=map][--plugin=spec] [path ...]
+ *
+ * Without path, deterministic corpora are generated in a temporary
+ * directory. Otherwise, the files under the paths are used.
+ * Each language is parsed in a child process, so that its peak RSS can be
+ * measured separately.
+ * With -t, the tags are printed instead of measuring.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "getopt.h"
+#include "checkalloc.h"
+#include "die.h"
+#include "gparam.h"
+#include "langmap.h"
+#include "makepath.h"
+#include "parser.h"
+#include "strbuf.h"
+#include "varray.h"
+
+const char *progname = "bench-parsers";
+int qflag;				/**< for get_version() */
+
+/*
+ * Corpus.
+ */
+struct file {
+	char *path;
+	const char *lang;
+	long size;
+};
+static VARRAY *files;
+
+/*
+ * Result of a language.
+ */
+struct result {
+	int files;
+	long long bytes;
+	long long tags;
+	double seconds;
+};
+
+static int repeat = 3;
+static long corpus_size = 2048;		/**< kbytes per generated file */
+
+static void
+usage(void)
+{
+	fputs("usage: bench-parsers [-kt][-r count][-s kbytes][--langmap=map][--plugin=spec] [path ...]\n", stderr);
+	exit(2);
+}
+
+/*
+ * Generators of the synthetic corpora.
+ *
+ * Each generator writes the n-th unit of its file. The units are repeated
+ * until the file reaches corpus_size.
+ */
+static void
+gen_c_macro(FILE *op, int n)
+{
+	int i;
+
+	/* deeply nested macros and condition macros */
+	fprintf(op, "#define M%d_0(x) (x)\n", n);
+	for (i = 1; i < 16; i++)
+		fprintf(op, "#define M%d_%d(x) M%d_%d((x) + %d)\n", n, i, n, i - 1, i);
+	for (i = 0; i < 8; i++)
+		fprintf(op, "%*s#if defined(CONFIG_%d_%d)\n", i, "", n, i);
+	fprintf(op, "int\nfunc_%d(int a, int b)\n{\n\treturn M%d_15(a) * b;\n}\n", n, n);
+	for (i = 7; i >= 0; i--)
+		fprintf(op, "%*s#endif /* CONFIG_%d_%d */\n", i, "", n, i);
+}
+static void
+gen_c_enum(FILE *op, int n)
+{
+	int i;
+
+	/* huge enums */
+	fprintf(op, "enum huge_%d {\n", n);
+	for (i = 0; i < 500; i++)
+		fprintf(op, "\tENUM_%d_%d = %d,\t/* value %d */\n", n, i, i, i);
+	fprintf(op, "};\n");
+}
+static void
+gen_c_longline(FILE *op, int n)
+{
+	int i;
+
+	/* very long lines */
+	fprintf(op, "static int table_%d[] = {", n);
+	for (i = 0; i < 2000; i++)
+		fprintf(op, " value_%d_%d,", n, i);
+	fprintf(op, " 0 };\nvoid\nlong_%d(void)\n{\n\tcall_%d(", n, n);
+	for (i = 0; i < 1000; i++)
+		fprintf(op, "arg_%d, ", i);
+	fprintf(op, "0);\n}\n");
+}
+static void
+gen_c_comment(FILE *op, int n)
+{
+	int i;
+
+	/* mostly comment generated headers */
+	fprintf(op, "/*\n");
+	for (i = 0; i < 40; i++)
+		fprintf(op, " * Register %d.%d: generated description of the field and its \"value\".\n", n, i);
+	fprintf(op, " */\n#define REG_%d_OFFSET 0x%04x\t/* offset of the register */\n", n, n * 4);
+	fprintf(op, "extern int reg_%d_read(void);\t// read the register\n", n);
+}
+static void
+gen_cpp(FILE *op, int n)
+{
+	/* templates and namespaces */
+	fprintf(op, "namespace ns_%d {\n", n);
+	fprintf(op, "template <typename T, int N = %d>\nclass Box_%d : public Base<T> {\npublic:\n", n, n);
+	fprintf(op, "\tBox_%d() {}\n\tT get(const std::vector<std::pair<T, int> > &v) const { return v[N].first; }\n", n);
+	fprintf(op, "\ttemplate <class U> U cast() const { return static_cast<U>(value); }\nprivate:\n\tT value;\n};\n");
+	fprintf(op, "template <typename T>\nT\nsum_%d(T a, T b)\n{\n\treturn a + b;\n}\n", n);
+	fprintf(op, "int\nBox_%d<int>::method_%d(int x)\n{\n\treturn ns_%d::sum_%d<int>(x, x);\n}\n}\n", n, n, n, n);
+}
+static void
+gen_yacc(FILE *op, int n)
+{
+	if (n == 0)
+		fprintf(op, "%%{\n#include <stdio.h>\n%%}\n%%token NUMBER\n%%%%\n");
+	fprintf(op, "rule_%d\t: rule_%d '+' NUMBER\t{ $$ = action_%d($1, $3); }\n\t| NUMBER\n\t;\n", n, n + 1, n);
+}
+static void
+gen_java(FILE *op, int n)
+{
+	fprintf(op, "class Class%d extends Base implements Runnable {\n", n);
+	fprintf(op, "\t@Override\n\tpublic void run() { method%d(new java.util.ArrayList<String>()); }\n", n);
+	fprintf(op, "\tprivate int method%d(java.util.List<String> list) {\n\t\treturn list.size() + field%d;\n\t}\n", n, n);
+	fprintf(op, "\tstatic int field%d = %d;\n}\n", n, n);
+}
+static void
+gen_php(FILE *op, int n)
+{
+	if (n == 0)
+		fprintf(op, "<?php\n");
+	fprintf(op, "class Class%d {\n\tvar $field%d;\n\tfunction method%d($a, $b) {\n", n, n, n);
+	fprintf(op, "\t\t// comment\n\t\t$x = \"string $a\";\n\t\treturn func%d($this->field%d, $b);\n\t}\n}\n", n, n);
+	fprintf(op, "function func%d($a, $b) { return $a + $b; }\n", n);
+}
+static void
+gen_asm(FILE *op, int n)
+{
+	fprintf(op, "ENTRY(asm_func_%d)\n\tmovl\t4(%%esp), %%eax\n\tcall\tsub_%d\n\tret\nEND(asm_func_%d)\n", n, n, n);
+	fprintf(op, "#define ASM_CONST_%d %d\n", n, n);
+}
+static const struct generator {
+	const char *name;
+	void (*gen)(FILE *, int);
+} generators[] = {
+	{"c_macro.c",		gen_c_macro},
+	{"c_enum.h",		gen_c_enum},
+	{"c_longline.c",	gen_c_longline},
+	{"c_comment.h",		gen_c_comment},
+	{"cpp_template.cpp",	gen_cpp},
+	{"yacc_grammar.y",	gen_yacc},
+	{"java_class.java",	gen_java},
+	{"php_class.php",	gen_php},
+	{"asm_entry.S",		gen_asm},
+};
+
+/**
+ * add_file: add a file to the corpus.
+ */
+static void
+add_file(const char *path)
+{
+	struct file *f;
+	struct stat st;
+	const char *lang, *base;
+
+	if (stat(path, &st) < 0 || !S_ISREG(st.st_mode))
+		return;
+	/*
+	 * Like gtags, select only files which have a suffix.
+	 * decide_lang_path() cannot handle a path without it.
+	 */
+	base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	if (strchr(base, '.') == NULL)
+		return;
+	if (get_parser(path) == NULL || (lang = decide_lang_path(path)) == NULL)
+		return;
+	f = varray_append(files);
+	f->path = check_strdup(path);
+	f->lang = check_strdup(lang);
+	f->size = st.st_size;
+}
+/**
+ * add_tree: add the files under the directory to the corpus.
+ */
+static void
+add_tree(const char *dir)
+{
+	DIR *dp;
+	struct dirent *dirp;
+	struct stat st;
+
+	if (stat(dir, &st) < 0)
+		die("'%s' not found.", dir);
+	if (!S_ISDIR(st.st_mode)) {
+		add_file(dir);
+		return;
+	}
+	if ((dp = opendir(dir)) == NULL)
+		die("cannot open directory '%s'.", dir);
+	while ((dirp = readdir(dp)) != NULL) {
+		char path[MAXPATHLEN];
+
+		if (dirp->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, dirp->d_name);
+		if (stat(path, &st) < 0)
+			continue;
+		if (S_ISDIR(st.st_mode))
+			add_tree(path);
+		else
+			add_file(path);
+	}
+	closedir(dp);
+}
+/**
+ * generate: generate the synthetic corpora.
+ *
+ *	@param[in]	dir	directory
+ */
+static void
+generate(const char *dir)
+{
+	int i;
+
+	for (i = 0; i < sizeof(generators) / sizeof(generators[0]); i++) {
+		const char *path = makepath(dir, generators[i].name, NULL);
+		FILE *op = fopen(path, "w");
+		int n;
+
+		if (op == NULL)
+			die("cannot create file '%s'.", path);
+		for (n = 0; ftell(op) < corpus_size * 1024; n++)
+			generators[i].gen(op, n);
+		if (fclose(op) != 0)
+			die("cannot write file '%s'.", path);
+		add_file(path);
+	}
+}
+
+/**
+ * count_tag: PARSER_CALLBACK which only counts tags.
+ */
+static void
+count_tag(int type, const char *tag, int lno, const char *path, const char *line, void *arg)
+{
+	struct result *r = arg;
+
+	r->tags++;
+}
+/**
+ * print_tag: PARSER_CALLBACK which prints a tag.
+ */
+static void
+print_tag(int type, const char *tag, int lno, const char *path, const char *line, void *arg)
+{
+	printf("%c %s %d %s\n", type == PARSER_DEF ? 'D' : 'R', tag, lno, path);
+}
+/**
+ * run: parse the files of a language.
+ *
+ *	@param[in]	lang	language
+ *	@param[out]	r	result
+ */
+static void
+run(const char *lang, struct result *r)
+{
+	struct file *f = varray_assign(files, 0, 0);
+	struct timeval start, end;
+	int i, n;
+
+	memset(r, 0, sizeof(*r));
+	gettimeofday(&start, NULL);
+	for (n = 0; n < repeat; n++) {
+		for (i = 0; i < files->length; i++) {
+			if (strcmp(f[i].lang, lang))
+				continue;
+			parse_file(f[i].path, 0, count_tag, r);
+			if (n == 0) {
+				r->files++;
+				r->bytes += f[i].size;
+			}
+		}
+	}
+	gettimeofday(&end, NULL);
+	r->bytes *= repeat;
+	r->seconds = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+}
+/**
+ * bench: measure a language in a child process and print the result.
+ */
+static void
+bench(const char *lang)
+{
+	struct result r;
+	struct rusage ru;
+	int fd[2], status;
+	pid_t pid;
+
+	if (pipe(fd) < 0)
+		die("cannot make pipe.");
+	fflush(NULL);
+	if ((pid = fork()) < 0)
+		die("cannot fork.");
+	if (pid == 0) {
+		close(fd[0]);
+		run(lang, &r);
+		if (write(fd[1], &r, sizeof(r)) != sizeof(r))
+			_exit(1);
+		_exit(0);
+	}
+	close(fd[1]);
+	if (read(fd[0], &r, sizeof(r)) != sizeof(r))
+		die("%s: the child process failed.", lang);
+	close(fd[0]);
+	if (wait4(pid, &status, 0, &ru) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+		die("%s: the child process terminated abnormally.", lang);
+	if (r.seconds <= 0)
+		r.seconds = 0.000001;
+	printf("%-10s %6d %12lld %10lld %9.3f %9.2f %12.0f %10ld\n",
+		lang, r.files, r.bytes, r.tags, r.seconds,
+		r.bytes / r.seconds / (1024 * 1024), r.tags / r.seconds, ru.ru_maxrss);
+}
+
+static struct option const long_options[] = {
+	{"keep", no_argument, NULL, 'k'},
+	{"langmap", required_argument, NULL, 'l'},
+	{"plugin", required_argument, NULL, 'p'},
+	{"repeat", required_argument, NULL, 'r'},
+	{"size", required_argument, NULL, 's'},
+	{"tags", no_argument, NULL, 't'},
+	{ 0 }
+};
+
+int
+main(int argc, char **argv)
+{
+	const char *langmap = NULL;
+	const char *plugin = NULL;
+	char tmpdir[MAXPATHLEN];
+	int keep = 0;
+	int tags = 0;
+	int optchar, i, j;
+	struct file *f;
+
+	while ((optchar = getopt_long(argc, argv, "kr:s:t", long_options, NULL)) != EOF) {
+		switch (optchar) {
+		case 'k':
+			keep = 1;
+			break;
+		case 'l':
+			langmap = optarg;
+			break;
+		case 'p':
+			plugin = optarg;
+			break;
+		case 'r':
+			if ((repeat = atoi(optarg)) <= 0)
+				usage();
+			break;
+		case 's':
+			if ((corpus_size = atol(optarg)) <= 0)
+				usage();
+			break;
+		case 't':
+			tags = 1;
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	parser_init(langmap, plugin);
+	files = varray_open(sizeof(struct file), 100);
+	tmpdir[0] = '\0';
+	if (argc == 0) {
+		const char *base = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+
+		snprintf(tmpdir, sizeof(tmpdir), "%s/bench-parsers.XXXXXX", base);
+		if (mkdtemp(tmpdir) == NULL)
+			die("cannot make temporary directory.");
+		generate(tmpdir);
+		fprintf(stderr, "generated corpora in %s (%ld KB per file)\n", tmpdir, corpus_size);
+	} else {
+		for (i = 0; i < argc; i++)
+			add_tree(argv[i]);
+	}
+	if (files->length == 0)
+		die("no source file found.");
+	f = varray_assign(files, 0, 0);
+	if (tags) {
+		for (i = 0; i < files->length; i++)
+			parse_file(f[i].path, 0, print_tag, NULL);
+	} else {
+		printf("%-10s %6s %12s %10s %9s %9s %12s %10s\n",
+			"language", "files", "bytes", "tags", "seconds", "MB/s", "tags/s", "maxrss(KB)");
+		/*
+		 * Measure each language in the order of appearance.
+		 */
+		for (i = 0; i < files->length; i++) {
+			for (j = 0; j < i; j++)
+				if (!strcmp(f[i].lang, f[j].lang))
+					break;
+			if (j == i)
+				bench(f[i].lang);
+		}
+	}
+	if (tmpdir[0] && !keep) {
+		for (i = 0; i < files->length; i++)
+			unlink(f[i].path);
+		rmdir(tmpdir);
+	}
+	parser_exit();
+	return 0;
+}
@@ -0,0 +1,19 @@
+#!/bin/sh
+#
+# Copyright (c) 2026 Tama Communications Corporation
+#
+# This file is free software; as a special exception the author gives
+# unlimited permission to copy and/or distribute it, with or without
+# modifications, as long as this notice is preserved.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY, to the extent permitted by law; without even the
+# implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# check-bench.sh: run bench-parsers over the source tree of GLOBAL.
+# The tree includes files without suffix, which must be skipped.
+#
+srcdir=${srcdir:-.}
+top=`cd "$srcdir/.." && pwd` || exit 1
+./bench-parsers -r 1 "$top" >/dev/null || exit 1
+exit 0
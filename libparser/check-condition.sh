@@ -0,0 +1,30 @@
+#!/bin/sh
+#
+# Copyright (c) 2026 Tama Communications Corporation
+#
+# This file is free software; as a special exception the author gives
+# unlimited permission to copy and/or distribute it, with or without
+# modifications, as long as this notice is preserved.
+#
+# This program is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY, to the extent permitted by law; without even the
+# implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+#
+# check-condition.sh: a stray '#else' at the top level must not disturb
+# the C and C++ parsers. Each file should yield the definition of barN.
+#
+dir=`mktemp -d "${TMPDIR:-/tmp}/check-condition.XXXXXX"` || exit 1
+trap 'rm -rf "$dir"' 0
+n=0
+while [ $n -lt 30 ]; do
+	for suffix in c cpp; do
+		printf 'int a%d;\n#else\nint bar%d(void){return 0;}\n' $n $n >"$dir/$suffix$n.$suffix"
+	done
+	n=`expr $n + 1`
+done
+count=`./bench-parsers -t "$dir" | grep -c '^D bar[0-9]* '`
+if [ "$count" != 60 ]; then
+	echo "check-condition.sh: $count definitions found, expected 60." >&2
+	exit 1
+fi
+exit 0
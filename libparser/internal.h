@@ -22,23 +22,49 @@
 #define _INTERNAL_H_
 
 #include "parser.h"
+#include "linetable.h"
 #include "strbuf.h"
 #include "token.h"
 
+/*
+ * If the line image is the current line of the tokenizer which reads
+ * the source in the batch, the batch refers to it instead of copying it.
+ */
 #define PUT(type, tag, lno, line) do {					\
-	DBG_PRINT(level, line);						\
-	param->put(type, tag, lno, curfile, line, param->arg);		\
+	DBG_PRINT(DBG_LEVEL, line);					\
+	if (param->batch && param->batch->source			\
+	 && tp->buf == param->batch->source && (line) == tp->sp)	\
+		parser_batch_put_line(param->batch, type, tag, lno,	\
+				tp->lineoff, tp->linelen);		\
+	else if (param->batch)						\
+		parser_batch_put(param->batch, type, tag, lno, line);	\
+	else								\
+		param->put(type, tag, lno, param->file, line, param->arg);\
 } while (0)
 
+/*
+ * The brace level which PUT() prints in debug mode.
+ * A parser which keeps it in its parse state redefines this.
+ */
+#define DBG_LEVEL level
 #ifdef DEBUG
 #define DBG_PRINT(level, a) do {					\
 	if (param->flags & PARSER_DEBUG)				\
-		dbg_print(level, a);					\
+		dbg_print(tp->lineno, level, a);			\
 } while (0)
 #else
 #define DBG_PRINT(level, a) do {} while (0)
 #endif
 
+/*
+ * Open the tokenizer. It reads the source in the batch if any.
+ */
+#define OPENTOKEN(param) (((param)->batch && (param)->batch->source) ?	\
+	opentoken_buffer((param)->file, (param)->batch->source, (param)->batch->sourcesize) : \
+	opentoken((param)->file))
+
+void parser_batch_put_line(struct parser_batch *, int, const char *, int, size_t, int);
+
 /* parser procedures */
 void C(const struct parser_param *);
 void yacc(const struct parser_param *);
@@ -47,10 +73,20 @@ void java(const struct parser_param *);
 void php(const struct parser_param *);
 void assembly(const struct parser_param *);
 
-void dbg_print(int, const char *);
+void dbg_print(int, int, const char *);
 
-extern STRBUF *asm_symtable;
-void asm_initscan(void);
-int asm_lex(const struct parser_param *);
+/*
+ * The state of a parse of assembly source. The scanner (asm_scan.l)
+ * keeps it as its extra data and the parser (asm_parse.y) refers to it.
+ */
+struct asm_state {
+	LINETABLE *lt;			/* line table of the source */
+	STRBUF *symtable;		/* symbols of the current line */
+	int last_directive;		/* the last '#' directive */
+};
+void *asm_initscan(struct asm_state *);
+void asm_termscan(void *);
+struct asm_state *asm_get_extra(void *);
+int asm_lex(int *, int *, const struct parser_param *, void *);
 
 #endif
@@ -43,6 +43,7 @@ void
 java(const struct parser_param *param)
 {
 	int c;
+	TOKEN *tp;
 	int level;					/* brace level */
 	int startclass, startthrows, startequal;
 	char classname[MAXTOKEN];
@@ -62,27 +63,27 @@ java(const struct parser_param *param)
 	level = classlevel = 0;
 	startclass = startthrows = startequal = 0;
 
-	if (!opentoken(param->file))
+	if ((tp = OPENTOKEN(param)) == NULL)
 		die("'%s' cannot open.", param->file);
-	while ((c = nexttoken(interested, java_reserved_word)) != EOF) {
+	while ((c = nexttoken(tp, interested, java_reserved_word)) != EOF) {
 		switch (c) {
 		case SYMBOL:					/* symbol */
-			for (; c == SYMBOL && peekc(1) == '.'; c = nexttoken(interested, java_reserved_word)) {
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+			for (; c == SYMBOL && peekc(tp, 1) == '.'; c = nexttoken(tp, interested, java_reserved_word)) {
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			}
 			if (c != SYMBOL)
 				break;
 			if (startclass || startthrows) {
-				PUT(PARSER_REF_SYM, token, lineno, sp);
-			} else if (peekc(0) == '('/* ) */) {
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
+			} else if (peekc(tp, 0) == '('/* ) */) {
 				if (level == stack[classlevel].level && !startequal)
 					/* ignore constructor */
-					if (strcmp(stack[classlevel].classname, token))
-						PUT(PARSER_DEF, token, lineno, sp);
+					if (strcmp(stack[classlevel].classname, tp->token))
+						PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 				if (level > stack[classlevel].level || startequal)
-					PUT(PARSER_REF_SYM, token, lineno, sp);
+					PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			} else {
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			}
 			break;
 		case '{': /* } */
@@ -94,7 +95,7 @@ java(const struct parser_param *param)
 				char *q = classname;
 
 				if (++classlevel >= MAXCLASSSTACK)
-					die("class stack over flow.[%s]", curfile);
+					die("class stack over flow.[%s]", tp->curfile);
 				if (classlevel > 1)
 					*p++ = '.';
 				stack[classlevel].classname = p;
@@ -110,7 +111,7 @@ java(const struct parser_param *param)
 		case '}':
 			if (--level < 0) {
 				if (param->flags & PARSER_WARNING)
-					warning("missing left '{' (at %d).", lineno); /* } */
+					warning("missing left '{' (at %d).", tp->lineno); /* } */
 				level = 0;
 			}
 			if (level < stack[classlevel].level)
@@ -127,18 +128,18 @@ java(const struct parser_param *param)
 		case JAVA_CLASS:
 		case JAVA_INTERFACE:
 		case JAVA_ENUM:
-			if ((c = nexttoken(interested, java_reserved_word)) == SYMBOL) {
-				strlimcpy(classname, token, sizeof(classname));
+			if ((c = nexttoken(tp, interested, java_reserved_word)) == SYMBOL) {
+				strlimcpy(classname, tp->token, sizeof(classname));
 				startclass = 1;
-				PUT(PARSER_DEF, token, lineno, sp);
+				PUT(PARSER_DEF, tp->token, tp->lineno, tp->sp);
 			}
 			break;
 		case JAVA_NEW:
 		case JAVA_INSTANCEOF:
-			while ((c = nexttoken(interested, java_reserved_word)) == SYMBOL && peekc(1) == '.')
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+			while ((c = nexttoken(tp, interested, java_reserved_word)) == SYMBOL && peekc(tp, 1) == '.')
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			if (c == SYMBOL)
-				PUT(PARSER_REF_SYM, token, lineno, sp);
+				PUT(PARSER_REF_SYM, tp->token, tp->lineno, tp->sp);
 			break;
 		case JAVA_THROWS:
 			startthrows = 1;
@@ -152,18 +153,18 @@ java(const struct parser_param *param)
 		case JAVA_LONG:
 		case JAVA_SHORT:
 		case JAVA_VOID:
-			if (peekc(1) == '.' && (c = nexttoken(interested, java_reserved_word)) != JAVA_CLASS)
-				pushbacktoken();
+			if (peekc(tp, 1) == '.' && (c = nexttoken(tp, interested, java_reserved_word)) != JAVA_CLASS)
+				pushbacktoken(tp);
 			break;
                 case '@':
 			/* skip through annotations */
-			if (nexttoken(interested, java_reserved_word) == SYMBOL) {
-				if (peekc(0) == '(') {
+			if (nexttoken(tp, interested, java_reserved_word) == SYMBOL) {
+				if (peekc(tp, 0) == '(') {
 					int paren_count = 0;
 					int in_annot = 1;
 
 					while (in_annot) {
-						c = nexttoken("()", java_reserved_word);
+						c = nexttoken(tp, "()", java_reserved_word);
 						if (c == '(') {
 							++paren_count;
 						} else if (c == ')') {
@@ -178,5 +179,5 @@ java(const struct parser_param *param)
 			break;
 		}
 	}
-	closetoken();
+	closetoken(tp);
 }
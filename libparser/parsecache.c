@@ -0,0 +1,454 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+
+#include "checkalloc.h"
+#include "die.h"
+#include "parsecache.h"
+#include "strbuf.h"
+#include "test.h"
+#include "varray.h"
+
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#define mkdir(path,mode) mkdir(path)
+#endif
+
+/*
+ * Parse cache.
+ *
+ * The tags extracted from a file are saved in a cache directory, keyed by
+ * a hash of the file contents and the identity of the parser (language,
+ * parser, plug-in parser, langmap and configuration). A file which has
+ * the same contents as a file parsed before, e.g. in another worktree of
+ * the same repository, is not parsed again.
+ *
+ *	<cache directory>/<first 2 digits of key>/<rest of key>
+ *
+ * Entry:
+ *	"GPC1" <key (32 bytes)> <count> <poolsize>
+ *	<type>... <lineno>... <tag>... <taglen>... <image>... <pool>
+ *
+ * Each entry is written to a temporary file and renamed, so concurrent
+ * gtags processes never read a half-written entry. The modification time
+ * of an entry is updated when it is used, and the least recently used
+ * entries are removed when the cache grows over the size limit.
+ */
+#define MAGIC		"GPC1"
+#define MAGICLEN	4
+#define KEYLEN		32
+#define HEADERSIZE	(MAGICLEN + KEYLEN + sizeof(int) * 2)
+
+static char *cachedir;				/**< NULL: cache is not used */
+static unsigned long long limit;		/**< size limit in bytes */
+static int stored;				/**< entries stored in this run */
+static char *buf;				/**< buffer for loading files */
+static size_t bufsize;
+
+/**
+ * parsecache_open: start using the parse cache.
+ *
+ *	@param[in]	dir	cache directory; it is made if it does not exist
+ *	@param[in]	size	size limit in megabytes
+ */
+void
+parsecache_open(const char *dir, int size)
+{
+	if (!test("d", dir) && mkdir(dir, 0775) < 0) {
+		warning("cannot make parse cache directory '%s'. (ignored)", dir);
+		return;
+	}
+	if (!test("drw", dir)) {
+		warning("parse cache directory '%s' is not writable. (ignored)", dir);
+		return;
+	}
+	cachedir = check_strdup(dir);
+	limit = (unsigned long long)size * 1024 * 1024;
+	stored = 0;
+}
+/**
+ * parsecache_active: is the parse cache used?
+ */
+int
+parsecache_active(void)
+{
+	return cachedir != NULL;
+}
+/**
+ * load: load a file into buf.
+ *
+ *	@param[in]	path	file
+ *	@param[out]	size	size of the file
+ *	@return		0: success, -1: failure
+ */
+static int
+load(const char *path, size_t *size)
+{
+	FILE *ip = fopen(path, "rb");
+	struct stat st;
+
+	if (ip == NULL)
+		return -1;
+	if (fstat(fileno(ip), &st) < 0) {
+		fclose(ip);
+		return -1;
+	}
+	if ((size_t)st.st_size + 1 > bufsize) {
+		bufsize = st.st_size + 1;
+		buf = check_realloc(buf, bufsize);
+	}
+	*size = fread(buf, 1, st.st_size, ip);
+	fclose(ip);
+	return *size == (size_t)st.st_size ? 0 : -1;
+}
+#define ROTL64(x, r)	(((x) << (r)) | ((x) >> (64 - (r))))
+#define C1		0x87c37b91114253d5ULL
+#define C2		0x4cf5ad432745937fULL
+/**
+ * hash_bytes: update the 128 bits hash value with the data.
+ */
+static void
+hash_bytes(unsigned long long h[2], const char *data, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)data;
+	unsigned long long k;
+	size_t i, j;
+
+	for (i = 0; i + 8 <= len; i += 8) {
+		for (k = 0, j = 0; j < 8; j++)
+			k |= (unsigned long long)p[i + j] << (j * 8);
+		h[0] ^= ROTL64(k * C1, 31) * C2;
+		h[0] = ROTL64(h[0], 27) + h[1];
+		h[1] ^= ROTL64(k * C2, 33) * C1;
+		h[1] = ROTL64(h[1], 31) + h[0];
+	}
+	for (k = 0, j = 0; i + j < len; j++)
+		k |= (unsigned long long)p[i + j] << (j * 8);
+	h[0] ^= ROTL64((k ^ len) * C1, 31) * C2;
+	h[1] ^= ROTL64((k + len) * C2, 33) * C1;
+	h[0] += h[1];
+	h[1] += h[0];
+}
+/**
+ * fmix: finalize a hash value.
+ */
+static unsigned long long
+fmix(unsigned long long k)
+{
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdULL;
+	k ^= k >> 33;
+	k *= 0xc4ceb9fe1a85ec53ULL;
+	k ^= k >> 33;
+	return k;
+}
+/**
+ * parsecache_key: make the key of a file.
+ *
+ *	@param[in]	path	source file
+ *	@param[in]	identity	identity of the parser
+ *	@param[out]	key	key
+ *	@return		0: success, -1: cannot read the file
+ */
+int
+parsecache_key(const char *path, const char *identity, PARSECACHE_KEY *key)
+{
+	static const char hex[] = "0123456789abcdef";
+	unsigned long long h[2] = {0x9e3779b97f4a7c15ULL, 0x6a09e667f3bcc909ULL};
+	size_t size;
+	int i, j;
+
+	hash_bytes(h, identity, strlen(identity) + 1);
+	if (load(path, &size) < 0)
+		return -1;
+	hash_bytes(h, buf, size);
+	h[0] = fmix(h[0]);
+	h[1] = fmix(h[1]);
+	for (i = 0; i < 2; i++)
+		for (j = 0; j < 16; j++)
+			key->name[i * 16 + j] = hex[(h[i] >> (60 - j * 4)) & 0xf];
+	key->name[KEYLEN] = '\0';
+	return 0;
+}
+/**
+ * entry_path: path of the cache entry
+ *
+ *	@param[in]	sb	buffer
+ *	@param[in]	key	key
+ *	@param[in]	dironly	1: path of the directory
+ */
+static const char *
+entry_path(STRBUF *sb, const PARSECACHE_KEY *key, int dironly)
+{
+	strbuf_reset(sb);
+	strbuf_puts(sb, cachedir);
+	strbuf_putc(sb, '/');
+	strbuf_nputs(sb, key->name, 2);
+	if (!dironly) {
+		strbuf_putc(sb, '/');
+		strbuf_puts(sb, key->name + 2);
+	}
+	return strbuf_value(sb);
+}
+/**
+ * parsecache_exists: whether the parse cache has an entry.
+ *
+ *	@param[in]	key	key
+ *	@return		1: exists, 0: not exists
+ */
+int
+parsecache_exists(const PARSECACHE_KEY *key)
+{
+	STATIC_STRBUF(sb);
+
+	return test("f", entry_path(sb, key, 0)) ? 1 : 0;
+}
+/**
+ * parsecache_get: get tags from the parse cache.
+ *
+ *	@param[in]	key	key
+ *	@param[out]	batch	tags
+ *	@return		1: found, 0: not found
+ *
+ * A broken entry is removed.
+ */
+int
+parsecache_get(const PARSECACHE_KEY *key, struct parser_batch *batch)
+{
+	STATIC_STRBUF(sb);
+	const char *path = entry_path(sb, key, 0);
+	const int *type, *lineno, *tag, *taglen, *image;
+	const char *pool;
+	size_t size;
+	int count, poolsize, i;
+
+	if (load(path, &size) < 0)
+		return 0;
+	if (size < HEADERSIZE || memcmp(buf, MAGIC, MAGICLEN)
+	 || memcmp(buf + MAGICLEN, key->name, KEYLEN))
+		goto broken;
+	memcpy(&count, buf + MAGICLEN + KEYLEN, sizeof(int));
+	memcpy(&poolsize, buf + MAGICLEN + KEYLEN + sizeof(int), sizeof(int));
+	if (count < 0 || poolsize < 0
+	 || size != HEADERSIZE + sizeof(int) * 5 * count + poolsize
+	 || (poolsize > 0 && buf[size - 1] != '\0'))
+		goto broken;
+	type = (const int *)(buf + HEADERSIZE);
+	lineno = type + count;
+	tag = lineno + count;
+	taglen = tag + count;
+	image = taglen + count;
+	pool = (const char *)(image + count);
+	for (i = 0; i < count; i++)
+		if (tag[i] < 0 || taglen[i] < 0 || tag[i] + taglen[i] >= poolsize
+		 || pool[tag[i] + taglen[i]] != '\0'
+		 || image[i] < 0 || image[i] >= poolsize)
+			goto broken;
+	parser_batch_reset(batch);
+	for (i = 0; i < count; i++)
+		parser_batch_put(batch, type[i], pool + tag[i], lineno[i], pool + image[i]);
+	/* It is recently used. */
+	utime(path, NULL);
+	return 1;
+broken:
+	unlink(path);
+	return 0;
+}
+/**
+ * parsecache_put: save tags into the parse cache.
+ *
+ *	@param[in]	key	key
+ *	@param[in]	batch	tags
+ */
+void
+parsecache_put(const PARSECACHE_KEY *key, const struct parser_batch *batch)
+{
+	STATIC_STRBUF(sb);
+	STATIC_STRBUF(tmp);
+	STATIC_STRBUF(extra);
+	const char *dir = entry_path(sb, key, 1);
+	const int *image = batch->image;
+	FILE *op;
+	int ok, i, poolsize;
+
+	if (!test("d", dir) && mkdir(dir, 0775) < 0 && !test("d", dir))
+		return;
+	strbuf_clear(tmp);
+	strbuf_sprintf(tmp, "%s/.tmp%d.%s", dir, (int)getpid(), key->name + 2);
+	if ((op = fopen(strbuf_value(tmp), "wb")) == NULL)
+		return;
+	/*
+	 * Line images in the source file are appended to the pool.
+	 */
+	strbuf_clear(extra);
+	for (i = 0; i < batch->count; i++)
+		if (batch->image[i] < 0)
+			break;
+	if (i < batch->count) {
+		static VARRAY *vb;
+		int *newimage;
+
+		if (vb == NULL)
+			vb = varray_open(sizeof(int), 1024);
+		varray_assign(vb, batch->count - 1, 1);	/* expand */
+		newimage = varray_assign(vb, 0, 0);
+		for (i = 0; i < batch->count; i++) {
+			if (batch->image[i] >= 0)
+				newimage[i] = batch->image[i];
+			else if (i > 0 && batch->image[i] == batch->image[i - 1])
+				newimage[i] = newimage[i - 1];
+			else {
+				newimage[i] = batch->poolsize + strbuf_getlen(extra);
+				strbuf_nputs(extra, PARSER_BATCH_IMAGE(batch, i), batch->imagelen[i]);
+				strbuf_putc(extra, '\0');
+			}
+		}
+		image = newimage;
+	}
+	poolsize = batch->poolsize + strbuf_getlen(extra);
+	fwrite(MAGIC, 1, MAGICLEN, op);
+	fwrite(key->name, 1, KEYLEN, op);
+	fwrite(&batch->count, sizeof(int), 1, op);
+	fwrite(&poolsize, sizeof(int), 1, op);
+	fwrite(batch->type, sizeof(int), batch->count, op);
+	fwrite(batch->lineno, sizeof(int), batch->count, op);
+	fwrite(batch->tag, sizeof(int), batch->count, op);
+	fwrite(batch->taglen, sizeof(int), batch->count, op);
+	fwrite(image, sizeof(int), batch->count, op);
+	fwrite(batch->pool, 1, batch->poolsize, op);
+	fwrite(strbuf_value(extra), 1, strbuf_getlen(extra), op);
+	ok = !ferror(op);
+	if (fclose(op) != 0)
+		ok = 0;
+	if (!ok || rename(strbuf_value(tmp), entry_path(sb, key, 0)) < 0)
+		unlink(strbuf_value(tmp));
+	else
+		stored++;
+}
+struct cache_entry {
+	time_t mtime;
+	unsigned long long size;
+	int name;			/**< offset of the path in names */
+};
+static int
+cmp_entry(const void *s1, const void *s2)
+{
+	const struct cache_entry *e1 = s1, *e2 = s2;
+
+	return e1->mtime < e2->mtime ? -1 : e1->mtime > e2->mtime ? 1 : 0;
+}
+/**
+ * evict: remove the least recently used entries.
+ *
+ * If the total size exceeds the limit, entries are removed until it gets
+ * lower than 90% of the limit, so that we don't have to do it every time.
+ */
+static void
+evict(void)
+{
+	VARRAY *vb = varray_open(sizeof(struct cache_entry), 1024);
+	STRBUF *names = strbuf_open(0);
+	STRBUF *sb = strbuf_open(0);
+	struct cache_entry *ent;
+	unsigned long long total = 0;
+	struct dirent *dp, *sp;
+	struct stat st;
+	DIR *dirp, *subp;
+	int i, len;
+
+	if ((dirp = opendir(cachedir)) == NULL)
+		goto out;
+	while ((dp = readdir(dirp)) != NULL) {
+		if (strlen(dp->d_name) != 2 || !strcmp(dp->d_name, ".."))
+			continue;
+		strbuf_reset(sb);
+		strbuf_puts(sb, cachedir);
+		strbuf_putc(sb, '/');
+		strbuf_puts(sb, dp->d_name);
+		if ((subp = opendir(strbuf_value(sb))) == NULL)
+			continue;
+		len = strbuf_getlen(sb);
+		while ((sp = readdir(subp)) != NULL) {
+			if (!strcmp(sp->d_name, ".") || !strcmp(sp->d_name, ".."))
+				continue;
+			strbuf_setlen(sb, len);
+			strbuf_putc(sb, '/');
+			strbuf_puts(sb, sp->d_name);
+			if (stat(strbuf_value(sb), &st) < 0 || !S_ISREG(st.st_mode))
+				continue;
+			ent = varray_append(vb);
+			ent->mtime = st.st_mtime;
+			ent->size = st.st_size;
+			ent->name = strbuf_getlen(names);
+			strbuf_puts0(names, strbuf_value(sb));
+			total += st.st_size;
+		}
+		closedir(subp);
+	}
+	closedir(dirp);
+	if (total <= limit)
+		goto out;
+	qsort(vb->vbuf, vb->length, sizeof(struct cache_entry), cmp_entry);
+	ent = (struct cache_entry *)vb->vbuf;
+	for (i = 0; i < vb->length && total > limit / 10 * 9; i++) {
+		if (unlink(strbuf_value(names) + ent[i].name) == 0)
+			total -= ent[i].size;
+	}
+out:
+	strbuf_close(sb);
+	strbuf_close(names);
+	varray_close(vb);
+}
+/**
+ * parsecache_close: stop using the parse cache.
+ */
+void
+parsecache_close(void)
+{
+	if (cachedir == NULL)
+		return;
+	if (stored > 0)
+		evict();
+	free(cachedir);
+	cachedir = NULL;
+	free(buf);
+	buf = NULL;
+	bufsize = 0;
+}
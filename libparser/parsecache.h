@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _PARSECACHE_H_
+#define _PARSECACHE_H_
+
+#include "parser.h"
+
+/*
+ * Key of a parse cache entry.
+ * It is a hash of the file contents and the parser identity.
+ */
+typedef struct {
+	char name[33];		/**< hexadecimal string of the hash */
+} PARSECACHE_KEY;
+
+void parsecache_open(const char *, int);
+int parsecache_active(void);
+int parsecache_key(const char *, const char *, PARSECACHE_KEY *);
+int parsecache_exists(const PARSECACHE_KEY *);
+int parsecache_get(const PARSECACHE_KEY *, struct parser_batch *);
+void parsecache_put(const PARSECACHE_KEY *, const struct parser_batch *);
+void parsecache_close(void);
+
+#endif /* ! _PARSECACHE_H_ */
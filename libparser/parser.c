@@ -22,6 +22,9 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
+#ifdef HAVE_LIMITS_H
+#include <limits.h>
+#endif
 #include <stdio.h>
 #ifdef STDC_HEADERS
 #include <stdlib.h>
@@ -31,6 +34,8 @@
 #else
 #include <strings.h>
 #endif
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <ltdl.h>
 #if defined(_WIN32) && !defined(__CYGWIN__)
 #define WIN32_LEAN_AND_MEAN
@@ -46,17 +51,28 @@
 #include "gtagsop.h"
 #include "langmap.h"
 #include "locatestring.h"
+#include "parsecache.h"
 #include "path.h"
 #include "queue.h"
 #include "strbuf.h"
 #include "strmake.h"
 #include "test.h"
+#include "usable.h"
+#include "version.h"
 
 #define NOTFUNCTION	".notfunction"
 #ifdef __DJGPP__
 #define DOS_NOTFUNCTION	"_notfunction"
 #endif
 
+#define BATCH_EXPAND	1024
+#define MAXAHEAD	64		/**< max number of files told in advance */
+
+static void run_parser(const struct lang_entry *, const char *, int, PARSER_CALLBACK, void *, struct parser_batch *, const char *const *, int);
+static void put_into_batch(int, const char *, int, const char *, const char *, void *);
+static const char *get_identity(const struct lang_entry *, int);
+static void ahead_clear(void);
+
 struct words {
 	const char *name;
 };
@@ -127,6 +143,7 @@ struct lang_entry {
 	PARSER parser;					/**< parser procedure */
 	const char *parser_name;
 	const char *lt_dl_name;
+	PARSER_TOOLS tools;				/**< external commands */
 };
 
 struct plugin_entry {
@@ -137,7 +154,7 @@ struct plugin_entry {
 
 static STAILQ_HEAD(plugin_list, plugin_entry)
 	plugin_list = STAILQ_HEAD_INITIALIZER(plugin_list);
-static char *langmap_saved, *pluginspec_saved;
+static char *langmap_saved, *pluginspec_saved, *pluginspec_value;
 
 /**
  * load_plugin_parser: Load plug-in parsers.
@@ -155,6 +172,7 @@ load_plugin_parser(const char *pluginspec)
 	char *p, *q;
 	const char *lt_dl_name, *parser_name;
 	struct plugin_entry *pent;
+	STRBUF *sb = strbuf_open(0);
 
 	pluginspec_saved = check_strdup(pluginspec);
 	if (lt_dlinit() != 0)
@@ -220,6 +238,9 @@ load_plugin_parser(const char *pluginspec)
 			die_with_code(2, "cannot open shared object '%s'.", lt_dl_name);
 		pent->entry.lt_dl_name = lt_dl_name;
 		pent->entry.parser = (PVOID)GetProcAddress((HINSTANCE)pent->handle, parser_name);
+		strbuf_reset(sb);
+		strbuf_sprintf(sb, "%s_tools", parser_name);
+		pent->entry.tools = (PVOID)GetProcAddress((HINSTANCE)pent->handle, strbuf_value(sb));
 #else
 		pent->handle = lt_dlopen(lt_dl_name);
 		if (pent->handle == NULL) {
@@ -236,6 +257,9 @@ load_plugin_parser(const char *pluginspec)
 		}
 		pent->entry.lt_dl_name = lt_dl_name;
 		pent->entry.parser = lt_dlsym(pent->handle, parser_name);
+		strbuf_reset(sb);
+		strbuf_sprintf(sb, "%s_tools", parser_name);
+		pent->entry.tools = lt_dlsym(pent->handle, strbuf_value(sb));
 #endif
 		if (pent->entry.parser == NULL)
 			die_with_code(2, "cannot find symbol '%s' in '%s'.", parser_name, lt_dl_name);
@@ -244,6 +268,7 @@ load_plugin_parser(const char *pluginspec)
 		if (p == NULL)
 			break;
 	}
+	strbuf_close(sb);
 }
 
 /**
@@ -353,6 +378,7 @@ parser_init(const char *langmap, const char *pluginspec)
 	langmap = trim_langmap(langmap);
 	setup_langmap(langmap);
 	langmap_saved = check_strdup(langmap);
+	pluginspec_value = check_strdup(pluginspec ? pluginspec : "");
 
 	/* load shared objects. */
 	if (pluginspec != NULL)
@@ -376,8 +402,11 @@ parser_init(const char *langmap, const char *pluginspec)
 void
 parser_exit(void)
 {
+	ahead_clear();
+	parsecache_close();
 	unload_plugin_parser();
 	free(langmap_saved);
+	free(pluginspec_value);
 }
 
 /**
@@ -439,24 +468,480 @@ get_parser(const char *path)
  */
 void
 execute_parser(const struct lang_entry *ent, const char *path, int flags, PARSER_CALLBACK put, void *arg)
+{
+	run_parser(ent, path, flags, put, arg, NULL, NULL, 0);
+}
+/**
+ * init_param: set up the argument of a parser.
+ */
+static void
+init_param(struct parser_param *param, const char *path, int flags, PARSER_CALLBACK put, void *arg, struct parser_batch *batch)
+{
+	param->size = sizeof(*param);
+	param->flags = flags;
+	param->file = path;
+	param->put = put;
+	param->arg = arg;
+	param->isnotfunction = isnotfunction;
+	param->langmap = langmap_saved;
+	param->getconf = getconf;
+	param->die = die;
+	param->warning = warning;
+	param->message = message;
+	param->batch = batch;
+	param->put_batch = parser_batch_put;
+	param->ahead = NULL;
+	param->nahead = 0;
+}
+/**
+ * run_parser: call language specific parser.
+ *
+ *	@param[in]	batch	batch of tags; NULL: tags are passed to put
+ *	@param[in]	ahead	files which will be given to the parser later
+ *	@param[in]	nahead	number of the files
+ */
+static void
+run_parser(const struct lang_entry *ent, const char *path, int flags, PARSER_CALLBACK put, void *arg, struct parser_batch *batch, const char *const *ahead, int nahead)
 {
 	struct parser_param param;
-	/*
-	 * call language specific parser.
-	 */
-	param.size = sizeof(param);
-	param.flags = flags;
-	param.file = path;
-	param.put = put;
-	param.arg = arg;
-	param.isnotfunction = isnotfunction;
-	param.langmap = langmap_saved;
-	param.getconf = getconf;
-	param.die = die;
-	param.warning = warning;
-	param.message = message;
+
+	init_param(&param, path, flags, put, arg, batch);
+	param.ahead = ahead;
+	param.nahead = nahead;
 	ent->parser(&param);
 }
+/*
+ * Files which will be parsed by plug-in parsers (see parser_ahead()).
+ */
+struct ahead_entry {
+	STAILQ_ENTRY(ahead_entry) next;
+	const struct lang_entry *ent;
+	int flags;
+	int state;			/**< AHEAD_XXX below */
+	PARSECACHE_KEY key;		/**< key of the parse cache, or "" */
+	char path[1];
+};
+#define AHEAD_UNCHECKED	0		/**< the parse cache is not checked yet */
+#define AHEAD_PARSE	1		/**< the file should be parsed */
+#define AHEAD_CACHED	2		/**< the tags are in the parse cache */
+
+static STAILQ_HEAD(ahead_list, ahead_entry)
+	ahead_list = STAILQ_HEAD_INITIALIZER(ahead_list);
+
+/**
+ * use_cache: whether the parse cache is used with the flags.
+ * Messages of the parser are not in the cache.
+ */
+static int
+use_cache(int flags)
+{
+	return parsecache_active() && !(flags & (PARSER_DEBUG|PARSER_WARNING));
+}
+/**
+ * parser_ahead: announce a file which will be parsed later.
+ *
+ *	@param[in]	path	path name
+ *	@param[in]	flags	flags which will be given to parse_file_batch()
+ *
+ * Files should be announced in the order of parsing. A plug-in parser
+ * is told the files which follow the current one (param->ahead), so
+ * that it can work on them in advance. Files for built-in parsers are
+ * not remembered.
+ */
+void
+parser_ahead(const char *path, int flags)
+{
+	struct plugin_entry *pent;
+	struct ahead_entry *entry;
+	const char *lang;
+
+	if (STAILQ_EMPTY(&plugin_list) || (lang = decide_lang_path(path)) == NULL)
+		return;
+	STAILQ_FOREACH(pent, &plugin_list, next)
+		if (!strcmp(lang, pent->entry.lang_name))
+			break;
+	if (pent == NULL)
+		return;
+	entry = check_malloc(sizeof(*entry) + strlen(path));
+	entry->ent = &pent->entry;
+	entry->flags = flags;
+	entry->state = AHEAD_UNCHECKED;
+	strcpy(entry->path, path);
+	STAILQ_INSERT_TAIL(&ahead_list, entry, next);
+}
+/**
+ * ahead_pop: remove the files up to the path from the announced files.
+ *
+ *	@param[in]	path	path name
+ *	@return		entry of the path (should be freed); NULL: not announced
+ *
+ * The files before the path were not parsed after all.
+ */
+static struct ahead_entry *
+ahead_pop(const char *path)
+{
+	struct ahead_entry *entry;
+
+	STAILQ_FOREACH(entry, &ahead_list, next)
+		if (!strcmp(entry->path, path))
+			break;
+	if (entry == NULL)
+		return NULL;
+	for (;;) {
+		entry = STAILQ_FIRST(&ahead_list);
+		STAILQ_REMOVE_HEAD(&ahead_list, next);
+		if (!strcmp(entry->path, path))
+			return entry;
+		free(entry);
+	}
+}
+/**
+ * ahead_files: the announced files which the parser will be given.
+ *
+ *	@param[in]	ent	language entry of the parser
+ *	@param[out]	nahead	number of the files
+ *	@return		files
+ *
+ * Files whose tags are in the parse cache are not included.
+ */
+static const char *const *
+ahead_files(const struct lang_entry *ent, int *nahead)
+{
+	static const char *files[MAXAHEAD];
+	struct ahead_entry *entry;
+	int n = 0, scanned = 0;
+
+	STAILQ_FOREACH(entry, &ahead_list, next) {
+		if (n >= MAXAHEAD || scanned++ >= MAXAHEAD * 4)
+			break;
+		if (entry->ent->parser != ent->parser)
+			continue;
+		if (entry->state == AHEAD_UNCHECKED) {
+			if (use_cache(entry->flags)
+			 && parsecache_key(entry->path, get_identity(entry->ent, entry->flags), &entry->key) == 0)
+				entry->state = parsecache_exists(&entry->key) ? AHEAD_CACHED : AHEAD_PARSE;
+			else {
+				entry->key.name[0] = '\0';
+				entry->state = AHEAD_PARSE;
+			}
+		}
+		if (entry->state == AHEAD_PARSE)
+			files[n++] = entry->path;
+	}
+	*nahead = n;
+	return files;
+}
+/**
+ * ahead_clear: forget the announced files.
+ */
+static void
+ahead_clear(void)
+{
+	struct ahead_entry *entry;
+
+	while (!STAILQ_EMPTY(&ahead_list)) {
+		entry = STAILQ_FIRST(&ahead_list);
+		STAILQ_REMOVE_HEAD(&ahead_list, next);
+		free(entry);
+	}
+}
+/**
+ * parse_file_batch: select and execute a parser, and store tags into a batch.
+ *
+ *	@param[in]	path	path name
+ *	@param[in]	flags	PARSER_WARNING: print warning messages
+ *	@param[out]	batch	batch of tags; it is reset before parsing
+ *
+ * Parsers which don't know the batch are also available. Their tags are
+ * stored into the batch through put_into_batch().
+ */
+void
+parse_file_batch(const char *path, int flags, struct parser_batch *batch)
+{
+	const struct lang_entry *ent = get_parser(path);
+	struct ahead_entry *entry = ahead_pop(path);
+	const char *const *ahead = NULL;
+	PARSECACHE_KEY key;
+	int cached, nahead = 0;
+
+	parser_batch_reset(batch);
+	if (ent) {
+		if (flags & PARSER_EXPLAIN)
+			fputs(get_explain(path, ent), stderr);
+		cached = use_cache(flags);
+		if (cached) {
+			if (entry != NULL && entry->state != AHEAD_UNCHECKED
+			 && entry->key.name[0] != '\0'
+			 && entry->ent == ent && entry->flags == flags)
+				key = entry->key;
+			else if (parsecache_key(path, get_identity(ent, flags), &key) < 0)
+				cached = 0;
+		}
+		free(entry);
+		if (cached && parsecache_get(&key, batch))
+			return;
+		/*
+		 * Built-in parsers read the source through the batch, so that
+		 * line images can be referred to instead of being copied.
+		 */
+		if (!strcmp(ent->lt_dl_name, "built-in")) {
+			if (readfile(path, &batch->source, &batch->sourcesize) < 0)
+				batch->source = NULL;
+		} else
+			ahead = ahead_files(ent, &nahead);
+		run_parser(ent, path, flags, put_into_batch, batch, batch, ahead, nahead);
+		if (cached)
+			parsecache_put(&key, batch);
+	} else
+		free(entry);
+}
+/*
+ * The flags which change the output of the parsers.
+ */
+#define IDENTITY_FLAGS	(PARSER_END_BLOCK | PARSER_BEGIN_BLOCK)
+/*
+ * Config variables read by the tools procedure of a plug-in parser
+ * are recorded here by getconf_recorded().
+ */
+static STRBUF *conf_record;
+
+/**
+ * getconf_recorded: getconf() which records the variable and its value.
+ */
+static char *
+getconf_recorded(const char *name)
+{
+	char *value = getconf(name);
+
+	strbuf_sprintf(conf_record, "%s=%s\n", name, value ? value : "");
+	return value;
+}
+/**
+ * get_identity: get the identity of a parser for the parse cache.
+ *
+ * It consists of everything which can change the output of the parser
+ * except for the file contents: the parser itself and its external
+ * commands, the output flags, langmap, gtags_parser, the config variables
+ * which the plug-in parser reads in its tools procedure and the words of
+ * '.notfunction'. Other config variables don't change the tags.
+ */
+static const char *
+get_identity(const struct lang_entry *ent, int flags)
+{
+	static const struct lang_entry *last;
+	static int lastflags;
+	STATIC_STRBUF(sb);
+	struct parser_param param;
+	struct stat st;
+	const char *tools, *command;
+	char *p, *next;
+	int i, idflags = flags & IDENTITY_FLAGS;
+
+	if (ent == last && idflags == lastflags)
+		return strbuf_value(sb);
+	strbuf_clear(sb);
+	strbuf_puts_nl(sb, get_version());
+	strbuf_puts_nl(sb, ent->lang_name);
+	strbuf_puts_nl(sb, ent->parser_name);
+	strbuf_puts_nl(sb, ent->lt_dl_name);
+	/* the plug-in parser may be rebuilt. */
+	if (strcmp(ent->lt_dl_name, "built-in") && stat(ent->lt_dl_name, &st) == 0)
+		strbuf_sprintf(sb, "%d %d\n", (int)st.st_mtime, (int)st.st_size);
+	/* so may the external commands. */
+	if (ent->tools != NULL) {
+		STRBUF *tb = strbuf_open(0);
+
+		init_param(&param, NULL, flags, NULL, NULL, NULL);
+		param.getconf = getconf_recorded;
+		conf_record = sb;
+		if ((tools = ent->tools(&param)) != NULL)
+			strbuf_puts(tb, tools);
+		conf_record = NULL;
+		for (p = strbuf_value(tb); p != NULL; p = next) {
+			if ((next = strchr(p, '\n')) != NULL)
+				*next++ = '\0';
+			if (*p == '\0')
+				continue;
+			strbuf_puts_nl(sb, p);
+			if ((command = usable(p)) != NULL && stat(command, &st) == 0)
+				strbuf_sprintf(sb, "%s %d %d\n", command, (int)st.st_mtime, (int)st.st_size);
+		}
+		strbuf_close(tb);
+	}
+	strbuf_putn(sb, idflags);
+	strbuf_putc(sb, '\n');
+	strbuf_puts_nl(sb, langmap_saved);
+	strbuf_puts_nl(sb, pluginspec_value);
+	for (i = 0; i < tablesize; i++)
+		strbuf_puts_nl(sb, words[i].name);
+	last = ent;
+	lastflags = idflags;
+	return strbuf_value(sb);
+}
+/**
+ * put_into_batch: PARSER_CALLBACK which stores a tag into the batch.
+ */
+static void
+put_into_batch(int type, const char *tag, int lno, const char *path, const char *image, void *arg)
+{
+	parser_batch_put(arg, type, tag, lno, image);
+}
+/**
+ * parser_batch_open: open a batch of tags.
+ */
+struct parser_batch *
+parser_batch_open(void)
+{
+	struct parser_batch *batch = check_calloc(sizeof(struct parser_batch), 1);
+
+	batch->alloced = BATCH_EXPAND;
+	batch->type = check_malloc(sizeof(int) * batch->alloced);
+	batch->lineno = check_malloc(sizeof(int) * batch->alloced);
+	batch->tag = check_malloc(sizeof(int) * batch->alloced);
+	batch->taglen = check_malloc(sizeof(int) * batch->alloced);
+	batch->image = check_malloc(sizeof(int) * batch->alloced);
+	batch->imagelen = check_malloc(sizeof(int) * batch->alloced);
+	batch->poolalloced = BATCH_EXPAND * 64;
+	batch->pool = check_malloc(batch->poolalloced);
+	return batch;
+}
+/**
+ * pool_put: put a string into the pool of the batch.
+ *
+ *	@return	offset of the string
+ */
+static int
+pool_put(struct parser_batch *batch, const char *s, int len)
+{
+	int offset = batch->poolsize;
+
+	if (batch->poolsize + len + 1 > batch->poolalloced) {
+		while (batch->poolsize + len + 1 > batch->poolalloced)
+			batch->poolalloced *= 2;
+		batch->pool = check_realloc(batch->pool, batch->poolalloced);
+	}
+	memcpy(batch->pool + offset, s, len);
+	batch->pool[offset + len] = '\0';
+	batch->poolsize += len + 1;
+	return offset;
+}
+/**
+ * batch_append: make room for a tag and set the columns except for image.
+ *
+ *	@return	index of the tag
+ */
+static int
+batch_append(struct parser_batch *batch, int type, const char *tag, int lno)
+{
+	int n = batch->count;
+	int len;
+
+	if (n >= batch->alloced) {
+		batch->alloced *= 2;
+		batch->type = check_realloc(batch->type, sizeof(int) * batch->alloced);
+		batch->lineno = check_realloc(batch->lineno, sizeof(int) * batch->alloced);
+		batch->tag = check_realloc(batch->tag, sizeof(int) * batch->alloced);
+		batch->taglen = check_realloc(batch->taglen, sizeof(int) * batch->alloced);
+		batch->image = check_realloc(batch->image, sizeof(int) * batch->alloced);
+		batch->imagelen = check_realloc(batch->imagelen, sizeof(int) * batch->alloced);
+	}
+	batch->type[n] = type;
+	batch->lineno[n] = lno;
+	len = strlen(tag);
+	batch->taglen[n] = len;
+	batch->tag[n] = pool_put(batch, tag, len);
+	batch->count++;
+	return n;
+}
+/**
+ * parser_batch_put: append a tag to the batch.
+ *
+ *	@param[in]	batch	batch of tags
+ *	@param[in]	type	PARSER_DEF or PARSER_REF_SYM
+ *	@param[in]	tag	tag name
+ *	@param[in]	lno	line number
+ *	@param[in]	image	line image
+ *
+ * Since tags tend to appear in the same line, the line image of the
+ * previous tag is shared if it is the same.
+ */
+void
+parser_batch_put(struct parser_batch *batch, int type, const char *tag, int lno, const char *image)
+{
+	int n = batch_append(batch, type, tag, lno);
+	int len = strlen(image);
+
+	batch->imagelen[n] = len;
+	if (n > 0 && batch->lineno[n - 1] == lno && batch->imagelen[n - 1] == len
+	 && !memcmp(PARSER_BATCH_IMAGE(batch, n - 1), image, len))
+		batch->image[n] = batch->image[n - 1];
+	else
+		batch->image[n] = pool_put(batch, image, len);
+}
+/**
+ * parser_batch_put_line: append a tag whose line image is in the source.
+ *
+ *	@param[in]	batch	batch of tags
+ *	@param[in]	type	PARSER_DEF or PARSER_REF_SYM
+ *	@param[in]	tag	tag name
+ *	@param[in]	lno	line number
+ *	@param[in]	offset	offset of the line image in batch->source
+ *	@param[in]	len	length of the line image
+ *
+ * The line image is not copied but referred to by the offset.
+ */
+void
+parser_batch_put_line(struct parser_batch *batch, int type, const char *tag, int lno, size_t offset, int len)
+{
+	const char *image = batch->source + offset;
+	const char *nul = memchr(image, '\0', len);
+	int n;
+
+	/* same as the line image copied into a string */
+	if (nul != NULL)
+		len = nul - image;
+	if (offset > INT_MAX) {
+		STATIC_STRBUF(sb);
+
+		strbuf_clear(sb);
+		strbuf_nputs(sb, image, len);
+		parser_batch_put(batch, type, tag, lno, strbuf_value(sb));
+		return;
+	}
+	n = batch_append(batch, type, tag, lno);
+	batch->image[n] = ~(int)offset;
+	batch->imagelen[n] = len;
+}
+/**
+ * parser_batch_reset: make the batch empty.
+ */
+void
+parser_batch_reset(struct parser_batch *batch)
+{
+	batch->count = 0;
+	batch->poolsize = 0;
+	if (batch->source != NULL) {
+		freefile(batch->source, batch->sourcesize);
+		batch->source = NULL;
+		batch->sourcesize = 0;
+	}
+}
+/**
+ * parser_batch_close: close the batch.
+ */
+void
+parser_batch_close(struct parser_batch *batch)
+{
+	parser_batch_reset(batch);
+	free(batch->type);
+	free(batch->lineno);
+	free(batch->tag);
+	free(batch->taglen);
+	free(batch->image);
+	free(batch->imagelen);
+	free(batch->pool);
+	free(batch);
+}
 /**
  * get_explain: get explain messages.
  */
@@ -474,7 +959,7 @@ get_explain(const char *path, const struct lang_entry *ent)
 	return strbuf_value(sb);
 }
 void
-dbg_print(int level, const char *s)
+dbg_print(int lineno, int level, const char *s)
 {
 	fprintf(stderr, "[%04d]", lineno);
 	for (; level > 0; level--)
@@ -21,6 +21,8 @@
 #ifndef _PARSER_H_
 #define _PARSER_H_
 
+#include <stddef.h>
+
 /*
  * Built-in parser base on gctags
  */
@@ -50,6 +52,37 @@ void parser_exit(void);
 
 typedef void (*PARSER_CALLBACK)(int, const char *, int, const char *, const char *, void *);
 
+/*
+ * Batch of tags (version 2).
+ *
+ * Tags of a file are stored in columns, and the strings are stored in
+ * the pool and referred to by offset. Parsers should append tags using
+ * param->put_batch(), not touch the members directly.
+ */
+struct parser_batch {
+	int count;		/**< number of tags */
+	int alloced;		/**< allocated number of tags */
+	int *type;		/**< PARSER_DEF or PARSER_REF_SYM */
+	int *lineno;		/**< line number */
+	int *tag;		/**< offset of tag name in the pool */
+	int *taglen;		/**< length of tag name */
+	int *image;		/**< offset of line image (see below) */
+	int *imagelen;		/**< length of line image */
+	char *pool;
+	int poolsize;
+	int poolalloced;
+	char *source;		/**< contents of the source file, if read */
+	size_t sourcesize;
+};
+#define PARSER_BATCH_TAG(batch, i)	((batch)->pool + (batch)->tag[i])
+/*
+ * A line image is in the pool, or in the source file if image[i] < 0.
+ * The latter is not terminated by '\0'. Use PARSER_BATCH_IMAGELEN().
+ */
+#define PARSER_BATCH_IMAGE(batch, i)	((batch)->image[i] < 0 ? \
+	(batch)->source + ~(batch)->image[i] : (batch)->pool + (batch)->image[i])
+#define PARSER_BATCH_IMAGELEN(batch, i)	((batch)->imagelen[i])
+
 struct parser_param {
 	int size;		/**< size of this structure */
 	int flags;
@@ -62,12 +95,50 @@ struct parser_param {
 	void (*die)(const char *, ...);
 	void (*warning)(const char *, ...);
 	void (*message)(const char *, ...);
+	/*
+	 * version 2
+	 *
+	 * If batch is not NULL, a parser can append tags with put_batch()
+	 * instead of calling put() per tag. Check PARSER_HAS_BATCH() first,
+	 * since older versions don't have these members.
+	 */
+	struct parser_batch *batch;
+	void (*put_batch)(struct parser_batch *, int, const char *, int, const char *);
+	/*
+	 * version 3
+	 *
+	 * The files which will be given to this parser after this one,
+	 * in the order. A parser which runs an external process can send
+	 * them in advance. Check PARSER_HAS_AHEAD() first.
+	 */
+	const char *const *ahead;
+	int nahead;
 };
+#define PARSER_HAS_BATCH(param) \
+	((param)->size >= (int)(offsetof(struct parser_param, put_batch) + sizeof((param)->put_batch)) \
+	 && (param)->batch != NULL)
+#define PARSER_HAS_AHEAD(param) \
+	((param)->size >= (int)(offsetof(struct parser_param, nahead) + sizeof((param)->nahead)))
 
 typedef void (*PARSER)(const struct parser_param *);
+/*
+ * A plug-in parser which runs external commands can define a function
+ * named '<function name>_tools' (e.g. parser_tools), which returns the
+ * commands separated by newlines. The parse cache is not used for the
+ * tags made by older commands. The config variables which the function
+ * reads with getconf() are part of the cache key too, so it should read
+ * every variable which changes the tags.
+ */
+typedef const char *(*PARSER_TOOLS)(const struct parser_param *);
 void parse_file(const char *, int, PARSER_CALLBACK, void *);
+void parse_file_batch(const char *, int, struct parser_batch *);
+void parser_ahead(const char *, int);
 const struct lang_entry *get_parser(const char *);
 void execute_parser(const struct lang_entry *, const char *, int, PARSER_CALLBACK, void *);
+struct parser_batch *parser_batch_open(void);
+void parser_batch_put(struct parser_batch *, int, const char *, int, const char *);
+void parser_batch_reset(struct parser_batch *);
+void parser_batch_close(struct parser_batch *);
 const char *get_explain(const char *, const struct lang_entry *);
 
 #endif
@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * bench-dbop: measure the trade-off of the page size of the tag files.
+ *
+ * usage: bench-dbop [-l lookups][-p size,...] [dbpath]
+ *
+ * The records of GPATH, GTAGS and GRTAGS in dbpath (default: the current
+ * directory) are written into temporary files of each page size in key
+ * order, as the sorted writing of gtags does. For each page size, the
+ * file size and the time to load, to scan all records and to look up
+ * keys as 'global -x' does are printed.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "getopt.h"
+#include "checkalloc.h"
+#include "dbop.h"
+#include "die.h"
+#include "gparam.h"
+#include "makepath.h"
+#include "pool.h"
+#include "varray.h"
+
+const char *progname = "bench-dbop";
+
+/*
+ * Records of a tag file.
+ */
+struct record {
+	char *key;
+	int ksize;
+	char *dat;
+	int dsize;
+};
+static VARRAY *records;
+static VARRAY *keys;			/**< index of the first record of each key */
+static POOL *pool;
+
+static int lookups = 10000;
+static const char *default_sizes = "1024,2048,4096,8192,16384,32768";
+
+static void
+usage(void)
+{
+	fputs("usage: bench-dbop [-l lookups][-p size,...] [dbpath]\n", stderr);
+	exit(2);
+}
+static double
+elapsed(struct timeval *start)
+{
+	struct timeval end;
+
+	gettimeofday(&end, NULL);
+	return (end.tv_sec - start->tv_sec) + (end.tv_usec - start->tv_usec) / 1000000.0;
+}
+/**
+ * load_records: read all records of a tag file into memory.
+ *
+ *	@param[in]	path	tag file
+ *	@return		0: normal, -1: not found
+ */
+static int
+load_records(const char *path)
+{
+	BTREEINFO info;
+	DB *db;
+	DBT key, dat;
+	int status;
+
+	memset(&info, 0, sizeof(info));
+	info.cachesize = GTAGSCACHE;
+	if ((db = dbopen(path, O_RDONLY, 0, DB_BTREE, &info)) == NULL)
+		return -1;
+	varray_reset(records);
+	varray_reset(keys);
+	pool_reset(pool);
+	for (status = (*db->seq)(db, &key, &dat, R_FIRST); status == RET_SUCCESS;
+	     status = (*db->seq)(db, &key, &dat, R_NEXT)) {
+		struct record *r = varray_append(records);
+
+		if (records->length == 1 || r[-1].ksize != key.size || memcmp(r[-1].key, key.data, key.size))
+			*(int *)varray_append(keys) = records->length - 1;
+		r->key = pool_malloc(pool, key.size);
+		memcpy(r->key, key.data, key.size);
+		r->ksize = key.size;
+		r->dat = pool_malloc(pool, dat.size);
+		memcpy(r->dat, dat.data, dat.size);
+		r->dsize = dat.size;
+	}
+	if (status == RET_ERROR)
+		die("cannot read '%s'.", path);
+	(void)(*db->close)(db, 0);
+	return 0;
+}
+/**
+ * bench: write the records into a file of the page size and measure it.
+ *
+ *	@param[in]	name	name of the tag file
+ *	@param[in]	tmp	temporary file
+ *	@param[in]	pagesize	page size
+ */
+static void
+bench(const char *name, const char *tmp, int pagesize)
+{
+	struct record *r = varray_assign(records, 0, 0);
+	int *k = varray_assign(keys, 0, 0);
+	BTREEINFO info;
+	DB *db;
+	DBT key, dat;
+	struct timeval start;
+	struct stat st;
+	double load, scan, lookup;
+	unsigned int seed = 1;
+	long found = 0;
+	int i, status;
+
+	memset(&info, 0, sizeof(info));
+	info.psize = pagesize;
+	info.cachesize = GTAGSCACHE;
+	if (strcmp(name, "GPATH"))
+		info.flags = R_DUP | R_FOLDDUP;
+	(void)unlink(tmp);
+	gettimeofday(&start, NULL);
+	if ((db = dbopen(tmp, O_RDWR|O_CREAT|O_TRUNC, 0600, DB_BTREE, &info)) == NULL)
+		die("cannot create '%s'.", tmp);
+	for (i = 0; i < records->length; i++) {
+		key.data = r[i].key;
+		key.size = r[i].ksize;
+		dat.data = r[i].dat;
+		dat.size = r[i].dsize;
+		if ((*db->put)(db, &key, &dat, 0) == RET_ERROR)
+			die("cannot write '%s'.", tmp);
+	}
+	if ((*db->close)(db, 0) == RET_ERROR)
+		die("cannot close '%s'.", tmp);
+	load = elapsed(&start);
+	if (stat(tmp, &st) < 0)
+		die("cannot stat '%s'.", tmp);
+
+	if ((db = dbopen(tmp, O_RDONLY, 0, DB_BTREE, &info)) == NULL)
+		die("cannot open '%s'.", tmp);
+	gettimeofday(&start, NULL);
+	for (status = (*db->seq)(db, &key, &dat, R_FIRST); status == RET_SUCCESS;
+	     status = (*db->seq)(db, &key, &dat, R_NEXT))
+		found++;
+	scan = elapsed(&start);
+	if (found != records->length)
+		die("%s: %ld records found, %d expected.", name, found, records->length);
+	/*
+	 * Look up keys in a fixed pseudo random order, reading all the
+	 * records of each key.
+	 */
+	found = 0;
+	gettimeofday(&start, NULL);
+	for (i = 0; i < lookups && keys->length > 0; i++) {
+		struct record *target;
+
+		seed = seed * 1103515245 + 12345;
+		target = &r[k[(seed >> 8) % keys->length]];
+		key.data = target->key;
+		key.size = target->ksize;
+		for (status = (*db->seq)(db, &key, &dat, R_CURSOR);
+		     status == RET_SUCCESS && key.size == target->ksize && !memcmp(key.data, target->key, key.size);
+		     status = (*db->seq)(db, &key, &dat, R_NEXT))
+			found++;
+	}
+	lookup = elapsed(&start);
+	(void)(*db->close)(db, 0);
+	printf("%-7s %8d %12ld %9.3f %9.3f %9.3f %10ld\n",
+		name, pagesize, (long)st.st_size, load, scan, lookup, found);
+}
+
+static struct option const long_options[] = {
+	{"lookups", required_argument, NULL, 'l'},
+	{"pagesize", required_argument, NULL, 'p'},
+	{ 0 }
+};
+
+int
+main(int argc, char **argv)
+{
+	static const char *const names[] = {"GPATH", "GTAGS", "GRTAGS"};
+	const char *dbpath = ".";
+	const char *sizes = default_sizes;
+	char tmp[MAXPATHLEN];
+	int optchar, i, fd;
+
+	while ((optchar = getopt_long(argc, argv, "l:p:", long_options, NULL)) != EOF) {
+		switch (optchar) {
+		case 'l':
+			if ((lookups = atoi(optarg)) < 0)
+				usage();
+			break;
+		case 'p':
+			sizes = optarg;
+			break;
+		default:
+			usage();
+			break;
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	if (argc > 1)
+		usage();
+	if (argc == 1)
+		dbpath = argv[0];
+
+	snprintf(tmp, sizeof(tmp), "%s/bench-dbop.XXXXXX", getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp");
+	if ((fd = mkstemp(tmp)) < 0)
+		die("cannot make temporary file.");
+	close(fd);
+	records = varray_open(sizeof(struct record), 10000);
+	keys = varray_open(sizeof(int), 1000);
+	pool = pool_open();
+	printf("%-7s %8s %12s %9s %9s %9s %10s\n",
+		"file", "pagesize", "bytes", "load(s)", "scan(s)", "lookup(s)", "found");
+	for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+		const char *p;
+
+		if (load_records(makepath(dbpath, names[i], NULL)) < 0) {
+			fprintf(stderr, "bench-dbop: %s not found in '%s'.\n", names[i], dbpath);
+			continue;
+		}
+		for (p = sizes; *p; ) {
+			int size = atoi(p);
+
+			if (size < DBOP_MINPAGESIZE || size > DBOP_MAXPAGESIZE || (size & (size - 1)))
+				die("page size must be a power of 2 from %d to %d.",
+					DBOP_MINPAGESIZE, DBOP_MAXPAGESIZE);
+			bench(names[i], tmp, size);
+			while (*p && *p != ',')
+				p++;
+			if (*p == ',')
+				p++;
+		}
+	}
+	(void)unlink(tmp);
+	pool_close(pool);
+	varray_close(keys);
+	varray_close(records);
+	return 0;
+}
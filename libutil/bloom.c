@@ -0,0 +1,484 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "bloom.h"
+#include "checkalloc.h"
+#include "die.h"
+#include "strbuf.h"
+#include "strlimcpy.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*
+ * File format (integers are little endian):
+ *
+ *	header:	magic(4) version(4) blocks(4) keys(4)
+ *		tag file size(8) mtime(8) mtime nanoseconds(4) reserved(4)
+ *	blocks:	BLOOM_BLOCKSIZE bytes each
+ *
+ * The header records the state of the tag file when the filter was
+ * written. A filter whose tag file has changed since then is not used.
+ */
+#define BLOOM_MAGIC		0x0b1005f1
+#define BLOOM_VERSION		2
+#define BLOOM_HEADERSIZE	40
+#define BLOOM_STATESIZE		24	/**< state of the tag file */
+
+/**
+ * bloom_hash: FNV-1a hash of a key with the final mixing of MurmurHash3.
+ * The upper half chooses a block and the lower half the bits in it.
+ *
+ *	@param[in]	key	key
+ *	@param[in]	len	length of the key
+ *	@return		hash value
+ */
+unsigned long long
+bloom_hash(const void *key, size_t len)
+{
+	const unsigned char *p = (const unsigned char *)key;
+	unsigned long long h = 14695981039346656037ULL;
+
+	while (len-- > 0) {
+		h ^= *p++;
+		h *= 1099511628211ULL;
+	}
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+/**
+ * bloom_blocks: number of blocks for keys.
+ *
+ *	@param[in]	keys	number of keys
+ *	@return		number of blocks (1 at least)
+ */
+unsigned int
+bloom_blocks(unsigned int keys)
+{
+	unsigned int nblocks = ((size_t)keys * BLOOM_BITS + BLOOM_BLOCKSIZE * 8 - 1) / (BLOOM_BLOCKSIZE * 8);
+
+	return nblocks > 0 ? nblocks : 1;
+}
+#define block_of(h, nblocks)	((unsigned int)((h) >> 32) % (nblocks))
+/**
+ * bloom_set: set the bits of a hash.
+ *
+ *	@param[in]	bits	blocks of a filter
+ *	@param[in]	nblocks	number of blocks
+ *	@param[in]	h	hash value
+ *	@return		1: some bits were not set, 0: all bits were already set
+ */
+int
+bloom_set(unsigned char *bits, unsigned int nblocks, unsigned long long h)
+{
+	unsigned char *block = bits + block_of(h, nblocks) * BLOOM_BLOCKSIZE;
+	unsigned int a = (unsigned int)h;
+	unsigned int b = (a >> 17 | a << 15) | 1;
+	int i, new = 0;
+
+	for (i = 0; i < BLOOM_HASHES; i++, a += b) {
+		unsigned int bit = a % (BLOOM_BLOCKSIZE * 8);
+
+		if (!(block[bit / 8] & (1 << (bit % 8)))) {
+			block[bit / 8] |= 1 << (bit % 8);
+			new = 1;
+		}
+	}
+	return new;
+}
+/**
+ * bloom_check: test the bits of a hash.
+ *
+ *	@param[in]	bits	blocks of a filter
+ *	@param[in]	nblocks	number of blocks
+ *	@param[in]	h	hash value
+ *	@return		1: all bits are set, 0: not
+ *
+ * The block of the hash alone may be given with nblocks = 1.
+ */
+int
+bloom_check(const unsigned char *bits, unsigned int nblocks, unsigned long long h)
+{
+	const unsigned char *block = bits + block_of(h, nblocks) * BLOOM_BLOCKSIZE;
+	unsigned int a = (unsigned int)h;
+	unsigned int b = (a >> 17 | a << 15) | 1;
+	int i;
+
+	for (i = 0; i < BLOOM_HASHES; i++, a += b) {
+		unsigned int bit = a % (BLOOM_BLOCKSIZE * 8);
+
+		if (!(block[bit / 8] & (1 << (bit % 8))))
+			return 0;
+	}
+	return 1;
+}
+static void
+put_le32(unsigned char *p, unsigned int val)
+{
+	p[0] = val & 0xff;
+	p[1] = (val >> 8) & 0xff;
+	p[2] = (val >> 16) & 0xff;
+	p[3] = (val >> 24) & 0xff;
+}
+static unsigned int
+get_le32(const unsigned char *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24;
+}
+static void
+put_le64(unsigned char *p, unsigned long long val)
+{
+	put_le32(p, (unsigned int)val);
+	put_le32(p + 4, (unsigned int)(val >> 32));
+}
+/**
+ * tag_state: the state of a tag file recorded in the header.
+ *
+ *	@param[in]	tagfile	tag file
+ *	@param[out]	state	size, mtime and its nanoseconds (BLOOM_STATESIZE bytes)
+ *	@return		0: normal, -1: cannot stat
+ *
+ * Whole seconds of mtime cannot tell a tag file rewritten within the
+ * second in which its filter was written, so the size and nanoseconds
+ * are compared too.
+ */
+static int
+tag_state(const char *tagfile, unsigned char *state)
+{
+	struct stat st;
+	long nsec = 0;
+
+	if (stat(tagfile, &st) < 0)
+		return -1;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+	nsec = st.st_mtim.tv_nsec;
+#endif
+	put_le64(state, (unsigned long long)st.st_size);
+	put_le64(state + 8, (unsigned long long)st.st_mtime);
+	put_le32(state + 16, (unsigned int)nsec);
+	put_le32(state + 20, 0);
+	return 0;
+}
+/**
+ * filter_name: make the name of the filter of a tag file.
+ *
+ *	@param[out]	path	filter file (MAXPATHLEN bytes)
+ *	@param[in]	tagfile	tag file
+ *
+ * makepath() is not used, since the tag file is often given as its result.
+ */
+static void
+filter_name(char *path, const char *tagfile)
+{
+	int len;
+
+	strlimcpy(path, tagfile, MAXPATHLEN);
+	len = strlen(path);
+	strlimcpy(path + len, "." BLOOM_SUFFIX, MAXPATHLEN - len);
+}
+/**
+ * read_header: read the header of a filter.
+ *
+ *	@return		0: normal, -1: not a filter, or a filter of another state of the tag file
+ */
+static int
+read_header(BLOOM *bloom)
+{
+	unsigned char header[BLOOM_HEADERSIZE], state[BLOOM_STATESIZE];
+
+	if (read(bloom->fd, header, sizeof(header)) != sizeof(header))
+		return -1;
+	if (get_le32(header) != BLOOM_MAGIC || get_le32(header + 4) != BLOOM_VERSION)
+		return -1;
+	if (tag_state(bloom->tagfile, state) < 0 || memcmp(header + 16, state, sizeof(state)))
+		return -1;
+	bloom->nblocks = get_le32(header + 8);
+	bloom->keys = get_le32(header + 12);
+	return bloom->nblocks > 0 ? 0 : -1;
+}
+/**
+ * bloom_open: open the bloom filter of a tag file.
+ *
+ *	@param[in]	tagfile	tag file
+ *	@param[in]	mode	0: read, 1: create, 2: modify
+ *	@return		filter, NULL: no usable filter (mode 0 only)
+ *
+ * In mode 2, if there is no usable filter, bloom_rebuild() requests
+ * the keys of the whole tag file.
+ */
+BLOOM *
+bloom_open(const char *tagfile, int mode)
+{
+	BLOOM *bloom = check_calloc(sizeof(BLOOM), 1);
+
+	strlimcpy(bloom->tagfile, tagfile, sizeof(bloom->tagfile));
+	filter_name(bloom->path, tagfile);
+	bloom->mode = mode;
+	bloom->fd = -1;
+	if (mode == 1) {
+		bloom->hashes = varray_open(sizeof(unsigned long long), 100000);
+		return bloom;
+	}
+	if ((bloom->fd = open(bloom->path, O_RDONLY|O_BINARY)) >= 0
+	    && read_header(bloom) == 0) {
+		if (mode == 0)
+			return bloom;
+		bloom->bits = check_malloc(bloom->nblocks * BLOOM_BLOCKSIZE);
+		if (read(bloom->fd, bloom->bits, bloom->nblocks * BLOOM_BLOCKSIZE)
+		    != bloom->nblocks * BLOOM_BLOCKSIZE) {
+			free(bloom->bits);
+			bloom->bits = NULL;
+		}
+	}
+	if (bloom->fd >= 0) {
+		close(bloom->fd);
+		bloom->fd = -1;
+	}
+	if (mode == 0) {
+		free(bloom);
+		return NULL;
+	}
+	return bloom;
+}
+/**
+ * bloom_add: add a key to a filter.
+ *
+ *	@param[in]	bloom	filter
+ *	@param[in]	key	key
+ *
+ * Keys put in key order are counted once.
+ */
+void
+bloom_add(BLOOM *bloom, const char *key)
+{
+	unsigned long long h = bloom_hash(key, strlen(key));
+
+	if (bloom->mode == 1) {
+		VARRAY *vb = bloom->hashes;
+
+		if (vb->length > 0 && *(unsigned long long *)varray_assign(vb, vb->length - 1, 0) == h)
+			return;
+		*(unsigned long long *)varray_append(vb) = h;
+	} else if (bloom->mode == 2 && bloom->bits != NULL) {
+		if (bloom_set(bloom->bits, bloom->nblocks, h))
+			bloom->keys++;
+	}
+}
+/**
+ * bloom_test: test whether a tag file may have a key.
+ *
+ *	@param[in]	bloom	filter
+ *	@param[in]	key	key
+ *	@return		0: certainly absent, 1: may be present
+ */
+int
+bloom_test(BLOOM *bloom, const char *key)
+{
+	unsigned char block[BLOOM_BLOCKSIZE];
+	unsigned long long h = bloom_hash(key, strlen(key));
+	off_t offset;
+
+	if (bloom->mode == 2 && bloom->bits != NULL)
+		return bloom_check(bloom->bits, bloom->nblocks, h);
+	if (bloom->mode != 0)
+		return 1;
+	offset = BLOOM_HEADERSIZE + (off_t)block_of(h, bloom->nblocks) * BLOOM_BLOCKSIZE;
+#if defined(HAVE_PREAD) && !defined(__CYGWIN__)
+	if (pread(bloom->fd, block, sizeof(block), offset) != sizeof(block))
+		return 1;
+#else
+	if (lseek(bloom->fd, offset, SEEK_SET) != offset
+	    || read(bloom->fd, block, sizeof(block)) != sizeof(block))
+		return 1;
+#endif
+	return bloom_check(block, 1, h);
+}
+/**
+ * bloom_rebuild: decide whether to make a filter from all the keys.
+ *
+ *	@param[in]	bloom	filter
+ *	@return		1: rebuild, 0: not needed
+ *
+ * A filter being modified is rebuilt when it was not usable, or when the
+ * keys added have doubled the rate of false positives. The caller passes
+ * all the keys of the tag file to bloom_add() in key order.
+ */
+int
+bloom_rebuild(BLOOM *bloom)
+{
+	if (bloom->mode != 2)
+		return 0;
+	if (bloom->bits != NULL && bloom->keys <= bloom->nblocks * BLOOM_BLOCKSIZE * 8 / BLOOM_BITS * 2)
+		return 0;
+	free(bloom->bits);
+	bloom->bits = NULL;
+	bloom->mode = 1;
+	bloom->hashes = varray_open(sizeof(unsigned long long), 100000);
+	return 1;
+}
+/**
+ * write_filter: write a filter into the file.
+ *
+ * The filter is written into a temporary file, which then replaces the
+ * filter file, so that readers never see a partial one.
+ */
+static void
+write_filter(BLOOM *bloom)
+{
+	STRBUF *sb = strbuf_open(0);
+	const char *tmp;
+	unsigned char header[BLOOM_HEADERSIZE];
+	size_t size = (size_t)bloom->nblocks * BLOOM_BLOCKSIZE;
+	int fd;
+
+	put_le32(header, BLOOM_MAGIC);
+	put_le32(header + 4, BLOOM_VERSION);
+	put_le32(header + 8, bloom->nblocks);
+	put_le32(header + 12, bloom->keys);
+	if (tag_state(bloom->tagfile, header + 16) < 0) {
+		(void)unlink(bloom->path);
+		strbuf_close(sb);
+		return;
+	}
+	strbuf_puts(sb, bloom->path);
+	strbuf_puts(sb, ".tmp");
+	tmp = strbuf_value(sb);
+	if ((fd = open(tmp, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, 0644)) < 0)
+		die("cannot make '%s'.", tmp);
+	if (write(fd, header, sizeof(header)) != sizeof(header)
+	    || write(fd, bloom->bits, size) != size
+	    || close(fd) < 0) {
+		(void)unlink(tmp);
+		(void)unlink(bloom->path);
+		die("cannot write '%s'.", tmp);
+	}
+#ifdef _WIN32
+	(void)unlink(bloom->path);
+#endif
+	if (rename(tmp, bloom->path) < 0)
+		die("cannot rename '%s' to '%s'.", tmp, bloom->path);
+	strbuf_close(sb);
+}
+/**
+ * bloom_close: close a filter, writing it if it was made or modified.
+ *
+ *	@param[in]	bloom	filter
+ *
+ * This must be called after the tag file is closed, since the filter
+ * records the state of the tag file.
+ */
+void
+bloom_close(BLOOM *bloom)
+{
+	if (bloom->mode == 1) {
+		VARRAY *vb = bloom->hashes;
+		unsigned long long *h = varray_assign(vb, 0, 0);
+		int i;
+
+		bloom->keys = vb->length;
+		bloom->nblocks = bloom_blocks(bloom->keys);
+		bloom->bits = check_calloc(bloom->nblocks, BLOOM_BLOCKSIZE);
+		for (i = 0; i < vb->length; i++)
+			bloom_set(bloom->bits, bloom->nblocks, h[i]);
+		varray_close(vb);
+		write_filter(bloom);
+	} else if (bloom->mode == 2) {
+		if (bloom->bits != NULL)
+			write_filter(bloom);
+		else
+			(void)unlink(bloom->path);
+	}
+	if (bloom->fd >= 0)
+		close(bloom->fd);
+	free(bloom->bits);
+	free(bloom);
+}
+/**
+ * bloom_exist: test whether a tag file may have a key.
+ *
+ *	@param[in]	tagfile	tag file
+ *	@param[in]	key	key
+ *	@return		0: certainly absent, 1: may be present or no usable filter
+ */
+int
+bloom_exist(const char *tagfile, const char *key)
+{
+	BLOOM *bloom = bloom_open(tagfile, 0);
+	int exist;
+
+	if (bloom == NULL)
+		return 1;
+	exist = bloom_test(bloom, key);
+	bloom_close(bloom);
+	return exist;
+}
+/**
+ * bloom_remove: remove the filter of a tag file.
+ *
+ *	@param[in]	tagfile	tag file
+ */
+void
+bloom_remove(const char *tagfile)
+{
+	char path[MAXPATHLEN];
+
+	filter_name(path, tagfile);
+	(void)unlink(path);
+}
+/**
+ * bloom_copy: make the filter of a copy of a tag file.
+ *
+ *	@param[in]	from	tag file
+ *	@param[in]	to	copy of the tag file
+ *
+ * The filter of 'from' is written for the state of 'to', whose keys
+ * must be the same. If 'from' has no usable filter, 'to' has none.
+ */
+void
+bloom_copy(const char *from, const char *to)
+{
+	BLOOM *bloom = bloom_open(from, 2);
+
+	strlimcpy(bloom->tagfile, to, sizeof(bloom->tagfile));
+	filter_name(bloom->path, to);
+	bloom_close(bloom);
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _BLOOM_H_
+#define _BLOOM_H_
+
+#include "gparam.h"
+#include "varray.h"
+
+/*
+ * Bloom filter of the keys of a tag file.
+ *
+ * The filter of a tag file 'GTAGS' is the file 'GTAGS.bloom', which is
+ * written by dbop when the tag file is made or updated. It answers
+ * whether a key is certainly absent from the tag file without opening it.
+ * A filter is ignored if its tag file has changed since the filter was
+ * written, since the tag file may have been written by a program which
+ * does not maintain the filter.
+ *
+ * The filter is split into blocks of BLOOM_BLOCKSIZE bytes, and a key sets
+ * BLOOM_HASHES bits in a block chosen by its hash, so that a lookup reads
+ * only one block. The sorted table (sstable.c) uses the same filter.
+ */
+		/** suffix of the filter file */
+#define BLOOM_SUFFIX		"bloom"
+#define BLOOM_BLOCKSIZE		64	/**< 512 bits */
+#define BLOOM_BITS		10	/**< bits per key */
+#define BLOOM_HASHES		7	/**< bits set by a key */
+
+typedef struct {
+	char tagfile[MAXPATHLEN];	/**< tag file */
+	char path[MAXPATHLEN];		/**< filter file */
+	int mode;			/**< 0: read, 1: create, 2: modify */
+	int fd;				/**< filter file (read) */
+	unsigned int nblocks;		/**< number of blocks */
+	unsigned int keys;		/**< number of keys */
+	unsigned char *bits;		/**< filter (modify) */
+	VARRAY *hashes;			/**< hash of each key (create) */
+} BLOOM;
+
+unsigned long long bloom_hash(const void *, size_t);
+unsigned int bloom_blocks(unsigned int);
+int bloom_set(unsigned char *, unsigned int, unsigned long long);
+int bloom_check(const unsigned char *, unsigned int, unsigned long long);
+BLOOM *bloom_open(const char *, int);
+void bloom_add(BLOOM *, const char *);
+int bloom_test(BLOOM *, const char *);
+int bloom_rebuild(BLOOM *);
+void bloom_close(BLOOM *);
+int bloom_exist(const char *, const char *);
+void bloom_remove(const char *);
+void bloom_copy(const char *, const char *);
+
+#endif /* ! _BLOOM_H_ */
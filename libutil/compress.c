@@ -170,13 +170,28 @@ abbrev_dump(void)
  */
 char *
 compress(const char *in, const char *name, STRBUF *sb)
+{
+	strbuf_reset(sb);
+	compress_nputs(sb, in, strlen(in), name);
+	return strbuf_value(sb);
+}
+/**
+ * compress_nputs: append a compressed source line to the buffer.
+ *
+ *	@param[out]	sb	buffer
+ *	@param[in]	in	source line (need not be terminated by '\0')
+ *	@param[in]	len	length of the source line
+ *	@param[in]	name	replaced string
+ */
+void
+compress_nputs(STRBUF *sb, const char *in, int len, const char *name)
 {
 	const char *p = in;
+	const char *end = in + len;
 	int length = strlen(name);
 	int spaces = 0;
 
-	strbuf_reset(sb);
-	while (*p) {
+	while (p < end) {
 		if (*p == ' ') {
 			spaces++;
 			p++;
@@ -199,7 +214,7 @@ compress(const char *in, const char *name, STRBUF *sb)
 		if (*p == '@') {
 			strbuf_puts(sb, "@@");
 			p++;
-		} else if (!strncmp(p, name, length)) {
+		} else if (end - p >= length && !memcmp(p, name, length)) {
 			strbuf_puts(sb, "@n");
 			p += length;
 		} else if (name2ab) {
@@ -207,7 +222,7 @@ compress(const char *in, const char *name, STRBUF *sb)
 			struct abbrmap *ab = (struct abbrmap *)varray_assign(name2ab, 0, 0);
 
 			for (i = 0; i < limit; i++) {
-				if (!strncmp(p, ab[i].name, ab[i].length)) {
+				if (end - p >= ab[i].length && !memcmp(p, ab[i].name, ab[i].length)) {
 					strbuf_putc(sb, '@');
 					strbuf_putc(sb, ab[i].c);
 					p += ab[i].length;
@@ -236,7 +251,6 @@ compress(const char *in, const char *name, STRBUF *sb)
 			strbuf_putc(sb, '}');
 		}
 	}
-	return strbuf_value(sb);
 }
 
 /**
@@ -33,6 +33,7 @@ void abbrev_open(const char *);
 void abbrev_close(void);
 void abbrev_dump(void);
 char *compress(const char *text, const char *name, STRBUF *sb);
+void compress_nputs(STRBUF *sb, const char *text, int len, const char *name);
 char *uncompress(const char *text, const char *name, STRBUF *sb);
 
 #endif /* ! _COMPRESS_H */
@@ -252,7 +252,7 @@ set_print0(void)
  * Path filter for the output of global(1).
  * The path name starts with "./" which is the project root directory.
  */
-static const char *
+const char *
 convert_pathname(CONVERT *cv, const char *path)
 {
 	static char buf[MAXPATHLEN];
@@ -571,6 +571,10 @@ convert_put_using(CONVERT *cv, const char *tag, const char *path, int lineno, co
 		set_color_tag(tag);
 	if (cv->tag_for_display)
 		tag = cv->tag_for_display;
+	if (cv->hook) {
+		(*cv->hook)(tag, path, lineno, rest, fid);
+		return;
+	}
 	switch (cv->format) {
 	case FORMAT_PATH:
 		fputs(convert_pathname(cv, path), cv->op);
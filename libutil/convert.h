@@ -39,6 +39,8 @@ typedef struct {
 	int start_point;
 	int db;			/**< for gtags-cscope */
 	char *tag_for_display;
+	/** if set, records are passed to this function instead of op */
+	void (*hook)(const char *, const char *, int, const char *, const char *);
 } CONVERT;
 
 void set_convert_flags(int);
@@ -47,6 +49,7 @@ CONVERT *convert_open(int, int, const char *, const char *, const char *, FILE *
 void convert_put(CONVERT *, const char *);
 void convert_put_path(CONVERT *, const char *, const char *);
 void convert_put_using(CONVERT *, const char *, const char *, int, const char *, const char *);
+const char *convert_pathname(CONVERT *, const char *);
 void convert_close(CONVERT *cv);
 
 #endif /* ! _CONVERT_H_ */
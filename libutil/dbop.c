@@ -39,6 +39,11 @@
 #include <unistd.h>
 #endif
 #include <errno.h>
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
 
 #include "char.h"
 #include "checkalloc.h"
@@ -46,13 +51,22 @@
 #include "die.h"
 #include "env.h"
 #include "locatestring.h"
+#include "sstable.h"
+#include "statistics.h"
 #include "strbuf.h"
 #include "strlimcpy.h"
 #include "test.h"
 
+/*
+ * The system db(3) of DB185 compatible mode does not fold duplicate keys.
+ */
+#ifndef R_FOLDDUP
+#define R_FOLDDUP	0
+#endif
+
 #ifdef USE_SQLITE3
 int is_sqlite3(const char *);
-DBOP *dbop3_open(const char *, int, int, int);
+DBOP *dbop3_open(const char *, int, int, int, int);
 const char *dbop3_get(DBOP *, const char *);
 const char *dbop3_getflag(DBOP *);
 char *dbop3_quote(char *);
@@ -207,6 +221,57 @@ is_sqlite3(const char *path) {
 	return sqlite3;
 }
 #endif
+/*
+ * Bytes of the caches of the tag files which are open now.
+ */
+static long cache_in_use;
+/**
+ * decide_cachesize: decide the cache size of a tag file.
+ *
+ *	@param[in]	path	database name, NULL: temporary file
+ *	@param[in]	mode	0: read only, 1: create, 2: modify
+ *	@return		cache size in bytes
+ *
+ * GTAGSCACHE (default 50MB, see libutil/gparam.h) is the ceiling of
+ * the caches of all the tag files open at a time. A file takes what it
+ * can use, but at most half of what is left, so that the files opened
+ * after it are not starved:
+ *
+ *	read only:	the file size. A query never needs more, and the
+ *			cache of a small file stays small.
+ *	modify:		twice the file size, for the records added.
+ *	create:		unknown, half of what is left.
+ *
+ * Since the pages of a cache are allocated when they are used, the
+ * memory of a file is also bounded by its size. Sorted writing, which
+ * gtags uses to create tag files, needs few pages in any case: records
+ * are added in key order and only the right edge of the tree is hot.
+ */
+static int
+decide_cachesize(const char *path, int mode)
+{
+	long ceiling = GTAGSCACHE;
+	long size = -1, cachesize;
+
+	if (getenv("GTAGSCACHE") != NULL)
+		ceiling = atol(getenv("GTAGSCACHE"));
+	if (mode != 1 && path != NULL) {
+		struct stat st;
+
+		if (stat(path, &st) == 0)
+			size = (long)st.st_size;
+	}
+	cachesize = (ceiling - cache_in_use) / 2;
+	if (size >= 0) {
+		if (mode == 2)
+			size *= 2;
+		if (size < cachesize)
+			cachesize = size;
+	}
+	if (cachesize < GTAGSMINCACHE)
+		cachesize = GTAGSMINCACHE;
+	return (int)cachesize;
+}
 /**
  * dbop_open: open db database.
  *
@@ -222,17 +287,42 @@ is_sqlite3(const char *path) {
  */
 DBOP *
 dbop_open(const char *path, int mode, int perm, int flags)
+{
+	return dbop_open_pagesize(path, mode, perm, flags, 0);
+}
+/**
+ * dbop_open_pagesize: open db database with the specified page size.
+ *
+ *	@param[in]	path	database name
+ *	@param[in]	mode	0: read only, 1: create, 2: modify
+ *	@param[in]	perm	file permission
+ *	@param[in]	flags	the same as dbop_open()
+ *	@param[in]	pagesize	page size of a new file, 0: #DBOP_PAGESIZE
+ *	@return		descripter for dbop_xxx() or NULL
+ *
+ * The page size is recorded in the file and is used only when creating it.
+ * An existing file is always read with its own page size.
+ */
+DBOP *
+dbop_open_pagesize(const char *path, int mode, int perm, int flags, int pagesize)
 {
 	DB *db;
 	int rw = 0;
 	DBOP *dbop;
 	BTREEINFO info;
 
+	if (pagesize == 0)
+		pagesize = DBOP_PAGESIZE;
 #ifdef USE_SQLITE3
 	if (mode != 1 && is_sqlite3(path))
 		flags |= DBOP_SQLITE3;
 	if (flags & DBOP_SQLITE3) {
-		dbop = dbop3_open(path, mode, perm, flags);
+		/*
+		 * The bloom filter is not maintained for sqlite3.
+		 */
+		if (mode != 0 && path != NULL && (flags & DBOP_BLOOM))
+			bloom_remove(path);
+		dbop = dbop3_open(path, mode, perm, flags, pagesize);
 		goto finish;
 	}
 #endif
@@ -253,18 +343,20 @@ dbop_open(const char *path, int mode, int perm, int flags)
 		assert(0);
 	}
 	memset(&info, 0, sizeof(info));
+	/*
+	 * A new tag file with duplicate records may store each key once per
+	 * run in a leaf page. It is optional, since older versions of GLOBAL
+	 * cannot read such a file. Existing files keep their own layout.
+	 */
 	if (flags & DBOP_DUP)
 		info.flags |= R_DUP;
-	info.psize = DBOP_PAGESIZE;
+	if (flags & DBOP_FOLDDUP)
+		info.flags |= R_FOLDDUP;
+	info.psize = pagesize;
 	/*
-	 * Decide cache size. The default value is 5MB.
-	 * See libutil/gparam.h for the details.
+	 * Decide cache size. See decide_cachesize() for the details.
 	 */
-	info.cachesize = GTAGSCACHE;
-	if (getenv("GTAGSCACHE") != NULL)
-		info.cachesize = atoi(getenv("GTAGSCACHE"));
-	if (info.cachesize < GTAGSMINCACHE)
-		info.cachesize = GTAGSMINCACHE;
+	info.cachesize = decide_cachesize(path, mode);
 
 	/*
 	 * if unlink do job normally, those who already open tag file can use
@@ -272,7 +364,29 @@ dbop_open(const char *path, int mode, int perm, int flags)
 	 */
 	if (path != NULL && mode == 1 && test("f", path))
 		(void)unlink(path);
+#ifndef USE_DB185_COMPAT
+	/*
+	 * A sorted table is read through the same DB interface.
+	 */
+	if (mode != 1 && path != NULL && is_sstable(path)) {
+		if (mode != 0)
+			die("'%s' is a read only sstable. Please convert it with 'gtags --format=btree'.", path);
+		flags |= DBOP_SSTABLE;
+		info.cachesize = 0;
+		db = sstable_open(path, rw, 0, 0);
+	} else {
+		/*
+		 * Readers share the pages they read through a shared memory
+		 * segment of GTAGSSHAREDCACHE bytes, if it is specified.
+		 */
+		if (mode == 0 && path != NULL && getenv("GTAGSSHAREDCACHE") != NULL &&
+		    atol(getenv("GTAGSSHAREDCACHE")) > 0)
+			info.shmsize = atol(getenv("GTAGSSHAREDCACHE"));
+		db = dbopen(path, info.shmsize > 0 ? rw | DB_SHMEM : rw, 0600, DB_BTREE, &info);
+	}
+#else
 	db = dbopen(path, rw, 0600, DB_BTREE, &info);
+#endif
 	if (!db)
 		return NULL;
 	/*
@@ -294,13 +408,30 @@ dbop_open(const char *path, int mode, int perm, int flags)
 		dbop->dbname[0] = '\0';
 	else
 		strlimcpy(dbop->dbname, path, sizeof(dbop->dbname));
+	dbop->mode	= mode;
 	dbop->db	= db;
 	dbop->openflags	= flags;
 	dbop->perm	= (mode == 1) ? perm : 0;
+	dbop->pagesize	= pagesize;
+	dbop->cachesize	= info.cachesize;
+	cache_in_use += dbop->cachesize;
 	dbop->lastdat	= NULL;
 	dbop->lastsize	= 0;
 	dbop->sortout	= NULL;
 	dbop->sortin	= NULL;
+	if (mode != 0 && path != NULL && (flags & DBOP_BLOOM))
+		dbop->bloom = bloom_open(path, mode);
+#if !defined(USE_DB185_COMPAT)
+	/*
+	 * An existing file keeps the page size it was made with.
+	 */
+	if (mode != 1 && path != NULL) {
+		int n = dbpagesize(db);
+
+		if (n > 0)
+			dbop->pagesize = n;
+	}
+#endif
 	/*
 	 * Setup sorted writing.
 	 */
@@ -378,6 +509,8 @@ dbop_put(DBOP *dbop, const char *name, const char *data)
 		putc('\n', dbop->sortout);
 		return;
 	}
+	if (dbop->bloom && !ismeta(name))
+		bloom_add(dbop->bloom, name);
 	key.data = (char *)name;
 	key.size = len+1;
 	dat.data = (char *)data;
@@ -785,11 +918,77 @@ dbop_putversion(DBOP *dbop, int version)
 	snprintf(number, sizeof(number), "%d", version);
 	dbop_putoption(dbop, VERSIONKEY, number);
 }
+/**
+ * dbop_getgeneration: get generation
+ *
+ * The tag files published together by an update have the same generation.
+ * A tag file which has never been updated is of generation 0.
+ */
+int
+dbop_getgeneration(DBOP *dbop)
+{
+	const char *p;
+
+	if ((p = dbop_getoption(dbop, GENERATIONKEY)) != NULL)
+		return atoi(p);
+	return 0;
+}
+/**
+ * dbop_putgeneration: put generation
+ */
+void
+dbop_putgeneration(DBOP *dbop, int generation)
+{
+	char number[32];
+
+	/* A tag file allowing duplicate records would keep the old one. */
+	dbop_delete(dbop, GENERATIONKEY);
+	snprintf(number, sizeof(number), "%d", generation);
+	dbop_putoption(dbop, GENERATIONKEY, number);
+}
 /**
  * dbop_close: close db
  * 
  *	@param[in]	dbop	dbop descripter
  */
+/**
+ * dbop_statistics: pass the counters of the tag file to statistics_db().
+ *
+ *	@param[in]	dbop	dbop descripter
+ *
+ * The cache is written out first, so that the writes by close are counted.
+ */
+static void
+dbop_statistics(DBOP *dbop)
+{
+	STATISTICS_DB count;
+
+	memset(&count, 0, sizeof(count));
+	count.readcount = dbop->readcount;
+	count.pagesize = dbop->pagesize;
+#if !defined(USE_DB185_COMPAT)
+#ifdef USE_SQLITE3
+	if (!(dbop->openflags & DBOP_SQLITE3))
+#endif
+	{
+		DB *db = dbop->db;
+		DBSTAT st;
+
+		if (dbop->mode != 0)
+			(void)db->sync(db, 0);
+		if (((dbop->openflags & DBOP_SSTABLE) ? sstable_stat(db, &st) : dbstat(db, &st)) == RET_SUCCESS) {
+			count.pageget = st.pageget;
+			count.cachehit = st.cachehit;
+			count.pageshared = st.pageshared;
+			count.pageread = st.pageread + st.pagereadahead;
+			count.pagewrite = st.pagewrite;
+			count.pagesize = st.psize;
+			count.depth = st.levels;
+		}
+	}
+#endif
+	statistics_db(dbop->dbname, &count);
+}
 void
 dbop_close(DBOP *dbop)
 {
@@ -826,6 +1025,23 @@ dbop_close(DBOP *dbop)
 		strbuf_close(sb);
 		terminate_sort_process(dbop);
 	}
+	if (dbop->dbname[0] != '\0')
+		dbop_statistics(dbop);
+	cache_in_use -= dbop->cachesize;
+	/*
+	 * Make the bloom filter from all the keys if it cannot be updated.
+	 */
+	if (dbop->bloom && bloom_rebuild(dbop->bloom)) {
+		DBT key, dat;
+		int status;
+
+		for (status = (*db->seq)(db, &key, &dat, R_FIRST); status == RET_SUCCESS;
+		     status = (*db->seq)(db, &key, &dat, R_NEXT))
+			if (!ismeta(key.data))
+				bloom_add(dbop->bloom, key.data);
+		if (status == RET_ERROR)
+			die("cannot read '%s'.", dbop->dbname);
+	}
 #ifdef USE_SQLITE3
 	if (dbop->openflags & DBOP_SQLITE3) {
 		dbop3_close(dbop);
@@ -844,11 +1060,118 @@ dbop_close(DBOP *dbop)
 		if (dbop->perm && chmod(dbop->dbname, dbop->perm) < 0)
 			die("chmod(2) failed.");
 	}
+	/*
+	 * The filter is written after the tag file. See libutil/bloom.h.
+	 */
+	if (dbop->bloom)
+		bloom_close(dbop->bloom);
 	(void)free(dbop);
 }
+/**
+ * dbop_convert: convert a tag file into a B-tree or a sorted table.
+ *
+ *	@param[in]	path	database name
+ *	@param[in]	flags
+ *			DBOP_DUP: the file has duplicate records.
+ *			DBOP_SSTABLE: convert into a sorted table,
+ *			otherwise into a B-tree.
+ *			DBOP_FOLDDUP: fold duplicate keys of the B-tree.
+ *	@param[in]	pagesize	page size of a B-tree, 0: #DBOP_PAGESIZE
+ *
+ * The records are copied in key order into a new file, which replaces
+ * the original one. The permission and the time stamps are kept, since
+ * incremental updating compares the modification time of GTAGS with
+ * that of the source files. A file already in the format is left as is.
+ * The bloom filter of the file is kept for the new file.
+ */
+void
+dbop_convert(const char *path, int flags, int pagesize)
+{
+#ifdef USE_DB185_COMPAT
+	if (flags & DBOP_SSTABLE)
+		die("sorted tables are not available with the DB185 compatible mode.");
+#else
+	char tmp[MAXPATHLEN];
+	BTREEINFO info;
+	DB *src, *dst;
+	DBT key, dat;
+	BLOOM *bloom;
+	struct stat st;
+	struct utimbuf times;
+	int status, sstable = is_sstable(path);
+
+	if ((flags & DBOP_SSTABLE) ? sstable : !sstable)
+		return;
+	bloom = bloom_open(path, 2);
+	if (stat(path, &st) < 0)
+		die("cannot stat '%s'.", path);
+	memset(&info, 0, sizeof(info));
+	info.cachesize = decide_cachesize(path, 0);
+	if (sstable)
+		src = sstable_open(path, O_RDONLY, 0, 0);
+	else
+		src = dbopen(path, O_RDONLY, 0, DB_BTREE, &info);
+	if (src == NULL)
+		die("cannot open '%s'.", path);
+	snprintf(tmp, sizeof(tmp), "%s.new", path);
+	(void)unlink(tmp);
+	if (flags & DBOP_SSTABLE) {
+		dst = sstable_open(tmp, O_RDWR|O_CREAT|O_TRUNC, 0600, 0);
+	} else {
+		if (flags & DBOP_DUP)
+			info.flags |= R_DUP;
+		if (flags & DBOP_FOLDDUP)
+			info.flags |= R_FOLDDUP;
+		info.psize = pagesize ? pagesize : DBOP_PAGESIZE;
+		dst = dbopen(tmp, O_RDWR|O_CREAT|O_TRUNC, 0600, DB_BTREE, &info);
+	}
+	if (dst == NULL)
+		die("cannot make '%s'.", tmp);
+	for (status = (*src->seq)(src, &key, &dat, R_FIRST); status == RET_SUCCESS;
+	     status = (*src->seq)(src, &key, &dat, R_NEXT))
+		if ((*dst->put)(dst, &key, &dat, 0) == RET_ERROR)
+			die("cannot write '%s'.", tmp);
+	if (status == RET_ERROR)
+		die("cannot read '%s'.", path);
+	(void)(*src->close)(src, 0);
+	if ((*dst->close)(dst, 0) == RET_ERROR)
+		die("cannot write '%s'.", tmp);
+	if (chmod(tmp, st.st_mode & 07777) < 0)
+		die("chmod(2) failed.");
+	times.actime = st.st_atime;
+	times.modtime = st.st_mtime;
+	if (utime(tmp, &times) < 0)
+		die("utime(2) failed.");
+#ifdef _WIN32
+	(void)unlink(path);
+#endif
+	if (rename(tmp, path) < 0)
+		die("cannot rename '%s' to '%s'.", tmp, path);
+	bloom_close(bloom);
+#endif
+}
+/**
+ * dbop_unshare: remove the shared cache of the tag files in a directory.
+ *
+ *	@param[in]	path	path of a tag file in the directory
+ *
+ * The readers share the pages through shared memory segments (see
+ * GTAGSSHAREDCACHE in dbop_open()), which are left after they exit.
+ * The pages of the rewritten tag files are useless, so the segments are
+ * removed when the tag files are made or updated. The readers using
+ * them at that time are not affected.
+ */
+void
+dbop_unshare(const char *path)
+{
+#ifndef USE_DB185_COMPAT
+	if (dbshmunlink(path) < 0 && errno != ENOSYS)
+		warning("cannot remove the shared cache of '%s'.", path);
+#endif
+}
 #ifdef USE_SQLITE3
 DBOP *
-dbop3_open(const char *path, int mode, int perm, int flags) {
+dbop3_open(const char *path, int mode, int perm, int flags, int pagesize) {
 	int rc, rw = 0;
 	char *errmsg = 0;
 	DBOP *dbop;
@@ -908,6 +1231,7 @@ dbop3_open(const char *path, int mode, int perm, int flags) {
 	dbop->db3       = db3;
 	dbop->openflags	= flags;
 	dbop->perm	= (mode == 1) ? perm : 0;
+	dbop->pagesize	= pagesize;
 	dbop->mode      = mode;
 	dbop->lastdat	= NULL;
 	dbop->lastflag	= NULL;
@@ -917,10 +1241,11 @@ dbop3_open(const char *path, int mode, int perm, int flags) {
 	dbop->stmt      = NULL;
 	dbop->tblname   = check_strdup(tblname);
 	/*
-	 * Maximum file size is DBOP_PAGESIZE * 2147483646.
-	 * if DBOP_PAGESIZE == 8192 then maximum file size is 17592186028032 (17T).
+	 * Maximum file size is pagesize * 2147483646.
+	 * if pagesize == 8192 then maximum file size is 17592186028032 (17T).
+	 * It is ignored by an existing file.
 	 */
-	snprintf(buf, sizeof(buf), "pragma page_size=%d", DBOP_PAGESIZE);
+	snprintf(buf, sizeof(buf), "pragma page_size=%d", pagesize);
 	rc = sqlite3_exec(dbop->db3, buf,  NULL, NULL, &errmsg);
 	if (rc != SQLITE_OK)
 		die("pragma page_size error: %s", errmsg);
@@ -954,15 +1279,11 @@ dbop3_open(const char *path, int mode, int perm, int flags) {
 		die("pragma synchronous=off error: %s", errmsg);
 	*/
 	/*
-         * Decide cache size.
-         * See libutil/gparam.h for the details.
+         * Decide cache size. See decide_cachesize() for the details.
          */
-	cache_size = GTAGSCACHE;
-	if (getenv("GTAGSCACHE") != NULL)
-		cache_size = atoi(getenv("GTAGSCACHE"));
-	if (cache_size < GTAGSMINCACHE)
-		cache_size = GTAGSMINCACHE;
-	cache_size = (cache_size + DBOP_PAGESIZE - 1) / DBOP_PAGESIZE;
+	dbop->cachesize = decide_cachesize(path[0] ? path : NULL, mode);
+	cache_in_use += dbop->cachesize;
+	cache_size = (dbop->cachesize + pagesize - 1) / pagesize;
 	snprintf(buf, sizeof(buf), "pragma cache_size=%d", cache_size);
 	rc = sqlite3_exec(dbop->db3, buf,  NULL, NULL, &errmsg);
        	if (rc != SQLITE_OK)
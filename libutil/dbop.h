@@ -21,6 +21,7 @@
 #ifndef _DBOP_H_
 #define _DBOP_H_
 
+#include "bloom.h"
 #include "gparam.h"
 #ifdef USE_DB185_COMPAT
 #include <db_185.h>
@@ -37,11 +38,15 @@
 typedef void* HANDLE;
 #endif
 
+/** default page size, and the range which can be specified */
 #define DBOP_PAGESIZE	8192
+#define DBOP_MINPAGESIZE	512
+#define DBOP_MAXPAGESIZE	32768
 #ifdef USE_SQLITE3
 #define DBOP_COMMIT_THRESHOLD	800
 #endif
 #define VERSIONKEY	" __.VERSION"
+#define GENERATIONKEY	" __.GENERATION"
 
 typedef	struct {
 	/*
@@ -67,6 +72,9 @@ typedef	struct {
 	int keylen;			/**< key length */
 	char prev[MAXKEYLEN];		/**< previous key value */
 	int perm;			/**< file permission */
+	int pagesize;			/**< page size of the file */
+	int cachesize;			/**< bytes of the cache */
+	BLOOM *bloom;			/**< bloom filter of the keys */
 
 	/*
 	 * (3) sorted write
@@ -112,6 +120,12 @@ typedef	struct {
 #define DBOP_RAW		4
 			/** sorted write */
 #define DBOP_SORTED_WRITE	8
+			/** read only sorted table (set by dbop_open) */
+#define DBOP_SSTABLE		16
+			/** maintain the bloom filter of the keys */
+#define DBOP_BLOOM		32
+			/** fold duplicate keys in leaf pages (new B-tree) */
+#define DBOP_FOLDDUP		64
 
 /*
  * ioflags
@@ -122,6 +136,7 @@ typedef	struct {
 #define DBOP_PREFIX		2
 
 DBOP *dbop_open(const char *, int, int, int);
+DBOP *dbop_open_pagesize(const char *, int, int, int, int);
 const char *dbop_get(DBOP *, const char *);
 void dbop_put(DBOP *, const char *, const char *);
 void dbop_put_tag(DBOP *, const char *, const char *);
@@ -137,6 +152,10 @@ const char *dbop_getoption(DBOP *, const char *);
 void dbop_putoption(DBOP *, const char *, const char *);
 int dbop_getversion(DBOP *);
 void dbop_putversion(DBOP *, int);
+int dbop_getgeneration(DBOP *);
+void dbop_putgeneration(DBOP *, int);
 void dbop_close(DBOP *);
+void dbop_convert(const char *, int, int);
+void dbop_unshare(const char *);
 
 #endif /* _DBOP_H_ */
@@ -0,0 +1,364 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#include <zlib.h>
+#define USE_ZLIB 1
+#endif
+
+#include "checkalloc.h"
+#include "dictzip.h"
+#include "die.h"
+#include "pool.h"
+#include "strbuf.h"
+#include "strhash.h"
+
+/*
+ * Dictionary compression module
+ *
+ * The abbreviation of compress.c replaces only the tag name and a few
+ * words in a line image. The rest of it, types, keywords and indentation,
+ * is common among the line images of a project, but a line image is too
+ * short to be compressed by itself. So, each line image is compressed by
+ * raw deflate of zlib whose window is preset to a dictionary made of the
+ * most frequent line images of the project. A line image is uncompressed
+ * by itself, only when it is printed.
+ *
+ * PROTOCOL:
+ *
+ *	meta record: " __.COMPDICT <dictionary>"
+ *
+ *	line image		record
+ *	-----------------------------------------
+ *	compressed		\002<deflated data>
+ *	begins with \002, \003	\003<line image>
+ *	others			<line image>
+ *
+ *	A line image is compressed only when it gets shorter. Since a record
+ *	cannot include '\0' and '\n', the following bytes are escaped in the
+ *	deflated data and the dictionary.
+ *
+ *	byte		escaped
+ *	-----------------------------------------
+ *	\0		\001\001
+ *	\001		\001\002
+ *	\n		\001\003
+ *	\r		\001\004
+ *
+ * TRAINING:
+ *	gtags(1) samples the first DICTZIP_SAMPLE line images, and concatenates
+ *	the most frequent ones up to DICTZIP_SIZE bytes. The most frequent
+ *	one is put at the end, since deflate encodes a near match shorter.
+ */
+#define DZ_ESCAPE	'\001'
+#define DZ_COMPRESSED	'\002'
+#define DZ_RAW		'\003'
+		/** window of deflate, which covers the dictionary and a line image */
+#define DZ_WBITS	13
+#define DZ_MEMLEVEL	6
+#define SAMPLEBUCKETS	2048
+
+static const char special[] = {'\0', '\001', '\n', '\r'};
+static STRBUF *dict;			/**< dictionary */
+static STRHASH *samples;		/**< line image => count */
+static POOL *sample_pool;
+static int nsamples;
+#ifdef USE_ZLIB
+static z_stream zout, zin;
+static int zout_ready, zin_ready;
+static unsigned char *zdata;		/**< deflated data */
+static int zdatasize;
+static STRBUF *zbuf;			/**< unescaped data */
+#endif
+
+/**
+ * escape: put bytes escaping the special bytes.
+ *
+ *	@param[out]	sb	string buffer
+ *	@param[in]	s	bytes
+ *	@param[in]	len	length of bytes
+ */
+static void
+escape(STRBUF *sb, const char *s, int len)
+{
+	int i;
+
+	for (; len-- > 0; s++) {
+		for (i = 0; i < sizeof(special); i++)
+			if (*s == special[i])
+				break;
+		if (i < sizeof(special)) {
+			strbuf_putc(sb, DZ_ESCAPE);
+			strbuf_putc(sb, i + 1);
+		} else
+			strbuf_putc(sb, *s);
+	}
+}
+/**
+ * unescape: put bytes unescaping the special bytes.
+ *
+ *	@param[out]	sb	string buffer
+ *	@param[in]	s	escaped string
+ *	@return		0: normal, -1: broken
+ */
+static int
+unescape(STRBUF *sb, const char *s)
+{
+	for (; *s; s++) {
+		if (*s == DZ_ESCAPE) {
+			s++;
+			if (*s < 1 || *s > sizeof(special))
+				return -1;
+			strbuf_putc(sb, special[*s - 1]);
+		} else
+			strbuf_putc(sb, *s);
+	}
+	return 0;
+}
+/**
+ * dictzip_open: setup the dictionary.
+ *
+ *	@param[in]	text	escaped dictionary of the meta record,
+ *			NULL: train a new dictionary by dictzip_sample()
+ */
+void
+dictzip_open(const char *text)
+{
+#ifdef USE_ZLIB
+	dict = strbuf_open(DICTZIP_SIZE);
+	zbuf = strbuf_open(0);
+	if (text == NULL) {
+		samples = strhash_open(SAMPLEBUCKETS);
+		sample_pool = pool_open();
+		nsamples = 0;
+	} else if (unescape(dict, text) < 0)
+		die("The dictionary of line images is broken.");
+#else
+	die("The line images are compressed with a dictionary, but zlib is not available.");
+#endif
+}
+/**
+ * dictzip_sample: count a line image to train the dictionary.
+ *
+ *	@param[in]	image	line image
+ *	@return		number of the line images counted
+ */
+int
+dictzip_sample(const char *image)
+{
+	struct sh_entry *entry = strhash_assign(samples, image, 1);
+
+	if (entry->value == NULL) {
+		entry->value = pool_malloc(sample_pool, sizeof(int));
+		*(int *)entry->value = 0;
+	}
+	(*(int *)entry->value)++;
+	return ++nsamples;
+}
+/**
+ * compare_sample: compare function for sorting samples.
+ * More frequent one comes first.
+ */
+static int
+compare_sample(const void *s1, const void *s2)
+{
+	const struct sh_entry *e1 = *(const struct sh_entry *const *)s1;
+	const struct sh_entry *e2 = *(const struct sh_entry *const *)s2;
+	int c1 = *(int *)e1->value;
+	int c2 = *(int *)e2->value;
+
+	if (c1 != c2)
+		return c2 - c1;
+	return strcmp(e1->name, e2->name);
+}
+/**
+ * dictzip_train: make the dictionary from the samples.
+ *
+ *	@param[out]	sb	escaped dictionary is appended for the meta record
+ *
+ * The dictionary is used by dictzip_nputs() after this.
+ */
+void
+dictzip_train(STRBUF *sb)
+{
+	struct sh_entry **array, *entry;
+	int i, n = 0, m = 0, size = 0;
+
+	array = check_malloc(sizeof(*array) * (nsamples + 1));
+	for (entry = strhash_first(samples); entry; entry = strhash_next(samples))
+		array[n++] = entry;
+	qsort(array, n, sizeof(*array), compare_sample);
+	/*
+	 * Pick up the most frequent line images which fit in the dictionary.
+	 */
+	for (i = 0; i < n; i++) {
+		int length = strlen(array[i]->name);
+
+		if (size + length > DICTZIP_SIZE)
+			continue;
+		size += length;
+		array[m++] = array[i];
+	}
+	/* the most frequent one at the end */
+	while (m-- > 0)
+		strbuf_puts(dict, array[m]->name);
+	free(array);
+	strhash_close(samples);
+	pool_close(sample_pool);
+	samples = NULL;
+	sample_pool = NULL;
+	escape(sb, strbuf_value(dict), strbuf_getlen(dict));
+}
+/**
+ * dictzip_nputs: put a line image compressing with the dictionary.
+ *
+ *	@param[out]	sb	string buffer
+ *	@param[in]	text	line image
+ *	@param[in]	len	length of the line image
+ */
+void
+dictzip_nputs(STRBUF *sb, const char *text, int len)
+{
+#ifdef USE_ZLIB
+	int i, length;
+
+	if (!zout_ready) {
+		if (deflateInit2(&zout, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -DZ_WBITS, DZ_MEMLEVEL, Z_DEFAULT_STRATEGY) != Z_OK)
+			die("deflateInit2 failed.");
+		zout_ready = 1;
+	} else if (deflateReset(&zout) != Z_OK)
+		die("deflateReset failed.");
+	if (strbuf_getlen(dict) > 0
+	    && deflateSetDictionary(&zout, (const Bytef *)strbuf_value(dict), strbuf_getlen(dict)) != Z_OK)
+		die("deflateSetDictionary failed.");
+	length = deflateBound(&zout, len);
+	if (zdatasize < length) {
+		zdatasize = length + 1024;
+		zdata = check_realloc(zdata, zdatasize);
+	}
+	zout.next_in = (Bytef *)text;
+	zout.avail_in = len;
+	zout.next_out = zdata;
+	zout.avail_out = zdatasize;
+	if (deflate(&zout, Z_FINISH) != Z_STREAM_END)
+		die("deflate failed.");
+	length = zout.total_out;
+	for (i = 0; i < zout.total_out; i++)
+		if (memchr(special, zdata[i], sizeof(special)))
+			length++;
+	if (length + 1 < len) {
+		strbuf_putc(sb, DZ_COMPRESSED);
+		escape(sb, (const char *)zdata, zout.total_out);
+		return;
+	}
+#endif
+	if (len > 0 && (*text == DZ_COMPRESSED || *text == DZ_RAW))
+		strbuf_putc(sb, DZ_RAW);
+	strbuf_nputs(sb, text, len);
+}
+/**
+ * dictzip_uncompress: uncompress a line image.
+ *
+ *	@param[in]	text	line image of a record
+ *	@param[out]	sb	string buffer
+ *	@return		uncompressed line image
+ */
+const char *
+dictzip_uncompress(const char *text, STRBUF *sb)
+{
+#ifdef USE_ZLIB
+	char out[1024];
+	int status;
+#endif
+
+	if (*text == DZ_RAW)
+		return text + 1;
+	if (*text != DZ_COMPRESSED)
+		return text;
+#ifdef USE_ZLIB
+	strbuf_reset(zbuf);
+	if (unescape(zbuf, text + 1) < 0)
+		die("invalid compressed line image.");
+	if (!zin_ready) {
+		if (inflateInit2(&zin, -MAX_WBITS) != Z_OK)
+			die("inflateInit2 failed.");
+		zin_ready = 1;
+	} else if (inflateReset(&zin) != Z_OK)
+		die("inflateReset failed.");
+	if (strbuf_getlen(dict) > 0
+	    && inflateSetDictionary(&zin, (const Bytef *)strbuf_value(dict), strbuf_getlen(dict)) != Z_OK)
+		die("inflateSetDictionary failed.");
+	zin.next_in = (Bytef *)strbuf_value(zbuf);
+	zin.avail_in = strbuf_getlen(zbuf);
+	strbuf_reset(sb);
+	do {
+		zin.next_out = (Bytef *)out;
+		zin.avail_out = sizeof(out);
+		status = inflate(&zin, Z_NO_FLUSH);
+		if (status != Z_OK && status != Z_STREAM_END)
+			die("invalid compressed line image.");
+		strbuf_nputs(sb, out, sizeof(out) - zin.avail_out);
+	} while (status != Z_STREAM_END);
+	return strbuf_value(sb);
+#else
+	die("The line images are compressed with a dictionary, but zlib is not available.");
+	return NULL;
+#endif
+}
+/**
+ * dictzip_close: free allocated memory.
+ */
+void
+dictzip_close(void)
+{
+#ifdef USE_ZLIB
+	if (zout_ready)
+		(void)deflateEnd(&zout);
+	if (zin_ready)
+		(void)inflateEnd(&zin);
+	zout_ready = zin_ready = 0;
+	if (zdata)
+		free(zdata);
+	zdata = NULL;
+	zdatasize = 0;
+	if (zbuf)
+		strbuf_close(zbuf);
+	zbuf = NULL;
+#endif
+	if (samples)
+		strhash_close(samples);
+	if (sample_pool)
+		pool_close(sample_pool);
+	samples = NULL;
+	sample_pool = NULL;
+	if (dict)
+		strbuf_close(dict);
+	dict = NULL;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _DICTZIP_H
+#define _DICTZIP_H
+
+#include "strbuf.h"
+
+/*
+ * Compression of line images with a dictionary (GTAGS_COMPDICT).
+ *
+ * Each line image is compressed by itself with zlib, using a dictionary
+ * made of the line images sampled from the project. See dictzip.c.
+ */
+		/** size of the dictionary */
+#define DICTZIP_SIZE		4096
+		/** number of the line images to train the dictionary */
+#define DICTZIP_SAMPLE		20000
+
+void dictzip_open(const char *);
+int dictzip_sample(const char *);
+void dictzip_train(STRBUF *);
+void dictzip_nputs(STRBUF *, const char *, int);
+const char *dictzip_uncompress(const char *, STRBUF *);
+void dictzip_close(void);
+
+#endif /* ! _DICTZIP_H */
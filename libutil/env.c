@@ -108,6 +108,7 @@ static const char *envname[] = {
 	"GTAGSGTAGS",
 	/*"GTAGSLABEL",*/
 	"GTAGSLIBPATH",
+	"GTAGSSHAREDCACHE",
 	"GTAGSLOGGING",
 	/*"GTAGSROOT",*/
 	"GTAGSOBJDIR",
@@ -40,6 +40,10 @@
 #else
 #include <sys/file.h>
 #endif
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#include <zlib.h>
+#define USE_ZLIB
+#endif
 
 #include "checkalloc.h"
 #include "die.h"
@@ -67,6 +71,9 @@ File operation: usage
 	...
 	close_file(fileop);
 
+ [WRITE AT ONCE]
+	write_output_file(path, buf, size);
+
  [READ]
 	FILEOP *fileop = open_input_file(path);
 	FILE *ip = get_descripter(fileop);
@@ -74,7 +81,17 @@ File operation: usage
 	fgets(buf, sizeof(buf), ip);
 	...
 	close_file(fileop);
+
+ [OUTPUT POLICY]
+	set_output_policy(FILEOP_GZIP, distpath, "html");
+	... open_output_file() and close_file() as usual ...
+	close_output_policy();
 */
+static void open_buffer(FILEOP *);
+static void flush_buffer(FILEOP *);
+static int policy_target(const char *);
+static void flush_page(const char *, const char *, size_t);
+static void write_buffer(const char *, const char *, size_t);
 /**
  * open input file.
  *
@@ -107,30 +124,46 @@ open_input_file(const char *path)
 FILEOP *
 open_output_file(const char *path, int compress)
 {
-	FILEOP *fileop;
-	FILE *fp;
+	FILEOP *fileop = check_calloc(sizeof(FILEOP), 1);
 	char command[MAXFILLEN];
 
 	if (compress) {
 		snprintf(command, sizeof(command), "gzip -c >\"%s\"", path);
-		fp = popen(command, "w");
-		if (fp == NULL)
+		fileop->fp = popen(command, "w");
+		if (fileop->fp == NULL)
 			die("cannot execute '%s'.", command);
+	} else if (policy_target(path)) {
+		open_buffer(fileop);
 	} else {
-		fp = fopen(path, "w");
-		if (fp == NULL)
+		fileop->fp = fopen(path, "w");
+		if (fileop->fp == NULL)
 			die("cannot create file '%s'.", path);
 	}
-	fileop = check_calloc(sizeof(FILEOP), 1);
 	strlimcpy(fileop->path, path, sizeof(fileop->path));
 	if (compress)
 		strlimcpy(fileop->command, command, sizeof(fileop->command));
-	fileop->type = FILEOP_OUTPUT;
+	fileop->type |= FILEOP_OUTPUT;
 	if (compress)
 		fileop->type |= FILEOP_COMPRESS;
-	fileop->fp = fp;
 	return fileop;
 }
+/**
+ * write output file at once
+ *
+ *	@param[in]	path	path name
+ *	@param[in]	buf	contents
+ *	@param[in]	size	size of contents
+ *
+ * The output policy is applied as well as open_output_file().
+ */
+void
+write_output_file(const char *path, const char *buf, size_t size)
+{
+	if (policy_target(path))
+		flush_page(path, buf, size);
+	else
+		write_buffer(path, buf, size);
+}
 /**
  * get UNIX file descripter
  *
@@ -152,6 +185,10 @@ close_file(FILEOP *fileop)
 	if (fileop->type & FILEOP_COMPRESS) {
 		if (pclose(fileop->fp) != 0)
 			die("terminated abnormally. '%s'", fileop->command);
+	} else if (fileop->type & FILEOP_BUFFER) {
+		flush_buffer(fileop);
+		flush_page(fileop->path, fileop->buf, fileop->bufsize);
+		free(fileop->buf);
 	} else
 		fclose(fileop->fp);
 	free(fileop);
@@ -260,3 +297,416 @@ read_first_line(const char *com, STRBUF *sb)
 	pclose(ip);
 	return (p == NULL) ? -1 : 0;
 }
+
+/*
+ * Output policy.
+ *
+ * Files which are under the root directory and have the suffix are
+ * written into a memory buffer, and dealt with at close_file() as follows:
+ *
+ *	FILEOP_GZIP:	write 'path' and the compressed sibling 'path.gz'.
+ *	FILEOP_PACK:	append the compressed contents to the pack file
+ *			'<root>/htags.pack' instead of making 'path'.
+ *
+ * Pack file format (integers are little endian):
+ *
+ *	header:	"GHTMLPK1"(8) count(4) flags(4) index offset(8)
+ *	blobs:	contents of each file
+ *	index:	for each file in the order written,
+ *		offset(8) length(4) size(4) encoding(1) reserved(1) namelen(2) name
+ *
+ * 'name' is the path relative to the root directory. 'length' is the
+ * length of the blob and 'size' is the original size. If 'encoding' is 1,
+ * the blob is a complete gzip member, so a server can send it as is with
+ * 'Content-Encoding: gzip'. Without zlib, blobs are stored with 'encoding' 0.
+ */
+#define PACK_MAGIC	"GHTMLPK1"
+#define PACK_HEADERSIZE	24
+
+static int policy;
+static char policy_root[MAXPATHLEN];
+static int policy_rootlen;
+static char policy_suffix[MAXFILLEN];
+static FILE *pack_fp;
+static STRBUF *pack_index;
+static unsigned int pack_count;
+static unsigned long long pack_offset;
+
+static void open_pack(const char *);
+static void put_le(STRBUF *, unsigned long long, int);
+
+/**
+ * set_output_policy: set output policy for open_output_file().
+ *
+ *	@param[in]	flags	FILEOP_GZIP, FILEOP_PACK
+ *	@param[in]	root	root directory
+ *	@param[in]	suffix	suffix of the target files (e.g. "html")
+ */
+void
+set_output_policy(int flags, const char *root, const char *suffix)
+{
+	policy = flags;
+	strlimcpy(policy_root, root, sizeof(policy_root));
+	policy_rootlen = strlen(policy_root);
+	strlimcpy(policy_suffix, suffix, sizeof(policy_suffix));
+	if (policy & FILEOP_PACK)
+		open_pack(makepath(root, FILEOP_PACKNAME, NULL));
+}
+/**
+ * open_pack: create a pack file.
+ *
+ *	@param[in]	path	path of the pack file
+ */
+static void
+open_pack(const char *path)
+{
+	char header[PACK_HEADERSIZE];
+
+	pack_fp = fopen(path, "wb");
+	if (pack_fp == NULL)
+		die("cannot create file '%s'.", path);
+	/* the header is written at close_output_policy() */
+	memset(header, 0, sizeof(header));
+	if (fwrite(header, 1, sizeof(header), pack_fp) != sizeof(header))
+		die("cannot write to the pack file.");
+	pack_index = strbuf_open(0);
+	pack_count = 0;
+	pack_offset = PACK_HEADERSIZE;
+}
+/**
+ * pack_part: path of the pack file of a worker.
+ */
+static const char *
+pack_part(int job)
+{
+	char name[MAXFILLEN];
+
+	snprintf(name, sizeof(name), "%s.%d", FILEOP_PACKNAME, job);
+	return makepath(policy_root, name, NULL);
+}
+/**
+ * fork_output_policy: take over the output policy in a worker process.
+ *
+ *	@param[in]	job	worker number
+ *
+ * A worker cannot append to the pack file of the parent. Instead, it makes
+ * its own pack file '<root>/htags.pack.<job>', which is merged into the
+ * pack file of the parent by join_output_policy(). The worker should call
+ * close_output_policy() at the end.
+ * The parent must flush the pack file before making workers.
+ */
+void
+fork_output_policy(int job)
+{
+	/* the stream of the parent is left as is */
+	if (pack_fp)
+		open_pack(pack_part(job));
+}
+/**
+ * get_le: get an integer in little endian.
+ */
+static unsigned long long
+get_le(const unsigned char *p, int size)
+{
+	unsigned long long val = 0;
+
+	while (size-- > 0)
+		val = (val << 8) | p[size];
+	return val;
+}
+/**
+ * join_output_policy: merge the pack files of workers.
+ *
+ *	@param[in]	jobs	number of workers
+ *
+ * The pack files of workers are removed.
+ */
+void
+join_output_policy(int jobs)
+{
+	STRBUF *sb = strbuf_open(0);
+	const char *path;
+	char buf[BUFSIZ];
+	int job;
+
+	if (!pack_fp)
+		return;
+	for (job = 0; job < jobs; job++) {
+		unsigned char header[PACK_HEADERSIZE];
+		unsigned long long base, rest, index_offset;
+		unsigned int count, i;
+		const unsigned char *p;
+		FILE *ip;
+		size_t n;
+
+		path = pack_part(job);
+		if ((ip = fopen(path, "rb")) == NULL)
+			die("cannot open file '%s'.", path);
+		if (fread(header, 1, sizeof(header), ip) != sizeof(header)
+		    || memcmp(header, PACK_MAGIC, strlen(PACK_MAGIC)))
+			die("invalid pack file '%s'.", path);
+		count = get_le(header + 8, 4);
+		index_offset = get_le(header + 16, 8);
+		/*
+		 * Copy the blobs.
+		 */
+		base = pack_offset;
+		for (rest = index_offset - PACK_HEADERSIZE; rest > 0; rest -= n) {
+			n = fread(buf, 1, rest < sizeof(buf) ? rest : sizeof(buf), ip);
+			if (n == 0)
+				die("invalid pack file '%s'.", path);
+			if (fwrite(buf, 1, n, pack_fp) != n)
+				die("cannot write to the pack file.");
+		}
+		pack_offset += index_offset - PACK_HEADERSIZE;
+		/*
+		 * Copy the index with rebasing the offsets.
+		 */
+		strbuf_reset(sb);
+		while ((n = fread(buf, 1, sizeof(buf), ip)) > 0)
+			strbuf_nputs(sb, buf, n);
+		fclose(ip);
+		p = (const unsigned char *)strbuf_value(sb);
+		for (i = 0; i < count; i++) {
+			int namelen;
+
+			if (p + 20 > (const unsigned char *)strbuf_value(sb) + strbuf_getlen(sb))
+				die("invalid pack file '%s'.", path);
+			namelen = get_le(p + 18, 2);
+			put_le(pack_index, get_le(p, 8) - PACK_HEADERSIZE + base, 8);
+			strbuf_nputs(pack_index, (const char *)p + 8, 12 + namelen);
+			p += 20 + namelen;
+		}
+		pack_count += count;
+		if (unlink(path) < 0)
+			die("cannot remove file '%s'.", path);
+	}
+	strbuf_close(sb);
+}
+/**
+ * put_le: put an integer in little endian.
+ */
+static void
+put_le(STRBUF *sb, unsigned long long val, int size)
+{
+	while (size-- > 0) {
+		strbuf_putc(sb, val & 0xff);
+		val >>= 8;
+	}
+}
+/**
+ * close_output_policy: finish the output policy.
+ *
+ * The pack file is completed here.
+ */
+void
+close_output_policy(void)
+{
+	if (pack_fp) {
+		STRBUF *header = strbuf_open(PACK_HEADERSIZE);
+		int len = strbuf_getlen(pack_index);
+
+		if (fwrite(strbuf_value(pack_index), 1, len, pack_fp) != len)
+			die("cannot write to the pack file.");
+		strbuf_puts(header, PACK_MAGIC);
+		put_le(header, pack_count, 4);
+		put_le(header, 0, 4);
+		put_le(header, pack_offset, 8);
+		if (fseek(pack_fp, 0L, SEEK_SET) < 0
+		    || fwrite(strbuf_value(header), 1, PACK_HEADERSIZE, pack_fp) != PACK_HEADERSIZE
+		    || fclose(pack_fp) != 0)
+			die("cannot write to the pack file.");
+		strbuf_close(header);
+		strbuf_close(pack_index);
+		pack_fp = NULL;
+		pack_index = NULL;
+	}
+	policy = 0;
+}
+/**
+ * policy_target: whether or not the path should be dealt with the output policy
+ */
+static int
+policy_target(const char *path)
+{
+	const char *p;
+
+	if (!policy)
+		return 0;
+	if (strncmp(path, policy_root, policy_rootlen) || path[policy_rootlen] != '/')
+		return 0;
+	p = strrchr(path + policy_rootlen, '.');
+	if (p == NULL || strcmp(p + 1, policy_suffix))
+		return 0;
+	return 1;
+}
+/**
+ * open_buffer: open memory buffer for the file
+ */
+static void
+open_buffer(FILEOP *fileop)
+{
+#ifdef HAVE_OPEN_MEMSTREAM
+	fileop->fp = open_memstream(&fileop->buf, &fileop->bufsize);
+#else
+	fileop->fp = tmpfile();
+#endif
+	if (fileop->fp == NULL)
+		die("cannot open memory buffer.");
+	fileop->type |= FILEOP_BUFFER;
+}
+/**
+ * flush_buffer: close the memory buffer and make the contents available
+ *		in fileop->buf and fileop->bufsize.
+ */
+static void
+flush_buffer(FILEOP *fileop)
+{
+#ifdef HAVE_OPEN_MEMSTREAM
+	if (fclose(fileop->fp) != 0)
+		die("cannot close memory buffer.");
+#else
+	long size;
+
+	if (fflush(fileop->fp) != 0 || (size = ftell(fileop->fp)) < 0)
+		die("cannot flush memory buffer.");
+	fileop->bufsize = size;
+	fileop->buf = check_malloc(size + 1);
+	rewind(fileop->fp);
+	if (fread(fileop->buf, 1, size, fileop->fp) != size)
+		die("cannot read memory buffer.");
+	fclose(fileop->fp);
+#endif
+	fileop->fp = NULL;
+}
+/**
+ * write_buffer: write a buffer to the file.
+ */
+static void
+write_buffer(const char *path, const char *buf, size_t size)
+{
+	int fd = open(path, O_WRONLY|O_CREAT|O_TRUNC|O_BINARY, 0666);
+
+	if (fd < 0)
+		die("cannot create file '%s'.", path);
+	while (size > 0) {
+		ssize_t n = write(fd, buf, size);
+
+		if (n <= 0)
+			die("file write error. '%s'", path);
+		buf += n;
+		size -= n;
+	}
+	close(fd);
+}
+#ifdef USE_ZLIB
+/**
+ * gzip_buffer: compress a buffer into a gzip member.
+ *
+ *	@param[in]	buf	buffer
+ *	@param[in]	size	size of buffer
+ *	@param[out]	outsize	size of compressed data
+ *	@return		compressed data (must be freed by caller)
+ */
+static char *
+gzip_buffer(const char *buf, size_t size, size_t *outsize)
+{
+	z_stream z;
+	char *out;
+	uLong bound;
+
+	memset(&z, 0, sizeof(z));
+	/* 16 + MAX_WBITS: write gzip header and trailer */
+	if (deflateInit2(&z, Z_BEST_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+		die("deflateInit2 failed.");
+	bound = deflateBound(&z, size);
+	out = check_malloc(bound);
+	z.next_in = (Bytef *)buf;
+	z.avail_in = size;
+	z.next_out = (Bytef *)out;
+	z.avail_out = bound;
+	if (deflate(&z, Z_FINISH) != Z_STREAM_END)
+		die("deflate failed.");
+	*outsize = z.total_out;
+	deflateEnd(&z);
+	return out;
+}
+#endif
+/**
+ * pack_append: append a file to the pack file.
+ *
+ *	@param[in]	name	path name relative to the root directory
+ *	@param[in]	buf	contents
+ *	@param[in]	size	size of contents
+ */
+static void
+pack_append(const char *name, const char *buf, size_t size)
+{
+	const char *blob = buf;
+	size_t length = size;
+	int encoding = 0;
+	char *compressed = NULL;
+
+#ifdef USE_ZLIB
+	blob = compressed = gzip_buffer(buf, size, &length);
+	encoding = 1;
+#endif
+	if (size > 0xffffffffUL || length > 0xffffffffUL)
+		die("file too large to pack. '%s'", name);
+	if (fwrite(blob, 1, length, pack_fp) != length)
+		die("cannot write to the pack file.");
+	put_le(pack_index, pack_offset, 8);
+	put_le(pack_index, length, 4);
+	put_le(pack_index, size, 4);
+	strbuf_putc(pack_index, encoding);
+	strbuf_putc(pack_index, 0);
+	put_le(pack_index, strlen(name), 2);
+	strbuf_puts(pack_index, name);
+	pack_offset += length;
+	pack_count++;
+	if (compressed)
+		free(compressed);
+}
+/**
+ * flush_page: write the contents of a file according to the output policy.
+ *
+ *	@param[in]	path	path name
+ *	@param[in]	buf	contents
+ *	@param[in]	size	size of contents
+ */
+static void
+flush_page(const char *path, const char *buf, size_t size)
+{
+	char gzpath[MAXPATHLEN];
+
+	if (policy & FILEOP_PACK) {
+		pack_append(path + policy_rootlen + 1, buf, size);
+		return;
+	}
+	write_buffer(path, buf, size);
+	if (policy & FILEOP_GZIP) {
+		snprintf(gzpath, sizeof(gzpath), "%s.gz", path);
+#ifdef USE_ZLIB
+		{
+			size_t length;
+			char *compressed = gzip_buffer(buf, size, &length);
+
+			write_buffer(gzpath, compressed, length);
+			free(compressed);
+		}
+#else
+		{
+			char command[MAXFILLEN];
+			FILE *op;
+
+			snprintf(command, sizeof(command), "gzip -9 -n -c >\"%s\"", gzpath);
+			if ((op = popen(command, "w")) == NULL)
+				die("cannot execute '%s'.", command);
+			if (fwrite(buf, 1, size, op) != size)
+				die("cannot write to '%s'.", command);
+			if (pclose(op) != 0)
+				die("terminated abnormally. '%s'", command);
+		}
+#endif
+	}
+}
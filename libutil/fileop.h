@@ -31,20 +31,37 @@
 #define FILEOP_INPUT	1
 #define FILEOP_OUTPUT	2
 #define FILEOP_COMPRESS	4
+#define FILEOP_BUFFER	8
+
+/*
+ * Output policy (see set_output_policy()).
+ */
+#define FILEOP_GZIP	1		/**< also write 'path.gz' */
+#define FILEOP_PACK	2		/**< store into the pack file */
+
+/** name of the pack file made in the root directory */
+#define FILEOP_PACKNAME	"htags.pack"
 
 typedef struct {
 	int type;
 	FILE *fp;
 	char command[MAXFILLEN];
 	char path[MAXPATHLEN];
+	char *buf;			/**< buffer for FILEOP_BUFFER */
+	size_t bufsize;
 } FILEOP;
 
 FILEOP *open_input_file(const char *);
 FILEOP *open_output_file(const char *, int);
+void write_output_file(const char *, const char *, size_t);
 FILE *get_descripter(FILEOP *);
 void close_file(FILEOP *);
 void copyfile(const char *, const char *);
 void copydirectory(const char *, const char *);
 int read_first_line(const char *, STRBUF *);
+void set_output_policy(int, const char *, const char *);
+void close_output_policy(void);
+void fork_output_policy(int);
+void join_output_policy(int);
 
 #endif /* ! _FILEOP_H */
@@ -24,6 +24,7 @@
 #endif
 #include <assert.h>
 #include <ctype.h>
+#include <errno.h>
 #ifdef HAVE_DIRENT_H
 #include <sys/types.h>
 #include <dirent.h>
@@ -48,6 +49,8 @@
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 #undef SLIST_ENTRY
+#else
+#include <sys/wait.h>
 #endif
 
 #include "gparam.h"
@@ -67,6 +70,7 @@
 #include "makepath.h"
 #include "path.h"
 #include "strbuf.h"
+#include "strhash.h"
 #include "strlimcpy.h"
 #include "test.h"
 #include "vstack.h"
@@ -94,8 +98,18 @@
  *	find_close();
  *
  */
-static regex_t *skip;			/**< regex for skipping units */
-static regex_t *suff;			/**< regex for suffixes */
+static STRHASH *skip_name;		/**< file names to skip */
+static STRHASH *skip_dir;		/**< directory names to skip */
+static STRHASH *skip_suffix;		/**< suffixes of files to skip */
+static STRHASH *skip_root;		/**< paths from the root to skip */
+static regex_t *skip;			/**< regex for the other skip patterns */
+static int skip_icase;			/**< ignore case of path names */
+static int skip_dotfiles;		/**< skip files which start with '.' */
+static int skip_prepared;
+static STRHASH *suff_hash;		/**< suffixes of source files */
+static regex_t *suff;			/**< regex for glob patterns of source files */
+static int suff_icase;			/**< ignore case of suffixes */
+static int suff_prepared;
 static FILE *ip;
 static FILE *temp;
 static char *rootdir;
@@ -150,19 +164,22 @@ getreason(const char *path)
 	return is_directory << 8 | type;
 }
 /**
- * prepare_source: preparing regular expression.
+ * prepare_source: preparing the suffix table and regular expression.
  *
- *	@return	compiled regular expression for source files.
+ * Suffixes are put into suff_hash, and glob patterns are compiled into
+ * suff. If there is no glob pattern, suff is NULL.
  */
-static regex_t *
+static void
 prepare_source(void)
 {
 	static regex_t suff_area;
 	STRBUF *sb = strbuf_open(0);
+	STRBUF *suffix = strbuf_open(0);
 	char *default_langmap = DEFAULTLANGMAP;
 	char *langmap = default_langmap;
 	char *p;
 	int flags = REG_EXTENDED;
+	int patterns = 0;
 
 	/*
 	 * load icase_path option.
@@ -172,6 +189,8 @@ prepare_source(void)
 #if defined(_WIN32) || defined(__DJGPP__)
 	flags |= REG_ICASE;
 #endif
+	suff_icase = (flags & REG_ICASE) ? 1 : 0;
+	suff_hash = strhash_open(64);
 	/*
 	 * make suffix list.
 	 */
@@ -193,12 +212,10 @@ prepare_source(void)
 		/* pick up a suffix or a glob pattern */
 		while (*p == '.' || *p == '(') {
 			if (*p == '.') {	/* suffix */
-				strbuf_puts(sb, "[^/]+\\.");
-				for (p++; *p && *p != '.' && *p != '(' && *p != ','; p++) {
-					if (!isalnum(*p))
-						strbuf_putc(sb, '\\');
-					strbuf_putc(sb, *p);
-				}
+				strbuf_reset(suffix);
+				for (p++; *p && *p != '.' && *p != '(' && *p != ','; p++)
+					strbuf_putc(suffix, suff_icase ? tolower((unsigned char)*p) : *p);
+				strhash_assign(suff_hash, strbuf_value(suffix), 1);
 			} else if (*p == '(') {	/* glob pattern */
 				for (p++; *p && *p != ')'; p++) {
 					if (*p == '.')
@@ -224,79 +241,150 @@ prepare_source(void)
 				if (*p == 0)
 					die_with_code(2, "syntax error in the langmap '%s'.", langmap);
 				p++;
+				strbuf_putc(sb, '|');
+				patterns++;
 			}
-			strbuf_putc(sb, '|');
 		}
 		if (*p == ',')
 			p++;
 	}
 	strbuf_unputc(sb, '|');
 	strbuf_puts(sb, ")$");
-	if (debug)
-		fprintf(stderr, "prepare_source: %s\n", strbuf_value(sb));
-	if (regcomp(&suff_area, strbuf_value(sb), flags) != 0)
-		die("cannot compile regular expression.");
+	if (patterns > 0) {
+		if (debug)
+			fprintf(stderr, "prepare_source: %s\n", strbuf_value(sb));
+		if (regcomp(&suff_area, strbuf_value(sb), flags) != 0)
+			die("cannot compile regular expression.");
+		suff = &suff_area;
+	}
+	strbuf_close(suffix);
 	strbuf_close(sb);
 	if (langmap != default_langmap)
 		free(langmap);
-	return &suff_area;
+	suff_prepared = 1;
+}
+/**
+ * skip_fold: put a string into a buffer, folding the case if required.
+ *
+ *	@param[out]	sb	string buffer
+ *	@param[in]	s	string
+ *	@param[in]	len	length of the string
+ *	@return		string in the buffer
+ */
+static const char *
+skip_fold(STRBUF *sb, const char *s, int len)
+{
+	strbuf_clear(sb);
+	if (skip_icase) {
+		for (; len-- > 0; s++)
+			strbuf_putc(sb, tolower((unsigned char)*s));
+	} else
+		strbuf_nputs(sb, s, len);
+	return strbuf_value(sb);
+}
+/**
+ * skip_simple: register a simple pattern of the skip list.
+ *
+ *	@param[in]	skipf	an item of the skip list
+ *	@return		1: registered, 0: not a simple pattern
+ *
+ * Simple patterns are matched by hash tables instead of the regular expression.
+ *
+ *	name		skip_name	the last component of a file
+ *	name/		skip_dir	any component of a directory
+ *	*.suffix	skip_suffix	suffix of the last component of a file
+ *	/path[/]	skip_root	path from the root directory
+ */
+static int
+skip_simple(const char *skipf)
+{
+	STATIC_STRBUF(sb);
+	STRHASH *hash;
+	const char *p;
+	int len, slashes = 0;
+
+	if (*skipf == '/') {
+		hash = skip_root;
+		skipf++;
+	} else if (*skipf == '*' && *(skipf + 1) == '.') {
+		hash = skip_suffix;
+		skipf++;			/* the key includes '.' */
+	} else
+		hash = skip_name;
+	if (*skipf == '\0' || *skipf == '/')
+		return 0;
+	for (p = skipf; *p; p++) {
+		if (*p == '*' || *p == '?' || *p == '[' || *p == '\\')
+			return 0;
+		if (*p == '/')
+			slashes++;
+	}
+	len = p - skipf;
+	if (hash == skip_suffix && slashes > 0)
+		return 0;
+	if (hash == skip_name && slashes > 0) {
+		if (slashes > 1 || *(p - 1) != '/')
+			return 0;
+		hash = skip_dir;
+		len--;
+	}
+	strhash_assign(hash, skip_fold(sb, skipf, len), 1);
+	return 1;
 }
 /**
  * prepare_skip: prepare skipping files.
  *
  *	Globals used (output):
- *		listarray[]: 	skip list.
- *		list_count:	 count of skip list.
- *
- *	@return	compiled regular expression for skip files.
+ *		skip_name, skip_dir, skip_suffix, skip_root: simple patterns
+ *		skip: compiled regular expression for the other patterns,
+ *		      NULL if there is no such pattern.
  */
-static regex_t *
+static void
 prepare_skip(void)
 {
 	static regex_t skip_area;
 	char *skiplist;
 	STRBUF *reg = strbuf_open(0);
 	char *p, *q;
+	int db, count = 0;
 	int flags = REG_EXTENDED|REG_NEWLINE;
 
 	/*
 	 * load icase_path option.
 	 */
+	skip_icase = 0;
 	if (getconfb("icase_path"))
-		flags |= REG_ICASE;
+		skip_icase = 1;
 #if defined(_WIN32) || defined(__DJGPP__)
-	flags |= REG_ICASE;
+	skip_icase = 1;
 #endif
+	if (skip_icase)
+		flags |= REG_ICASE;
 	/*
 	 * load skip data.
 	 */
-	if (!getconfs("skip", reg)) {
-		strbuf_close(reg);
-		return NULL;
-	}
+	if (!getconfs("skip", reg))
+		die("prepare_skip failed.");
 	skiplist = check_strdup(strbuf_value(reg));
 	if (debug)
 		fprintf(stderr, "DBG: Original skip list:\n%s\n", skiplist);
 	strbuf_reset(reg);
-	/*
-	 * construct regular expression.
-	 */
-	strbuf_putc(reg, '(');	/* ) */
+	skip_name = strhash_open(64);
+	skip_dir = strhash_open(64);
+	skip_suffix = strhash_open(64);
+	skip_root = strhash_open(64);
 	/*
 	 * Hard coded skip files:
-	 * (1) files which start with '.'
+	 * (1) files which start with '.' (see skip_match())
 	 * (2) tag files
 	 */
-	/* skip files which start with '.' e.g. .cvsignore */
-	if (!accept_dotfiles) {
-		strbuf_puts(reg, "/\\.[^/]+$|");
-		strbuf_puts(reg, "/\\.[^/]+/|");
-	}
-	/* skip tag files */
-	strbuf_puts(reg, "/GTAGS$|");
-	strbuf_puts(reg, "/GRTAGS$|");
-	strbuf_puts(reg, "/GSYMS$|");
-	strbuf_puts(reg, "/GPATH$|");
+	skip_dotfiles = !accept_dotfiles;
+	for (db = 0; db < GTAGLIM; db++)
+		skip_simple(dbname(db));
+	/*
+	 * construct regular expression for the other patterns.
+	 */
+	strbuf_putc(reg, '(');	/* ) */
 	for (p = skiplist; *p; ) {
 		char *skipf;
 		STATIC_STRBUF(sb);
@@ -314,6 +402,9 @@ prepare_skip(void)
 			strbuf_putc(sb, *p);
 		}
 		skipf = strbuf_value(sb);
+		if (skip_simple(skipf))
+			continue;
+		count++;
 		/* '/' means project root directory */
 		if (*skipf == '/') {
 			strbuf_puts(reg, "^\\./");
@@ -381,22 +472,23 @@ prepare_skip(void)
 		}
 		if (*(q - 1) != '/')
 			strbuf_putc(reg, '$');
-		if (*p == ',')
-			strbuf_putc(reg, '|');
+		strbuf_putc(reg, '|');
 	}
 	strbuf_unputc(reg, '|');
 	strbuf_putc(reg, ')');
 	/*
 	 * compile regular expression.
 	 */
-	if (debug)
-		fprintf(stderr, "DBG: Regular expression of the skip list:\n%s\n", strbuf_value(reg));
-	if (regcomp(&skip_area, strbuf_value(reg), flags) != 0)
-		die("cannot compile regular expression.");
+	if (count > 0) {
+		if (debug)
+			fprintf(stderr, "DBG: Regular expression of the skip list:\n%s\n", strbuf_value(reg));
+		if (regcomp(&skip_area, strbuf_value(reg), flags) != 0)
+			die("cannot compile regular expression.");
+		skip = &skip_area;
+	}
 	strbuf_close(reg);
 	free(skiplist);
-
-	return &skip_area;
+	skip_prepared = 1;
 }
 /**
  * issourcefile: check whether or not a source file.
@@ -407,12 +499,99 @@ prepare_skip(void)
 int
 issourcefile(const char *path)
 {
-	if (suff == NULL) {
-		suff = prepare_source();	/* XXX this cannot return NULL */
-		if (suff == NULL)
-			die("prepare_source failed.");
+	STATIC_STRBUF(sb);
+	const char *base, *dot, *p;
+
+	if (!suff_prepared)
+		prepare_source();
+	/*
+	 * The base name should consist of one or more characters,
+	 * a dot and a suffix in the list.
+	 */
+	base = strrchr(path, '/');
+	base = base ? base + 1 : path;
+	dot = strrchr(base, '.');
+	if (dot != NULL && dot > base) {
+		p = dot + 1;
+		if (suff_icase) {
+			strbuf_clear(sb);
+			for (; *p; p++)
+				strbuf_putc(sb, tolower((unsigned char)*p));
+			p = strbuf_value(sb);
+		}
+		if (strhash_assign(suff_hash, p, 0) != NULL)
+			return 1;
 	}
-	if (regexec(suff, path, 0, 0, 0) == 0)
+	if (suff && regexec(suff, path, 0, 0, 0) == 0)
+		return 1;
+	return 0;
+}
+/**
+ * skip_lookup: look up a part of a path name in a hash table.
+ *
+ *	@param[in]	hash	hash table
+ *	@param[in]	s	string
+ *	@param[in]	len	length of the string
+ *	@return		1: found, 0: not found
+ */
+static int
+skip_lookup(STRHASH *hash, const char *s, int len)
+{
+	STATIC_STRBUF(sb);
+
+	if (hash->entries == 0)
+		return 0;
+	strbuf_clear(sb);
+	strbuf_nputs(sb, s, len);
+	return strhash_assign(hash, strbuf_value(sb), 0) != NULL;
+}
+/**
+ * skip_match: check whether or not a path matches the skip list.
+ *
+ *	@param[in]	path	path name (must start with "./")
+ *	@return		1: match, 0: not match
+ *
+ * Each component is looked up in the hash tables, so the regular expression
+ * is only used for the patterns which skip_simple() could not register.
+ */
+static int
+skip_match(const char *path)
+{
+	STATIC_STRBUF(sb);
+	const char *p, *comp, *next, *dot;
+	int len;
+
+	p = skip_icase ? skip_fold(sb, path, strlen(path)) : path;
+	for (comp = strchr(p, '/'); comp != NULL; comp = next) {
+		comp++;
+		next = strchr(comp, '/');
+		len = next ? next - comp : strlen(comp);
+		if (len == 0)
+			break;
+		/* files which start with '.' */
+		if (skip_dotfiles && *comp == '.' && len > 1)
+			return 1;
+		if (next) {
+			if (skip_lookup(skip_dir, comp, len))
+				return 1;
+		} else {
+			if (skip_lookup(skip_name, comp, len))
+				return 1;
+			for (dot = comp; (dot = strchr(dot, '.')) != NULL; dot++)
+				if (skip_lookup(skip_suffix, dot, len - (dot - comp)))
+					return 1;
+		}
+	}
+	if (skip_root->entries > 0 && p[0] == '.' && p[1] == '/') {
+		const char *rel = p + 2;
+
+		if (skip_lookup(skip_root, rel, strlen(rel)))
+			return 1;
+		for (next = rel; (next = strchr(next, '/')) != NULL; next++)
+			if (skip_lookup(skip_root, rel, next - rel + 1))
+				return 1;
+	}
+	if (skip && regexec(skip, path, 0, 0, 0) == 0)
 		return 1;
 	return 0;
 }
@@ -430,32 +609,14 @@ issourcefile(const char *path)
 int
 skipthisfile(const char *path)
 {
-	regmatch_t m;
-	int i;
-
 	/*
 	 * unit check.
 	 */
-	if (skip == NULL) {
-		skip = prepare_skip();
-		if (skip == NULL)
-			die("prepare_skip failed.");
-	}
-	if (regexec(skip, path, 1, &m, 0) == 0) {
-		if (debug) {
-			int len = strlen(path);
-			fprintf(stderr, "DBG: ");
-			for (i = 0; i < len; i++) {
-				if (m.rm_so == i)
-					fputc('[', stderr);
-				if (m.rm_eo == i)
-					fputc(']', stderr);
-				fputc(path[i], stderr);
-			}
-			if (m.rm_eo == len)
-				fputc(']', stderr);
-			fprintf(stderr, " => SKIPPED\n");
-		}
+	if (!skip_prepared)
+		prepare_skip();
+	if (skip_match(path)) {
+		if (debug)
+			fprintf(stderr, "DBG: %s => SKIPPED\n", path);
 		if (find_explain) {
 			int type = getreason(path);
 			const char *kind = (type >> 8) ? "Directory" : "File";
@@ -504,23 +665,43 @@ getrealpath(const char *dir)
 		die("cannot get real path of '%s'.", trimpath(dir));
 	return real;
 }
+/**
+ * getchildrealpath: return a real path of a directory which is not a symbolic link.
+ *
+ *	@param[in]	parent	real path of the parent directory
+ *	@param[in]	name	name of the directory
+ *	@return		real path using allocated area
+ *
+ * This is equal to realpath(3) but doesn't need a system call per component.
+ */
+static char *
+getchildrealpath(const char *parent, const char *name)
+{
+	int len = strlen(parent);
+	char *real = check_malloc(len + strlen(name) + 2);
+
+	strcpy(real, parent);
+	if (len == 0 || real[len - 1] != '/')
+		real[len++] = '/';
+	strcpy(real + len, name);
+	return real;
+}
 /**
  * has_symlinkloop: whether or not dir has a symbolic link loops.
  *
  *	@param[in]	dir	directory (should end by "/")
+ *	@param[in]	real	real path of dir
  *	@return		1: has a loop, 0: don't have a loop
  */
 static int
-has_symlinkloop(const char *dir)
+has_symlinkloop(const char *dir, const char *real)
 {
 	struct stack_entry *sp;
-	char *real, *p;
-	int i, ret = 0;
+	const char *p;
+	int i;
 
 	if (!strcmp(dir, "./"))
 		return 0;
-	if ((real = realpath(dir, NULL)) == NULL)
-		die("cannot get real path of '%s'.", trimpath(dir));
 #ifdef SLOOPDEBUG
 	fprintf(stderr, "======== has_symlinkloop ======\n");
 	fprintf(stderr, "dir = '%s', real path = '%s'\n", dir, real);
@@ -528,10 +709,8 @@ has_symlinkloop(const char *dir)
 	fprintf(stderr, "\tcheck '%s' < '%s'\n", real, rootdir);
 #endif
 	p = locatestring(rootdir, real, MATCH_AT_FIRST);
-	if (p && (*p == '/' || *p == '\0' || !strcmp(real, "/"))) {
-		ret = 1;
-		goto out;
-	}
+	if (p && (*p == '/' || *p == '\0' || !strcmp(real, "/")))
+		return 1;
 	sp = varray_assign(vstack->varray, 0, 0);
 #ifdef SLOOPDEBUG
 	fprintf(stderr, "TEST-2\n");
@@ -540,17 +719,13 @@ has_symlinkloop(const char *dir)
 #ifdef SLOOPDEBUG
 		fprintf(stderr, "%d:\tcheck '%s' == '%s'\n", i, real, sp[i].real);
 #endif
-		if (!strcmp(sp[i].real, real)) {
-			ret = 1;
-			goto out;
-		}
+		if (!strcmp(sp[i].real, real))
+			return 1;
 	}
 #ifdef SLOOPDEBUG
 	fprintf(stderr, "===============================\n");
 #endif
-out:
-	free(real);
-	return ret;
+	return 0;
 }
 /**
  * skips '.', '..'.
@@ -576,85 +751,515 @@ ignore(const char *path)
 	}
 	return 0;
 }
+/**
+ * skipunit: check whether or not a unit in a directory is in the skip list.
+ *
+ *	@param[in]	dir	directory (should end by "/")
+ *	@param[in]	name	name of the unit
+ *	@param[in]	isdir	1: directory, 0: other
+ *	@return		1: skip, 0: don't skip
+ */
+static int
+skipunit(const char *dir, const char *name, int isdir)
+{
+	STATIC_STRBUF(sb);
+
+	strbuf_clear(sb);
+	strbuf_puts(sb, makepath(dir, name, NULL));
+	if (isdir)
+		strbuf_putc(sb, '/');
+	return skipthisfile(strbuf_value(sb));
+}
+/*
+ * Directory readers
+ *
+ * Reading a directory costs a readdir(3) and some stat(2) and access(2)
+ * for each unit, which is slow on network file systems. If readers are
+ * set (set_find_readers()), child processes read the directories which
+ * will be traversed later, in parallel. The results are interpreted by
+ * getdirs() in the order of the traversal, so the output and the messages
+ * are the same as reading the directories by ourselves.
+ */
+struct unit {
+	int type;			/**< 'd', 'f': told by readdir(3), 0: unknown */
+	int stat_errno;			/**< result of stat(2) if type == 0 */
+	int mode;			/**< st_mode if type == 0 */
+	int access_errno;		/**< result of access(2) */
+	int lstat_errno;		/**< result of lstat(2) if skip_symlink */
+	int islink;			/**< symbolic link if skip_symlink */
+	int namelen;			/**< length of the name which follows */
+};
+#define UNITNAME(u)	((char *)((u) + 1))
+#define NEXTUNIT(u)	((struct unit *)(UNITNAME(u) + ((u)->namelen + sizeof(int)) / sizeof(int) * sizeof(int)))
+
+/**
+ * readunits: read a directory.
+ *
+ *	@param[in]	dir	directory (should end by "/")
+ *	@param[out]	sb	units (struct unit and name)
+ *	@return		0: normal, otherwise: errno of opendir(3)
+ */
+static int
+readunits(const char *dir, STRBUF *sb)
+{
+	DIR *dirp;
+	struct dirent *dp;
+	struct stat st;
+	struct unit u;
+	static const char pad[sizeof(int)];
+
+	if ((dirp = opendir(dir)) == NULL)
+		return errno ? errno : ENOENT;
+	while ((dp = readdir(dirp)) != NULL) {
+		if (ignore(dp->d_name))
+			continue;
+		memset(&u, 0, sizeof(u));
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+		if (dp->d_type == DT_DIR || dp->d_type == DT_REG)
+			u.type = (dp->d_type == DT_DIR) ? 'd' : 'f';
+#endif
+		if (!u.type) {
+			if (stat(makepath(dir, dp->d_name, NULL), &st) < 0)
+				u.stat_errno = errno ? errno : ENOENT;
+			else
+				u.mode = st.st_mode;
+		}
+		if (!u.stat_errno && !(S_ISSOCK(u.mode) || S_ISFIFO(u.mode) || S_ISCHR(u.mode) || S_ISBLK(u.mode))) {
+			if (access(makepath(dir, dp->d_name, NULL), R_OK) < 0)
+				u.access_errno = errno ? errno : EACCES;
+#ifndef __DJGPP__
+			else if (!u.type && skip_symlink > 0) {
+#if defined(_WIN32) && !defined(__CYGWIN__)
+				DWORD attr = GetFileAttributes(makepath(dir, dp->d_name, NULL));
+				u.islink = (attr != -1 && (attr & FILE_ATTRIBUTE_REPARSE_POINT));
+#else
+				struct stat st2;
+
+				if (lstat(makepath(dir, dp->d_name, NULL), &st2) < 0)
+					u.lstat_errno = errno ? errno : ENOENT;
+				else
+					u.islink = S_ISLNK(st2.st_mode);
+#endif
+			}
+#endif
+		}
+		u.namelen = strlen(dp->d_name);
+		strbuf_nputs(sb, (char *)&u, sizeof(u));
+		strbuf_nputs(sb, dp->d_name, u.namelen);
+		strbuf_nputs(sb, pad, sizeof(int) - u.namelen % sizeof(int));
+	}
+	(void)closedir(dirp);
+	return 0;
+}
+#if !defined(_WIN32) || defined(__CYGWIN__)
+#define MAXREADERS	64
+#define MAXREQUESTS	8		/**< max requests in flight per reader */
+struct reader {
+	pid_t pid;
+	int req;			/**< pipe to send requests */
+	int res;			/**< pipe to receive results */
+	char *inflight[MAXREQUESTS];	/**< requested directories in the order */
+	int head, count;
+};
+static struct reader readers[MAXREADERS];
+static int nreaders;			/**< number of readers (set_find_readers) */
+static int started;			/**< number of started readers */
+static char **pending;			/**< directories to be requested (stack) */
+static int npending, pendingsize;
+struct result {
+	struct result *next;
+	char *path;
+	int status;
+	STRBUF *sb;
+};
+static struct result *received;		/**< results received in advance */
+
+/**
+ * readn: read just n bytes from a pipe.
+ *
+ *	@return		0: normal, -1: error or EOF
+ */
+static int
+readn(int fd, void *buf, size_t n)
+{
+	char *p = buf;
+	ssize_t r;
+
+	while (n > 0) {
+		r = read(fd, p, n);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			return -1;
+		p += r;
+		n -= r;
+	}
+	return 0;
+}
+/**
+ * writen: write just n bytes to a pipe.
+ *
+ *	@return		0: normal, -1: error
+ */
+static int
+writen(int fd, const void *buf, size_t n)
+{
+	const char *p = buf;
+	ssize_t r;
+
+	while (n > 0) {
+		r = write(fd, p, n);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r < 0)
+			return -1;
+		p += r;
+		n -= r;
+	}
+	return 0;
+}
+/**
+ * reader_loop: body of a reader process.
+ *
+ * A request is the length of a path and the path. A result is
+ * the return value of readunits(), the size of the units and the units.
+ */
+static void
+reader_loop(int req, int res)
+{
+	STRBUF *sb = strbuf_open(0);
+	char path[MAXPATHLEN];
+	int header[2], len;
+
+	for (;;) {
+		if (readn(req, &len, sizeof(len)) < 0 || len <= 0 || len >= MAXPATHLEN
+		 || readn(req, path, len) < 0)
+			break;
+		path[len] = '\0';
+		strbuf_reset(sb);
+		header[0] = readunits(path, sb);
+		header[1] = strbuf_getlen(sb);
+		if (writen(res, header, sizeof(header)) < 0
+		 || writen(res, strbuf_value(sb), header[1]) < 0)
+			break;
+	}
+	_exit(0);
+}
+/**
+ * start_readers: start the reader processes.
+ */
+static void
+start_readers(void)
+{
+	struct reader *rp;
+	int reqpipe[2], respipe[2];
+	int j;
+
+	/* the buffered output must not be inherited by the readers */
+	fflush(NULL);
+	for (started = 0; started < nreaders; started++) {
+		rp = &readers[started];
+		if (pipe(reqpipe) < 0 || pipe(respipe) < 0)
+			die("cannot create pipe.");
+		rp->pid = fork();
+		if (rp->pid < 0)
+			die("cannot fork.");
+		if (rp->pid == 0) {
+			/* only the parent handles errors. */
+			sethandler(NULL);
+			for (j = 0; j < started; j++) {
+				close(readers[j].req);
+				close(readers[j].res);
+			}
+			close(reqpipe[1]);
+			close(respipe[0]);
+			reader_loop(reqpipe[0], respipe[1]);
+		}
+		close(reqpipe[0]);
+		close(respipe[1]);
+		rp->req = reqpipe[1];
+		rp->res = respipe[0];
+		rp->head = rp->count = 0;
+	}
+}
+/**
+ * stop_readers: stop the reader processes.
+ */
+static void
+stop_readers(void)
+{
+	struct reader *rp;
+	struct result *r;
+	int i;
+
+	for (i = 0; i < started; i++) {
+		rp = &readers[i];
+		close(rp->req);
+		close(rp->res);
+		while (waitpid(rp->pid, NULL, 0) < 0 && errno == EINTR)
+			;
+		for (; rp->count > 0; rp->count--) {
+			free(rp->inflight[rp->head]);
+			rp->head = (rp->head + 1) % MAXREQUESTS;
+		}
+	}
+	started = 0;
+	for (i = 0; i < npending; i++)
+		free(pending[i]);
+	npending = 0;
+	while ((r = received) != NULL) {
+		received = r->next;
+		free(r->path);
+		strbuf_close(r->sb);
+		free(r);
+	}
+}
+/**
+ * dispatch: send the pending requests to the readers which have room.
+ */
+static void
+dispatch(void)
+{
+	struct reader *rp;
+	char *path;
+	int i, len;
+
+	while (npending > 0) {
+		rp = NULL;
+		for (i = 0; i < started; i++)
+			if (readers[i].count < MAXREQUESTS && (rp == NULL || readers[i].count < rp->count))
+				rp = &readers[i];
+		if (rp == NULL)
+			break;
+		path = pending[--npending];
+		len = strlen(path);
+		if (writen(rp->req, &len, sizeof(len)) < 0 || writen(rp->req, path, len) < 0)
+			die("cannot send a request to the directory reader.");
+		rp->inflight[(rp->head + rp->count++) % MAXREQUESTS] = path;
+	}
+}
+/**
+ * receive: receive the oldest result of a reader.
+ *
+ *	@param[out]	sb	units
+ *	@return		return value of readunits()
+ */
+static int
+receive(struct reader *rp, STRBUF *sb)
+{
+	char buf[BUFSIZ];
+	int header[2], n;
+
+	if (readn(rp->res, header, sizeof(header)) < 0)
+		die("directory reader terminated abnormally.");
+	strbuf_reset(sb);
+	while (header[1] > 0) {
+		n = header[1] < (int)sizeof(buf) ? header[1] : (int)sizeof(buf);
+		if (readn(rp->res, buf, n) < 0)
+			die("directory reader terminated abnormally.");
+		strbuf_nputs(sb, buf, n);
+		header[1] -= n;
+	}
+	free(rp->inflight[rp->head]);
+	rp->head = (rp->head + 1) % MAXREQUESTS;
+	rp->count--;
+	return header[0];
+}
+#endif
+/**
+ * request_dirs: tell the directories which will be read.
+ *
+ *	@param[in]	dir	parent directory (should end by "/")
+ *	@param[in]	units	directory list of getdirs()
+ *	@param[in]	len	length of the list
+ */
+static void
+request_dirs(const char *dir, const char *units, int len)
+{
+#if !defined(_WIN32) || defined(__CYGWIN__)
+	STATIC_STRBUF(sb);
+	const char *p, *end = units + len;
+	int n = 0, i;
+
+	if (started == 0)
+		return;
+	for (p = units; p < end; p += strlen(p) + 1)
+		if (*p == 'd' || *p == 'D')
+			n++;
+	if (npending + n > pendingsize) {
+		pendingsize = npending + n + 64;
+		pending = check_realloc(pending, sizeof(char *) * pendingsize);
+	}
+	/* The first one is put on the top, since it will be read first. */
+	i = npending + n;
+	for (p = units; p < end; p += strlen(p) + 1)
+		if (*p == 'd' || *p == 'D') {
+			strbuf_clear(sb);
+			strbuf_puts(sb, dir);
+			strbuf_puts(sb, p + 1);
+			strbuf_putc(sb, '/');
+			pending[--i] = check_strdup(strbuf_value(sb));
+		}
+	npending += n;
+	dispatch();
+#endif
+}
+/**
+ * getunits: get the units of a directory, read in advance if possible.
+ *
+ *	@param[in]	dir	directory (should end by "/")
+ *	@param[out]	sb	units
+ *	@return		0: normal, otherwise: errno of opendir(3)
+ */
+static int
+getunits(const char *dir, STRBUF *sb)
+{
+#if !defined(_WIN32) || defined(__CYGWIN__)
+	struct result *r, **prev;
+	struct reader *rp;
+	int i, j, status;
+
+	if (started > 0) {
+		for (prev = &received; (r = *prev) != NULL; prev = &r->next)
+			if (!strcmp(r->path, dir)) {
+				*prev = r->next;
+				strbuf_reset(sb);
+				strbuf_nputs(sb, strbuf_value(r->sb), strbuf_getlen(r->sb));
+				status = r->status;
+				free(r->path);
+				strbuf_close(r->sb);
+				free(r);
+				return status;
+			}
+		for (i = 0; i < started; i++) {
+			rp = &readers[i];
+			for (j = 0; j < rp->count; j++)
+				if (!strcmp(rp->inflight[(rp->head + j) % MAXREQUESTS], dir))
+					break;
+			if (j == rp->count)
+				continue;
+			/* keep the results before it */
+			for (; j > 0; j--) {
+				r = check_malloc(sizeof(*r));
+				r->path = check_strdup(rp->inflight[rp->head]);
+				r->sb = strbuf_open(0);
+				r->status = receive(rp, r->sb);
+				r->next = received;
+				received = r;
+			}
+			status = receive(rp, sb);
+			dispatch();
+			return status;
+		}
+		/* not requested yet */
+		for (i = npending - 1; i >= 0; i--)
+			if (!strcmp(pending[i], dir)) {
+				free(pending[i]);
+				memmove(&pending[i], &pending[i + 1], sizeof(char *) * (npending - i - 1));
+				npending--;
+				break;
+			}
+	}
+#endif
+	strbuf_reset(sb);
+	return readunits(dir, sb);
+}
 /**
  * getdirs: get directory list
  *
  *	@param[in]	dir	directory (should end by "/")
+ *	@param[in]	real	real path of dir
  *	@param[out]	sb	string buffer
  *	@return		-1: error, 0: normal
  *
  * format of directory list:
- * |ddir1\0ffile1\0|
- * means directory "dir1", file "file1".
+ * |ddir1\0Ddir2\0ffile1\0|
+ * means directory "dir1", directory "dir2" which may be a symbolic link,
+ * file "file1".
  */
 static int
-getdirs(const char *dir, STRBUF *sb)
+getdirs(const char *dir, const char *real, STRBUF *sb)
 {
-	DIR *dirp;
-	struct dirent *dp;
-	struct stat st;
+	STATIC_STRBUF(ub);
+	struct unit *u, *end;
+	const char *name;
+	int status;
 
-	if (check_looplink && has_symlinkloop(dir)) {
+	if (check_looplink && has_symlinkloop(dir, real)) {
 		warning("symbolic link loop detected. '%s' is ignored.", trimpath(dir));
 		return -1;
 	}
-	if ((dirp = opendir(dir)) == NULL) {
+	if ((status = getunits(dir, ub)) != 0) {
 		warning("cannot open directory '%s'. ignored.", trimpath(dir));
 		return -1;
 	}
-	while ((dp = readdir(dirp)) != NULL) {
-		if (ignore(dp->d_name))
-			continue;
-		if (stat(makepath(dir, dp->d_name, NULL), &st) < 0) {
-			warning("cannot stat '%s'. ignored.", trimpath(dp->d_name));
-			continue;
+	u = (struct unit *)strbuf_value(ub);
+	end = (struct unit *)(strbuf_value(ub) + strbuf_getlen(ub));
+	for (; u < end; u = NEXTUNIT(u)) {
+		int type = u->type;
+
+		name = UNITNAME(u);
+		/*
+		 * If the directory entry tells that the unit is a regular file
+		 * or a directory, it is not a symbolic link and neither stat(2)
+		 * nor lstat(2) is needed. The units in the skip list are pruned
+		 * here, so skipped directories are never read.
+		 */
+		if (type) {
+			if (skipunit(dir, name, type == 'd'))
+				continue;
+		} else {
+			if (u->stat_errno) {
+				warning("cannot stat '%s'. ignored.", trimpath(name));
+				continue;
+			}
+			if (S_ISSOCK(u->mode) || S_ISFIFO(u->mode) || S_ISCHR(u->mode) || S_ISBLK(u->mode)) {
+				warning("file is not regular file '%s'. ignored.", trimpath(name));
+				continue;
+			}
 		}
-		if (S_ISSOCK(st.st_mode) || S_ISFIFO(st.st_mode) || S_ISCHR(st.st_mode) || S_ISBLK(st.st_mode)) {
-			warning("file is not regular file '%s'. ignored.", trimpath(dp->d_name));
+		if (u->access_errno) {
+			if (!skip_unreadable)
+				die("cannot read file '%s'.", trimpath(name));
+			warning("cannot read '%s'. ignored.", trimpath(name));
 			continue;
 		}
-		if (access(makepath(dir, dp->d_name, NULL), R_OK) < 0) {
-			if (!skip_unreadable)
-				die("cannot read file '%s'.", trimpath(dp->d_name));
-			warning("cannot read '%s'. ignored.", trimpath(dp->d_name));
+		if (type) {
+			strbuf_putc(sb, type);
+			strbuf_puts0(sb, name);
 			continue;
 		}
 #ifndef __DJGPP__
 		if (skip_symlink > 0) {
-#if defined(_WIN32) && !defined(__CYGWIN__)
-			DWORD attr = GetFileAttributes(makepath(dir, dp->d_name, NULL));
-			if (attr != -1 && (attr & FILE_ATTRIBUTE_REPARSE_POINT))
-#else
-			struct stat st2;
-
-			if (lstat(makepath(dir, dp->d_name, NULL), &st2) < 0) {
-				warning("cannot lstat '%s'. ignored.", trimpath(dp->d_name));
+#if !defined(_WIN32) || defined(__CYGWIN__)
+			if (u->lstat_errno) {
+				warning("cannot lstat '%s'. ignored.", trimpath(name));
 				continue;
 			}
-			if (S_ISLNK(st2.st_mode))
 #endif
-			{
-				if (((skip_symlink & SKIP_SYMLINK_FOR_DIR) && S_ISDIR(st.st_mode)) ||
-				    ((skip_symlink & SKIP_SYMLINK_FOR_FILE) && S_ISREG(st.st_mode)))
+			if (u->islink) {
+				if (((skip_symlink & SKIP_SYMLINK_FOR_DIR) && S_ISDIR(u->mode)) ||
+				    ((skip_symlink & SKIP_SYMLINK_FOR_FILE) && S_ISREG(u->mode)))
 				{
 					if (find_explain)
 						fprintf(stderr, " - Symbolic link '%s' is skipped.\n",
-							trimpath(makepath(dir, dp->d_name, NULL)));
+							trimpath(makepath(dir, name, NULL)));
 					continue;
 				}
 			}
 		}
 #endif
-		if (S_ISDIR(st.st_mode))
-			strbuf_putc(sb, 'd');
-		else if (S_ISREG(st.st_mode))
+		if (skipunit(dir, name, S_ISDIR(u->mode)))
+			continue;
+		if (S_ISDIR(u->mode))
+			strbuf_putc(sb, 'D');
+		else if (S_ISREG(u->mode))
 			strbuf_putc(sb, 'f');
 		else
 			strbuf_putc(sb, ' ');
-		strbuf_puts(sb, dp->d_name);
-		strbuf_putc(sb, '\0');
+		strbuf_puts0(sb, name);
 	}
-	(void)closedir(dirp);
+	request_dirs(dir, strbuf_value(sb), strbuf_getlen(sb));
 	return 0;
 }
 /**
@@ -686,6 +1291,19 @@ set_skip_symlink(int mode)
 {
 	skip_symlink = mode;
 }
+/**
+ * set_find_readers: set the number of directory readers.
+ *
+ *	@param[in]	n	number of processes which read directories in advance
+ *			0: directories are read by find_read()
+ */
+void
+set_find_readers(int n)
+{
+#if !defined(_WIN32) || defined(__CYGWIN__)
+	nreaders = n < 0 ? 0 : n > MAXREADERS ? MAXREADERS : n;
+#endif
+}
 /**
  * find_open: start iterator without GPATH.
  *
@@ -714,7 +1332,11 @@ find_open(const char *start, int explain)
 	curp->dirp = dir + strlen(dir);
 	curp->sb = strbuf_open(0);
 	curp->real = getrealpath(dir);
-	if (getdirs(dir, curp->sb) < 0)
+#if !defined(_WIN32) || defined(__CYGWIN__)
+	if (nreaders > 0)
+		start_readers();
+#endif
+	if (getdirs(dir, curp->real, curp->sb) < 0)
 		die("Work is given up.");
 	curp->start = curp->p = strbuf_value(curp->sb);
 	curp->end   = curp->start + strbuf_getlen(curp->sb);
@@ -877,28 +1499,18 @@ find_read_traverse(void)
 			curp->p += strlen(curp->p) + 1;
 
 			/*
-			 * Skip files described in the skip list.
+			 * Files described in the skip list were already
+			 * removed by getdirs().
 			 */
 				/* makepath() returns unsafe module local area. */
 			strlimcpy(path, makepath(dir, unit, NULL), sizeof(path));
-			if (type == 'd')
+			if (type == 'd' || type == 'D')
 				strcat(path, "/");
-			if (skipthisfile(path))
-				continue;
 			if (type == 'f') {
 				/*
-				 * Skip the following:
-				 * o directory
-				 * o file which does not exist
-				 * o dead symbolic link
+				 * Directories, files which do not exist and dead
+				 * symbolic links were already removed by getdirs().
 				 */
-				if (!test("f", path)) {
-					if (test("d", path))
-						warning("'%s' is a directory. ignored.", trimpath(path));
-					else
-						warning("'%s' not found. ignored.", trimpath(path));
-					continue;
-				}
 				/*
 				 * Now GLOBAL can treat the path which includes blanks.
 				 * This message is obsoleted.
@@ -921,12 +1533,23 @@ find_read_traverse(void)
 				val[sizeof(val) - 1] = '\0';
 				return val;
 			}
-			if (type == 'd') {
+			if (type == 'd' || type == 'D') {
 				STRBUF *sb = strbuf_open(0);
 				char *dirp = curp->dirp;
+				char *real;
+
 				strcat(dirp, unit);
 				strcat(dirp, "/");
-				if (getdirs(dir, sb) < 0) {
+				/*
+				 * Only a directory which may be a symbolic link
+				 * needs realpath(3).
+				 */
+				if (type == 'd')
+					real = getchildrealpath(curp->real, unit);
+				else
+					real = getrealpath(dir);
+				if (getdirs(dir, real, sb) < 0) {
+					free(real);
 					strbuf_close(sb);
 					*(curp->dirp) = 0;
 					continue;
@@ -936,7 +1559,7 @@ find_read_traverse(void)
 				 */
 				curp = vstack_push(vstack);
 				curp->dirp = dirp + strlen(dirp);
-				curp->real = getrealpath(dir);
+				curp->real = real;
 				curp->sb = sb;
 				curp->start = curp->p = strbuf_value(sb);
 				curp->end   = curp->start + strbuf_getlen(sb);
@@ -986,6 +1609,9 @@ find_close(void)
 {
 	assert(find_mode != 0);
 	if (find_mode == FIND_OPEN) {
+#if !defined(_WIN32) || defined(__CYGWIN__)
+		stop_readers();
+#endif
 		if (vstack)
 			vstack_close(vstack);
 	} else if (find_mode == FILELIST_OPEN) {
@@ -1000,9 +1626,25 @@ find_close(void)
 	}
 	if (rootdir)
 		free(rootdir);
-	if (suff)
+	if (suff) {
 		regfree(suff);
-	if (skip)
+		suff = NULL;
+	}
+	if (suff_hash) {
+		strhash_close(suff_hash);
+		suff_hash = NULL;
+	}
+	suff_prepared = 0;
+	if (skip) {
 		regfree(skip);
+		skip = NULL;
+	}
+	if (skip_prepared) {
+		strhash_close(skip_name);
+		strhash_close(skip_dir);
+		strhash_close(skip_suffix);
+		strhash_close(skip_root);
+		skip_prepared = 0;
+	}
 	find_eof = find_mode = 0;
 }
@@ -24,6 +24,7 @@
 #include "abs2rel.h"
 #include "args.h"
 #include "assoc.h"
+#include "bloom.h"
 #include "char.h"
 #include "checkalloc.h"
 #include "compress.h"
@@ -54,6 +55,7 @@
 #include "rewrite.h"
 #include "secure_popen.h"
 #include "split.h"
+#include "sstable.h"
 #include "statistics.h"
 #include "strbuf.h"
 #include "strhash.h"
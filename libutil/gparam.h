@@ -52,12 +52,20 @@
 		/** max length of URL		*/
 #define MAXURLLEN	1024
 /*
- * The default cache size of db library is 50MB.
- * The minimum size is 500KB.
+ * The default cache size of db library is 50MB, which is shared by
+ * the tag files open at a time. See decide_cachesize() in dbop.c.
+ * The minimum size of each file is 500KB.
  */
 		/** default cache size 50MB	*/
 #define GTAGSCACHE	50000000
 		/** minimum cache size 500KB	*/
 #define GTAGSMINCACHE	500000
+/**
+ * Times to open again the tag files of different generations.
+ * See gtags_open().
+ */
+#define GENERATION_RETRY	16
+		/** default parse cache size (MB) */
+#define PARSECACHESIZE	512
 
 #endif /* ! _GPARAM_H_ */
@@ -48,12 +48,18 @@ static int _nextkey;
 static int _mode;
 static int opened;
 static int created;
+static int generation;
 
 static int openflags;
 void
 set_gpath_flags(int flags) {
 	openflags = flags;
 }
+static int pagesize;
+void
+set_gpath_pagesize(int size) {
+	pagesize = size;
+}
 /**
  * compare_nearpath: compare function for 'nearness sort'.
  */
@@ -104,6 +110,25 @@ compare_nearpath(const void *s1, const void *s2)
  */
 static int support_version = 2;	/**< acceptable format version   */
 static int create_version = 2;	/**< format version of newly created tag file */
+/**
+ * read_meta: read the meta records of GPATH opened for reading.
+ */
+static void
+read_meta(void)
+{
+	int format_version;
+	const char *path = dbop_get(dbop, NEXTKEY);
+
+	if (path == NULL)
+		die("nextkey not found in GPATH.");
+	_startkey = _nextkey = atoi(path);
+	generation = dbop_getgeneration(dbop);
+	format_version = dbop_getversion(dbop);
+	if (format_version > support_version)
+		die("GPATH seems new format. Please install the latest GLOBAL.");
+	else if (format_version < support_version)
+		die("GPATH seems older format. Please remake tag files.");
+}
 /**
  * gpath_open: open gpath tag file
  *
@@ -129,26 +154,45 @@ gpath_open(const char *dbpath, int mode)
 	_mode = mode;
 	if (mode == 1 && created)
 		mode = 0;
-	dbop = dbop_open(makepath(dbpath, dbname(GPATH), NULL), mode, 0644, openflags);
+	dbop = dbop_open_pagesize(makepath(dbpath, dbname(GPATH), NULL), mode, 0644, openflags, pagesize);
 	if (dbop == NULL)
 		return -1;
 	if (mode == 1) {
 		dbop_putversion(dbop, create_version);
 		_startkey = _nextkey = 1;
-	} else {
-		int format_version;
-		const char *path = dbop_get(dbop, NEXTKEY);
+	} else
+		read_meta();
+	opened++;
+	return 0;
+}
+/**
+ * gpath_reopen: open GPATH again if it has been replaced.
+ *
+ *	@param[in]	dbpath	GTAGSDBPATH
+ *	@return		0: normal,
+ *			-1: error
+ *
+ * Since GPATH is shared by the users of gpath_open(), gpath_close() and
+ * gpath_open() don't read it again while another user has it open.
+ * This reads the generation of the GPATH file, and replaces the open
+ * GPATH with the file if the generation differs. Read only mode only.
+ */
+int
+gpath_reopen(const char *dbpath)
+{
+	DBOP *newdbop;
 
-		if (path == NULL)
-			die("nextkey not found in GPATH.");
-		_startkey = _nextkey = atoi(path);
-		format_version = dbop_getversion(dbop);
-		if (format_version > support_version)
-			die("GPATH seems new format. Please install the latest GLOBAL.");
-		else if (format_version < support_version)
-                        die("GPATH seems older format. Please remake tag files."); 
+	assert(opened > 0 && _mode == 0);
+	newdbop = dbop_open_pagesize(makepath(dbpath, dbname(GPATH), NULL), 0, 0644, openflags, pagesize);
+	if (newdbop == NULL)
+		return -1;
+	if (dbop_getgeneration(newdbop) == generation) {
+		dbop_close(newdbop);
+		return 0;
 	}
-	opened++;
+	dbop_close(dbop);
+	dbop = newdbop;
+	read_meta();
 	return 0;
 }
 /**
@@ -290,6 +334,17 @@ gpath_nextkey(void)
 	assert(_mode != 1);
 	return _nextkey;
 }
+/**
+ * gpath_generation: return the generation of GPATH
+ *
+ *	@return		generation
+ */
+int
+gpath_generation(void)
+{
+	assert(opened > 0 && _mode != 1);
+	return generation;
+}
 /**
  * gpath_count: count the number of records
  *
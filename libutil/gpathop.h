@@ -60,6 +60,7 @@ typedef struct {
 } GFIND;
 
 void set_gpath_flags(int);
+void set_gpath_pagesize(int);
 int gpath_open(const char *, int);
 const char *gpath_path2fid(const char *, int *);
 const char *gpath_fid2path(const char *, int *);
@@ -70,6 +71,8 @@ void gpath_delete(const char *);
 int gpath_count(int);
 void gpath_close(void);
 int gpath_nextkey(void);
+int gpath_generation(void);
+int gpath_reopen(const char *);
 GFIND *gfind_open(const char *, const char *, int, int);
 const char *gfind_read(GFIND *);
 void gfind_close(GFIND *);
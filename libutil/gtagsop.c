@@ -38,11 +38,13 @@
 #include <unistd.h>
 #endif
 
+#include "bloom.h"
 #include "char.h"
 #include "checkalloc.h"
 #include "conf.h"
 #include "compress.h"
 #include "dbop.h"
+#include "dictzip.h"
 #include "die.h"
 #include "format.h"
 #include "getdbpath.h"
@@ -72,8 +74,19 @@ static int is_defined_in_GTAGS(GTOP *, const char *);
 static char *get_prefix(const char *, int);
 static int gtags_restart(GTOP *);
 static void flush_pool(GTOP *, const char *);
+static void put_compdict(GTOP *, const char *, const char *, int);
+static void train_compdict(GTOP *);
 static void segment_read(GTOP *);
 
+/**
+ * Tag record kept until the dictionary is trained (GTAGS_COMPDICT).
+ */
+struct dict_record {
+	const char *key;
+	const char *record;
+	int offset;			/**< offset of the line image */
+};
+
 /**
  * compare_path: compare function for sorting path names.
  */
@@ -176,6 +189,8 @@ seekto(const char *string, int n)
  * 
  *         Line image might be compressed (GTAGS_COMPRESS).
  *         Tag name might be compressed (GTAGS_COMPNAME).
+ *         Line image might be compressed with a dictionary after
+ *         GTAGS_COMPRESS (GTAGS_COMPDICT). See dictzip.c.
  *
  * Compact format:
  * 
@@ -245,6 +260,10 @@ seekto(const char *string, int n)
                        if (format > 5 || format < 4) then print error message.
   GLOBAL-5.9 -		support only format version 6
                        if (format > 6 || format < 6) then print error message.
+  (not released)	support format version 6 and 7
+                       if (format > 7 || format < 6) then print error message.
+                       format version 7 is format version 6 with
+                       GTAGS_COMPDICT, which is used only by 'gtags --dictionary'.
  *
  * In GLOBAL-5.0, we threw away the compatibility with the past formats.
  * Though we could continue the support for older formats, it seemed
@@ -260,7 +279,7 @@ seekto(const char *string, int n)
  *       GTAGS seems older format. Please remake tag files.
  */
 static int new_format_version = 6;	/**< new format version */
-static int upper_bound_version = 6;	/**< acceptable format version (upper bound) */
+static int upper_bound_version = 7;	/**< acceptable format version (upper bound) */
 static int lower_bound_version = 6;	/**< acceptable format version (lower bound) */
 static const char *const tagslist[] = {"GPATH", "GTAGS", "GRTAGS", "GSYMS"};
 /**
@@ -317,6 +336,83 @@ dbname(int db)
 	assert(db >= 0 && db < GTAGLIM);
 	return tagslist[db];
 }
+/**
+ * Page size of each tag file when it is created. 0: default.
+ */
+static int pagesize[GTAGLIM];
+/**
+ * set_gtags_pagesize: set page size of a tag file to be created
+ *
+ *	@param[in]	db	GPATH, GTAGS, GRTAGS
+ *	@param[in]	size	page size, 0: default
+ */
+void
+set_gtags_pagesize(int db, int size)
+{
+	assert(db >= 0 && db < GTAGLIM);
+	if (db == GPATH)
+		set_gpath_pagesize(size);
+	pagesize[db] = size;
+}
+/**
+ * open_tagfile: open the tag file of gtags_open().
+ *
+ *	@param[in]	gtop	descripter of GTOP
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	tagfile	path of the tag file
+ *	@param[in]	dbmode	mode of dbop_open()
+ *	@param[in]	dbop_flags	flags of dbop_open()
+ */
+static void
+open_tagfile(GTOP *gtop, const char *dbpath, const char *tagfile, int dbmode, int dbop_flags)
+{
+	int db = gtop->db;
+
+	gtop->dbop = dbop_open_pagesize(tagfile, dbmode, 0644, dbop_flags,
+			pagesize[db == GSYMS ? GRTAGS : db]);
+	if (gtop->dbop == NULL) {
+		if (dbmode == 1)
+			die("cannot make %s.", dbname(db));
+		else if (errno == EFTYPE)
+			die("%s seems corrupted.", tagfile);
+		else
+			die("%s not found.", dbname(db));
+	}
+	if (gtop->mode == GTAGS_READ)
+		gtop->bloom = bloom_open(tagfile, 0);
+	if (gtop->mode == GTAGS_READ && db != GTAGS) {
+		const char *gtags = makepath(dbpath, dbname(GTAGS), NULL);
+		int format_version;
+
+		gtop->gtags = dbop_open(gtags, 0, 0, 0);
+		if (gtop->gtags == NULL)
+			die("GTAGS not found.");
+		format_version = dbop_getversion(gtop->dbop);
+		if (format_version > upper_bound_version)
+			die("%s seems new format. Please install the latest GLOBAL.", gtags);
+		else if (format_version < lower_bound_version)
+			die("%s seems older format. Please remake tag files.", gtags);
+	}
+}
+/**
+ * close_tagfile: close the tag file opened by open_tagfile().
+ *
+ *	@param[in]	gtop	descripter of GTOP
+ */
+static void
+close_tagfile(GTOP *gtop)
+{
+	dbop_close(gtop->dbop);
+	gtop->dbop = NULL;
+	if (gtop->gtags) {
+		dbop_close(gtop->gtags);
+		gtop->gtags = NULL;
+	}
+	if (gtop->bloom) {
+		bloom_close(gtop->bloom);
+		gtop->bloom = NULL;
+	}
+}
 /**
  * gtags_open: open global tag.
  *
@@ -369,6 +465,10 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 	} else
 #endif
 		dbop_flags |= DBOP_SORTED_WRITE;
+	if (gtop->mode != GTAGS_READ)
+		dbop_flags |= DBOP_BLOOM;
+	if (gtop->mode == GTAGS_CREATE && (flags & GTAGS_FOLDDUP))
+		dbop_flags |= DBOP_FOLDDUP;
 	/*
 	 * GRTAGS and GSYMS are virtual tag file. They are included in a real GRTAGS file.
 	 * In fact, GSYMS doesn't exist now.
@@ -377,27 +477,30 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 	 * GSYMS:	tags which belongs to GRTAGS, and is not defined in GTAGS.
 	 */
 	strlimcpy(tagfile, makepath(dbpath, dbname(db == GSYMS ? GRTAGS : db), NULL), sizeof(tagfile));
-	gtop->dbop = dbop_open(tagfile, dbmode, 0644, dbop_flags);
-	if (gtop->dbop == NULL) {
-		if (dbmode == 1)
-			die("cannot make %s.", dbname(db));
-		else if (errno == EFTYPE)
-			die("%s seems corrupted.", tagfile);
-		else
-			die("%s not found.", dbname(db));
-	}
-	if (gtop->mode == GTAGS_READ && db != GTAGS) {
-		const char *gtags = makepath(dbpath, dbname(GTAGS), NULL);
-		int format_version;
+	open_tagfile(gtop, dbpath, tagfile, dbmode, dbop_flags);
+	/*
+	 * gtags -i publishes the tag files of a new generation by
+	 * renaming them one by one, GPATH first. A reader which came in between
+	 * gets tag files of different generations, and opens them again.
+	 * GPATH may have been opened before by another user (e.g. htags),
+	 * so it is read again by gpath_reopen().
+	 */
+	if (gtop->mode == GTAGS_READ) {
+		int retry;
 
-		gtop->gtags = dbop_open(gtags, 0, 0, 0);
-		if (gtop->gtags == NULL)
-			die("GTAGS not found.");
-		format_version = dbop_getversion(gtop->dbop);
-		if (format_version > upper_bound_version)
-			die("%s seems new format. Please install the latest GLOBAL.", gtags);
-		else if (format_version < lower_bound_version)
-			die("%s seems older format. Please remake tag files.", gtags);
+		if (gpath_open(dbpath, 0) < 0)
+			die("GPATH not found.");
+		for (retry = 0; ; retry++) {
+			if (dbop_getgeneration(gtop->dbop) == gpath_generation() &&
+			    (gtop->gtags == NULL || dbop_getgeneration(gtop->gtags) == gpath_generation()))
+				break;
+			if (retry == GENERATION_RETRY)
+				die("%s has been updated while reading. Please retry.", tagfile);
+			close_tagfile(gtop);
+			if (gpath_reopen(dbpath) < 0)
+				die("GPATH not found.");
+			open_tagfile(gtop, dbpath, tagfile, dbmode, dbop_flags);
+		}
 	}
 	if (gtop->mode == GTAGS_CREATE) {
 		/*
@@ -415,6 +518,10 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 		} else {
 			/* standard format */
 			gtop->format |= GTAGS_COMPRESS;
+			if (gtop->openflags & GTAGS_COMPDICT) {
+				gtop->format |= GTAGS_COMPDICT;
+				gtop->format_version = 7;
+			}
 		}
 		gtop->format |= GTAGS_COMPNAME;
 		if (gtop->format & GTAGS_COMPACT)
@@ -427,6 +534,14 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 			dbop_putoption(gtop->dbop, COMPLINEKEY, NULL);
 		if (gtop->format & GTAGS_COMPNAME)
 			dbop_putoption(gtop->dbop, COMPNAMEKEY, NULL);
+		/*
+		 * The dictionary is put after training. See put_compdict().
+		 */
+		if (gtop->format & GTAGS_COMPDICT) {
+			dictzip_open(NULL);
+			gtop->dict_pool = pool_open();
+			gtop->dict_records = varray_open(sizeof(struct dict_record), 1000);
+		}
 		dbop_putversion(gtop->dbop, gtop->format_version); 
 	} else {
 		/*
@@ -455,8 +570,16 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 			gtop->format |= GTAGS_COMPLINE;
 		if (dbop_getoption(gtop->dbop, COMPNAMEKEY) != NULL)
 			gtop->format |= GTAGS_COMPNAME;
+		if ((p = dbop_get(gtop->dbop, COMPDICTKEY)) != NULL) {
+			/* dbop_getoption() cannot be used for the long value */
+			p += strlen(COMPDICTKEY);
+			if (*p == ' ')
+				p++;
+			dictzip_open(p);
+			gtop->format |= GTAGS_COMPDICT;
+		}
 	}
-	if (gpath_open(dbpath, dbmode) < 0) {
+	if (gtop->mode != GTAGS_READ && gpath_open(dbpath, dbmode) < 0) {
 		if (dbmode == 1)
 			die("cannot create GPATH.");
 		else
@@ -474,6 +597,8 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
 			gtop->path_hash = strhash_open(HASHBUCKETS);
 	}
 	gtop->sb_compress = strbuf_open(0);
+	if (gtop->format & GTAGS_COMPDICT && gtop->mode != GTAGS_READ)
+		gtop->sb_dict = strbuf_open(0);
 	return gtop;
 }
 /**
@@ -487,8 +612,26 @@ gtags_open(const char *dbpath, const char *root, int db, int mode, int flags)
  */
 void
 gtags_put_using(GTOP *gtop, const char *tag, int lno, const char *fid, const char *img)
+{
+	gtags_put_image(gtop, tag, lno, fid, img, strlen(img));
+}
+/**
+ * gtags_put_image: put tag record with packing.
+ *
+ *	@param[in]	gtop	descripter of GTOP
+ *	@param[in]	tag	tag name
+ *	@param[in]	lno	line number
+ *	@param[in]	fid	file id
+ *	@param[in]	img	line image (need not be terminated by '\0')
+ *	@param[in]	imglen	length of the line image
+ *
+ * The line image is written into the record directly from img.
+ */
+void
+gtags_put_image(GTOP *gtop, const char *tag, int lno, const char *fid, const char *img, int imglen)
 {
 	const char *key;
+	int offset;
 
 	if (gtop->format & GTAGS_COMPACT) {
 		struct sh_entry *entry;
@@ -535,8 +678,71 @@ gtags_put_using(GTOP *gtop, const char *tag, int lno, const char *fid, const cha
 	strbuf_putc(gtop->sb, ' ');
 	strbuf_putn(gtop->sb, lno);
 	strbuf_putc(gtop->sb, ' ');
-	strbuf_puts(gtop->sb, (gtop->format & GTAGS_COMPRESS) ? compress(img, key, gtop->sb_compress) : img);
-	dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb));
+	offset = strbuf_getlen(gtop->sb);
+	if (gtop->format & GTAGS_COMPRESS)
+		compress_nputs(gtop->sb, img, imglen, key);
+	else
+		strbuf_nputs(gtop->sb, img, imglen);
+	if (gtop->format & GTAGS_COMPDICT)
+		put_compdict(gtop, key, strbuf_value(gtop->sb), offset);
+	else
+		dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb));
+}
+/**
+ * put_compdict: put tag record compressing the line image with a dictionary.
+ *
+ *	@param[in]	gtop	descripter of GTOP
+ *	@param[in]	key	key of the record
+ *	@param[in]	record	tag record
+ *	@param[in]	offset	offset of the line image in the record
+ *
+ * The first DICTZIP_SAMPLE records are kept to train the dictionary,
+ * and put after that.
+ */
+static void
+put_compdict(GTOP *gtop, const char *key, const char *record, int offset)
+{
+	if (gtop->dict_records) {
+		struct dict_record *r = varray_append(gtop->dict_records);
+
+		r->key = pool_strdup(gtop->dict_pool, key, 0);
+		r->record = pool_strdup(gtop->dict_pool, record, 0);
+		r->offset = offset;
+		if (dictzip_sample(record + offset) >= DICTZIP_SAMPLE)
+			train_compdict(gtop);
+		return;
+	}
+	strbuf_reset(gtop->sb_dict);
+	strbuf_nputs(gtop->sb_dict, record, offset);
+	dictzip_nputs(gtop->sb_dict, record + offset, strlen(record + offset));
+	dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb_dict));
+}
+/**
+ * train_compdict: train the dictionary and put the records kept until now.
+ *
+ *	@param[in]	gtop	descripter of GTOP
+ */
+static void
+train_compdict(GTOP *gtop)
+{
+	VARRAY *records = gtop->dict_records;
+	STRBUF *sb = strbuf_open(0);
+	int i;
+
+	strbuf_puts(sb, COMPDICTKEY);
+	strbuf_putc(sb, ' ');
+	dictzip_train(sb);
+	dbop_put(gtop->dbop, COMPDICTKEY, strbuf_value(sb));
+	strbuf_close(sb);
+	gtop->dict_records = NULL;
+	for (i = 0; i < records->length; i++) {
+		struct dict_record *r = varray_assign(records, i, 0);
+
+		put_compdict(gtop, r->key, r->record, r->offset);
+	}
+	varray_close(records);
+	pool_close(gtop->dict_pool);
+	gtop->dict_pool = NULL;
 }
 /**
  * gtags_flush: Flush the pool for compact format.
@@ -670,6 +876,40 @@ gtags_restart(GTOP *gtop)
 		fprintf(stderr, "gtags_restart: not prepared.\n");
 	return 0;
 }
+/**
+ * is_name: whether gtags_first() reads the records of exactly the pattern.
+ *
+ *	@param[in]	pattern	pattern of gtags_first()
+ *	@param[in]	flags	flags of gtags_first()
+ *	@return		1: name, 0: other
+ */
+static int
+is_name(const char *pattern, int flags)
+{
+	if (pattern == NULL || *pattern == 0 || flags & (GTOP_PREFIX|GTOP_IGNORECASE))
+		return 0;
+	return (flags & GTOP_NOREGEX || !isregex(pattern)) ? 1 : 0;
+}
+/**
+ * gtags_may_exist: test whether a tag file may have a name, using the
+ * bloom filter only.
+ *
+ *	@param[in]	dbpath	dbpath directory
+ *	@param[in]	db	GTAGS, GRTAGS, GSYMS
+ *	@param[in]	pattern	pattern of gtags_first()
+ *	@param[in]	flags	flags of gtags_first()
+ *	@return		0: gtags_first() certainly returns NULL, 1: may not
+ *
+ * This is cheaper than gtags_open() and gtags_first(), since it opens
+ * neither the tag file nor GPATH.
+ */
+int
+gtags_may_exist(const char *dbpath, int db, const char *pattern, int flags)
+{
+	if (!is_name(pattern, flags))
+		return 1;
+	return bloom_exist(makepath(dbpath, dbname(db == GSYMS ? GRTAGS : db), NULL), pattern);
+}
 /**
  * gtags_first: return first record
  *
@@ -714,6 +954,11 @@ gtags_first(GTOP *gtop, const char *pattern, int flags)
 		free(gtop->path_array);
 		gtop->path_array = NULL;
 	}
+	/*
+	 * A name which the bloom filter doesn't know is not in the tag file.
+	 */
+	if (gtop->bloom && is_name(pattern, flags) && !bloom_test(gtop->bloom, pattern))
+		return NULL;
 
 	if (flags & GTOP_KEY)
 		gtop->dbflags |= DBOP_KEY;
@@ -971,8 +1216,14 @@ gtags_show_statistics(GTOP *gtop)
 void
 gtags_close(GTOP *gtop)
 {
+	if (gtop->dict_records)
+		train_compdict(gtop);
 	if (gtop->format & GTAGS_COMPRESS)
 		abbrev_close();
+	if (gtop->format & GTAGS_COMPDICT)
+		dictzip_close();
+	if (gtop->sb_dict)
+		strbuf_close(gtop->sb_dict);
 	if (gtop->segment_pool)
 		pool_close(gtop->segment_pool);
 	if (gtop->path_array)
@@ -989,6 +1240,8 @@ gtags_close(GTOP *gtop)
 	dbop_close(gtop->dbop);
 	if (gtop->gtags)
 		dbop_close(gtop->gtags);
+	if (gtop->bloom)
+		bloom_close(gtop->bloom);
 	free(gtop);
 }
 /**
@@ -1083,7 +1336,7 @@ flush_pool(GTOP *gtop, const char *s_fid)
 					} else {
 						strbuf_putn(gtop->sb, n);
 					}
-					if (strbuf_getlen(gtop->sb) > DBOP_PAGESIZE / 4) {
+					if (strbuf_getlen(gtop->sb) > gtop->dbop->pagesize / 4) {
 						dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb));
 						strbuf_setlen(gtop->sb, header_offset);
 					}
@@ -1107,7 +1360,7 @@ flush_pool(GTOP *gtop, const char *s_fid)
 				if (strbuf_getlen(gtop->sb) > header_offset)
 					strbuf_putc(gtop->sb, ',');
 				strbuf_putn(gtop->sb, n);
-				if (strbuf_getlen(gtop->sb) > DBOP_PAGESIZE / 4) {
+				if (strbuf_getlen(gtop->sb) > gtop->dbop->pagesize / 4) {
 					dbop_put_tag(gtop->dbop, key, strbuf_value(gtop->sb));
 					strbuf_setlen(gtop->sb, header_offset);
 				}
@@ -25,6 +25,7 @@
 #include <stdio.h>
 
 #include "gparam.h"
+#include "bloom.h"
 #include "dbop.h"
 #include "idset.h"
 #include "strbuf.h"
@@ -35,6 +36,7 @@
 #define COMPRESSKEY	" __.COMPRESS"
 #define COMPLINEKEY	" __.COMPLINE"
 #define COMPNAMEKEY	" __.COMPNAME"
+#define COMPDICTKEY	" __.COMPDICT"
 
 #define NOTAGS		-1
 #define GPATH		0
@@ -64,6 +66,10 @@
 #ifdef USE_SQLITE3
 #define GTAGS_SQLITE3	32
 #endif
+			/** compression option for line image with a dictionary */
+#define GTAGS_COMPDICT		64
+			/** fold duplicate keys in leaf pages of B-tree */
+#define GTAGS_FOLDDUP		128
 			/** print information for debug */
 #define GTAGS_DEBUG		65536
 
@@ -101,7 +107,7 @@ typedef struct {
 	DBOP *dbop;			/**< descripter of DBOP */
 	DBOP *gtags;			/**< descripter of GTAGS */
 	int format_version;		/**< format version */
-	int format;			/**< GTAGS_COMPACT, GTAGS_COMPRESS */
+	int format;			/**< GTAGS_COMPACT, GTAGS_COMPRESS, ... */
 	int mode;			/**< mode */
 	int db;				/**< 0:GTAGS, 1:GRTAGS, 2:GSYMS */
 	int openflags;			/**< flags value of gtags_open() */
@@ -132,6 +138,13 @@ typedef struct {
 	STRBUF *sb;			/**< string buffer */
 	STRBUF *sb_compress;		/**< string buffer */
 
+	/*
+	 * Stuff for dictionary compression (GTAGS_COMPDICT)
+	 */
+	STRBUF *sb_dict;		/**< string buffer */
+	POOL *dict_pool;		/**< records put before training */
+	VARRAY *dict_records;		/**< records put before training */
+
 	/** used for compact format and path name only read */
 	STRHASH *path_hash;
 
@@ -143,13 +156,19 @@ typedef struct {
 	regex_t *preg;
 	int dbflags;
 	int readcount;
+
+	/** bloom filter of the tag file (read only) */
+	BLOOM *bloom;
 } GTOP;
 
 const char *dbname(int);
+void set_gtags_pagesize(int, int);
 GTOP *gtags_open(const char *, const char *, int, int, int);
 void gtags_put_using(GTOP *, const char *, int, const char *, const char *);
+void gtags_put_image(GTOP *, const char *, int, const char *, const char *, int);
 void gtags_flush(GTOP *, const char *);
 void gtags_delete(GTOP *, IDSET *);
+int gtags_may_exist(const char *, int, const char *, int);
 GTP *gtags_first(GTOP *, const char *, int);
 GTP *gtags_next(GTOP *);
 void gtags_show_statistics(GTOP *);
@@ -21,6 +21,7 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
+#include <ctype.h>
 #ifdef STDC_HEADERS
 #include <stdlib.h>
 #endif
@@ -41,12 +42,33 @@
 #include "fnmatch.h"
 
 static void trim_suffix_list(STRBUF *, STRHASH *);
-static int match_suffix_list(const char *, const char *, const char *);
+static void compile_langmap(const char *);
+static const char *lookup_langmap(const char *, const char *);
 
 STATIC_STRBUF(lastmatch);
 static STRBUF *active_map;
 static int wflag;
 
+/*
+ * Compiled language map.
+ *
+ * Suffixes are looked up in the hash table, and then glob patterns are
+ * tried in order. Every entry has its position in the map, so that the
+ * first match in the map is adopted as before.
+ */
+struct langmap_entry {
+	const char *lang;		/**< language name */
+	char *text;			/**< suffix without '.' or glob pattern */
+	int pos;			/**< position in the map */
+};
+static STRHASH *suffix_hash;		/**< suffix -> struct langmap_entry */
+static VARRAY *pattern_list;		/**< glob patterns (struct langmap_entry) */
+#if defined(_WIN32) || defined(__DJGPP__)
+#define SUFFIX_ICASE 1
+#else
+#define SUFFIX_ICASE 0
+#endif
+
 /**
  * set warning flag on.
  */
@@ -87,6 +109,105 @@ setup_langmap(const char *map)
 	if (onsuffix == 0)
 		die_with_code(2, "syntax error in langmap '%s'.", map);
 	/* strbuf_close(active_map); */
+	compile_langmap(map);
+}
+/**
+ * suffix_key: make the key of the suffix hash.
+ */
+static const char *
+suffix_key(const char *suffix)
+{
+	STATIC_STRBUF(sb);
+	const char *p;
+
+	if (!SUFFIX_ICASE)
+		return suffix;
+	strbuf_clear(sb);
+	for (p = suffix; *p; p++)
+		strbuf_putc(sb, tolower((unsigned char)*p));
+	return strbuf_value(sb);
+}
+/**
+ * compile_langmap: compile the active language map.
+ *
+ *	@param[in]	map	langmap (for error message)
+ */
+static void
+compile_langmap(const char *map)
+{
+	const char *lang = strbuf_value(active_map);
+	const char *tail = lang + strbuf_getlen(active_map);
+	const char *list, *p;
+	struct langmap_entry *ent;
+	struct sh_entry *sh;
+	int pos = 0;
+
+	suffix_hash = strhash_open(64);
+	pattern_list = varray_open(sizeof(struct langmap_entry), 16);
+	for (; lang < tail; lang = list + strlen(list) + 1) {
+		list = lang + strlen(lang) + 1;
+		for (p = list; *p; pos++) {
+			const char *text;
+
+			if (*p == '.') {
+				text = strmake(++p, ".(");
+				p += strlen(text);
+				sh = strhash_assign(suffix_hash, suffix_key(text), 1);
+				if (sh->value != NULL)	/* the first one is adopted */
+					continue;
+				ent = check_malloc(sizeof(struct langmap_entry));
+				sh->value = ent;
+			} else if (*p == '(') {
+				text = strmake(++p, ")");
+				p += strlen(text);
+				if (*p == ')')
+					p++;
+				ent = varray_append(pattern_list);
+			} else {
+				die_with_code(2, "syntax error in langmap '%s'.", map);
+			}
+			ent->lang = lang;
+			ent->text = check_strdup(text);
+			ent->pos = pos;
+		}
+	}
+}
+/**
+ * lookup_langmap: look up the language of a file.
+ *
+ *	@param[in]	suffix	suffix with '.'
+ *	@param[in]	basename	base name of the file (NULL: not used)
+ *	@return		language name, NULL: not found
+ */
+static const char *
+lookup_langmap(const char *suffix, const char *basename)
+{
+	const struct langmap_entry *found = NULL;
+	struct sh_entry *sh;
+	int i;
+
+	strbuf_clear(lastmatch);
+	if ((sh = strhash_assign(suffix_hash, suffix_key(suffix + 1), 0)) != NULL)
+		found = sh->value;
+	if (basename) {
+		for (i = 0; i < pattern_list->length; i++) {
+			const struct langmap_entry *ent = varray_assign(pattern_list, i, 0);
+
+			if (found && found->pos < ent->pos)
+				break;
+			if (fnmatch(ent->text, basename, 0) == 0) {
+				strbuf_putc(lastmatch, '(');
+				strbuf_puts(lastmatch, ent->text);
+				strbuf_putc(lastmatch, ')');
+				return ent->lang;
+			}
+		}
+	}
+	if (found == NULL)
+		return NULL;
+	strbuf_putc(lastmatch, '.');
+	strbuf_puts(lastmatch, found->text);
+	return found->lang;
 }
 /**
  * trim suffix list
@@ -233,8 +354,6 @@ trim_langmap(const char *map)
 const char *
 decide_lang(const char *suffix)
 {
-	const char *lang, *list, *tail;
-
 	/*
 	 * Though '*.h' files are shared by C and C++, GLOBAL treats them
 	 * as C source files by default. If you set an environment variable
@@ -245,17 +364,7 @@ decide_lang(const char *suffix)
 		strbuf_puts(lastmatch, ".h");
 		return "cpp";
 	}
-	lang = strbuf_value(active_map);
-	tail = lang + strbuf_getlen(active_map);
-
-	/* check whether or not list includes suffix. */
-	while (lang < tail) {
-		list = lang + strlen(lang) + 1;
-		if (match_suffix_list(suffix, NULL, list))
-			return lang;
-		lang = list + strlen(list) + 1;
-	}
-	return NULL;
+	return lookup_langmap(suffix, NULL);
 }
 /**
  * decide language of the path.
@@ -263,7 +372,6 @@ decide_lang(const char *suffix)
 const char *
 decide_lang_path(const char *path)
 {
-	const char *lang, *list, *tail;
 	const char *suffix = locatestring(path, ".", MATCH_LAST);
 	const char *basename = locatestring(path, "/", MATCH_LAST);
 
@@ -279,60 +387,13 @@ decide_lang_path(const char *path)
 		strbuf_puts(lastmatch, ".h");
 		return "cpp";
 	}
-	lang = strbuf_value(active_map);
-	tail = lang + strbuf_getlen(active_map);
-
-	/* check whether or not list includes suffix. */
-	while (lang < tail) {
-		list = lang + strlen(lang) + 1;
-		if (match_suffix_list(suffix, basename, list))
-			return lang;
-		lang = list + strlen(list) + 1;
-	}
-	return NULL;
+	return lookup_langmap(suffix, basename);
 }
 
 /**
- * return true if the suffix exists in the list.
- * suffix may include '(<glob pattern>)'.
+ * return the suffix or '(<glob pattern>)' matched last.
  */
 const char *
 get_last_match() {
 	return strbuf_value(lastmatch);
 }
-static int
-match_suffix_list(const char *suffix, const char *basename, const char *list)
-{
-	const char *p;
-
-	strbuf_clear(lastmatch);
-	suffix++;	/* skip '.' */
-	/*
-	 * list includes suffixes and/or patterns.
-	 */
-	while (*list) {
-		if (*list == '.') {
-			p = strmake(++list, ".(");
-			if (locatestring(p, suffix, MATCH_COMPLETE
-#if defined(_WIN32) || defined(__DJGPP__)
-								|IGNORE_CASE
-#endif
-			)) {
-				strbuf_putc(lastmatch, '.');
-				strbuf_puts(lastmatch, p);
-				return 1;
-			}
-			list += strlen(p);
-		} else if (*list == '(') {
-			p = strmake(++list, ")");
-			if (basename && fnmatch(p, basename, 0) == 0) {
-				strbuf_putc(lastmatch, '(');
-				strbuf_puts(lastmatch, p);
-				strbuf_putc(lastmatch, ')');
-				return 1;
-			}
-			list += strlen(p) + 1;
-		}
-	}
-	return 0;
-}
@@ -20,11 +20,25 @@
 #ifndef _LINETABLE_H
 #define _LINETABLE_H
 #include <stdio.h>
+#include "strbuf.h"
+#include "varray.h"
 
-int linetable_open(const char *);
-int linetable_read(char *, int);
-char *linetable_get(int, int *);
-void linetable_close(void);
-void linetable_print(FILE *, int);
+typedef struct _linetable {
+	/* File buffer */
+	STRBUF *ib;
+	char *filebuf;
+	int filesize;
+	/* File pointer */
+	char *curp;
+	char *endp;
+	/* Offset table */
+	VARRAY *vb;
+} LINETABLE;
+
+LINETABLE *linetable_open(const char *);
+int linetable_read(LINETABLE *, char *, int);
+char *linetable_get(LINETABLE *, int, int *);
+void linetable_close(LINETABLE *);
+void linetable_print(LINETABLE *, FILE *, int);
 
 #endif /* ! _LINETABLE_H */
@@ -34,6 +34,7 @@
 #endif
 #include "compress.h"
 #include "convert.h"
+#include "dictzip.h"
 #include "die.h"
 #include "format.h"
 #include "gparam.h"
@@ -58,6 +59,7 @@ static int nosource;
 static int format;
 
 static STRBUF *sb_uncompress;
+static STRBUF *sb_dictzip;
 
 /** get next number and seek to the next character */
 #define GET_NEXT_NUMBER(p) do {                                                \
@@ -77,12 +79,15 @@ start_output(int a_format, int a_nosource)
 	fp = NULL;
 	src = "";
 	sb_uncompress = strbuf_open(0);
+	sb_dictzip = strbuf_open(0);
 }
 void
 end_output(void)
 {
 	if (sb_uncompress)
 		strbuf_close(sb_uncompress);
+	if (sb_dictzip)
+		strbuf_close(sb_dictzip);
 	if (fp)
 		fclose(fp);
 }
@@ -270,6 +275,8 @@ put_standard_format(CONVERT *cv, GTP *gtp, int flags)
 		while (*p != ' ')
 			p++;
 		image = p + 1;		/* c + 1 */
+		if (flags & GTAGS_COMPDICT)
+			image = dictzip_uncompress(image, sb_dictzip);
 		if (flags & GTAGS_COMPRESS)
 			image = (char *)uncompress(image, gtp->tag, sb_uncompress);
 	}
@@ -0,0 +1,791 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
+#ifdef HAVE_STRING_H
+#include <string.h>
+#else
+#include <strings.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ)
+#include <zlib.h>
+#define USE_ZLIB 1
+#endif
+
+#include "bloom.h"
+#include "checkalloc.h"
+#include "sstable.h"
+#include "strbuf.h"
+#include "varray.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/*
+ * File format (integers are little endian):
+ *
+ *	header:	magic(4) version(4) block size(4) flags(4)
+ *	blocks:	records of each block, compressed if the flags say so
+ *	index:	for each block,
+ *		offset(8) length(4) size(4) keylen(4) the last key of the block
+ *	bloom:	bloom filter of the keys (see bloom.h)
+ *	footer:	index offset(8) index length(4) blocks(4)
+ *		bloom offset(8) bloom length(4) hashes(4) records(4) magic(4)
+ *
+ * 'length' is the length of a block in the file and 'size' is the length
+ * of its records. A block whose length equals its size is not compressed.
+ * A record is
+ *
+ *	shared(v) unshared(v) datlen(v) key[shared..] data
+ *
+ * where (v) is a variable length number of 7 bits per byte, lowest first,
+ * and 'shared' is the length of the prefix shared with the previous key
+ * of the block. Keys and data are stored as given, including the NUL.
+ */
+#define SST_MAGIC	0x0553ab1e
+#define SST_VERSION	2
+#define SST_HEADERSIZE	16
+#define SST_FOOTERSIZE	40
+#define SST_COMPRESSED	0x01		/**< flags: blocks are compressed */
+
+/**
+ * is_sstable: check whether the file is a sorted table.
+ *
+ *	@param[in]	path	file
+ *	@return		1: sorted table, 0: other
+ */
+int
+is_sstable(const char *path)
+{
+	unsigned char buf[4];
+	int sstable = 0;
+	int fd = open(path, O_RDONLY|O_BINARY);
+
+	if (fd >= 0) {
+		if (read(fd, buf, sizeof(buf)) == sizeof(buf)
+		    && (buf[0] | buf[1] << 8 | buf[2] << 16 | (u_int32_t)buf[3] << 24) == SST_MAGIC)
+			sstable = 1;
+		close(fd);
+	}
+	return sstable;
+}
+#ifndef USE_DB185_COMPAT
+struct sst_block {
+	off_t offset;			/**< offset in the file */
+	u_int32_t length;		/**< length in the file */
+	u_int32_t size;			/**< length of the records */
+	u_int32_t keylen;		/**< length of the last key */
+	const unsigned char *key;	/**< the last key of the block */
+};
+
+typedef struct {
+	int fd;
+	int writing;			/**< 1: being written */
+	u_int32_t bsize;		/**< size of a block */
+	u_int32_t flags;		/**< SST_COMPRESSED */
+	u_int32_t nrecords;		/**< number of records */
+	/*
+	 * writing
+	 */
+	STRBUF *block;			/**< records of the current block */
+	STRBUF *index;			/**< index written so far */
+	STRBUF *last;			/**< the last key put */
+	unsigned char *zbuf;		/**< compressed block */
+	unsigned long zbufsize;		/**< size of zbuf */
+	VARRAY *hashes;			/**< hash of each key */
+	off_t offset;			/**< end of the file */
+	u_int32_t nblocks;		/**< number of blocks */
+	/*
+	 * reading
+	 */
+	struct sst_block *blocks;
+	unsigned char *indexbuf;	/**< index read from the file */
+	unsigned char *bloom;		/**< bloom filter */
+	u_int32_t bloomblocks;		/**< blocks of the bloom filter */
+	unsigned char *data;		/**< records of the loaded block */
+	unsigned char *zdata;		/**< compressed block */
+	long loaded;			/**< loaded block, -1: none */
+	long cursor;			/**< block of the cursor, -1: not set */
+	u_int32_t cursorpos;		/**< next record in the cursor block */
+	STRBUF *key;			/**< key of the cursor */
+	STRBUF *getkey;			/**< key being compared by db->get */
+	/*
+	 * statistics
+	 */
+	unsigned long blockget;
+	unsigned long blockhit;
+	unsigned long blockread;
+} SST;
+
+static int sst_close(DB *, int);
+static int sst_del(const DB *, const DBT *, u_int);
+static int sst_fd(const DB *);
+static int sst_get(const DB *, const DBT *, DBT *, u_int);
+static int sst_put(const DB *, DBT *, const DBT *, u_int);
+static int sst_seq(const DB *, DBT *, DBT *, u_int);
+static int sst_sync(const DB *, u_int);
+
+static void
+put_le(STRBUF *sb, unsigned long long val, int size)
+{
+	while (size-- > 0) {
+		strbuf_putc(sb, val & 0xff);
+		val >>= 8;
+	}
+}
+static unsigned long long
+get_le(const unsigned char *p, int size)
+{
+	unsigned long long val = 0;
+
+	while (size-- > 0)
+		val = (val << 8) | p[size];
+	return val;
+}
+static void
+put_varint(STRBUF *sb, u_int32_t val)
+{
+	while (val >= 0x80) {
+		strbuf_putc(sb, (val & 0x7f) | 0x80);
+		val >>= 7;
+	}
+	strbuf_putc(sb, val);
+}
+/**
+ * get_varint: read a variable length number.
+ *
+ *	@param[in,out]	pp	position, which is advanced
+ *	@param[in]	end	end of the records
+ *	@param[out]	val	number
+ *	@return		0: normal, -1: broken
+ */
+static int
+get_varint(const unsigned char **pp, const unsigned char *end, u_int32_t *val)
+{
+	const unsigned char *p = *pp;
+	int shift;
+
+	*val = 0;
+	for (shift = 0; p < end && shift < 32; shift += 7) {
+		*val |= (u_int32_t)(*p & 0x7f) << shift;
+		if (!(*p++ & 0x80)) {
+			*pp = p;
+			return 0;
+		}
+	}
+	return -1;
+}
+/**
+ * compare: compare keys as the default comparison of B-tree does.
+ */
+static int
+compare(const void *k1, size_t l1, const void *k2, size_t l2)
+{
+	int r = memcmp(k1, k2, l1 < l2 ? l1 : l2);
+
+	if (r != 0)
+		return r;
+	return l1 < l2 ? -1 : l1 > l2 ? 1 : 0;
+}
+static int
+write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+	ssize_t n;
+
+	while (len > 0) {
+		if ((n = write(fd, p, len)) < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += n;
+		len -= n;
+	}
+	return 0;
+}
+static int
+read_at(int fd, off_t offset, void *buf, size_t len)
+{
+#if defined(HAVE_PREAD) && !defined(__CYGWIN__)
+	if (pread(fd, buf, len, offset) != (ssize_t)len)
+		return -1;
+#else
+	if (lseek(fd, offset, SEEK_SET) != offset || read(fd, buf, len) != (ssize_t)len)
+		return -1;
+#endif
+	return 0;
+}
+/**
+ * sstable_open: open a sorted table.
+ *
+ *	@param[in]	path	file
+ *	@param[in]	flags	O_RDONLY: read, O_RDWR|O_CREAT|O_TRUNC: create
+ *	@param[in]	mode	permission of a new file
+ *	@param[in]	bsize	size of a block, 0: SSTABLE_BSIZE
+ *	@return		DB or NULL (errno is set)
+ *
+ * A new table is written by db->put in key order and completed by
+ * db->close. An existing table is read only.
+ */
+DB *
+sstable_open(const char *path, int flags, int mode, int bsize)
+{
+	unsigned char header[SST_HEADERSIZE], footer[SST_FOOTERSIZE];
+	struct stat st;
+	DB *dbp;
+	SST *t;
+	off_t index_offset, bloom_offset;
+	u_int32_t index_length, bloom_length, maxsize, i;
+	const unsigned char *p, *end;
+	int fd, save_errno;
+
+	if ((fd = open(path, flags|O_BINARY, mode)) < 0)
+		return NULL;
+	t = check_calloc(sizeof(SST), 1);
+	t->fd = fd;
+	t->loaded = t->cursor = -1;
+	t->key = strbuf_open(0);
+	t->getkey = strbuf_open(0);
+	dbp = check_calloc(sizeof(DB), 1);
+	dbp->type = DB_SSTABLE;
+	dbp->internal = t;
+	dbp->close = sst_close;
+	dbp->del = sst_del;
+	dbp->fd = sst_fd;
+	dbp->get = sst_get;
+	dbp->put = sst_put;
+	dbp->seq = sst_seq;
+	dbp->sync = sst_sync;
+	if (flags & O_CREAT) {
+		STRBUF *sb = strbuf_open(SST_HEADERSIZE);
+
+		t->writing = 1;
+		t->bsize = bsize > 0 ? bsize : SSTABLE_BSIZE;
+#ifdef USE_ZLIB
+		t->flags = SST_COMPRESSED;
+#endif
+		t->block = strbuf_open(t->bsize + t->bsize / 4);
+		t->index = strbuf_open(0);
+		t->last = strbuf_open(0);
+		t->hashes = varray_open(sizeof(unsigned long long), 10000);
+		put_le(sb, SST_MAGIC, 4);
+		put_le(sb, SST_VERSION, 4);
+		put_le(sb, t->bsize, 4);
+		put_le(sb, t->flags, 4);
+		if (write_all(fd, strbuf_value(sb), SST_HEADERSIZE) < 0) {
+			strbuf_close(sb);
+			goto err;
+		}
+		strbuf_close(sb);
+		t->offset = SST_HEADERSIZE;
+		return dbp;
+	}
+	/*
+	 * Read the header, the footer, the index and the bloom filter.
+	 */
+	errno = EFTYPE;
+	if (fstat(fd, &st) < 0 || st.st_size < SST_HEADERSIZE + SST_FOOTERSIZE)
+		goto err;
+	if (read_at(fd, 0, header, SST_HEADERSIZE) < 0
+	    || read_at(fd, st.st_size - SST_FOOTERSIZE, footer, SST_FOOTERSIZE) < 0)
+		goto err;
+	if (get_le(header, 4) != SST_MAGIC || get_le(header + 4, 4) != SST_VERSION
+	    || get_le(footer + 36, 4) != SST_MAGIC)
+		goto err;
+	t->bsize = get_le(header + 8, 4);
+	t->flags = get_le(header + 12, 4);
+#ifndef USE_ZLIB
+	if (t->flags & SST_COMPRESSED)
+		goto err;
+#endif
+	index_offset = get_le(footer, 8);
+	index_length = get_le(footer + 8, 4);
+	t->nblocks = get_le(footer + 12, 4);
+	bloom_offset = get_le(footer + 16, 8);
+	bloom_length = get_le(footer + 24, 4);
+	t->nrecords = get_le(footer + 32, 4);
+	if (index_offset + index_length > st.st_size || bloom_offset + bloom_length > st.st_size)
+		goto err;
+	if (bloom_length % BLOOM_BLOCKSIZE != 0 || get_le(footer + 28, 4) != BLOOM_HASHES)
+		goto err;
+	t->indexbuf = check_malloc(index_length + 1);
+	t->bloom = check_malloc(bloom_length + 1);
+	t->bloomblocks = bloom_length / BLOOM_BLOCKSIZE;
+	if (read_at(fd, index_offset, t->indexbuf, index_length) < 0
+	    || read_at(fd, bloom_offset, t->bloom, bloom_length) < 0)
+		goto err;
+	t->blocks = check_malloc(sizeof(struct sst_block) * (t->nblocks + 1));
+	p = t->indexbuf;
+	end = p + index_length;
+	maxsize = 0;
+	for (i = 0; i < t->nblocks; i++) {
+		struct sst_block *b = &t->blocks[i];
+
+		if (end - p < 20)
+			goto err;
+		b->offset = get_le(p, 8);
+		b->length = get_le(p + 8, 4);
+		b->size = get_le(p + 12, 4);
+		b->keylen = get_le(p + 16, 4);
+		b->key = p + 20;
+		p += 20 + b->keylen;
+		if (p > end || b->offset + b->length > index_offset)
+			goto err;
+		if (b->size > maxsize)
+			maxsize = b->size;
+	}
+	t->data = check_malloc(maxsize + 1);
+	t->zdata = check_malloc(maxsize + maxsize / 1000 + 64);
+	return dbp;
+err:
+	save_errno = errno;
+	(void)sst_close(dbp, 1);
+	errno = save_errno;
+	return NULL;
+}
+/**
+ * flush_block: write the current block and its index entry.
+ */
+static int
+flush_block(SST *t)
+{
+	const char *data = strbuf_value(t->block);
+	u_int32_t size = strbuf_getlen(t->block);
+	u_int32_t length = size;
+
+	if (size == 0)
+		return 0;
+#ifdef USE_ZLIB
+	{
+		uLongf zlen = compressBound(size);
+
+		if (zlen > t->zbufsize) {
+			t->zbuf = check_realloc(t->zbuf, zlen);
+			t->zbufsize = zlen;
+		}
+		if (compress2(t->zbuf, &zlen, (const Bytef *)data, size, Z_DEFAULT_COMPRESSION) == Z_OK
+		    && zlen < size) {
+			data = (const char *)t->zbuf;
+			length = zlen;
+		}
+	}
+#endif
+	if (write_all(t->fd, data, length) < 0)
+		return -1;
+	put_le(t->index, t->offset, 8);
+	put_le(t->index, length, 4);
+	put_le(t->index, size, 4);
+	put_le(t->index, strbuf_getlen(t->last), 4);
+	strbuf_nputs(t->index, strbuf_value(t->last), strbuf_getlen(t->last));
+	t->offset += length;
+	t->nblocks++;
+	strbuf_reset(t->block);
+	return 0;
+}
+/**
+ * finish: write the rest of a new table.
+ */
+static int
+finish(SST *t)
+{
+	STRBUF *sb;
+	unsigned long long *h = varray_assign(t->hashes, 0, 0);
+	u_int32_t nblocks, i;
+	off_t index_offset, bloom_offset;
+	unsigned char *bloom;
+	int status;
+
+	if (flush_block(t) < 0)
+		return -1;
+	index_offset = t->offset;
+	if (write_all(t->fd, strbuf_value(t->index), strbuf_getlen(t->index)) < 0)
+		return -1;
+	bloom_offset = index_offset + strbuf_getlen(t->index);
+	nblocks = bloom_blocks(t->hashes->length);
+	bloom = check_calloc(nblocks, BLOOM_BLOCKSIZE);
+	for (i = 0; i < t->hashes->length; i++)
+		bloom_set(bloom, nblocks, h[i]);
+	status = write_all(t->fd, bloom, nblocks * BLOOM_BLOCKSIZE);
+	free(bloom);
+	if (status < 0)
+		return -1;
+	sb = strbuf_open(SST_FOOTERSIZE);
+	put_le(sb, index_offset, 8);
+	put_le(sb, strbuf_getlen(t->index), 4);
+	put_le(sb, t->nblocks, 4);
+	put_le(sb, bloom_offset, 8);
+	put_le(sb, nblocks * BLOOM_BLOCKSIZE, 4);
+	put_le(sb, BLOOM_HASHES, 4);
+	put_le(sb, t->nrecords, 4);
+	put_le(sb, SST_MAGIC, 4);
+	status = write_all(t->fd, strbuf_value(sb), SST_FOOTERSIZE);
+	strbuf_close(sb);
+	return status;
+}
+static int
+sst_close(DB *dbp, int nowrite)
+{
+	SST *t = dbp->internal;
+	int status = RET_SUCCESS;
+
+	if (t->writing) {
+		if (!nowrite && finish(t) < 0)
+			status = RET_ERROR;
+		strbuf_close(t->block);
+		strbuf_close(t->index);
+		strbuf_close(t->last);
+		varray_close(t->hashes);
+	}
+	if (close(t->fd) < 0)
+		status = RET_ERROR;
+	strbuf_close(t->key);
+	strbuf_close(t->getkey);
+	free(t->blocks);
+	free(t->indexbuf);
+	free(t->bloom);
+	free(t->data);
+	free(t->zdata);
+	free(t->zbuf);
+	free(t);
+	free(dbp);
+	return status;
+}
+static int
+sst_del(const DB *dbp, const DBT *key, u_int flags)
+{
+	errno = EPERM;
+	return RET_ERROR;
+}
+static int
+sst_fd(const DB *dbp)
+{
+	return ((SST *)dbp->internal)->fd;
+}
+static int
+sst_sync(const DB *dbp, u_int flags)
+{
+	return RET_SUCCESS;
+}
+/**
+ * sst_put: add a record to a new table.
+ *
+ * Records must be put in key order; records of the same key are kept
+ * in the order put.
+ */
+static int
+sst_put(const DB *dbp, DBT *key, const DBT *data, u_int flags)
+{
+	SST *t = dbp->internal;
+	const unsigned char *k = key->data;
+	size_t lastlen = strbuf_getlen(t->last);
+	u_int32_t shared = 0;
+	int r;
+
+	if (!t->writing) {
+		errno = EPERM;
+		return RET_ERROR;
+	}
+	r = t->nrecords ? compare(k, key->size, strbuf_value(t->last), lastlen) : 1;
+	if (r < 0) {
+		errno = EINVAL;
+		return RET_ERROR;
+	}
+	if (r > 0)
+		*(unsigned long long *)varray_append(t->hashes) = bloom_hash(k, key->size);
+	if (strbuf_getlen(t->block) > 0 && strbuf_getlen(t->block) + key->size + data->size > t->bsize) {
+		if (flush_block(t) < 0)
+			return RET_ERROR;
+	}
+	if (strbuf_getlen(t->block) > 0) {
+		const unsigned char *l = (const unsigned char *)strbuf_value(t->last);
+
+		while (shared < lastlen && shared < key->size && l[shared] == k[shared])
+			shared++;
+	}
+	put_varint(t->block, shared);
+	put_varint(t->block, key->size - shared);
+	put_varint(t->block, data->size);
+	strbuf_nputs(t->block, (const char *)k + shared, key->size - shared);
+	strbuf_nputs(t->block, data->data, data->size);
+	strbuf_reset(t->last);
+	strbuf_nputs(t->last, (const char *)k, key->size);
+	t->nrecords++;
+	return RET_SUCCESS;
+}
+#ifdef USE_ZLIB
+/**
+ * inflate_block: uncompress a block.
+ *
+ * uncompress() of zlib is not used, since libutil/compress.c has a
+ * function of the same name.
+ *
+ *	@return		length of the records, -1: broken
+ */
+static long
+inflate_block(unsigned char *out, u_int32_t size, unsigned char *in, u_int32_t length)
+{
+	z_stream z;
+	long n;
+
+	memset(&z, 0, sizeof(z));
+	if (inflateInit(&z) != Z_OK)
+		return -1;
+	z.next_in = in;
+	z.avail_in = length;
+	z.next_out = out;
+	z.avail_out = size;
+	n = (inflate(&z, Z_FINISH) == Z_STREAM_END) ? (long)z.total_out : -1;
+	(void)inflateEnd(&z);
+	return n;
+}
+#endif
+/**
+ * load_block: load a block into t->data.
+ *
+ *	@return		0: normal, -1: error
+ */
+static int
+load_block(SST *t, long n)
+{
+	const struct sst_block *b = &t->blocks[n];
+
+	t->blockget++;
+	if (t->loaded == n) {
+		t->blockhit++;
+		return 0;
+	}
+	t->loaded = -1;
+	t->blockread++;
+	if (b->length == b->size) {
+		if (read_at(t->fd, b->offset, t->data, b->size) < 0)
+			return -1;
+	} else {
+#ifdef USE_ZLIB
+		if (b->length > b->size + b->size / 1000 + 64)
+			goto broken;
+		if (read_at(t->fd, b->offset, t->zdata, b->length) < 0)
+			return -1;
+		if (inflate_block(t->data, b->size, t->zdata, b->length) != b->size)
+			goto broken;
+#else
+		goto broken;
+#endif
+	}
+	t->loaded = n;
+	return 0;
+broken:
+	errno = EFTYPE;
+	return -1;
+}
+/**
+ * read_record: read a record of the loaded block.
+ *
+ *	@param[in]	t	table
+ *	@param[in,out]	pos	position of the record in the block
+ *	@param[in,out]	key	key of the previous record, then of this record
+ *	@param[out]	data	data of this record
+ *	@return		0: normal, -1: broken
+ */
+static int
+read_record(SST *t, u_int32_t *pos, STRBUF *key, DBT *data)
+{
+	const unsigned char *p = t->data + *pos;
+	const unsigned char *end = t->data + t->blocks[t->loaded].size;
+	u_int32_t shared, unshared, datlen;
+
+	if (get_varint(&p, end, &shared) < 0 || get_varint(&p, end, &unshared) < 0
+	    || get_varint(&p, end, &datlen) < 0 || shared > strbuf_getlen(key)
+	    || unshared > end - p || datlen > end - p - unshared) {
+		errno = EFTYPE;
+		return -1;
+	}
+	strbuf_setlen(key, shared);
+	strbuf_nputs(key, (const char *)p, unshared);
+	p += unshared;
+	data->data = (void *)p;
+	data->size = datlen;
+	*pos = p + datlen - t->data;
+	return 0;
+}
+/**
+ * seek: locate the first record whose key is not less than the key.
+ *
+ *	@param[in]	t	table
+ *	@param[in]	k	key
+ *	@param[out]	block	block of the record
+ *	@param[out]	pos	position of the next record in the block
+ *	@param[out]	key	key of the record
+ *	@param[out]	data	data of the record
+ *	@return		RET_SUCCESS, RET_SPECIAL: not found, RET_ERROR
+ */
+static int
+seek(SST *t, const DBT *k, long *block, u_int32_t *pos, STRBUF *key, DBT *data)
+{
+	long lo = 0, hi = t->nblocks;
+
+	/* the first block whose last key is not less than the key */
+	while (lo < hi) {
+		long mid = (lo + hi) / 2;
+		const struct sst_block *b = &t->blocks[mid];
+
+		if (compare(b->key, b->keylen, k->data, k->size) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == t->nblocks)
+		return RET_SPECIAL;
+	if (load_block(t, lo) < 0)
+		return RET_ERROR;
+	*block = lo;
+	*pos = 0;
+	strbuf_reset(key);
+	while (*pos < t->blocks[lo].size) {
+		if (read_record(t, pos, key, data) < 0)
+			return RET_ERROR;
+		if (compare(strbuf_value(key), strbuf_getlen(key), k->data, k->size) >= 0)
+			return RET_SUCCESS;
+	}
+	errno = EFTYPE;
+	return RET_ERROR;
+}
+/**
+ * sst_get: get the data of the first record of the key.
+ *
+ * The bloom filter answers most lookups of absent keys without reading
+ * a block. The cursor is not moved.
+ */
+static int
+sst_get(const DB *dbp, const DBT *key, DBT *data, u_int flags)
+{
+	SST *t = dbp->internal;
+	u_int32_t pos;
+	long block;
+	int status;
+
+	if (t->writing) {
+		errno = EPERM;
+		return RET_ERROR;
+	}
+	if (t->bloomblocks > 0 && !bloom_check(t->bloom, t->bloomblocks, bloom_hash(key->data, key->size)))
+		return RET_SPECIAL;
+	status = seek(t, key, &block, &pos, t->getkey, data);
+	if (status != RET_SUCCESS)
+		return status;
+	if (compare(strbuf_value(t->getkey), strbuf_getlen(t->getkey), key->data, key->size) != 0)
+		return RET_SPECIAL;
+	return RET_SUCCESS;
+}
+/**
+ * sst_seq: sequential read.
+ *
+ *	R_CURSOR:	the first record whose key is not less than the key
+ *	R_FIRST:	the first record
+ *	R_NEXT:		the record next to the cursor, or the first record
+ */
+static int
+sst_seq(const DB *dbp, DBT *key, DBT *data, u_int flags)
+{
+	SST *t = dbp->internal;
+	int status;
+
+	if (t->writing) {
+		errno = EPERM;
+		return RET_ERROR;
+	}
+	switch (flags) {
+	case R_CURSOR:
+		status = seek(t, key, &t->cursor, &t->cursorpos, t->key, data);
+		if (status != RET_SUCCESS) {
+			t->cursor = t->nblocks;
+			return status;
+		}
+		goto found;
+	case R_NEXT:
+		if (t->cursor >= 0)
+			break;
+		/* FALLTHROUGH */
+	case R_FIRST:
+		t->cursor = 0;
+		t->cursorpos = 0;
+		strbuf_reset(t->key);
+		break;
+	default:
+		errno = EINVAL;
+		return RET_ERROR;
+	}
+	for (;;) {
+		if (t->cursor >= t->nblocks)
+			return RET_SPECIAL;
+		if (t->cursorpos < t->blocks[t->cursor].size)
+			break;
+		t->cursor++;
+		t->cursorpos = 0;
+		strbuf_reset(t->key);
+	}
+	if (load_block(t, t->cursor) < 0)
+		return RET_ERROR;
+	/*
+	 * Since db->get shares the block buffer, the key of the cursor is
+	 * kept in t->key; only the position is needed to read on.
+	 */
+	if (read_record(t, &t->cursorpos, t->key, data) < 0)
+		return RET_ERROR;
+found:
+	key->data = strbuf_value(t->key);
+	key->size = strbuf_getlen(t->key);
+	return RET_SUCCESS;
+}
+/**
+ * sstable_stat: get the statistics of a table.
+ *
+ * A block counts as a page. The index is kept in memory, so the
+ * depth is 1.
+ */
+int
+sstable_stat(const DB *dbp, DBSTAT *sp)
+{
+	SST *t = dbp->internal;
+
+	memset(sp, 0, sizeof(DBSTAT));
+	sp->pageget = t->blockget;
+	sp->cachehit = t->blockhit;
+	sp->cachemiss = t->blockget - t->blockhit;
+	sp->pageread = t->blockread;
+	sp->npages = t->nblocks;
+	sp->psize = t->bsize;
+	sp->maxcache = 1;
+	sp->levels = 1;
+	return RET_SUCCESS;
+}
+#endif /* !USE_DB185_COMPAT */
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2026 Tama Communications Corporation
+ *
+ * This file is part of GNU GLOBAL.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef _SSTABLE_H_
+#define _SSTABLE_H_
+
+#include "dbop.h"
+
+/*
+ * Sorted table (sstable): a read only tag file.
+ *
+ * The records of a tag file are written once in key order into compressed
+ * blocks, followed by the index of the blocks and a bloom filter of the
+ * keys. sstable_open() returns a DB, which is read through db->get and
+ * db->seq like a B-tree, so dbop reads it without knowing the format.
+ */
+		/** default size of the records of a block */
+#define SSTABLE_BSIZE		16384
+
+#ifndef USE_DB185_COMPAT
+DB *sstable_open(const char *, int, int, int);
+int sstable_stat(const DB *, DBSTAT *);
+#endif
+int is_sstable(const char *);
+
+#endif /* ! _SSTABLE_H_ */
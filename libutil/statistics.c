@@ -120,6 +120,18 @@ static STATISTICS_TIME *T_all;
 static STAILQ_HEAD(statistics_time_list, statistics_time)
 	statistics_time_list = STAILQ_HEAD_INITIALIZER(statistics_time_list);
 
+struct statistics_db {
+	STAILQ_ENTRY(statistics_db) next;
+
+	STATISTICS_DB count;
+
+	int name_len;
+	char name[1];
+};
+
+static STAILQ_HEAD(statistics_db_list, statistics_db)
+	statistics_db_list = STAILQ_HEAD_INITIALIZER(statistics_db_list);
+
 void
 init_statistics(void)
 {
@@ -186,6 +198,42 @@ statistics_time_end(STATISTICS_TIME *t)
 	STAILQ_INSERT_TAIL(&statistics_time_list, t, next);
 }
 
+/**
+ * statistics_db: add up the counters of a tag file.
+ *
+ *	@param[in]	name	path of the tag file
+ *	@param[in]	count	counters of an open of the file
+ *
+ * Nothing is done unless init_statistics() has been called.
+ */
+void
+statistics_db(const char *name, const STATISTICS_DB *count)
+{
+	struct statistics_db *d;
+
+	if (sb == NULL)
+		return;
+	STAILQ_FOREACH(d, &statistics_db_list, next)
+		if (!strcmp(d->name, name))
+			break;
+	if (d == NULL) {
+		d = check_malloc(offsetof(struct statistics_db, name) + strlen(name) + 1);
+		memset(&d->count, 0, sizeof(d->count));
+		d->name_len = strlen(name);
+		strcpy(d->name, name);
+		STAILQ_INSERT_TAIL(&statistics_db_list, d, next);
+	}
+	d->count.readcount += count->readcount;
+	d->count.pageget += count->pageget;
+	d->count.cachehit += count->cachehit;
+	d->count.pageshared += count->pageshared;
+	d->count.pageread += count->pageread;
+	d->count.pagewrite += count->pagewrite;
+	d->count.pagesize = count->pagesize;
+	if (count->depth > d->count.depth)
+		d->count.depth = count->depth;
+}
+
 struct printing_width {
 	int name;
 	int elapsed;
@@ -405,6 +453,113 @@ print_time_table(const STATISTICS_TIME *t, void *priv)
 #endif
 }
 
+/*
+ * Columns of the counters of a tag file.
+ */
+#define DB_COLUMNS	9
+#define DB_COLUMN_LEN	32
+
+static const char *const db_heading_string[DB_COLUMNS] = {
+	"pagesize", "depth", "records", "gets", "hit[%]", "shared", "reads", "read[KB]", "writes"
+};
+
+static void
+format_db(const struct statistics_db *d, char buf[DB_COLUMNS][DB_COLUMN_LEN])
+{
+	const STATISTICS_DB *c = &d->count;
+
+	snprintf(buf[0], DB_COLUMN_LEN, "%d", c->pagesize);
+	snprintf(buf[1], DB_COLUMN_LEN, "%d", c->depth);
+	snprintf(buf[2], DB_COLUMN_LEN, "%lu", c->readcount);
+	snprintf(buf[3], DB_COLUMN_LEN, "%lu", c->pageget);
+	snprintf(buf[4], DB_COLUMN_LEN, "%.1f",
+		c->pageget ? (double)c->cachehit * 100 / c->pageget : 0.0);
+	snprintf(buf[5], DB_COLUMN_LEN, "%lu", c->pageshared);
+	snprintf(buf[6], DB_COLUMN_LEN, "%lu", c->pageread);
+	snprintf(buf[7], DB_COLUMN_LEN, "%.0f", (double)c->pageread * c->pagesize / 1024);
+	snprintf(buf[8], DB_COLUMN_LEN, "%lu", c->pagewrite);
+}
+
+static void
+print_db_list(void)
+{
+	const struct statistics_db *d;
+	char buf[DB_COLUMNS][DB_COLUMN_LEN];
+	char *dots;
+	int name_width = 0;
+
+	STAILQ_FOREACH(d, &statistics_db_list, next)
+		if (d->name_len > name_width)
+			name_width = d->name_len;
+	dots = check_malloc(name_width + MIN_DOTS_LEN + 1);
+	memset(dots, '.', name_width + MIN_DOTS_LEN);
+	dots[name_width + MIN_DOTS_LEN] = '\0';
+
+	STAILQ_FOREACH(d, &statistics_db_list, next) {
+		format_db(d, buf);
+		message("- %s %s pagesize %s depth %s records %s gets %s hit %s%%"
+			" shared %s reads %s (%sKB) writes %s",
+			d->name, dots + d->name_len,
+			buf[0], buf[1], buf[2], buf[3], buf[4], buf[5], buf[6], buf[7],
+			buf[8]);
+	}
+	free(dots);
+}
+
+static const char db_name_heading_string[] = "tag file";
+
+static void
+print_db_table(void)
+{
+	const struct statistics_db *d;
+	char buf[DB_COLUMNS][DB_COLUMN_LEN];
+	int width[DB_COLUMNS];
+	int name_width = sizeof(db_name_heading_string) - 1;
+	int bar_len, i;
+	char *bar;
+
+	for (i = 0; i < DB_COLUMNS; i++)
+		width[i] = (int)strlen(db_heading_string[i]);
+	STAILQ_FOREACH(d, &statistics_db_list, next) {
+		if (d->name_len > name_width)
+			name_width = d->name_len;
+		format_db(d, buf);
+		for (i = 0; i < DB_COLUMNS; i++)
+			if ((int)strlen(buf[i]) > width[i])
+				width[i] = (int)strlen(buf[i]);
+	}
+	bar_len = name_width;
+	for (i = 0; i < DB_COLUMNS; i++)
+		if (width[i] > bar_len)
+			bar_len = width[i];
+	bar = check_malloc(bar_len + 1);
+	memset(bar, '-', bar_len);
+	bar[bar_len] = '\0';
+
+	message("%s", "");
+	message("%-*s %*s %*s %*s %*s %*s %*s %*s %*s %*s",
+		name_width, db_name_heading_string,
+		width[0], db_heading_string[0], width[1], db_heading_string[1],
+		width[2], db_heading_string[2], width[3], db_heading_string[3],
+		width[4], db_heading_string[4], width[5], db_heading_string[5],
+		width[6], db_heading_string[6], width[7], db_heading_string[7],
+		width[8], db_heading_string[8]);
+	message("%.*s %.*s %.*s %.*s %.*s %.*s %.*s %.*s %.*s %.*s",
+		name_width, bar,
+		width[0], bar, width[1], bar, width[2], bar, width[3], bar,
+		width[4], bar, width[5], bar, width[6], bar, width[7], bar,
+		width[8], bar);
+	STAILQ_FOREACH(d, &statistics_db_list, next) {
+		format_db(d, buf);
+		message("%-*s %*s %*s %*s %*s %*s %*s %*s %*s %*s",
+			name_width, d->name,
+			width[0], buf[0], width[1], buf[1], width[2], buf[2],
+			width[3], buf[3], width[4], buf[4], width[5], buf[5],
+			width[6], buf[6], width[7], buf[7], width[8], buf[8]);
+	}
+	free(bar);
+}
+
 static void
 print_footer_common(void *priv)
 {
@@ -415,15 +570,16 @@ struct printng_style {
 	void (*print_header)(void **);
 	void (*print_time)(const STATISTICS_TIME *, void *);
 	void (*print_footer)(void *);
+	void (*print_db)(void);
 };
 
 static const struct printng_style printing_styles[] = {
 	/* STATISTICS_STYLE_NONE */
-	{ NULL, NULL, NULL },
+	{ NULL, NULL, NULL, NULL },
 	/* STATISTICS_STYLE_LIST */
-	{ print_header_list, print_time_list, print_footer_common },
+	{ print_header_list, print_time_list, print_footer_common, print_db_list },
 	/* STATISTICS_STYLE_TABLE */
-	{ print_header_table, print_time_table, print_footer_common },
+	{ print_header_table, print_time_table, print_footer_common, print_db_table },
 };
 
 #if !defined(ARRAY_SIZE)
@@ -435,6 +591,7 @@ print_statistics(int style_no)
 {
 	const struct printng_style *style;
 	STATISTICS_TIME *t;
+	struct statistics_db *d;
 	void *priv;
 
 	assert(T_all != NULL);
@@ -459,6 +616,14 @@ print_statistics(int style_no)
 	if (style->print_footer != NULL)
 		style->print_footer(priv);
 
+	if (style->print_db != NULL && !STAILQ_EMPTY(&statistics_db_list))
+		style->print_db();
+	while (!STAILQ_EMPTY(&statistics_db_list)) {
+		d = STAILQ_FIRST(&statistics_db_list);
+		STAILQ_REMOVE_HEAD(&statistics_db_list, next);
+		free(d);
+	}
+
 	strbuf_close(sb);
 	T_all = NULL;
 	sb = NULL;
@@ -89,10 +89,36 @@ enum {
 	STATISTICS_STYLE_TABLE
 };
 
+/**
+ * STATISTICS_DB:
+ *    Counters of a tag file. dbop_close() adds them up for each file,
+ *    and print_statistics() prints them after the times like following.
+ *
+ *     tag file  pagesize depth records  gets hit[%] shared reads read[KB] writes
+ *     --------- -------- ----- ------- ----- ------ ------ ----- -------- ------
+ *     /tmp/GTAGS    8192     3   24093 50344   99.6      0   202     1616      0
+ *
+ *    'reads' and 'read[KB]' include the pages read ahead. If 'reads' is
+ *    large while 'hit[%]' is low, enlarging GTAGSCACHE may help. 'shared'
+ *    is the pages copied from the shared cache (GTAGSSHAREDCACHE) instead
+ *    of being read.
+ */
+typedef struct {
+	unsigned long readcount;	/**< records read through dbop */
+	unsigned long pageget;		/**< pages requested to the cache */
+	unsigned long cachehit;		/**< pages found in the cache */
+	unsigned long pageshared;	/**< pages copied from the shared cache */
+	unsigned long pageread;		/**< pages read from the file */
+	unsigned long pagewrite;	/**< pages written to the file */
+	int pagesize;			/**< page size */
+	int depth;			/**< levels of the B-tree */
+} STATISTICS_DB;
+
 void init_statistics(void);
 STATISTICS_TIME *statistics_time_start(const char *, ...)
 	__attribute__ ((__format__ (__printf__, 1, 2)));
 void statistics_time_end(STATISTICS_TIME *);
+void statistics_db(const char *, const STATISTICS_DB *);
 void print_statistics(int);
 
 #endif
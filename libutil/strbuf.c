@@ -23,6 +23,7 @@
 #include <config.h>
 #endif
 #include <ctype.h>
+#include <limits.h>
 #ifdef STDC_HEADERS
 #include <stdlib.h>
 #endif
@@ -87,9 +88,25 @@ void
 __strbuf_expandbuf(STRBUF *sb, int length)
 {
 	int count = sb->curp - sb->sbuf;
-	int newsize = sb->sbufsize + (length > EXPANDSIZE ? length : EXPANDSIZE);
+	size_t newsize, grow;
 	char *newbuf;
 
+	/*
+	 * The size is kept in an int. The required room must fit in it.
+	 */
+	if (length < 0 || (size_t)sb->sbufsize + length > INT_MAX)
+		die("string buffer too large.");
+	/*
+	 * Grow at least by the current size so that large buffers are
+	 * not reallocated repeatedly, but not beyond the limit.
+	 */
+	grow = length > sb->sbufsize ? length : sb->sbufsize;
+	if (grow < EXPANDSIZE)
+		grow = EXPANDSIZE;
+	newsize = (size_t)sb->sbufsize + grow;
+	if (newsize > INT_MAX)
+		newsize = INT_MAX;
+
 	newbuf = (char *)check_realloc(sb->sbuf, newsize + 1);
 	sb->sbufsize = newsize;
 	sb->sbuf = newbuf;
@@ -161,8 +178,8 @@ strbuf_nputs(STRBUF *sb, const char *s, int len)
 	if (len > 0) {
 		if (sb->curp + len > sb->endp)
 			__strbuf_expandbuf(sb, len);
-		while (len-- > 0)
-			*sb->curp++ = *s++;
+		memcpy(sb->curp, s, len);
+		sb->curp += len;
 	}
 }
 /**
@@ -115,14 +115,14 @@ read_file_detabing(char *buf, size_t size, FILE *ip, int *dest_saved, int *space
 	return p - buf;
 }
 /**
- * detab_replacing: convert tabs into spaces and print with replacing.
+ * detab_replacing: convert tabs into spaces and put with replacing.
  *
- *	@param[in]	op	FILE *
+ *	@param[out]	sb	string buffer
  *	@param[in]	buf	string including tabs
  *	@param[in]	replace	replacing function
  */
 void
-detab_replacing(FILE *op, const char *buf, const char *(*replace)(int c))
+detab_replacing(STRBUF *sb, const char *buf, const char *(*replace)(int c))
 {
 	int dst, spaces;
 	int c;
@@ -132,17 +132,15 @@ detab_replacing(FILE *op, const char *buf, const char *(*replace)(int c))
 		if (c == '\t') {
 			spaces = tabs - dst % tabs;
 			dst += spaces;
-			do {
-				putc(' ', op);
-			} while (--spaces);
+			strbuf_nputc(sb, ' ', spaces);
 		} else {
 			const char *s = replace(c);
 			if (s)
-				fputs(s, op);
+				strbuf_puts(sb, s);
 			else
-				putc(c, op);
+				strbuf_putc(sb, c);
 			dst++;
 		}
 	}
-	putc('\n', op);
+	strbuf_putc(sb, '\n');
 }
@@ -23,9 +23,11 @@
 
 #include <stdio.h>
 
+#include "strbuf.h"
+
 void settabs(int);
 size_t read_file_detabing(char *, size_t, FILE *, int *, int *);
-void detab_replacing(FILE *op, const char *buf, const char *(*replace)(int c));
+void detab_replacing(STRBUF *, const char *, const char *(*)(int));
 
 
 #endif /* ! _TAB_H_ */
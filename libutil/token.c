@@ -22,79 +22,256 @@
 #include <config.h>
 #endif
 #include <ctype.h>
+#include <errno.h>
 #include <stdio.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef STDC_HEADERS
+#include <stdlib.h>
+#endif
 #ifdef HAVE_STRING_H
 #include <string.h>
 #else
 #include <strings.h>
 #endif
+#ifdef HAVE_FCNTL_H
+#include <fcntl.h>
+#endif
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
+#include "checkalloc.h"
 #include "die.h"
 #include "gparam.h"
 #include "strlimcpy.h"
 #include "token.h"
 
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
 /*
- * File input method.
+ * Character class table.
+ *
+ * It is equivalent to isspace(), isalpha() and isdigit() in the C locale,
+ * and avoids the function call per character.
  */
-int lineno;
-const char *sp, *cp, *lp;
-int crflag;			/* 1: return '\n', 0: doesn't return */
-int cmode;			/* allow token which start with '#' */
-int cppmode;			/* allow '::' as a token */
-int ymode;			/* allow token which start with '%' */
-char token[MAXTOKEN];
-char curfile[MAXPATHLEN];
-int continued_line;		/* previous line ends with '\' */
+#define S	1		/* space */
+#define A	2		/* alphabet */
+#define D	4		/* digit */
+#define U	8		/* '_' */
+#define H	16		/* 8 bit character */
+static const unsigned char ctype_table[256] = {
+	0, 0, 0, 0, 0, 0, 0, 0,
+	0, S, S, S, S, S, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0,
+	S, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0,
+	D, D, D, D, D, D, D, D,
+	D, D, 0, 0, 0, 0, 0, 0,
+	0, A, A, A, A, A, A, A,
+	A, A, A, A, A, A, A, A,
+	A, A, A, A, A, A, A, A,
+	A, A, A, 0, 0, 0, 0, U,
+	0, A, A, A, A, A, A, A,
+	A, A, A, A, A, A, A, A,
+	A, A, A, A, A, A, A, A,
+	A, A, A, 0, 0, 0, 0, 0,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+	H, H, H, H, H, H, H, H,
+};
+#undef S
+#undef A
+#undef D
+#undef U
+#undef H
+#define IS_SPACE(c)	(ctype_table[c] & 1)
+#define IS_DIGIT(c)	(ctype_table[c] & 4)
+#define IS_ALNUM(c)	(ctype_table[c] & (2|4))
+#define IS_IDENT(c)	(ctype_table[c] & (2|4|8|16))
+#define IS_IDENT_START(c)	(ctype_table[c] & (2|8|16))
 
-static char ptok[MAXTOKEN];
-static int lasttok;
-static FILE *ip;
-static STRBUF *ib;
+#define tlen	(p - &tp->token[0])
+#define bufgetc(tp, pos)	((pos) < (tp)->endp ? (unsigned char)*(pos)++ : EOF)
+static void pushbackchar(TOKEN *);
+static void skipto(TOKEN *, const char *);
 
-#define tlen	(p - &token[0])
-static void pushbackchar(void);
+/**
+ * readfile: read whole of a file into memory.
+ *
+ *	@param[in]	file	file name
+ *	@param[out]	buf	contents of the file (NULL if the file is empty)
+ *	@param[out]	size	size of the contents
+ *	@return		0: success, -1: cannot open the file
+ *
+ * The file is read with read(2) into a malloc'ed buffer, not mapped by
+ * mmap(2): a mapped file which is truncated by another process while it
+ * is parsed raises SIGBUS. If the file gets shorter while it is read,
+ * size is what was actually read.
+ */
+int
+readfile(const char *file, char **buf, size_t *size)
+{
+	struct stat st;
+	size_t len;
+	ssize_t n;
+	int fd;
 
+	if ((fd = open(file, O_RDONLY|O_BINARY)) < 0)
+		return -1;
+	if (fstat(fd, &st) < 0) {
+		close(fd);
+		return -1;
+	}
+	*buf = NULL;
+	*size = 0;
+	if (st.st_size > 0) {
+		*buf = check_malloc(st.st_size);
+		for (len = 0; len < (size_t)st.st_size; len += n) {
+			n = read(fd, *buf + len, st.st_size - len);
+			if (n < 0) {
+				if (errno != EINTR)
+					die("read failed (%s).", file);
+				n = 0;
+			} else if (n == 0)
+				break;
+		}
+		if (len == 0) {
+			free(*buf);
+			*buf = NULL;
+		}
+		*size = len;
+	}
+	close(fd);
+	return 0;
+}
+/**
+ * freefile: release the memory read by readfile().
+ */
+void
+freefile(char *buf, size_t size)
+{
+	if (size > 0)
+		free(buf);
+}
 /**
- * opentoken:
+ * opentoken: open a file for the tokenizer.
  *
  *	@param[in]	file
+ *	@return		tokenizer context, NULL: cannot open the file
+ *
+ * Whole of the file is read into memory at once.
  */
-int
+TOKEN *
 opentoken(const char *file)
 {
-	/*
-	 * b flag is needed for WIN32 environment. Almost unix ignore it.
-	 */
-	if ((ip = fopen(file, "rb")) == NULL)
-		return 0;
-	ib = strbuf_open(MAXBUFLEN);
-	strlimcpy(curfile, file, sizeof(curfile));
-	sp = cp = lp = NULL; ptok[0] = '\0'; lineno = 0;
-	crflag = cmode = cppmode = ymode = 0;
-	continued_line = 0;
-	return 1;
+	TOKEN *tp;
+	char *buf;
+	size_t size;
+
+	if (readfile(file, &buf, &size) < 0)
+		return NULL;
+	tp = opentoken_buffer(file, buf, size);
+	tp->ownbuf = 1;
+	return tp;
 }
 /**
- * closetoken:
+ * opentoken_buffer: open the contents of a file already in memory.
+ *
+ *	@param[in]	file	file name
+ *	@param[in]	buf	contents of the file
+ *	@param[in]	size	size of the contents
+ *	@return		tokenizer context
+ *
+ * The contents must be kept until closetoken() is called.
+ */
+TOKEN *
+opentoken_buffer(const char *file, const char *buf, size_t size)
+{
+	TOKEN *tp = check_calloc(sizeof(TOKEN), 1);
+
+	tp->buf = buf;
+	tp->bufsize = size;
+	tp->ep = tp->buf;
+	tp->endp = tp->buf + tp->bufsize;
+	tp->ib = strbuf_open(MAXBUFLEN);
+	strlimcpy(tp->curfile, file, sizeof(tp->curfile));
+	return tp;
+}
+/**
+ * closetoken: close the tokenizer context.
+ *
+ *	@param[in]	tp	tokenizer context
  */
 void
-closetoken(void)
+closetoken(TOKEN *tp)
 {
-	strbuf_close(ib);
-	fclose(ip);
+	if (tp->ownbuf)
+		freefile((char *)tp->buf, tp->bufsize);
+	strbuf_close(tp->ib);
+	free(tp);
+}
+/**
+ * nextline: read the next line.
+ *
+ *	@param[in]	tp	tokenizer context
+ *	@return		line without '\r' and '\n', NULL: end of file
+ *
+ * It is compatible with strbuf_fgets(ib, ip, STRBUF_NOCRLF).
+ */
+const char *
+nextline(TOKEN *tp)
+{
+	const char *start = tp->ep;
+	const char *nl;
+	size_t len;
+
+	if (start >= tp->endp)
+		return NULL;
+	nl = memchr(start, '\n', tp->endp - start);
+	if (nl) {
+		len = nl - start;
+		if (len > 0 && start[len - 1] == '\r')
+			len--;
+		tp->ep = nl + 1;
+	} else {
+		len = tp->endp - start;
+		tp->ep = tp->endp;
+	}
+	tp->lineoff = start - tp->buf;
+	tp->linelen = len;
+	strbuf_reset(tp->ib);
+	strbuf_nputs(tp->ib, start, len);
+	return strbuf_value(tp->ib);
 }
 
 /*
  * nexttoken: get next token
  *
+ *	@param[in]	tp	tokenizer context
  *	@param[in]	interested	interested special character
  *				if NULL then all character.
  *	@param[in]	reserved	converter from token to token number
  *				if this is specified, nexttoken() return
  *				word number, else return symbol.
  *	@return	EOF(-1)	end of file,
- *		c ==0		symbol (SYMBOL; token has the value.),
+ *		c ==0		symbol (SYMBOL; tp->token has the value.),
  *		c < 256		interested special character,
  *		c > 1000	reserved word
  *
@@ -106,7 +283,7 @@ closetoken(void)
  */
 
 int
-nexttoken(const char *interested, int (*reserved)(const char *, int))
+nexttoken(TOKEN *tp, const char *interested, int (*reserved)(const char *, int))
 {
 	int c;
 	char *p;
@@ -114,95 +291,97 @@ nexttoken(const char *interested, int (*reserved)(const char *, int))
 	int percent = 0;
 
 	/* check push back buffer */
-	if (ptok[0]) {
-		strlimcpy(token, ptok, sizeof(token));
-		ptok[0] = '\0';
-		return lasttok;
+	if (tp->ptok[0]) {
+		strlimcpy(tp->token, tp->ptok, sizeof(tp->token));
+		tp->ptok[0] = '\0';
+		return tp->lasttok;
 	}
 
 	for (;;) {
 		/* skip spaces */
-		if (!crflag)
-			while ((c = nextchar()) != EOF && isspace(c))
+		if (!tp->crflag)
+			while ((c = nextchar(tp)) != EOF && IS_SPACE(c))
 				;
 		else
-			while ((c = nextchar()) != EOF && isspace(c) && c != '\n')
+			while ((c = nextchar(tp)) != EOF && IS_SPACE(c) && c != '\n')
 				;
 		if (c == EOF || c == '\n')
 			break;
 
 		if (c == '"' || c == '\'') {	/* quoted string */
+			const char *stops = (c == '"') ? "\"\\" : "'\\";
 			int quote = c;
 
-			while ((c = nextchar()) != EOF) {
+			for (skipto(tp, stops); (c = nextchar(tp)) != EOF; skipto(tp, stops)) {
 				if (c == quote)
 					break;
 				if (quote == '\'' && c == '\n')
 					break;
-				if (c == '\\' && (c = nextchar()) == EOF)
+				if (c == '\\' && (c = nextchar(tp)) == EOF)
 					break;
 			}
 		} else if (c == '/') {			/* comment */
-			if ((c = nextchar()) == '/') {
-				while ((c = nextchar()) != EOF)
+			if ((c = nextchar(tp)) == '/') {
+				skipto(tp, "");
+				while ((c = nextchar(tp)) != EOF)
 					if (c == '\n') {
-						pushbackchar();
+						pushbackchar(tp);
 						break;
 					}
 			} else if (c == '*') {
-				while ((c = nextchar()) != EOF) {
+				for (skipto(tp, "*"); (c = nextchar(tp)) != EOF; skipto(tp, "*")) {
 					if (c == '*') {
-						if ((c = nextchar()) == '/')
+						if ((c = nextchar(tp)) == '/')
 							break;
-						pushbackchar();
+						pushbackchar(tp);
 					}
 				}
 			} else
-				pushbackchar();
+				pushbackchar(tp);
 		} else if (c == '\\') {
-			if (nextchar() == '\n')
-				continued_line = 1;
-		} else if (isdigit(c)) {		/* digit */
-			while ((c = nextchar()) != EOF && (c == '.' || isalnum(c)))
+			if (nextchar(tp) == '\n')
+				tp->continued_line = 1;
+		} else if (IS_DIGIT(c)) {		/* digit */
+			while ((c = nextchar(tp)) != EOF && (c == '.' || IS_ALNUM(c)))
 				;
-			pushbackchar();
-		} else if (c == '#' && cmode) {
+			pushbackchar(tp);
+		} else if (c == '#' && tp->cmode) {
 			/* recognize '##' as a token if it is reserved word. */
-			if (peekc(1) == '#') {
-				p = token;
+			if (peekc(tp, 1) == '#') {
+				p = tp->token;
 				*p++ = c;
-				*p++ = nextchar();
+				*p++ = nextchar(tp);
 				*p   = 0;
-				if (reserved && (c = (*reserved)(token, tlen)) == 0)
+				if (reserved && (c = (*reserved)(tp->token, tlen)) == 0)
 					break;
-			} else if (!continued_line && atfirst_exceptspace()) {
+			} else if (!tp->continued_line && atfirst_exceptspace(tp)) {
 				sharp = 1;
 				continue;
 			}
-		} else if (c == ':' && cppmode && peekc(1) == ':') {
-			p = token;
+		} else if (c == ':' && tp->cppmode && peekc(tp, 1) == ':') {
+			p = tp->token;
 			*p++ = c;
-			*p++ = nextchar();
+			*p++ = nextchar(tp);
 			*p   = 0;
-			if (reserved && (c = (*reserved)(token, tlen)) == 0)
+			if (reserved && (c = (*reserved)(tp->token, tlen)) == 0)
 				break;
-		} else if (c == '%' && ymode) {
+		} else if (c == '%' && tp->ymode) {
 			/* recognize '%%' as a token if it is reserved word. */
-			if (atfirst) {
-				p = token;
+			if (atfirst(tp)) {
+				p = tp->token;
 				*p++ = c;
-				if ((c = peekc(1)) == '%' || c == '{' || c == '}') {
-					*p++ = nextchar();
+				if ((c = peekc(tp, 1)) == '%' || c == '{' || c == '}') {
+					*p++ = nextchar(tp);
 					*p   = 0;
-					if (reserved && (c = (*reserved)(token, tlen)) != 0)
+					if (reserved && (c = (*reserved)(tp->token, tlen)) != 0)
 						break;
-				} else if (!isspace(c)) {
+				} else if (!IS_SPACE(c)) {
 					percent = 1;
 					continue;
 				}
 			}
-		} else if (c & 0x80 || isalpha(c) || c == '_') {/* symbol */
-			p = token;
+		} else if (IS_IDENT_START(c)) {	/* symbol */
+			p = tp->token;
 			if (sharp) {
 				sharp = 0;
 				*p++ = '#';
@@ -210,28 +389,28 @@ nexttoken(const char *interested, int (*reserved)(const char *, int))
 				percent = 0;
 				*p++ = '%';
 			} else if (c == 'L') {
-				int tmp = peekc(1);
+				int tmp = peekc(tp, 1);
 
 				if (tmp == '\"' || tmp == '\'')
 					continue;
 			}
-			for (*p++ = c; (c = nextchar()) != EOF && (c & 0x80 || isalnum(c) || c == '_');) {
-				if (tlen < sizeof(token))
+			for (*p++ = c; (c = nextchar(tp)) != EOF && IS_IDENT(c);) {
+				if (tlen < sizeof(tp->token))
 					*p++ = c;
 			}
-			if (tlen == sizeof(token)) {
-				warning("symbol name is too long. (Ignored) [+%d %s]", lineno, curfile);
-				token[0] = '\0';
+			if (tlen == sizeof(tp->token)) {
+				warning("symbol name is too long. (Ignored) [+%d %s]", tp->lineno, tp->curfile);
+				tp->token[0] = '\0';
 				continue;
 			}
 			*p = 0;
 	
 			if (c != EOF)
-				pushbackchar();
+				pushbackchar(tp);
 			/* convert token string into token number */
 			c = SYMBOL;
 			if (reserved)
-				c = (*reserved)(token, tlen);
+				c = (*reserved)(tp->token, tlen);
 			break;
 		} else {				/* special char */
 			if (interested == NULL || strchr(interested, c))
@@ -240,7 +419,7 @@ nexttoken(const char *interested, int (*reserved)(const char *, int))
 		}
 		sharp = percent = 0;
 	}
-	return lasttok = c;
+	return tp->lasttok = c;
 }
 /**
  * pushbacktoken: push back token
@@ -248,41 +427,42 @@ nexttoken(const char *interested, int (*reserved)(const char *, int))
  *	following nexttoken() return same token again.
  */
 void
-pushbacktoken(void)
+pushbacktoken(TOKEN *tp)
 {
-	strlimcpy(ptok, token, sizeof(ptok));
+	strlimcpy(tp->ptok, tp->token, sizeof(tp->ptok));
 }
 /**
  * peekc: peek next char
  *
+ *	@param[in]	tp	tokenizer context
  *	@param[in]	immediate	0: ignore blank, 1: include blank
  *
  * peekc() read ahead following blanks but doesn't change line.
  */
 int
-peekc(int immediate)
+peekc(TOKEN *tp, int immediate)
 {
 	int c;
-	long pos;
+	const char *pos;
     int comment = 0;
 
-	if (cp != NULL) {
+	if (tp->cp != NULL) {
 		if (immediate)
-			c = nextchar();
+			c = nextchar(tp);
 		else
-            while ((c = nextchar()) != EOF && c != '\n') {
+            while ((c = nextchar(tp)) != EOF && c != '\n') {
                 if (c == '/') {			/* comment */
-                    if ((c = nextchar()) == '/') {
-                        while ((c = nextchar()) != EOF)
+                    if ((c = nextchar(tp)) == '/') {
+                        while ((c = nextchar(tp)) != EOF)
                             if (c == '\n') {
-                                pushbackchar();
+                                pushbackchar(tp);
                                 break;
                             }
                     } else if (c == '*') {
                         comment = 1;
-                        while ((c = nextchar()) != EOF) {
+                        while ((c = nextchar(tp)) != EOF) {
                             if (c == '*') {
-                                if ((c = nextchar()) == '/')
+                                if ((c = nextchar(tp)) == '/')
                                 {
                                     comment = 0;
                                     break;
@@ -290,30 +470,30 @@ peekc(int immediate)
                             }
                             else if (c == '\n')
                             {
-                                pushbackchar();
+                                pushbackchar(tp);
                                 break;
                             }
                         }
                     } else
-                        pushbackchar();
+                        pushbackchar(tp);
                 }
-                else if (!isspace(c))
+                else if (!IS_SPACE(c))
                     break;
             }
 		if (c != EOF)
-			pushbackchar();
+			pushbackchar(tp);
 		if (c != '\n' || immediate)
 			return c;
 	}
-	pos = ftell(ip);
+	pos = tp->ep;
 	if (immediate)
-		c = getc(ip);
+		c = bufgetc(tp, pos);
 	else
-        while ((c = getc(ip)) != EOF) {
+        while ((c = bufgetc(tp, pos)) != EOF) {
             if (comment) {
-                while ((c = getc(ip)) != EOF) {
+                while ((c = bufgetc(tp, pos)) != EOF) {
                     if (c == '*') {
-                        if ((c = getc(ip)) == '/')
+                        if ((c = bufgetc(tp, pos)) == '/')
                         {
                             comment = 0;
                             break;
@@ -322,36 +502,34 @@ peekc(int immediate)
                 }
             }
             else if (c == '/') {			/* comment */
-                if ((c = getc(ip)) == '/') {
-                    while ((c = getc(ip)) != EOF)
+                if ((c = bufgetc(tp, pos)) == '/') {
+                    while ((c = bufgetc(tp, pos)) != EOF)
                         if (c == '\n') {
                             break;
                         }
                 } else if (c == '*') {
-                    while ((c = getc(ip)) != EOF) {
+                    while ((c = bufgetc(tp, pos)) != EOF) {
                         if (c == '*') {
-                            if ((c = getc(ip)) == '/')
+                            if ((c = bufgetc(tp, pos)) == '/')
                                 break;
                         }
                     }
                 } else
                     break;
             }
-            else if (!isspace(c))
+            else if (!IS_SPACE(c))
                 break;
         }
 
-	(void)fseek(ip, pos, SEEK_SET);
-
 	return c;
 }
 /**
  * throwaway_nextchar: throw away next character
  */
 void
-throwaway_nextchar(void)
+throwaway_nextchar(TOKEN *tp)
 {
-	nextchar();
+	nextchar(tp);
 }
 /**
  * atfirst_exceptspace: return if current position is the first column
@@ -361,10 +539,10 @@ throwaway_nextchar(void)
  *	|      # define
  */
 int
-atfirst_exceptspace(void)
+atfirst_exceptspace(TOKEN *tp)
 {
-	const char *start = sp;
-	const char *end = cp ? cp - 1 : lp;
+	const char *start = tp->sp;
+	const char *end = tp->cp ? tp->cp - 1 : tp->lp;
 
 	while (start < end && *start && isspace(*start))
 		start++;
@@ -377,12 +555,27 @@ atfirst_exceptspace(void)
  * 
  */
 static void
-pushbackchar(void)
+pushbackchar(TOKEN *tp)
 {
-        if (sp == NULL)
+        if (tp->sp == NULL)
                 return;         /* nothing to do */
-        if (cp == NULL)
-                cp = lp;
+        if (tp->cp == NULL)
+                tp->cp = tp->lp;
         else
-                --cp;
+                --tp->cp;
+}
+/**
+ * skipto: skip characters in the current line.
+ *
+ *	@param[in]	tp	tokenizer context
+ *	@param[in]	stops	characters to stop at
+ *
+ * Following nextchar() returns one of stops or '\n'.
+ * The search is done by strcspn(3), which is much faster than nextchar().
+ */
+static void
+skipto(TOKEN *tp, const char *stops)
+{
+	if (tp->cp != NULL)
+		tp->cp += strcspn(tp->cp, stops);
 }
@@ -24,36 +24,63 @@
 #include "gparam.h"
 #include "strbuf.h"
 
+#include <stdio.h>
+
 #define SYMBOL		0
 
-extern const char *sp, *cp, *lp;
-extern int lineno;
-extern int crflag;
-extern int cmode;
-extern int cppmode;
-extern int ymode;
-extern char token[MAXTOKEN];
-extern char curfile[MAXPATHLEN];
-extern int continued_line;
-
-#define nextchar() \
-	(cp == NULL ? \
-		((sp = cp = strbuf_fgets(ib, ip, STRBUF_NOCRLF)) == NULL ? \
+/*
+ * Tokenizer context.
+ *
+ * All the state of the tokenizer is kept here, so that several files
+ * can be tokenized at the same time.
+ */
+typedef struct {
+	const char *sp, *cp, *lp;
+	int lineno;
+	int crflag;			/**< 1: return '\n', 0: doesn't return */
+	int cmode;			/**< allow token which start with '#' */
+	int cppmode;			/**< allow '::' as a token */
+	int ymode;			/**< allow token which start with '%' */
+	char token[MAXTOKEN];
+	char curfile[MAXPATHLEN];
+	int continued_line;		/**< previous line ends with '\' */
+	size_t lineoff;			/**< offset of the current line (sp) in buf */
+	int linelen;			/**< length of the current line */
+	/*
+	 * private area
+	 */
+	char ptok[MAXTOKEN];		/**< push back buffer */
+	int lasttok;
+	const char *buf;		/**< whole of the file */
+	size_t bufsize;
+	int ownbuf;			/**< 1: buf is released by closetoken() */
+	const char *ep;			/**< next line in buf */
+	const char *endp;		/**< end of buf */
+	STRBUF *ib;			/**< current line */
+} TOKEN;
+
+#define nextchar(tp) \
+	((tp)->cp == NULL ? \
+		(((tp)->sp = (tp)->cp = nextline(tp)) == NULL ? \
 			EOF : \
-			(lineno++, *cp == 0 ? \
-				(lp = cp, cp = NULL, continued_line = 0, '\n') : \
-				(unsigned char)*cp++)) : \
-		(*cp == 0 ? \
-			(lp = cp, cp = NULL, continued_line = 0, '\n') : \
-			(unsigned char)*cp++))
-#define atfirst (sp && sp == (cp ? cp - 1 : lp))
-
-int opentoken(const char *);
-void closetoken(void);
-int nexttoken(const char *, int (*)(const char *, int));
-void pushbacktoken(void);
-int peekc(int);
-void throwaway_nextchar(void);
-int atfirst_exceptspace(void);
+			((tp)->lineno++, *(tp)->cp == 0 ? \
+				((tp)->lp = (tp)->cp, (tp)->cp = NULL, (tp)->continued_line = 0, '\n') : \
+				(unsigned char)*(tp)->cp++)) : \
+		(*(tp)->cp == 0 ? \
+			((tp)->lp = (tp)->cp, (tp)->cp = NULL, (tp)->continued_line = 0, '\n') : \
+			(unsigned char)*(tp)->cp++))
+#define atfirst(tp) ((tp)->sp && (tp)->sp == ((tp)->cp ? (tp)->cp - 1 : (tp)->lp))
+
+int readfile(const char *, char **, size_t *);
+void freefile(char *, size_t);
+TOKEN *opentoken(const char *);
+TOKEN *opentoken_buffer(const char *, const char *, size_t);
+const char *nextline(TOKEN *);
+void closetoken(TOKEN *);
+int nexttoken(TOKEN *, const char *, int (*)(const char *, int));
+void pushbacktoken(TOKEN *);
+int peekc(TOKEN *, int);
+void throwaway_nextchar(TOKEN *);
+int atfirst_exceptspace(TOKEN *);
 
 #endif /* ! _TOKEN_H_ */
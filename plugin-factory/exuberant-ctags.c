@@ -365,7 +365,25 @@ put_line(char *ctags_x, const struct parser_param *param)
 		while (isspace((unsigned char)*p))
 			p++;
 	}
-	param->put(type, tagname, lineno, filename, p, param->arg);
+	if (PARSER_HAS_BATCH(param))
+		param->put_batch(param->batch, type, tagname, lineno, p);
+	else
+		param->put(type, tagname, lineno, filename, p, param->arg);
+}
+
+/**
+ * parser_tools: the ctags command for the parse cache (see parser.h).
+ */
+const char *
+parser_tools(const struct parser_param *param)
+{
+	static char *path;
+
+	free(path);
+	path = param->getconf("ctagscom");
+	if (path && strlen(path) > 0 && strcmp(path, "no") != 0)
+		return path;
+	return ctagscom;
 }
 
 void
@@ -17,7 +17,6 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-
 #ifdef __MINGW32__
 #define __USE_MINGW_ANSI_STDIO 0	/* no need for C99 sprintf here */
 #endif
@@ -40,6 +39,14 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#if defined(_WIN32) && !defined(__CYGWIN__)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <fcntl.h>
+#else
+#include <fcntl.h>
+#include <sys/wait.h>
+#endif
 
 #include "parser.h"
 
@@ -52,13 +59,39 @@
 
 /*
  * Function layer plugin parser sample
+ *
+ * Protocol:
+ * We write the path of a file followed by a newline. The script answers
+ * with one frame per file in the order of the requests: a header line
+ * '<count> <size>\n' and <size> bytes of <count> tag records. Each record
+ * consists of four fields: type ('D' or 'R'), line number, tag and image.
+ * Each field is written as '<length>:<bytes>'.
+ *
+ * Several scripts run in parallel (pygments_processes in gtags.conf,
+ * the number of processors by default). The files which will be parsed
+ * later (param->ahead) are requested in advance, so that the scripts
+ * are busy while gtags writes the tags.
  */
 
-#define TERMINATOR		"###terminator###"
 #define LANGMAP_OPTION		"--langmap="
 #define INITIAL_BUFSIZE		1024
+#define MAXPROCESSES		64	/**< max number of scripts */
+#define MAXINFLIGHT		4	/**< max number of requests per script */
 
-static FILE *ip, *op;
+struct coprocess {
+#if defined(_WIN32) && !defined(__CYGWIN__)
+	HANDLE pid;
+#else
+	pid_t pid;
+#endif
+	FILE *ip, *op;
+	char *inflight[MAXINFLIGHT];	/**< requested files in the order */
+	int head;			/**< index of the oldest request */
+	int count;			/**< number of the requests */
+};
+static struct coprocess pool[MAXPROCESSES];
+static int nprocesses;			/**< number of started scripts */
+static int maxprocesses;		/**< 0: not initialized */
 static char *linebuf;
 static size_t bufsize;
 
@@ -87,12 +120,8 @@ copy_langmap_converting_cpp(char *dst, const char *src)
 }
 
 #if defined(_WIN32) && !defined(__CYGWIN__)
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#include <fcntl.h>
-static HANDLE pid;
 static void
-start_process(const struct parser_param *param)
+start_process(const struct parser_param *param, struct coprocess *cp)
 {
 	HANDLE opipe[2], ipipe[2];
 	SECURITY_ATTRIBUTES sa;
@@ -127,43 +156,34 @@ start_process(const struct parser_param *param)
 	si.dwFlags = STARTF_USESTDHANDLES;
 	if (!CreateProcess(NULL, arg, NULL, NULL, TRUE, 0, NULL, NULL, &si, &pi))
 		param->die("no python");
+	free(arg);
 	CloseHandle(opipe[0]);
 	CloseHandle(ipipe[1]);
 	CloseHandle(pi.hThread);
-	pid = pi.hProcess;
-	op = fdopen(_open_osfhandle((intptr_t)opipe[1], _O_WRONLY), "w");
-	ip = fdopen(_open_osfhandle((intptr_t)ipipe[0], _O_RDONLY), "r");
-	if (ip == NULL || op == NULL)
+	cp->pid = pi.hProcess;
+	cp->op = fdopen(_open_osfhandle((intptr_t)opipe[1], _O_WRONLY), "w");
+	cp->ip = fdopen(_open_osfhandle((intptr_t)ipipe[0], _O_RDONLY | _O_BINARY), "rb");
+	if (cp->ip == NULL || cp->op == NULL)
 		param->die("fdopen failed.");
-
-	bufsize = INITIAL_BUFSIZE;
-	linebuf = malloc(bufsize);
-	if (linebuf == NULL)
-		param->die("short of memory.");
 }
 static void
-terminate_process(void) {
-	if (op == NULL)
-		return;
-	free(linebuf);
-	fclose(op);
-	fclose(ip);
-	WaitForSingleObject(pid, INFINITE);
-	CloseHandle(pid);
+wait_process(struct coprocess *cp)
+{
+	WaitForSingleObject(cp->pid, INFINITE);
+	CloseHandle(cp->pid);
 }
 #else
-#include <sys/wait.h>
 static char *argv[] = {
 	PYGMENTS_PARSER,
 	NULL,
 	NULL
 };
-static pid_t pid;
 
 static void
-start_process(const struct parser_param *param)
+start_process(const struct parser_param *param, struct coprocess *cp)
 {
 	int opipe[2], ipipe[2];
+	pid_t pid;
 
 	argv[1] = malloc(sizeof(LANGMAP_OPTION) + strlen(param->langmap));
 	if (argv[1] == NULL)
@@ -173,6 +193,13 @@ start_process(const struct parser_param *param)
 
 	if (pipe(opipe) < 0 || pipe(ipipe) < 0)
 		param->die("cannot create pipe.");
+	/*
+	 * Other scripts must not inherit our ends of the pipes.
+	 * Otherwise, they would keep this script from seeing EOF.
+	 */
+	if (fcntl(opipe[1], F_SETFD, FD_CLOEXEC) < 0
+	 || fcntl(ipipe[0], F_SETFD, FD_CLOEXEC) < 0)
+		param->die("fcntl failed.");
 	pid = fork();
 	if (pid == 0) {
 		/* child process */
@@ -192,32 +219,80 @@ start_process(const struct parser_param *param)
 	free(argv[1]);
 	close(opipe[0]);
 	close(ipipe[1]);
-	ip = fdopen(ipipe[0], "r");
-	op = fdopen(opipe[1], "w");
-	if (ip == NULL || op == NULL)
+	cp->pid = pid;
+	cp->ip = fdopen(ipipe[0], "r");
+	cp->op = fdopen(opipe[1], "w");
+	if (cp->ip == NULL || cp->op == NULL)
 		param->die("fdopen failed.");
+}
+static void
+wait_process(struct coprocess *cp)
+{
+	while (waitpid(cp->pid, NULL, 0) < 0 && errno == EINTR)
+		;
+}
+#endif
+
+/**
+ * setup_pool: decide the number of scripts.
+ */
+static void
+setup_pool(const struct parser_param *param)
+{
+	char *value = param->getconf("pygments_processes");
 
+	if (value != NULL) {
+		maxprocesses = atoi(value);
+		free(value);
+	}
+#ifdef _SC_NPROCESSORS_ONLN
+	else
+		maxprocesses = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+	/* Without the files in advance, the scripts cannot work in parallel. */
+	if (!PARSER_HAS_AHEAD(param) || maxprocesses < 1)
+		maxprocesses = 1;
+	else if (maxprocesses > MAXPROCESSES)
+		maxprocesses = MAXPROCESSES;
 	bufsize = INITIAL_BUFSIZE;
 	linebuf = malloc(bufsize);
 	if (linebuf == NULL)
 		param->die("short of memory.");
 }
 
+/**
+ * terminate_process: terminate the scripts.
+ *
+ * A script answers the requests in flight before it sees EOF,
+ * so the answers are read and discarded.
+ */
 static void
 terminate_process(void)
 {
-	if (op == NULL)
-		return;
+	char buf[BUFSIZ];
+	struct coprocess *cp;
+	int i;
+
+	for (i = 0; i < nprocesses; i++) {
+		cp = &pool[i];
+		fclose(cp->op);
+		while (fread(buf, 1, sizeof(buf), cp->ip) > 0)
+			;
+		fclose(cp->ip);
+		wait_process(cp);
+		while (cp->count > 0) {
+			free(cp->inflight[cp->head]);
+			cp->head = (cp->head + 1) % MAXINFLIGHT;
+			cp->count--;
+		}
+	}
+	nprocesses = 0;
 	free(linebuf);
-	fclose(op);
-	fclose(ip);
-	while (waitpid(pid, NULL, 0) < 0 && errno == EINTR)
-		;
+	linebuf = NULL;
 }
-#endif
 
 static char *
-get_line(const struct parser_param *param)
+get_line(const struct parser_param *param, FILE *ip)
 {
 	size_t linelen = 0;
 
@@ -242,95 +317,230 @@ get_line(const struct parser_param *param)
 	return linebuf;
 }
 
+/**
+ * read_frame: read a frame into linebuf
+ *
+ *	@param[in]	ip	input from the script
+ *	@param[out]	count	number of records
+ *	@return		size of the frame body
+ */
+static size_t
+read_frame(const struct parser_param *param, FILE *ip, int *count)
+{
+	char *line;
+	unsigned long size;
+
+	line = get_line(param, ip);
+	if (line == NULL)
+		param->die("unexpected EOF.");
+	if (sscanf(line, "%d %lu", count, &size) != 2 || *count < 0)
+		param->die("unexpected frame header: %s", line);
+	if (size >= bufsize) {
+		while (size >= bufsize)
+			bufsize *= 2;
+		linebuf = realloc(linebuf, bufsize);
+		if (linebuf == NULL)
+			param->die("short of memory.");
+	}
+	if (fread(linebuf, 1, size, ip) != size)
+		param->die("unexpected EOF.");
+	linebuf[size] = '\0';
+	return size;
+}
+/**
+ * get_field: get a field '<length>:<bytes>' of a record.
+ *
+ *	@param[in,out]	p	position in the frame body
+ *	@param[in]	end	end of the frame body
+ *	@param[out]	len	length of the field
+ *	@return		the field; NULL: broken
+ */
+static char *
+get_field(char **p, const char *end, size_t *len)
+{
+	char *q = *p;
+	size_t n = 0;
+
+	if (q >= end || !isdigit((unsigned char)*q))
+		return NULL;
+	while (q < end && isdigit((unsigned char)*q))
+		n = n * 10 + (*q++ - '0');
+	if (q >= end || *q++ != ':' || n > (size_t)(end - q))
+		return NULL;
+	*p = q + n;
+	*len = n;
+	return q;
+}
+/**
+ * put_frame: put the tag records in a frame
+ *
+ *	@param[in]	count	number of records
+ *	@param[in]	size	size of the frame body
+ *
+ * The fields are terminated in place. The byte after the line image
+ * is the beginning of the next record, so that it is restored.
+ */
 static void
-put_line(char *line, const struct parser_param *param)
+put_frame(int count, size_t size, const struct parser_param *param)
 {
-	int lineno;
-	int type = PARSER_DEF;
-	char *p, *tagname, *filename;
+	char *p = linebuf, *end = linebuf + size;
+	char *field[4];
+	size_t len[4];
+	int i, type = PARSER_DEF;
+	char save;
 
-	/*
-	 * Output of ctags:
-	 * ctags -x ...
-	 * main              326 global/global.c  main(int argc, char **argv)
-	 *
-	 * ctags -x --gtags ...
-	 * D main              326 global/global.c  main(int argc, char **argv)
-	 */
-	switch (*line) {
-	case 'D':
-		type = PARSER_DEF;
-		break;
-	case 'R':
-		type = PARSER_REF_SYM;
-		break;
-	default:
-		param->die("unexpected type string: %s", line);
+	while (count-- > 0) {
+		for (i = 0; i < 4; i++)
+			if ((field[i] = get_field(&p, end, &len[i])) == NULL)
+				param->die("broken frame from pygments parser.");
+		if (len[0] != 1)
+			param->die("unexpected type string.");
+		switch (*field[0]) {
+		case 'D':
+			type = PARSER_DEF;
+			break;
+		case 'R':
+			type = PARSER_REF_SYM;
+			break;
+		default:
+			param->die("unexpected type string: %c", *field[0]);
+		}
+		field[1][len[1]] = '\0';
+		field[2][len[2]] = '\0';
+		save = field[3][len[3]];
+		field[3][len[3]] = '\0';
+		if (PARSER_HAS_BATCH(param))
+			param->put_batch(param->batch, type, field[2], atoi(field[1]), field[3]);
+		else
+			param->put(type, field[2], atoi(field[1]), param->file, field[3], param->arg);
+		field[3][len[3]] = save;
+	}
+}
+
+/**
+ * find_request: find the script which the file was requested to.
+ *
+ *	@param[in]	path	path name
+ *	@return		script; NULL: not requested
+ */
+static struct coprocess *
+find_request(const char *path)
+{
+	struct coprocess *cp;
+	int i, j;
+
+	for (i = 0; i < nprocesses; i++) {
+		cp = &pool[i];
+		for (j = 0; j < cp->count; j++)
+			if (!strcmp(cp->inflight[(cp->head + j) % MAXINFLIGHT], path))
+				return cp;
 	}
-	/* skip type string */
-	while (*line && !isspace((unsigned char)*line))
-		line++;
-	while (*line  && isspace((unsigned char)*line))
-		line++;
-	filename = strstr(line, param->file);
-	if (filename == NULL || filename == line)
-		return;
-	p = filename - 1;
-	if (!isspace((unsigned char)*p))
-		return;
-	while (p >= line && isspace((unsigned char)*p))
-		*p-- = '\0';
-	if (p < line)
-		return;
-	if (!isdigit((unsigned char)*p))
-		return;
-	while (p >= line && isdigit((unsigned char)*p))
-		p--;
-	if (p < line)
-		return;
-	lineno = atoi(p + 1);
-	if (!isspace((unsigned char)*p))
-		return;
-	while (p >= line && isspace((unsigned char)*p))
-		*p-- = '\0';
-	if (p < line)
-		return;
-	while (p >= line && !isspace((unsigned char)*p))
-		p--;
-	tagname = p + 1;
-	p = filename + strlen(param->file);
-	if (*p != '\0') {
-		if (!isspace((unsigned char)*p))
-			return;
-		*p++ = '\0';
-		while (isspace((unsigned char)*p))
-			p++;
+	return NULL;
+}
+/**
+ * request: request a file to the least busy script.
+ *
+ *	@param[in]	path	path name
+ *	@return		script; NULL: all scripts are busy
+ *
+ * A new script is started if all the running scripts have requests.
+ */
+static struct coprocess *
+request(const struct parser_param *param, const char *path)
+{
+	struct coprocess *cp = NULL;
+	int i;
+
+	for (i = 0; i < nprocesses; i++)
+		if (cp == NULL || pool[i].count < cp->count)
+			cp = &pool[i];
+	if ((cp == NULL || cp->count > 0) && nprocesses < maxprocesses) {
+		cp = &pool[nprocesses];
+		start_process(param, cp);
+		nprocesses++;
 	}
-	param->put(type, tagname, lineno, filename, p, param->arg);
+	if (cp->count >= MAXINFLIGHT)
+		return NULL;
+	cp->inflight[(cp->head + cp->count) % MAXINFLIGHT] = strdup(path);
+	if (cp->inflight[(cp->head + cp->count) % MAXINFLIGHT] == NULL)
+		param->die("short of memory.");
+	cp->count++;
+	fputs(path, cp->op);
+	putc('\n', cp->op);
+	return cp;
+}
+/**
+ * discard: read and discard the answer of the oldest request of a script.
+ */
+static void
+discard(const struct parser_param *param, struct coprocess *cp)
+{
+	int count;
+
+	read_frame(param, cp->ip, &count);
+	free(cp->inflight[cp->head]);
+	cp->head = (cp->head + 1) % MAXINFLIGHT;
+	cp->count--;
+}
+
+/**
+ * parser_tools: the script and the ctags command for the parse cache
+ * (see parser.h).
+ */
+const char *
+parser_tools(const struct parser_param *param)
+{
+	static char *tools;
+	char *path = param->getconf("ctagscom");
+	const char *ctags = EXUBERANT_CTAGS;
+
+	if (path && strlen(path) > 0 && strcmp(path, "no") != 0)
+		ctags = path;
+	free(tools);
+	tools = malloc(sizeof(PYGMENTS_PARSER) + 1 + strlen(ctags) + 1);
+	if (tools == NULL)
+		param->die("short of memory.");
+	sprintf(tools, "%s\n%s", PYGMENTS_PARSER, ctags);
+	free(path);
+	return tools;
 }
 
 void
 parser(const struct parser_param *param)
 {
-	char *line;
+	struct coprocess *cp;
+	size_t size;
+	int i, count;
 
 	assert(param->size >= sizeof(*param));
 
-	if (op == NULL)
-		start_process(param);
-
-	/* Write path of input file to pipe. */
-	fputs(param->file, op);
-	putc('\n', op);
-	fflush(op);
-
-	/* Read output of the process. */
-	for (;;) {
-		line = get_line(param);
-		if (line == NULL)
-			param->die("unexpected EOF.");
-		if (strcmp(line, TERMINATOR) == 0)
-			break;
-		put_line(line, param);
+	if (maxprocesses == 0)
+		setup_pool(param);
+	/*
+	 * Request the file unless it was requested in advance.
+	 * If all the scripts are busy, the requests which were not
+	 * followed (e.g. the file was not parsed after all) are discarded.
+	 */
+	if ((cp = find_request(param->file)) == NULL) {
+		while ((cp = request(param, param->file)) == NULL)
+			discard(param, &pool[0]);
+	}
+	/* Request the following files in advance. */
+	if (PARSER_HAS_AHEAD(param)) {
+		for (i = 0; i < param->nahead; i++)
+			if (find_request(param->ahead[i]) == NULL
+			 && request(param, param->ahead[i]) == NULL)
+				break;
 	}
+	for (i = 0; i < nprocesses; i++)
+		fflush(pool[i].op);
+	/* Skip the answers of the requests before the file. */
+	while (strcmp(cp->inflight[cp->head], param->file))
+		discard(param, cp);
+	/* Read a frame from the script. */
+	size = read_frame(param, cp->ip, &count);
+	put_frame(count, size, param);
+	free(cp->inflight[cp->head]);
+	cp->head = (cp->head + 1) % MAXINFLIGHT;
+	cp->count--;
 }